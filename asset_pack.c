@@ -0,0 +1,109 @@
+#include "asset_pack.h"
+
+static bool isValidEntry(const AssetPackEntry* entry, size_t fileSize);
+
+AssetPackError assetPackMap(AssetPack* pack, const char* path)
+{
+    struct stat fileStat;
+    const AssetPackHeader* header = NULL;
+    void* mapping = MAP_FAILED;
+    int32_t fileDesc = -1;
+    uint16_t i = 0;
+
+    if (pack == NULL || path == NULL)
+    {
+        printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+        return AP_ERROR;
+    }
+
+    memset(pack, 0x0, sizeof(AssetPack));
+
+    fileDesc = open(path, O_RDONLY);
+    if (fileDesc == -1)
+    {
+        return AP_ERROR;
+    }
+
+    if (fstat(fileDesc, &fileStat) || fileStat.st_size < (off_t) sizeof(AssetPackHeader))
+    {
+        printf("\n%s : ERROR %s is not a valid asset pack\n", __FUNCTION__, path);
+        close(fileDesc);
+        return AP_ERROR;
+    }
+
+    mapping = mmap(NULL, fileStat.st_size, PROT_READ, MAP_SHARED, fileDesc, 0);
+    close(fileDesc);
+    if (mapping == MAP_FAILED)
+    {
+        printf("\n%s : ERROR mmap %s (%s)\n", __FUNCTION__, path, strerror(errno));
+        return AP_ERROR;
+    }
+
+    header = (const AssetPackHeader*) mapping;
+    if (header->magic != ASSET_PACK_MAGIC || header->version != ASSET_PACK_VERSION ||
+        header->headerSize != sizeof(AssetPackHeader) || header->fileSize != (size_t) fileStat.st_size ||
+        header->assetCount > ASSET_PACK_MAX_ASSETS ||
+        header->headerSize + header->assetCount * sizeof(AssetPackEntry) > (size_t) fileStat.st_size)
+    {
+        printf("\n%s : ERROR %s is not a valid asset pack\n", __FUNCTION__, path);
+        munmap(mapping, fileStat.st_size);
+        return AP_ERROR;
+    }
+
+    pack->header = header;
+    pack->entries = (const AssetPackEntry*) ((const uint8_t*) mapping + header->headerSize);
+    pack->assetCount = header->assetCount;
+    pack->mappingSize = fileStat.st_size;
+
+    /* pixels are not checked, that would read the whole file in, only the table they are found by */
+    for (i = 0; i < pack->assetCount; i++)
+    {
+        if (!isValidEntry(&pack->entries[i], pack->mappingSize))
+        {
+            printf("\n%s : ERROR %s has invalid asset %u\n", __FUNCTION__, path, i);
+            assetPackUnmap(pack);
+            return AP_ERROR;
+        }
+    }
+
+    return AP_NO_ERROR;
+}
+
+void assetPackUnmap(AssetPack* pack)
+{
+    if (pack != NULL && pack->header != NULL)
+    {
+        munmap((void*) pack->header, pack->mappingSize);
+        memset(pack, 0x0, sizeof(AssetPack));
+    }
+}
+
+const uint32_t* assetPackFind(const AssetPack* pack, const char* name, int32_t* width, int32_t* height, int32_t* pitch)
+{
+    uint16_t i = 0;
+
+    for (i = 0; i < pack->assetCount; i++)
+    {
+        if (strcmp(pack->entries[i].name, name) == 0)
+        {
+            *width = pack->entries[i].width;
+            *height = pack->entries[i].height;
+            *pitch = pack->entries[i].pitch;
+            return (const uint32_t*) ((const uint8_t*) pack->header + pack->entries[i].offset);
+        }
+    }
+
+    return NULL;
+}
+
+bool isValidEntry(const AssetPackEntry* entry, size_t fileSize)
+{
+    if (memchr(entry->name, '\0', ASSET_PACK_MAX_NAME_LENGTH) == NULL || entry->width <= 0 || entry->height <= 0 ||
+        entry->offset % ASSET_PACK_ALIGNMENT != 0 || entry->pitch % ASSET_PACK_PITCH_ALIGNMENT != 0 ||
+        entry->pitch < (uint32_t) entry->width * 4)
+    {
+        return false;
+    }
+
+    return (uint64_t) entry->offset + (uint64_t) entry->pitch * entry->height <= fileSize;
+}
@@ -0,0 +1,96 @@
+#ifndef __ASSET_PACK_H__
+#define __ASSET_PACK_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define ASSET_PACK_MAGIC 0x4F534450                 /* "OSDP" */
+#define ASSET_PACK_VERSION 1                        /* Format version, files with other version are rejected */
+#define ASSET_PACK_MAX_ASSETS 64
+#define ASSET_PACK_MAX_NAME_LENGTH 64               /* Asset id, same as image cache asset id */
+#define ASSET_PACK_ALIGNMENT 64                     /* Pixels of every asset start on a cache line */
+#define ASSET_PACK_PITCH_ALIGNMENT 16               /* Bytes, rows start where SIMD loads and blitter want them */
+
+/**
+ * @brief Structure that defines asset pack error
+ */
+typedef enum _AssetPackError
+{
+    AP_NO_ERROR = 0,
+    AP_ERROR
+}AssetPackError;
+
+/**
+ * @brief Structure that defines header at the start of asset pack file, asset table follows it
+ */
+typedef struct _AssetPackHeader
+{
+    uint32_t magic;                                 /* ASSET_PACK_MAGIC */
+    uint16_t version;                               /* ASSET_PACK_VERSION */
+    uint16_t headerSize;
+    uint16_t assetCount;
+    uint16_t reserved;
+    uint32_t fileSize;
+}AssetPackHeader;
+
+/**
+ * @brief Structure that defines one asset, premultiplied ARGB pixels ready to blit
+ */
+typedef struct _AssetPackEntry
+{
+    char name[ASSET_PACK_MAX_NAME_LENGTH];
+    uint32_t offset;                                /* From start of file, multiple of ASSET_PACK_ALIGNMENT */
+    uint32_t pitch;                                 /* Bytes per row, multiple of ASSET_PACK_PITCH_ALIGNMENT */
+    int32_t width;
+    int32_t height;
+}AssetPackEntry;
+
+/**
+ * @brief Structure that holds read-only mapping of asset pack file
+ *
+ * Pixels are read straight from the mapping, pages are shared with page cache and loaded on first blit.
+ */
+typedef struct _AssetPack
+{
+    const AssetPackHeader* header;
+    const AssetPackEntry* entries;
+    uint16_t assetCount;
+    size_t mappingSize;
+}AssetPack;
+
+/**
+ * @brief Maps asset pack file read-only and checks its asset table
+ *
+ * @param [out] pack - mapped pack
+ * @param [in]  path - asset pack file
+ * @return asset pack error code
+ */
+AssetPackError assetPackMap(AssetPack* pack, const char* path);
+
+/**
+ * @brief Unmaps asset pack file, surfaces wrapping its pixels must be released first
+ *
+ * @param [in] pack - mapped pack
+ */
+void assetPackUnmap(AssetPack* pack);
+
+/**
+ * @brief Finds asset in pack
+ *
+ * @param [in]  pack - mapped pack, may be unmapped
+ * @param [in]  name - asset id
+ * @param [out] width - asset width
+ * @param [out] height - asset height
+ * @param [out] pitch - bytes per row
+ * @return premultiplied ARGB pixels inside the mapping, NULL if pack has no such asset
+ */
+const uint32_t* assetPackFind(const AssetPack* pack, const char* name, int32_t* width, int32_t* height, int32_t* pitch);
+
+#endif /* __ASSET_PACK_H__ */
@@ -0,0 +1,268 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <png.h>
+#include "asset_pack.h"
+#include "osd_pixel.h"
+
+#define PACKER_MAX_LINE 256
+
+/**
+ * @brief Structure that holds one image decoded for packing
+ */
+typedef struct _PackerImage
+{
+    uint32_t* pixels;                               /* Premultiplied ARGB, width pixels per row */
+    int32_t width;
+    int32_t height;
+}PackerImage;
+
+static bool readImage(const char* path, PackerImage* image);
+static bool readPng(const char* path, PackerImage* image);
+static bool readPam(const char* path, PackerImage* image);
+static bool writePack(const char* path, AssetPackEntry* entries, const PackerImage* images, uint16_t count);
+static uint32_t alignUp(uint32_t value, uint32_t alignment);
+
+/*
+ * Decodes OSD images on the build host into one asset pack, the receiver maps it and blits the
+ * pixels as they are.
+ *
+ * Usage: asset_packer <pack> <asset id>[=<image file>]...
+ * Asset id is the path graphics controller asks the image cache for, the image is read from it
+ * unless another file is given. Images are PNG, or PAM for files ending in .pam.
+ */
+int main(int argc, char** argv)
+{
+    AssetPackEntry entries[ASSET_PACK_MAX_ASSETS];
+    PackerImage images[ASSET_PACK_MAX_ASSETS];
+    const char* path = NULL;
+    char* separator = NULL;
+    uint16_t count = 0;
+    bool success = true;
+    int32_t i = 0;
+
+    if (argc < 3 || argc - 2 > ASSET_PACK_MAX_ASSETS)
+    {
+        printf("usage: %s <pack> <asset id>[=<image file>]... (at most %d assets)\n", argv[0], ASSET_PACK_MAX_ASSETS);
+        return 1;
+    }
+
+    memset(entries, 0x0, sizeof(entries));
+    memset(images, 0x0, sizeof(images));
+
+    for (i = 2; i < argc && success; i++)
+    {
+        separator = strchr(argv[i], '=');
+        path = separator != NULL ? separator + 1 : argv[i];
+        if (separator != NULL)
+        {
+            *separator = '\0';
+        }
+
+        if (strlen(argv[i]) >= ASSET_PACK_MAX_NAME_LENGTH)
+        {
+            printf("%s : asset id too long\n", argv[i]);
+            success = false;
+            break;
+        }
+
+        strcpy(entries[count].name, argv[i]);
+        success = readImage(path, &images[count]);
+        if (success)
+        {
+            entries[count].width = images[count].width;
+            entries[count].height = images[count].height;
+            count++;
+        }
+    }
+
+    if (success)
+    {
+        success = writePack(argv[1], entries, images, count);
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        free(images[i].pixels);
+    }
+
+    return success ? 0 : 1;
+}
+
+bool readImage(const char* path, PackerImage* image)
+{
+    size_t length = strlen(path);
+    bool success = false;
+
+    if (length > 4 && strcmp(path + length - 4, ".pam") == 0)
+    {
+        success = readPam(path, image);
+    }
+    else
+    {
+        success = readPng(path, image);
+    }
+
+    if (!success)
+    {
+        printf("%s : cannot read image\n", path);
+        free(image->pixels);
+        image->pixels = NULL;
+        return false;
+    }
+
+    /* blended as they are on the receiver, so alpha is applied here once */
+    pixelKernelsBest()->premultiply(image->pixels, image->pixels, image->width * image->height);
+
+    return true;
+}
+
+bool readPng(const char* path, PackerImage* image)
+{
+    png_image png;
+
+    memset(&png, 0x0, sizeof(png));
+    png.version = PNG_IMAGE_VERSION;
+    if (!png_image_begin_read_from_file(&png, path))
+    {
+        return false;
+    }
+
+    /* B, G, R, A bytes are ARGB words on little endian host and receiver */
+    png.format = PNG_FORMAT_BGRA;
+    image->width = png.width;
+    image->height = png.height;
+    image->pixels = (uint32_t*)malloc(PNG_IMAGE_SIZE(png));
+    if (image->pixels == NULL)
+    {
+        png_image_free(&png);
+        return false;
+    }
+
+    return png_image_finish_read(&png, NULL, image->pixels, 0, NULL) != 0;
+}
+
+bool readPam(const char* path, PackerImage* image)
+{
+    FILE* file = fopen(path, "rb");
+    char line[PACKER_MAX_LINE];
+    uint8_t sample[4];
+    int32_t depth = 0;
+    int32_t maxValue = 0;
+    int32_t i = 0;
+
+    if (file == NULL)
+    {
+        return false;
+    }
+
+    if (fgets(line, sizeof(line), file) == NULL || strncmp(line, "P7", 2) != 0)
+    {
+        fclose(file);
+        return false;
+    }
+
+    while (fgets(line, sizeof(line), file) != NULL && strncmp(line, "ENDHDR", 6) != 0)
+    {
+        sscanf(line, "WIDTH %d", &image->width);
+        sscanf(line, "HEIGHT %d", &image->height);
+        sscanf(line, "DEPTH %d", &depth);
+        sscanf(line, "MAXVAL %d", &maxValue);
+    }
+
+    if (image->width <= 0 || image->height <= 0 || maxValue != 255 || (depth != 3 && depth != 4))
+    {
+        fclose(file);
+        return false;
+    }
+
+    image->pixels = (uint32_t*)malloc((size_t)image->width * image->height * sizeof(uint32_t));
+    if (image->pixels == NULL)
+    {
+        fclose(file);
+        return false;
+    }
+
+    /* samples are straight alpha in R, G, B, A order */
+    sample[3] = 0xFF;
+    for (i = 0; i < image->width * image->height; i++)
+    {
+        if (fread(sample, 1, depth, file) != (size_t)depth)
+        {
+            fclose(file);
+            return false;
+        }
+        image->pixels[i] = ((uint32_t)sample[3] << 24) | ((uint32_t)sample[0] << 16) | ((uint32_t)sample[1] << 8) | sample[2];
+    }
+
+    fclose(file);
+
+    return true;
+}
+
+bool writePack(const char* path, AssetPackEntry* entries, const PackerImage* images, uint16_t count)
+{
+    static const uint8_t padding[ASSET_PACK_ALIGNMENT] = { 0 };
+    AssetPackHeader header;
+    FILE* file = NULL;
+    uint32_t offset = 0;
+    uint32_t written = 0;
+    uint32_t rowBytes = 0;
+    uint16_t i = 0;
+    int32_t row = 0;
+    bool success = true;
+
+    /* asset table first, then pixels of every asset at an aligned offset */
+    offset = sizeof(AssetPackHeader) + count * sizeof(AssetPackEntry);
+    for (i = 0; i < count; i++)
+    {
+        offset = alignUp(offset, ASSET_PACK_ALIGNMENT);
+        entries[i].offset = offset;
+        entries[i].pitch = alignUp((uint32_t)entries[i].width * 4, ASSET_PACK_PITCH_ALIGNMENT);
+        offset += entries[i].pitch * entries[i].height;
+    }
+
+    memset(&header, 0x0, sizeof(header));
+    header.magic = ASSET_PACK_MAGIC;
+    header.version = ASSET_PACK_VERSION;
+    header.headerSize = sizeof(AssetPackHeader);
+    header.assetCount = count;
+    header.fileSize = offset;
+
+    file = fopen(path, "wb");
+    if (file == NULL)
+    {
+        printf("%s : cannot create pack\n", path);
+        return false;
+    }
+
+    success = fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(entries, sizeof(AssetPackEntry), count, file) == count;
+    written = sizeof(AssetPackHeader) + count * sizeof(AssetPackEntry);
+    for (i = 0; i < count && success; i++)
+    {
+        success = fwrite(padding, 1, entries[i].offset - written, file) == entries[i].offset - written;
+        rowBytes = (uint32_t)entries[i].width * 4;
+        for (row = 0; row < entries[i].height && success; row++)
+        {
+            success = fwrite(images[i].pixels + (size_t)row * entries[i].width, 1, rowBytes, file) == rowBytes &&
+                      fwrite(padding, 1, entries[i].pitch - rowBytes, file) == entries[i].pitch - rowBytes;
+        }
+        written = entries[i].offset + entries[i].pitch * entries[i].height;
+    }
+
+    if (fclose(file) != 0 || !success)
+    {
+        printf("%s : cannot write pack\n", path);
+        remove(path);
+        return false;
+    }
+
+    printf("%s : %u assets, %u bytes\n", path, count, header.fileSize);
+
+    return true;
+}
+
+uint32_t alignUp(uint32_t value, uint32_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
@@ -0,0 +1,325 @@
+#include "channel_database.h"
+
+static uint32_t recordsChecksum(const ChannelMultiplex* multiplexes, uint16_t multiplexCount,
+                                const ChannelService* services, uint16_t serviceCount);
+static bool writeAll(int32_t fileDesc, const void* data, size_t size);
+
+void channelDatabaseClear(ChannelDatabase* database)
+{
+    if (database != NULL)
+    {
+        memset(database, 0x0, sizeof(ChannelDatabase));
+    }
+}
+
+ChannelDatabaseError channelDatabaseAddMultiplex(ChannelDatabase* database, const ChannelMultiplex* multiplex, uint16_t* multiplexIndex)
+{
+    uint16_t i = 0;
+
+    if (database == NULL || multiplex == NULL || multiplexIndex == NULL)
+    {
+        printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+        return CDB_ERROR;
+    }
+
+    for (i = 0; i < database->multiplexCount; i++)
+    {
+        if (multiplex->frequency != 0 && database->multiplexes[i].frequency == multiplex->frequency)
+        {
+            database->multiplexes[i] = *multiplex;
+            *multiplexIndex = i;
+            return CDB_NO_ERROR;
+        }
+    }
+
+    if (database->multiplexCount >= CHANNEL_DATABASE_MAX_MULTIPLEXES)
+    {
+        printf("\n%s : ERROR there is not enough space in database for multiplex\n", __FUNCTION__);
+        return CDB_FULL;
+    }
+
+    database->multiplexes[database->multiplexCount] = *multiplex;
+    *multiplexIndex = database->multiplexCount;
+    database->multiplexCount++;
+
+    return CDB_NO_ERROR;
+}
+
+ChannelDatabaseError channelDatabaseAddService(ChannelDatabase* database, const ChannelService* service)
+{
+    uint16_t i = 0;
+
+    if (database == NULL || service == NULL)
+    {
+        printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+        return CDB_ERROR;
+    }
+
+    for (i = 0; i < database->serviceCount; i++)
+    {
+        if (database->services[i].multiplexIndex == service->multiplexIndex &&
+            database->services[i].serviceId == service->serviceId)
+        {
+            database->services[i] = *service;
+            return CDB_NO_ERROR;
+        }
+    }
+
+    if (database->serviceCount >= CHANNEL_DATABASE_MAX_SERVICES)
+    {
+        printf("\n%s : ERROR there is not enough space in database for service\n", __FUNCTION__);
+        return CDB_FULL;
+    }
+
+    database->services[database->serviceCount] = *service;
+    database->serviceCount++;
+
+    return CDB_NO_ERROR;
+}
+
+void channelDatabaseSort(ChannelDatabase* database)
+{
+    uint16_t i = 0;
+    int32_t j = 0;
+    ChannelService service;
+
+    if (database == NULL)
+    {
+        return;
+    }
+
+    /* insertion sort keeps scan order of services with equal numbers */
+    for (i = 1; i < database->serviceCount; i++)
+    {
+        service = database->services[i];
+        j = i - 1;
+
+        while (j >= 0 && database->services[j].logicalChannelNumber > service.logicalChannelNumber)
+        {
+            database->services[j + 1] = database->services[j];
+            j--;
+        }
+        database->services[j + 1] = service;
+    }
+}
+
+ChannelDatabaseError channelDatabaseSave(ChannelDatabase* database, const char* path)
+{
+    char tempPath[PATH_MAX];
+    ChannelDatabaseHeader header;
+    int32_t fileDesc = -1;
+    bool written = false;
+
+    if (database == NULL || path == NULL)
+    {
+        printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+        return CDB_ERROR;
+    }
+
+    snprintf(tempPath, sizeof(tempPath), "%s.tmp", path);
+
+    fileDesc = open(tempPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fileDesc == -1)
+    {
+        printf("\n%s : ERROR opening %s (%s)\n", __FUNCTION__, tempPath, strerror(errno));
+        return CDB_ERROR;
+    }
+
+    memset(&header, 0x0, sizeof(ChannelDatabaseHeader));
+    header.magic = CHANNEL_DATABASE_MAGIC;
+    header.version = CHANNEL_DATABASE_VERSION;
+    header.headerSize = sizeof(ChannelDatabaseHeader);
+    header.generation = database->generation + 1;
+    header.multiplexCount = database->multiplexCount;
+    header.serviceCount = database->serviceCount;
+    header.checksum = recordsChecksum(database->multiplexes, database->multiplexCount,
+                                      database->services, database->serviceCount);
+
+    written = writeAll(fileDesc, &header, sizeof(ChannelDatabaseHeader)) &&
+              writeAll(fileDesc, database->multiplexes, database->multiplexCount * sizeof(ChannelMultiplex)) &&
+              writeAll(fileDesc, database->services, database->serviceCount * sizeof(ChannelService)) &&
+              fsync(fileDesc) == 0;
+
+    if (close(fileDesc) || !written)
+    {
+        printf("\n%s : ERROR writing %s\n", __FUNCTION__, tempPath);
+        unlink(tempPath);
+        return CDB_ERROR;
+    }
+
+    /* rename replaces old database atomically */
+    if (rename(tempPath, path))
+    {
+        printf("\n%s : ERROR renaming %s (%s)\n", __FUNCTION__, tempPath, strerror(errno));
+        unlink(tempPath);
+        return CDB_ERROR;
+    }
+
+    database->generation = header.generation;
+
+    return CDB_NO_ERROR;
+}
+
+ChannelDatabaseError channelDatabaseLoad(ChannelDatabase* database, const char* path)
+{
+    ChannelDatabaseView view;
+
+    if (database == NULL || path == NULL)
+    {
+        printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+        return CDB_ERROR;
+    }
+
+    channelDatabaseClear(database);
+
+    if (channelDatabaseMap(&view, path))
+    {
+        return CDB_ERROR;
+    }
+
+    database->generation = view.header->generation;
+    database->multiplexCount = view.multiplexCount;
+    database->serviceCount = view.serviceCount;
+    memcpy(database->multiplexes, view.multiplexes, view.multiplexCount * sizeof(ChannelMultiplex));
+    memcpy(database->services, view.services, view.serviceCount * sizeof(ChannelService));
+
+    channelDatabaseUnmap(&view);
+
+    return CDB_NO_ERROR;
+}
+
+ChannelDatabaseError channelDatabaseMap(ChannelDatabaseView* view, const char* path)
+{
+    struct stat fileStat;
+    const ChannelDatabaseHeader* header = NULL;
+    void* mapping = MAP_FAILED;
+    int32_t fileDesc = -1;
+    size_t expectedSize = 0;
+
+    if (view == NULL || path == NULL)
+    {
+        printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+        return CDB_ERROR;
+    }
+
+    memset(view, 0x0, sizeof(ChannelDatabaseView));
+
+    fileDesc = open(path, O_RDONLY);
+    if (fileDesc == -1)
+    {
+        return CDB_ERROR;
+    }
+
+    if (fstat(fileDesc, &fileStat) || fileStat.st_size < (off_t) sizeof(ChannelDatabaseHeader))
+    {
+        printf("\n%s : ERROR %s is not a valid channel database\n", __FUNCTION__, path);
+        close(fileDesc);
+        return CDB_ERROR;
+    }
+
+    mapping = mmap(NULL, fileStat.st_size, PROT_READ, MAP_SHARED, fileDesc, 0);
+    close(fileDesc);
+    if (mapping == MAP_FAILED)
+    {
+        printf("\n%s : ERROR mmap %s (%s)\n", __FUNCTION__, path, strerror(errno));
+        return CDB_ERROR;
+    }
+
+    header = (const ChannelDatabaseHeader*) mapping;
+    expectedSize = header->headerSize + header->multiplexCount * sizeof(ChannelMultiplex) +
+                   header->serviceCount * sizeof(ChannelService);
+
+    if (header->magic != CHANNEL_DATABASE_MAGIC || header->version != CHANNEL_DATABASE_VERSION ||
+        header->headerSize != sizeof(ChannelDatabaseHeader) || expectedSize != (size_t) fileStat.st_size ||
+        header->multiplexCount > CHANNEL_DATABASE_MAX_MULTIPLEXES || header->serviceCount > CHANNEL_DATABASE_MAX_SERVICES)
+    {
+        printf("\n%s : ERROR %s is not a valid channel database\n", __FUNCTION__, path);
+        munmap(mapping, fileStat.st_size);
+        return CDB_ERROR;
+    }
+
+    view->header = header;
+    view->multiplexes = (const ChannelMultiplex*) ((const uint8_t*) mapping + header->headerSize);
+    view->services = (const ChannelService*) (view->multiplexes + header->multiplexCount);
+    view->multiplexCount = header->multiplexCount;
+    view->serviceCount = header->serviceCount;
+    view->mappingSize = fileStat.st_size;
+
+    if (recordsChecksum(view->multiplexes, view->multiplexCount, view->services, view->serviceCount) != header->checksum)
+    {
+        printf("\n%s : ERROR %s checksum mismatch\n", __FUNCTION__, path);
+        channelDatabaseUnmap(view);
+        return CDB_ERROR;
+    }
+
+    return CDB_NO_ERROR;
+}
+
+void channelDatabaseUnmap(ChannelDatabaseView* view)
+{
+    if (view != NULL && view->header != NULL)
+    {
+        munmap((void*) view->header, view->mappingSize);
+        memset(view, 0x0, sizeof(ChannelDatabaseView));
+    }
+}
+
+void channelDatabasePrint(const ChannelDatabase* database)
+{
+    uint16_t i = 0;
+    uint8_t j = 0;
+
+    if (database == NULL)
+    {
+        return;
+    }
+
+    printf("\n********************CHANNEL DATABASE********************\n");
+    for (i = 0; i < database->serviceCount; i++)
+    {
+        const ChannelService* service = &database->services[i];
+
+        printf("%4d | %-24s | %9u Hz | sid %5d | pmt %4d |", service->logicalChannelNumber == CHANNEL_DATABASE_NO_LCN ? -1 : service->logicalChannelNumber,
+               service->name, database->multiplexes[service->multiplexIndex].frequency, service->serviceId, service->pmtPid);
+        for (j = 0; j < service->streamCount; j++)
+        {
+            printf(" %d(0x%.2x)", service->streams[j].pid, service->streams[j].streamType);
+        }
+        printf("\n");
+    }
+    printf("%d services on %d multiplexes\n", database->serviceCount, database->multiplexCount);
+    printf("\n********************CHANNEL DATABASE********************\n");
+}
+
+static uint32_t recordsChecksum(const ChannelMultiplex* multiplexes, uint16_t multiplexCount,
+                                const ChannelService* services, uint16_t serviceCount)
+{
+    /* records are contiguous in the file, in memory they are checked one array at a time */
+    uint32_t multiplexCrc = tsCrc32((const uint8_t*) multiplexes, multiplexCount * sizeof(ChannelMultiplex));
+    uint32_t serviceCrc = tsCrc32((const uint8_t*) services, serviceCount * sizeof(ChannelService));
+
+    return multiplexCrc ^ serviceCrc;
+}
+
+static bool writeAll(int32_t fileDesc, const void* data, size_t size)
+{
+    const uint8_t* position = (const uint8_t*) data;
+    ssize_t written = 0;
+
+    while (size > 0)
+    {
+        written = write(fileDesc, position, size);
+        if (written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (written <= 0)
+        {
+            return false;
+        }
+        position += written;
+        size -= written;
+    }
+
+    return true;
+}
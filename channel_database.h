@@ -0,0 +1,196 @@
+#ifndef __CHANNEL_DATABASE_H__
+#define __CHANNEL_DATABASE_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "tables.h"
+#include "ts_packet.h"
+
+#define CHANNEL_DATABASE_MAX_MULTIPLEXES 64         /* Max number of multiplexes (frequencies) */
+#define CHANNEL_DATABASE_MAX_SERVICES 4096          /* Max number of services over all multiplexes */
+#define CHANNEL_DATABASE_MAX_STREAMS 8              /* Max number of elementary streams stored per service */
+#define CHANNEL_DATABASE_NO_LCN 0xFFFF              /* Service has no logical channel number */
+#define CHANNEL_DATABASE_MAGIC 0x43484442           /* "CHDB" */
+#define CHANNEL_DATABASE_VERSION 2                  /* Format version, files with other version are rejected */
+
+/**
+ * @brief Structure that defines channel database error
+ */
+typedef enum _ChannelDatabaseError
+{
+    CDB_NO_ERROR = 0,
+    CDB_ERROR,
+    CDB_FULL
+}ChannelDatabaseError;
+
+/**
+ * @brief Structure that defines one multiplex
+ */
+typedef struct _ChannelMultiplex
+{
+    uint32_t frequency;                             /* In Hz */
+    uint8_t bandwidth;                              /* In MHz */
+    uint8_t patVersion;
+    uint8_t sdtVersion;
+    uint8_t nitVersion;
+    uint16_t transportStreamId;
+    uint16_t originalNetworkId;
+}ChannelMultiplex;
+
+/**
+ * @brief Structure that defines one elementary stream of a service
+ */
+typedef struct _ChannelStream
+{
+    uint16_t pid;
+    uint8_t streamType;                             /* PMT stream_type */
+    uint8_t reserved;
+}ChannelStream;
+
+/**
+ * @brief Structure that defines one service
+ */
+typedef struct _ChannelService
+{
+    uint16_t multiplexIndex;                        /* Position of multiplex in database */
+    uint16_t serviceId;                             /* program_number */
+    uint16_t pmtPid;
+    uint16_t pcrPid;
+    uint16_t logicalChannelNumber;                  /* CHANNEL_DATABASE_NO_LCN if not signalled */
+    uint8_t serviceType;
+    uint8_t pmtVersion;
+    uint8_t streamCount;
+    uint8_t patIndex;                               /* Position of service in PAT, channel number used by stream controller */
+    uint8_t reserved[2];
+    ChannelStream streams[CHANNEL_DATABASE_MAX_STREAMS];
+    char name[TABLES_MAX_NAME_LENGTH];
+}ChannelService;
+
+/**
+ * @brief Structure that holds whole channel database
+ */
+typedef struct _ChannelDatabase
+{
+    uint32_t generation;                            /* Incremented on every save */
+    ChannelMultiplex multiplexes[CHANNEL_DATABASE_MAX_MULTIPLEXES];
+    uint16_t multiplexCount;
+    ChannelService services[CHANNEL_DATABASE_MAX_SERVICES];
+    uint16_t serviceCount;
+}ChannelDatabase;
+
+/**
+ * @brief Structure that defines header of channel database file
+ *
+ * Header is followed by multiplexCount multiplex records and serviceCount service records.
+ */
+typedef struct _ChannelDatabaseHeader
+{
+    uint32_t magic;                                 /* CHANNEL_DATABASE_MAGIC */
+    uint16_t version;                               /* CHANNEL_DATABASE_VERSION */
+    uint16_t headerSize;
+    uint32_t generation;
+    uint16_t multiplexCount;
+    uint16_t serviceCount;
+    uint32_t checksum;                              /* CRC-32 of multiplex and service records */
+}ChannelDatabaseHeader;
+
+/**
+ * @brief Structure that holds read-only mapping of channel database file
+ */
+typedef struct _ChannelDatabaseView
+{
+    const ChannelDatabaseHeader* header;
+    const ChannelMultiplex* multiplexes;
+    const ChannelService* services;
+    uint16_t multiplexCount;
+    uint16_t serviceCount;
+    size_t mappingSize;
+}ChannelDatabaseView;
+
+/**
+ * @brief Empties channel database
+ *
+ * @param [out] database - channel database
+ */
+void channelDatabaseClear(ChannelDatabase* database);
+
+/**
+ * @brief Adds multiplex to channel database, existing multiplex with same frequency is reused
+ *
+ * @param [in]  database - channel database
+ * @param [in]  multiplex - multiplex to add
+ * @param [out] multiplexIndex - position of multiplex in database
+ * @return channel database error code
+ */
+ChannelDatabaseError channelDatabaseAddMultiplex(ChannelDatabase* database, const ChannelMultiplex* multiplex, uint16_t* multiplexIndex);
+
+/**
+ * @brief Adds service to channel database, existing service with same multiplex and service id is replaced
+ *
+ * @param [in] database - channel database
+ * @param [in] service - service to add
+ * @return channel database error code
+ */
+ChannelDatabaseError channelDatabaseAddService(ChannelDatabase* database, const ChannelService* service);
+
+/**
+ * @brief Sorts services by logical channel number, services without one go last in scan order
+ *
+ * @param [in] database - channel database
+ */
+void channelDatabaseSort(ChannelDatabase* database);
+
+/**
+ * @brief Writes channel database to file
+ *
+ * Database is written to a temporary file which replaces the old one only when complete,
+ * so a power cut leaves either the old or the new database.
+ *
+ * @param [in] database - channel database, generation is incremented
+ * @param [in] path - path of database file
+ * @return channel database error code
+ */
+ChannelDatabaseError channelDatabaseSave(ChannelDatabase* database, const char* path);
+
+/**
+ * @brief Reads channel database from file
+ *
+ * @param [out] database - channel database
+ * @param [in]  path - path of database file
+ * @return channel database error code
+ */
+ChannelDatabaseError channelDatabaseLoad(ChannelDatabase* database, const char* path);
+
+/**
+ * @brief Maps channel database file read-only and checks version and checksum
+ *
+ * @param [out] view - mapped database
+ * @param [in]  path - path of database file
+ * @return channel database error code
+ */
+ChannelDatabaseError channelDatabaseMap(ChannelDatabaseView* view, const char* path);
+
+/**
+ * @brief Unmaps channel database file
+ *
+ * @param [in] view - mapped database
+ */
+void channelDatabaseUnmap(ChannelDatabaseView* view);
+
+/**
+ * @brief Prints channel database
+ *
+ * @param [in] database - channel database
+ */
+void channelDatabasePrint(const ChannelDatabase* database);
+
+#endif /* __CHANNEL_DATABASE_H__ */
@@ -0,0 +1,847 @@
+#include "channel_scan.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/time.h>
+
+/**
+ * @brief Structure that holds SI collected on one multiplex
+ */
+typedef struct _MultiplexScan
+{
+    uint32_t frequency;
+    uint8_t bandwidth;
+    const char* sourcePath;
+    bool locked;
+    bool patReceived;
+    bool sdtReceived;
+    bool nitReceived;
+    PatTable patTable;
+    uint16_t pmtProgramNumbers[CHANNEL_SCAN_MAX_SECTIONS];
+    uint8_t pmtCount;
+    uint8_t pmtExpected;
+    uint8_t sections[CHANNEL_SCAN_MAX_SECTIONS][CHANNEL_SCAN_SECTION_SIZE];
+    uint8_t sectionCount;
+    double lockSeconds;
+    double collectSeconds;
+}MultiplexScan;
+
+/**
+ * @brief Structure that holds state of one multiplex file being scanned
+ */
+typedef struct _FileScanContext
+{
+    MultiplexScan* scan;
+    TsSectionAssembler* patAssembler;
+    TsSectionAssembler* sdtAssembler;
+    TsSectionAssembler* nitAssembler;
+    TsSectionAssembler* pmtAssemblers;
+    uint8_t pmtAssemblerCount;
+}FileScanContext;
+
+typedef bool(*ScanPredicate)(const MultiplexScan* scan, uint16_t argument);
+
+static MultiplexScan* currentScan = NULL;
+static pthread_mutex_t scanMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t scanCond = PTHREAD_COND_INITIALIZER;
+static bool tunerLocked = false;
+static bool networkKnown = false;
+
+/* multiplexes waiting for the merge worker, NULL ends the scan */
+static MultiplexScan* mergeQueue[CHANNEL_SCAN_MAX_FREQUENCIES + 1];
+static uint8_t mergeQueueHead = 0;
+static uint8_t mergeQueueTail = 0;
+static pthread_mutex_t mergeMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t mergeCond = PTHREAD_COND_INITIALIZER;
+static ChannelDatabase* mergeDatabase = NULL;
+
+/* file scan work distribution */
+static char* const* filePaths = NULL;
+static MultiplexScan** fileScans = NULL;
+static uint8_t fileCount = 0;
+static uint8_t nextFile = 0;
+static pthread_mutex_t fileMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void storeSection(MultiplexScan* scan, const uint8_t* section, uint16_t sectionSize);
+static void mergeMultiplex(MultiplexScan* scan, ChannelDatabase* database);
+static int32_t scanSectionCallback(uint8_t* buffer);
+static int32_t scanTunerStatusCallback(t_LockStatus status);
+static bool waitFor(ScanPredicate predicate, uint16_t argument, const struct timespec* deadline);
+static bool isLocked(const MultiplexScan* scan, uint16_t argument);
+static bool isPatReceived(const MultiplexScan* scan, uint16_t argument);
+static bool isPmtReceived(const MultiplexScan* scan, uint16_t programNumber);
+static bool isSdtReceived(const MultiplexScan* scan, uint16_t argument);
+static bool isNitReceived(const MultiplexScan* scan, uint16_t argument);
+static void collectMultiplex(uint32_t playerHandle, MultiplexScan* scan, const struct timespec* lockTime);
+static void* mergeTask();
+static void* fileScanTask();
+static void scanFile(MultiplexScan* scan);
+static void fileSectionCallback(const uint8_t* section, uint16_t sectionSize, void* userData);
+static void deadlineAfter(struct timespec* deadline, uint32_t milliseconds);
+static double secondsSince(const struct timespec* start);
+
+ChannelScanError channelScanFrequencies(const uint32_t* frequencies, uint8_t frequencyCount, uint32_t bandwidth,
+                                        t_Module module, ChannelDatabase* database)
+{
+    struct timespec scanStart;
+    struct timespec lockTime;
+    struct timespec deadline;
+    pthread_t mergeThread;
+    uint32_t playerHandle = 0;
+    uint32_t sourceHandle = 0;
+    uint8_t i = 0;
+
+    if (frequencies == NULL || database == NULL || frequencyCount > CHANNEL_SCAN_MAX_FREQUENCIES)
+    {
+        printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+        return CS_ERROR;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &scanStart);
+
+    if (Tuner_Init())
+    {
+        printf("\n%s : ERROR Tuner_Init() fail\n", __FUNCTION__);
+        return CS_ERROR;
+    }
+
+    if (Tuner_Register_Status_Callback(scanTunerStatusCallback))
+    {
+        printf("\n%s : ERROR Tuner_Register_Status_Callback() fail\n", __FUNCTION__);
+    }
+
+    if (Player_Init(&playerHandle))
+    {
+        printf("\n%s : ERROR Player_Init() fail\n", __FUNCTION__);
+        Tuner_Deinit();
+        return CS_ERROR;
+    }
+
+    if (Player_Source_Open(playerHandle, &sourceHandle))
+    {
+        printf("\n%s : ERROR Player_Source_Open() fail\n", __FUNCTION__);
+        Player_Deinit(playerHandle);
+        Tuner_Deinit();
+        return CS_ERROR;
+    }
+
+    if (Demux_Register_Section_Filter_Callback(scanSectionCallback))
+    {
+        printf("\n%s : ERROR Demux_Register_Section_Filter_Callback() fail\n", __FUNCTION__);
+    }
+
+    mergeDatabase = database;
+    mergeQueueHead = 0;
+    mergeQueueTail = 0;
+    networkKnown = false;
+    if (pthread_create(&mergeThread, NULL, &mergeTask, NULL))
+    {
+        printf("\n%s : ERROR creating merge task!\n", __FUNCTION__);
+        Player_Source_Close(playerHandle, sourceHandle);
+        Player_Deinit(playerHandle);
+        Tuner_Deinit();
+        return CS_THREAD_ERROR;
+    }
+
+    for (i = 0; i < frequencyCount; i++)
+    {
+        struct timespec muxStart;
+        MultiplexScan* scan = (MultiplexScan*) calloc(1, sizeof(MultiplexScan));
+
+        if (scan == NULL)
+        {
+            printf("\n%s : ERROR Cannot allocate memory\n", __FUNCTION__);
+            break;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &muxStart);
+        scan->frequency = frequencies[i];
+        scan->bandwidth = (uint8_t) bandwidth;
+
+        pthread_mutex_lock(&scanMutex);
+        tunerLocked = false;
+        pthread_mutex_unlock(&scanMutex);
+
+        if (Tuner_Lock_To_Frequency(frequencies[i], bandwidth, module))
+        {
+            printf("\n%s : ERROR Tuner_Lock_To_Frequency(): %u Hz - fail!\n", __FUNCTION__, frequencies[i]);
+        }
+        else
+        {
+            deadlineAfter(&deadline, CHANNEL_SCAN_LOCK_TIMEOUT);
+            scan->locked = waitFor(isLocked, 0, &deadline);
+            scan->lockSeconds = secondsSince(&muxStart);
+            clock_gettime(CLOCK_REALTIME, &lockTime);
+
+            if (scan->locked)
+            {
+                collectMultiplex(playerHandle, scan, &lockTime);
+            }
+        }
+
+        scan->collectSeconds = secondsSince(&muxStart);
+
+        /* parsing and merging overlaps with tuning of next frequency */
+        pthread_mutex_lock(&mergeMutex);
+        mergeQueue[mergeQueueTail++] = scan;
+        pthread_cond_signal(&mergeCond);
+        pthread_mutex_unlock(&mergeMutex);
+    }
+
+    pthread_mutex_lock(&mergeMutex);
+    mergeQueue[mergeQueueTail++] = NULL;
+    pthread_cond_signal(&mergeCond);
+    pthread_mutex_unlock(&mergeMutex);
+
+    if (pthread_join(mergeThread, NULL))
+    {
+        printf("\n%s : ERROR pthread_join fail!\n", __FUNCTION__);
+    }
+
+    Player_Source_Close(playerHandle, sourceHandle);
+    Player_Deinit(playerHandle);
+    Tuner_Deinit();
+
+    channelDatabaseSort(database);
+
+    printf("\n%s : INFO scanned %d frequencies in %.3f s, %d services found\n", __FUNCTION__,
+           frequencyCount, secondsSince(&scanStart), database->serviceCount);
+
+    return CS_NO_ERROR;
+}
+
+ChannelScanError channelScanFiles(char* const* paths, uint8_t pathCount, ChannelDatabase* database)
+{
+    struct timespec scanStart;
+    pthread_t scanThreads[CHANNEL_SCAN_MAX_THREADS];
+    uint8_t threadCount = 0;
+    uint8_t i = 0;
+    ChannelScanError result = CS_NO_ERROR;
+
+    if (paths == NULL || database == NULL || pathCount == 0)
+    {
+        printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+        return CS_ERROR;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &scanStart);
+
+    fileScans = (MultiplexScan**) calloc(pathCount, sizeof(MultiplexScan*));
+    if (fileScans == NULL)
+    {
+        printf("\n%s : ERROR Cannot allocate memory\n", __FUNCTION__);
+        return CS_ERROR;
+    }
+
+    filePaths = paths;
+    fileCount = pathCount;
+    nextFile = 0;
+
+    for (i = 0; i < pathCount && i < CHANNEL_SCAN_MAX_THREADS; i++)
+    {
+        if (pthread_create(&scanThreads[threadCount], NULL, &fileScanTask, NULL))
+        {
+            printf("\n%s : ERROR creating file scan task!\n", __FUNCTION__);
+            result = CS_THREAD_ERROR;
+            break;
+        }
+        threadCount++;
+    }
+
+    for (i = 0; i < threadCount; i++)
+    {
+        pthread_join(scanThreads[i], NULL);
+    }
+
+    /* merge in file order so the database does not depend on thread timing */
+    for (i = 0; i < pathCount; i++)
+    {
+        if (fileScans[i] != NULL)
+        {
+            mergeMultiplex(fileScans[i], database);
+            free(fileScans[i]);
+        }
+    }
+    free(fileScans);
+    fileScans = NULL;
+
+    channelDatabaseSort(database);
+
+    printf("\n%s : INFO scanned %d multiplexes on %d threads in %.3f s, %d services found\n", __FUNCTION__,
+           pathCount, threadCount, secondsSince(&scanStart), database->serviceCount);
+
+    return (threadCount > 0) ? result : CS_THREAD_ERROR;
+}
+
+/* keeps raw copies of the first PAT, SDT and NIT section and of one PMT per program */
+static void storeSection(MultiplexScan* scan, const uint8_t* section, uint16_t sectionSize)
+{
+    uint8_t tableId = section[0];
+    uint16_t programNumber = 0;
+    uint8_t i = 0;
+
+    if (sectionSize > CHANNEL_SCAN_SECTION_SIZE || scan->sectionCount >= CHANNEL_SCAN_MAX_SECTIONS)
+    {
+        return;
+    }
+
+    if (tableId == 0x00)
+    {
+        if (scan->patReceived || parsePatTable(section, &scan->patTable) != TABLES_PARSE_OK)
+        {
+            return;
+        }
+
+        scan->pmtExpected = 0;
+        for (i = 0; i < scan->patTable.serviceInfoCount; i++)
+        {
+            if (scan->patTable.patServiceInfoArray[i].programNumber != 0)
+            {
+                scan->pmtExpected++;
+            }
+        }
+        scan->patReceived = true;
+    }
+    else if (tableId == 0x02)
+    {
+        programNumber = (uint16_t) ((section[3] << 8) + section[4]);
+        for (i = 0; i < scan->pmtCount; i++)
+        {
+            if (scan->pmtProgramNumbers[i] == programNumber)
+            {
+                return;
+            }
+        }
+        scan->pmtProgramNumbers[scan->pmtCount++] = programNumber;
+    }
+    else if (tableId == 0x42 && !scan->sdtReceived)
+    {
+        scan->sdtReceived = true;
+    }
+    else if (tableId == 0x40 && !scan->nitReceived)
+    {
+        scan->nitReceived = true;
+    }
+    else
+    {
+        return;
+    }
+
+    memcpy(scan->sections[scan->sectionCount], section, sectionSize);
+    scan->sectionCount++;
+}
+
+static void mergeMultiplex(MultiplexScan* scan, ChannelDatabase* database)
+{
+    PmtTable pmtTables[TABLES_MAX_NUMBER_OF_PIDS_IN_PAT];
+    uint8_t pmtCount = 0;
+    SdtTable sdtTable;
+    NitTable nitTable;
+    bool sdtValid = false;
+    bool nitValid = false;
+    ChannelMultiplex multiplex;
+    uint16_t multiplexIndex = 0;
+    uint16_t servicesAdded = 0;
+    uint8_t i = 0;
+    uint8_t j = 0;
+
+    if (!scan->patReceived)
+    {
+        printf("\n%s : INFO %u Hz %s: no PAT (lock %.3f s, total %.3f s)\n", __FUNCTION__, scan->frequency,
+               scan->sourcePath ? scan->sourcePath : "", scan->lockSeconds, scan->collectSeconds);
+        return;
+    }
+
+    for (i = 0; i < scan->sectionCount; i++)
+    {
+        const uint8_t* section = scan->sections[i];
+
+        if (section[0] == 0x02 && pmtCount < TABLES_MAX_NUMBER_OF_PIDS_IN_PAT &&
+            parsePmtTable(section, &pmtTables[pmtCount]) == TABLES_PARSE_OK)
+        {
+            pmtCount++;
+        }
+        else if (section[0] == 0x42)
+        {
+            sdtValid = (parseSdtTable(section, &sdtTable) == TABLES_PARSE_OK);
+        }
+        else if (section[0] == 0x40)
+        {
+            nitValid = (parseNitTable(section, &nitTable) == TABLES_PARSE_OK);
+        }
+    }
+
+    memset(&multiplex, 0x0, sizeof(ChannelMultiplex));
+    multiplex.frequency = scan->frequency;
+    multiplex.bandwidth = scan->bandwidth;
+    multiplex.transportStreamId = scan->patTable.patHeader.transportStreamId;
+    multiplex.patVersion = scan->patTable.patHeader.versionNumber;
+    if (sdtValid)
+    {
+        multiplex.originalNetworkId = sdtTable.originalNetworkId;
+        multiplex.sdtVersion = sdtTable.versionNumber;
+    }
+    if (nitValid)
+    {
+        multiplex.nitVersion = nitTable.versionNumber;
+        for (i = 0; i < nitTable.transportStreamCount; i++)
+        {
+            /* file sources know their frequency only from NIT */
+            if (nitTable.nitTransportStreamInfoArray[i].transportStreamId == multiplex.transportStreamId && multiplex.frequency == 0)
+            {
+                multiplex.frequency = nitTable.nitTransportStreamInfoArray[i].frequency;
+                multiplex.bandwidth = nitTable.nitTransportStreamInfoArray[i].bandwidth;
+            }
+        }
+    }
+
+    if (channelDatabaseAddMultiplex(database, &multiplex, &multiplexIndex))
+    {
+        return;
+    }
+
+    for (i = 0; i < scan->patTable.serviceInfoCount; i++)
+    {
+        const PatServiceInfo* patService = &scan->patTable.patServiceInfoArray[i];
+        ChannelService service;
+
+        /* program number 0 carries NIT pid */
+        if (patService->programNumber == 0)
+        {
+            continue;
+        }
+
+        memset(&service, 0x0, sizeof(ChannelService));
+        service.multiplexIndex = multiplexIndex;
+        service.serviceId = patService->programNumber;
+        service.pmtPid = patService->pid;
+        service.patIndex = i;
+        service.logicalChannelNumber = CHANNEL_DATABASE_NO_LCN;
+        snprintf(service.name, TABLES_MAX_NAME_LENGTH, "Service %d", service.serviceId);
+
+        for (j = 0; j < pmtCount; j++)
+        {
+            if (pmtTables[j].pmtHeader.programNumber == service.serviceId)
+            {
+                uint8_t k = 0;
+
+                service.pcrPid = pmtTables[j].pmtHeader.pcrPid;
+                service.pmtVersion = pmtTables[j].pmtHeader.versionNumber;
+                for (k = 0; k < pmtTables[j].elementaryInfoCount && k < CHANNEL_DATABASE_MAX_STREAMS; k++)
+                {
+                    service.streams[k].pid = pmtTables[j].pmtElementaryInfoArray[k].elementaryPid;
+                    service.streams[k].streamType = pmtTables[j].pmtElementaryInfoArray[k].streamType;
+                }
+                service.streamCount = k;
+                break;
+            }
+        }
+
+        if (sdtValid)
+        {
+            for (j = 0; j < sdtTable.serviceInfoCount; j++)
+            {
+                if (sdtTable.sdtServiceInfoArray[j].serviceId == service.serviceId)
+                {
+                    service.serviceType = sdtTable.sdtServiceInfoArray[j].serviceType;
+                    if (sdtTable.sdtServiceInfoArray[j].serviceName[0] != '\0')
+                    {
+                        strcpy(service.name, sdtTable.sdtServiceInfoArray[j].serviceName);
+                    }
+                    break;
+                }
+            }
+        }
+
+        if (nitValid)
+        {
+            for (j = 0; j < nitTable.logicalChannelCount; j++)
+            {
+                if (nitTable.nitLogicalChannelArray[j].serviceId == service.serviceId &&
+                    nitTable.nitLogicalChannelArray[j].transportStreamId == multiplex.transportStreamId)
+                {
+                    service.logicalChannelNumber = nitTable.nitLogicalChannelArray[j].logicalChannelNumber;
+                    break;
+                }
+            }
+        }
+
+        if (channelDatabaseAddService(database, &service) == CDB_NO_ERROR)
+        {
+            servicesAdded++;
+        }
+    }
+
+    printf("\n%s : INFO %u Hz %s: %d services, lock %.3f s, total %.3f s\n", __FUNCTION__, multiplex.frequency,
+           scan->sourcePath ? scan->sourcePath : "", servicesAdded, scan->lockSeconds, scan->collectSeconds);
+}
+
+/* sets filters while locked to a multiplex and waits for its tables */
+static void collectMultiplex(uint32_t playerHandle, MultiplexScan* scan, const struct timespec* lockTime)
+{
+    struct timespec psiDeadline;
+    struct timespec nitDeadline;
+    struct timespec deadline;
+    uint32_t patFilter = 0;
+    uint32_t sdtFilter = 0;
+    uint32_t nitFilter = 0;
+    bool patFilterSet = false;
+    bool sdtFilterSet = false;
+    bool nitFilterSet = false;
+    uint8_t i = 0;
+
+    pthread_mutex_lock(&scanMutex);
+    currentScan = scan;
+    pthread_mutex_unlock(&scanMutex);
+
+    psiDeadline = *lockTime;
+    psiDeadline.tv_sec += CHANNEL_SCAN_PSI_TIMEOUT / 1000;
+    nitDeadline = *lockTime;
+    nitDeadline.tv_sec += CHANNEL_SCAN_NIT_TIMEOUT / 1000;
+
+    /* PAT, SDT and NIT are collected at the same time */
+    patFilterSet = !Demux_Set_Filter(playerHandle, 0x0000, 0x00, &patFilter);
+    sdtFilterSet = !Demux_Set_Filter(playerHandle, 0x0011, 0x42, &sdtFilter);
+    nitFilterSet = !Demux_Set_Filter(playerHandle, 0x0010, 0x40, &nitFilter);
+
+    if (patFilterSet && waitFor(isPatReceived, 0, &psiDeadline))
+    {
+        Demux_Free_Filter(playerHandle, patFilter);
+        patFilterSet = false;
+
+        for (i = 0; i < scan->patTable.serviceInfoCount; i++)
+        {
+            uint32_t pmtFilter = 0;
+            const PatServiceInfo* patService = &scan->patTable.patServiceInfoArray[i];
+
+            if (patService->programNumber == 0)
+            {
+                continue;
+            }
+
+            if (Demux_Set_Filter(playerHandle, patService->pid, 0x02, &pmtFilter))
+            {
+                printf("\n%s : ERROR Demux_Set_Filter() fail\n", __FUNCTION__);
+                continue;
+            }
+
+            deadlineAfter(&deadline, CHANNEL_SCAN_PSI_TIMEOUT);
+            waitFor(isPmtReceived, patService->programNumber, &deadline);
+            Demux_Free_Filter(playerHandle, pmtFilter);
+        }
+    }
+
+    if (sdtFilterSet)
+    {
+        deadlineAfter(&deadline, CHANNEL_SCAN_PSI_TIMEOUT);
+        waitFor(isSdtReceived, 0, &deadline);
+    }
+
+    /* NIT actual describes the whole network, waiting for it once is enough */
+    if (nitFilterSet && !networkKnown)
+    {
+        networkKnown = waitFor(isNitReceived, 0, &nitDeadline);
+    }
+
+    pthread_mutex_lock(&scanMutex);
+    currentScan = NULL;
+    pthread_mutex_unlock(&scanMutex);
+
+    if (patFilterSet)
+    {
+        Demux_Free_Filter(playerHandle, patFilter);
+    }
+    if (sdtFilterSet)
+    {
+        Demux_Free_Filter(playerHandle, sdtFilter);
+    }
+    if (nitFilterSet)
+    {
+        Demux_Free_Filter(playerHandle, nitFilter);
+    }
+}
+
+static int32_t scanSectionCallback(uint8_t* buffer)
+{
+    uint16_t sectionSize = 3 + ((((*(buffer + 1)) << 8) + (*(buffer + 2))) & 0x0FFF);
+
+    pthread_mutex_lock(&scanMutex);
+    if (currentScan != NULL)
+    {
+        storeSection(currentScan, buffer, sectionSize);
+        pthread_cond_broadcast(&scanCond);
+    }
+    pthread_mutex_unlock(&scanMutex);
+
+    return 0;
+}
+
+static int32_t scanTunerStatusCallback(t_LockStatus status)
+{
+    pthread_mutex_lock(&scanMutex);
+    tunerLocked = (status == STATUS_LOCKED);
+    pthread_cond_broadcast(&scanCond);
+    pthread_mutex_unlock(&scanMutex);
+
+    return 0;
+}
+
+static bool waitFor(ScanPredicate predicate, uint16_t argument, const struct timespec* deadline)
+{
+    bool result = false;
+
+    pthread_mutex_lock(&scanMutex);
+    while (!(result = predicate(currentScan, argument)))
+    {
+        if (pthread_cond_timedwait(&scanCond, &scanMutex, deadline) == ETIMEDOUT)
+        {
+            result = predicate(currentScan, argument);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&scanMutex);
+
+    return result;
+}
+
+static bool isLocked(const MultiplexScan* scan, uint16_t argument)
+{
+    return tunerLocked;
+}
+
+static bool isPatReceived(const MultiplexScan* scan, uint16_t argument)
+{
+    return scan != NULL && scan->patReceived;
+}
+
+static bool isPmtReceived(const MultiplexScan* scan, uint16_t programNumber)
+{
+    uint8_t i = 0;
+
+    for (i = 0; scan != NULL && i < scan->pmtCount; i++)
+    {
+        if (scan->pmtProgramNumbers[i] == programNumber)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool isSdtReceived(const MultiplexScan* scan, uint16_t argument)
+{
+    return scan != NULL && scan->sdtReceived;
+}
+
+static bool isNitReceived(const MultiplexScan* scan, uint16_t argument)
+{
+    return scan != NULL && scan->nitReceived;
+}
+
+static void* mergeTask()
+{
+    MultiplexScan* scan = NULL;
+
+    while (1)
+    {
+        pthread_mutex_lock(&mergeMutex);
+        while (mergeQueueHead == mergeQueueTail)
+        {
+            pthread_cond_wait(&mergeCond, &mergeMutex);
+        }
+        scan = mergeQueue[mergeQueueHead++];
+        pthread_mutex_unlock(&mergeMutex);
+
+        if (scan == NULL)
+        {
+            break;
+        }
+
+        mergeMultiplex(scan, mergeDatabase);
+        free(scan);
+    }
+
+    return NULL;
+}
+
+static void* fileScanTask()
+{
+    while (1)
+    {
+        uint8_t fileIndex = 0;
+        MultiplexScan* scan = NULL;
+        struct timespec muxStart;
+
+        pthread_mutex_lock(&fileMutex);
+        if (nextFile >= fileCount)
+        {
+            pthread_mutex_unlock(&fileMutex);
+            break;
+        }
+        fileIndex = nextFile++;
+        pthread_mutex_unlock(&fileMutex);
+
+        scan = (MultiplexScan*) calloc(1, sizeof(MultiplexScan));
+        if (scan == NULL)
+        {
+            printf("\n%s : ERROR Cannot allocate memory\n", __FUNCTION__);
+            continue;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &muxStart);
+        scan->sourcePath = filePaths[fileIndex];
+        scan->locked = true;
+        scanFile(scan);
+        scan->collectSeconds = secondsSince(&muxStart);
+
+        fileScans[fileIndex] = scan;
+    }
+
+    return NULL;
+}
+
+/* file stand-in for one multiplex: sections are reassembled from packets instead of demux filters */
+static void scanFile(MultiplexScan* scan)
+{
+    static const uint32_t readSize = 5577 * TS_PACKET_SIZE;
+    FileScanContext context;
+    uint8_t* readBuffer = NULL;
+    int32_t fileDesc = -1;
+    ssize_t bytesRead = 0;
+    size_t bufferFill = 0;
+    uint64_t totalBytes = 0;
+    bool complete = false;
+
+    memset(&context, 0x0, sizeof(FileScanContext));
+    context.scan = scan;
+
+    fileDesc = open(scan->sourcePath, O_RDONLY);
+    if (fileDesc == -1)
+    {
+        printf("\n%s : ERROR opening %s (%s)\n", __FUNCTION__, scan->sourcePath, strerror(errno));
+        return;
+    }
+
+    readBuffer = (uint8_t*) malloc(readSize);
+    context.patAssembler = (TsSectionAssembler*) malloc(sizeof(TsSectionAssembler));
+    context.sdtAssembler = (TsSectionAssembler*) malloc(sizeof(TsSectionAssembler));
+    context.nitAssembler = (TsSectionAssembler*) malloc(sizeof(TsSectionAssembler));
+    context.pmtAssemblers = (TsSectionAssembler*) malloc(TABLES_MAX_NUMBER_OF_PIDS_IN_PAT * sizeof(TsSectionAssembler));
+    if (readBuffer == NULL || context.patAssembler == NULL || context.sdtAssembler == NULL ||
+        context.nitAssembler == NULL || context.pmtAssemblers == NULL)
+    {
+        printf("\n%s : ERROR Cannot allocate memory\n", __FUNCTION__);
+        complete = true;
+    }
+    else
+    {
+        tsSectionAssemblerInit(context.patAssembler, 0x0000);
+        tsSectionAssemblerInit(context.sdtAssembler, 0x0011);
+        tsSectionAssemblerInit(context.nitAssembler, 0x0010);
+    }
+
+    while (!complete && totalBytes < CHANNEL_SCAN_MAX_FILE_BYTES &&
+           (bytesRead = read(fileDesc, readBuffer + bufferFill, readSize - bufferFill)) > 0)
+    {
+        size_t packetBytes = 0;
+        size_t position = 0;
+
+        bufferFill += bytesRead;
+        totalBytes += bytesRead;
+        packetBytes = bufferFill - (bufferFill % TS_PACKET_SIZE);
+
+        for (position = 0; position < packetBytes && !complete; position += TS_PACKET_SIZE)
+        {
+            const uint8_t* packet = readBuffer + position;
+            uint16_t pid = 0;
+            uint8_t i = 0;
+
+            if (*packet != TS_SYNC_BYTE)
+            {
+                continue;
+            }
+
+            pid = tsPacketGetPid(packet);
+            if (pid == 0x0000 && !scan->patReceived)
+            {
+                tsSectionAssemblerPush(context.patAssembler, packet, fileSectionCallback, &context);
+            }
+            else if (pid == 0x0011 && !scan->sdtReceived)
+            {
+                tsSectionAssemblerPush(context.sdtAssembler, packet, fileSectionCallback, &context);
+            }
+            else if (pid == 0x0010 && !scan->nitReceived)
+            {
+                tsSectionAssemblerPush(context.nitAssembler, packet, fileSectionCallback, &context);
+            }
+            else
+            {
+                for (i = 0; i < context.pmtAssemblerCount; i++)
+                {
+                    if (context.pmtAssemblers[i].pid == pid)
+                    {
+                        tsSectionAssemblerPush(&context.pmtAssemblers[i], packet, fileSectionCallback, &context);
+                        break;
+                    }
+                }
+            }
+
+            complete = scan->patReceived && scan->pmtCount >= scan->pmtExpected && scan->sdtReceived && scan->nitReceived;
+        }
+
+        memmove(readBuffer, readBuffer + packetBytes, bufferFill - packetBytes);
+        bufferFill -= packetBytes;
+    }
+
+    free(readBuffer);
+    free(context.patAssembler);
+    free(context.sdtAssembler);
+    free(context.nitAssembler);
+    free(context.pmtAssemblers);
+    close(fileDesc);
+}
+
+static void fileSectionCallback(const uint8_t* section, uint16_t sectionSize, void* userData)
+{
+    FileScanContext* context = (FileScanContext*) userData;
+    MultiplexScan* scan = context->scan;
+    bool patWasReceived = scan->patReceived;
+    uint8_t i = 0;
+
+    storeSection(scan, section, sectionSize);
+
+    /* PMT pids become known with PAT */
+    if (!patWasReceived && scan->patReceived)
+    {
+        for (i = 0; i < scan->patTable.serviceInfoCount && context->pmtAssemblerCount < TABLES_MAX_NUMBER_OF_PIDS_IN_PAT; i++)
+        {
+            if (scan->patTable.patServiceInfoArray[i].programNumber != 0)
+            {
+                tsSectionAssemblerInit(&context->pmtAssemblers[context->pmtAssemblerCount], scan->patTable.patServiceInfoArray[i].pid);
+                context->pmtAssemblerCount++;
+            }
+        }
+    }
+}
+
+static void deadlineAfter(struct timespec* deadline, uint32_t milliseconds)
+{
+    clock_gettime(CLOCK_REALTIME, deadline);
+    deadline->tv_sec += milliseconds / 1000;
+    deadline->tv_nsec += (milliseconds % 1000) * 1000000L;
+    if (deadline->tv_nsec >= 1000000000L)
+    {
+        deadline->tv_sec++;
+        deadline->tv_nsec -= 1000000000L;
+    }
+}
+
+static double secondsSince(const struct timespec* start)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
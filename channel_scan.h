@@ -0,0 +1,60 @@
+#ifndef __CHANNEL_SCAN_H__
+#define __CHANNEL_SCAN_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "pthread.h"
+#include "tdp_api.h"
+#include "tables.h"
+#include "ts_packet.h"
+#include "channel_database.h"
+
+#define CHANNEL_SCAN_MAX_FREQUENCIES 64             /* Max number of frequencies in one scan */
+#define CHANNEL_SCAN_MAX_THREADS 4                  /* Max number of multiplexes scanned in parallel from files */
+#define CHANNEL_SCAN_LOCK_TIMEOUT 3000              /* Tuner lock timeout in ms */
+#define CHANNEL_SCAN_PSI_TIMEOUT 2000               /* PAT, PMT and SDT timeout in ms */
+#define CHANNEL_SCAN_NIT_TIMEOUT 10000              /* NIT timeout in ms, NIT repeats at most every 10 s */
+#define CHANNEL_SCAN_MAX_FILE_BYTES (64 * 1024 * 1024) /* Bytes of a multiplex file searched for tables */
+#define CHANNEL_SCAN_SECTION_SIZE 1024              /* Max size of PSI/SI section */
+#define CHANNEL_SCAN_MAX_SECTIONS (TABLES_MAX_NUMBER_OF_PIDS_IN_PAT + 3) /* PAT, PMTs, SDT and NIT */
+
+/**
+ * @brief Structure that defines channel scan error
+ */
+typedef enum _ChannelScanError
+{
+    CS_NO_ERROR = 0,
+    CS_ERROR,
+    CS_THREAD_ERROR
+}ChannelScanError;
+
+/**
+ * @brief Scans list of frequencies with the tuner and collects services into channel database
+ *
+ * SI of a multiplex is parsed and merged on a worker thread while the tuner locks to the next frequency.
+ *
+ * @param [in]  frequencies - frequencies in Hz
+ * @param [in]  frequencyCount - number of frequencies
+ * @param [in]  bandwidth - bandwidth in MHz
+ * @param [in]  module - DTV standard
+ * @param [out] database - channel database receiving found services
+ * @return channel scan error code
+ */
+ChannelScanError channelScanFrequencies(const uint32_t* frequencies, uint8_t frequencyCount, uint32_t bandwidth,
+                                        t_Module module, ChannelDatabase* database);
+
+/**
+ * @brief Scans multiplexes recorded to transport stream files, files are scanned in parallel
+ *
+ * @param [in]  paths - paths of transport stream files, one multiplex per file
+ * @param [in]  pathCount - number of files
+ * @param [out] database - channel database receiving found services
+ * @return channel scan error code
+ */
+ChannelScanError channelScanFiles(char* const* paths, uint8_t pathCount, ChannelDatabase* database);
+
+#endif /* __CHANNEL_SCAN_H__ */
@@ -0,0 +1,249 @@
+#include "epg.h"
+
+static bool storeEvent(EpgService* service, const EitEventInfo* eventInfo, EpgChange* change);
+static void removeEvents(EpgService* service, uint16_t first, uint16_t count, EpgChange* change);
+static void extendChange(EpgChange* change, uint32_t start, uint32_t end);
+
+void epgClear(Epg* epg)
+{
+    if (epg != NULL)
+    {
+        epg->serviceCount = 0;
+    }
+}
+
+int32_t epgFindService(const Epg* epg, uint16_t transportStreamId, uint16_t serviceId)
+{
+    uint16_t i = 0;
+
+    for (i = 0; i < epg->serviceCount; i++)
+    {
+        if (epg->services[i].transportStreamId == transportStreamId && epg->services[i].serviceId == serviceId)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+EpgError epgAddService(Epg* epg, uint16_t transportStreamId, uint16_t serviceId, uint16_t number, const char* name, int32_t* row)
+{
+    EpgService* service = NULL;
+    uint16_t position = 0;
+
+    if (epg == NULL || name == NULL || row == NULL)
+    {
+        printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+        return EPG_ERROR;
+    }
+
+    *row = epgFindService(epg, transportStreamId, serviceId);
+    if (*row >= 0)
+    {
+        return EPG_NO_ERROR;
+    }
+
+    if (epg->serviceCount >= EPG_MAX_SERVICES)
+    {
+        return EPG_FULL;
+    }
+
+    while (position < epg->serviceCount && epg->services[position].number <= number)
+    {
+        position++;
+    }
+    memmove(&epg->services[position + 1], &epg->services[position], (epg->serviceCount - position) * sizeof(EpgService));
+    epg->serviceCount++;
+
+    service = &epg->services[position];
+    service->transportStreamId = transportStreamId;
+    service->serviceId = serviceId;
+    service->number = number;
+    snprintf(service->name, sizeof(service->name), "%s", name);
+    service->eventCount = 0;
+    *row = position;
+
+    return EPG_NO_ERROR;
+}
+
+EpgError epgStoreEvents(Epg* epg, int32_t row, const EitTable* eitTable, EpgChange* change)
+{
+    EpgError result = EPG_NO_ERROR;
+    uint8_t i = 0;
+
+    if (epg == NULL || eitTable == NULL || change == NULL || row < 0 || row >= epg->serviceCount)
+    {
+        printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+        return EPG_ERROR;
+    }
+
+    change->changed = false;
+    for (i = 0; i < eitTable->eventInfoCount; i++)
+    {
+        if (!storeEvent(&epg->services[row], &eitTable->eitEventInfoArray[i], change))
+        {
+            result = EPG_FULL;
+        }
+    }
+
+    return result;
+}
+
+int32_t epgFindEvent(const Epg* epg, int32_t row, uint32_t time)
+{
+    const EpgService* service = &epg->services[row];
+    uint16_t position = epgFirstEventAfter(epg, row, time);
+
+    if (position < service->eventCount && service->events[position].start <= time)
+    {
+        return position;
+    }
+
+    return -1;
+}
+
+uint16_t epgFirstEventAfter(const Epg* epg, int32_t row, uint32_t time)
+{
+    const EpgService* service = &epg->services[row];
+    uint16_t low = 0;
+    uint16_t high = service->eventCount;
+    uint16_t middle = 0;
+
+    /* events do not overlap, so their ends are sorted as well */
+    while (low < high)
+    {
+        middle = (low + high) / 2;
+        if (service->events[middle].start + service->events[middle].duration <= time)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+bool storeEvent(EpgService* service, const EitEventInfo* eventInfo, EpgChange* change)
+{
+    EpgEvent* event = NULL;
+    uint32_t end = eventInfo->startTime + eventInfo->duration;
+    uint16_t first = 0;
+    uint16_t last = 0;
+    uint16_t i = 0;
+
+    if (eventInfo->duration == 0)
+    {
+        return true;
+    }
+
+    /* first stored event that ends after new one starts, it and the following ones up to new end overlap it */
+    first = 0;
+    last = service->eventCount;
+    while (first < last)
+    {
+        i = (first + last) / 2;
+        if (service->events[i].start + service->events[i].duration <= eventInfo->startTime)
+        {
+            first = i + 1;
+        }
+        else
+        {
+            last = i;
+        }
+    }
+    last = first;
+    while (last < service->eventCount && service->events[last].start < end)
+    {
+        last++;
+    }
+
+    /* sections repeat all the time, an event stored as is changes nothing */
+    if (last == first + 1)
+    {
+        event = &service->events[first];
+        if (event->start == eventInfo->startTime && event->duration == eventInfo->duration &&
+            event->eventId == eventInfo->eventId && strcmp(event->name, eventInfo->eventName) == 0)
+        {
+            return true;
+        }
+    }
+
+    removeEvents(service, first, last - first, change);
+
+    /* an event that moved is found under its id at its old time */
+    for (i = 0; i < service->eventCount; i++)
+    {
+        if (service->events[i].eventId == eventInfo->eventId)
+        {
+            if (i < first)
+            {
+                first--;
+            }
+            removeEvents(service, i, 1, change);
+            break;
+        }
+    }
+
+    if (service->eventCount >= EPG_MAX_EVENTS)
+    {
+        /* latest events are the least needed ones */
+        if (first >= service->eventCount)
+        {
+            return false;
+        }
+        removeEvents(service, service->eventCount - 1, 1, change);
+    }
+
+    memmove(&service->events[first + 1], &service->events[first], (service->eventCount - first) * sizeof(EpgEvent));
+    service->eventCount++;
+
+    event = &service->events[first];
+    event->start = eventInfo->startTime;
+    event->duration = eventInfo->duration;
+    event->eventId = eventInfo->eventId;
+    memcpy(event->name, eventInfo->eventName, sizeof(event->name));
+    extendChange(change, event->start, end);
+
+    return true;
+}
+
+void removeEvents(EpgService* service, uint16_t first, uint16_t count, EpgChange* change)
+{
+    uint16_t i = 0;
+
+    if (count == 0)
+    {
+        return;
+    }
+
+    for (i = first; i < first + count; i++)
+    {
+        extendChange(change, service->events[i].start, service->events[i].start + service->events[i].duration);
+    }
+    memmove(&service->events[first], &service->events[first + count], (service->eventCount - first - count) * sizeof(EpgEvent));
+    service->eventCount -= count;
+}
+
+void extendChange(EpgChange* change, uint32_t start, uint32_t end)
+{
+    if (!change->changed)
+    {
+        change->changed = true;
+        change->start = start;
+        change->end = end;
+        return;
+    }
+
+    if (start < change->start)
+    {
+        change->start = start;
+    }
+    if (end > change->end)
+    {
+        change->end = end;
+    }
+}
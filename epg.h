@@ -0,0 +1,130 @@
+#ifndef __EPG_H__
+#define __EPG_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "tables.h"
+
+#define EPG_MAX_SERVICES 32                         /* Services with a schedule, EIT is received for tuned multiplex only */
+#define EPG_MAX_EVENTS 512                          /* Events kept per service, seven days of 20 minute programmes */
+
+/**
+ * @brief Structure that defines EPG error
+ */
+typedef enum _EpgError
+{
+    EPG_NO_ERROR = 0,
+    EPG_ERROR,
+    EPG_FULL
+}EpgError;
+
+/**
+ * @brief Structure that defines one scheduled event
+ */
+typedef struct _EpgEvent
+{
+    uint32_t start;                                 /* UTC, seconds since 1970 */
+    uint32_t duration;                              /* In seconds */
+    uint16_t eventId;
+    char name[TABLES_MAX_NAME_LENGTH];
+}EpgEvent;
+
+/**
+ * @brief Structure that holds schedule of one service
+ */
+typedef struct _EpgService
+{
+    uint16_t transportStreamId;
+    uint16_t serviceId;
+    uint16_t number;                                /* Channel number, services are kept in its order */
+    char name[TABLES_MAX_NAME_LENGTH];
+    EpgEvent events[EPG_MAX_EVENTS];                /* Sorted by start, never overlapping */
+    uint16_t eventCount;
+}EpgService;
+
+/**
+ * @brief Structure that holds schedules of all services, one service per row of EPG grid
+ */
+typedef struct _Epg
+{
+    EpgService services[EPG_MAX_SERVICES];
+    uint16_t serviceCount;
+}Epg;
+
+/**
+ * @brief Structure that reports time span of a row whose events changed
+ */
+typedef struct _EpgChange
+{
+    bool changed;
+    uint32_t start;                                 /* UTC, seconds since 1970 */
+    uint32_t end;
+}EpgChange;
+
+/**
+ * @brief Empties EPG
+ *
+ * @param [out] epg - EPG
+ */
+void epgClear(Epg* epg);
+
+/**
+ * @brief Finds row of a service
+ *
+ * @param [in] epg - EPG
+ * @param [in] transportStreamId - transport_stream_id of EIT
+ * @param [in] serviceId - service_id of EIT
+ * @return row, -1 if service has no row yet
+ */
+int32_t epgFindService(const Epg* epg, uint16_t transportStreamId, uint16_t serviceId);
+
+/**
+ * @brief Adds row for a service, rows below it move down by one
+ *
+ * @param [in]  epg - EPG
+ * @param [in]  transportStreamId - transport_stream_id of EIT
+ * @param [in]  serviceId - service_id of EIT
+ * @param [in]  number - channel number, rows are ordered by it
+ * @param [in]  name - service name shown in front of the row
+ * @param [out] row - row of added service
+ * @return EPG error code, EPG_FULL if there is no free row
+ */
+EpgError epgAddService(Epg* epg, uint16_t transportStreamId, uint16_t serviceId, uint16_t number, const char* name, int32_t* row);
+
+/**
+ * @brief Stores events of an EIT section, events they overlap are replaced
+ *
+ * Events that are stored already with same time and name leave the row unchanged, so repeated
+ * sections cause no change.
+ *
+ * @param [in]  epg - EPG
+ * @param [in]  row - row of service the section belongs to
+ * @param [in]  eitTable - parsed EIT section
+ * @param [out] change - span of row whose events changed
+ * @return EPG error code, EPG_FULL if some events did not fit
+ */
+EpgError epgStoreEvents(Epg* epg, int32_t row, const EitTable* eitTable, EpgChange* change);
+
+/**
+ * @brief Finds event running at given time
+ *
+ * @param [in] epg - EPG
+ * @param [in] row - row of service
+ * @param [in] time - UTC, seconds since 1970
+ * @return position of event in row, -1 if nothing is scheduled at that time
+ */
+int32_t epgFindEvent(const Epg* epg, int32_t row, uint32_t time);
+
+/**
+ * @brief Finds first event that ends after given time
+ *
+ * @param [in] epg - EPG
+ * @param [in] row - row of service
+ * @param [in] time - UTC, seconds since 1970
+ * @return position of event in row, eventCount if every event ended before
+ */
+uint16_t epgFirstEventAfter(const Epg* epg, int32_t row, uint32_t time);
+
+#endif /* __EPG_H__ */
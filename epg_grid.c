@@ -0,0 +1,272 @@
+#include "epg_grid.h"
+
+#define EPG_GRID_GAP 3                              /* Pixels between rows and in front of every event */
+#define EPG_GRID_TEXT_MARGIN 8
+#define EPG_GRID_GAP_COLOR 0xEF404048               /* ARGB, grid lines and time with nothing scheduled */
+#define EPG_GRID_EVENT_COLOR 0xEFE091D7
+#define EPG_GRID_CURSOR_COLOR 0xEF9050C0
+#define EPG_GRID_TEXT_COLOR 0xFF000000
+
+static EpgTile* findTile(EpgGrid* grid, int32_t row, int32_t slot);
+static EpgTile* recycleTile(EpgGrid* grid);
+static void renderTile(EpgGrid* grid, const Epg* epg, EpgTile* tile, int32_t row, int32_t slot);
+static int32_t timeToPixel(uint32_t time, uint32_t slotStart);
+
+EpgGridError epgGridInit(EpgGrid* grid, const OsdBackend* backend, OsdFont* font)
+{
+    int32_t ascender = 0;
+    uint8_t i = 0;
+
+    if (grid == NULL || backend == NULL || font == NULL)
+    {
+        printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+        return EPG_GRID_ERROR;
+    }
+
+    memset(grid, 0x0, sizeof(EpgGrid));
+    grid->backend = backend;
+    grid->font = font;
+    grid->cursorRow = -1;
+    backend->getFontMetrics(font, &grid->fontHeight, &ascender);
+
+    for (i = 0; i < EPG_GRID_TILE_COUNT; i++)
+    {
+        grid->tiles[i].row = -1;
+        grid->tiles[i].surface = backend->createSurface(EPG_GRID_TILE_WIDTH, EPG_GRID_TILE_HEIGHT);
+        if (grid->tiles[i].surface == NULL)
+        {
+            printf("\n%s : ERROR cannot create tile surface\n", __FUNCTION__);
+            epgGridDeinit(grid);
+            return EPG_GRID_ERROR;
+        }
+    }
+
+    return EPG_GRID_NO_ERROR;
+}
+
+void epgGridDeinit(EpgGrid* grid)
+{
+    uint8_t i = 0;
+
+    for (i = 0; i < EPG_GRID_TILE_COUNT; i++)
+    {
+        if (grid->tiles[i].surface != NULL)
+        {
+            grid->backend->releaseSurface(grid->tiles[i].surface);
+            grid->tiles[i].surface = NULL;
+        }
+    }
+}
+
+void epgGridInvalidate(EpgGrid* grid, int32_t row, uint32_t start, uint32_t end)
+{
+    int32_t firstSlot = start / EPG_GRID_SLOT_SECONDS;
+    int32_t lastSlot = (end - 1) / EPG_GRID_SLOT_SECONDS;
+    uint8_t i = 0;
+
+    for (i = 0; i < EPG_GRID_TILE_COUNT; i++)
+    {
+        if (grid->tiles[i].valid && (row == EPG_GRID_ALL_ROWS || grid->tiles[i].row == row) &&
+            grid->tiles[i].slot >= firstSlot && grid->tiles[i].slot <= lastSlot)
+        {
+            grid->tiles[i].valid = false;
+            grid->stats.invalidatedCount++;
+        }
+    }
+}
+
+void epgGridInvalidateRows(EpgGrid* grid, int32_t firstRow)
+{
+    uint8_t i = 0;
+
+    for (i = 0; i < EPG_GRID_TILE_COUNT; i++)
+    {
+        if (grid->tiles[i].valid && grid->tiles[i].row >= firstRow)
+        {
+            grid->tiles[i].valid = false;
+            grid->stats.invalidatedCount++;
+        }
+    }
+}
+
+void epgGridDraw(EpgGrid* grid, const Epg* epg, OsdSurface* destination, int32_t x, int32_t y,
+                 int32_t topRow, int32_t leftSlot, int32_t cursorRow, uint32_t cursorTime)
+{
+    EpgTile* tile = NULL;
+    uint32_t cursorStart = 0;
+    uint32_t cursorEnd = 0;
+    int32_t row = 0;
+    int32_t slot = 0;
+
+    grid->frame++;
+
+    /* cursor is drawn into tiles, only tiles it leaves and enters are rendered again */
+    epgGridCursorSpan(epg, cursorRow, cursorTime, &cursorStart, &cursorEnd);
+    if (cursorRow != grid->cursorRow || cursorStart != grid->cursorStart || cursorEnd != grid->cursorEnd)
+    {
+        if (grid->cursorRow >= 0)
+        {
+            epgGridInvalidate(grid, grid->cursorRow, grid->cursorStart, grid->cursorEnd);
+        }
+        epgGridInvalidate(grid, cursorRow, cursorStart, cursorEnd);
+        grid->cursorRow = cursorRow;
+        grid->cursorStart = cursorStart;
+        grid->cursorEnd = cursorEnd;
+    }
+
+    for (row = topRow; row < topRow + EPG_GRID_ROWS && row < epg->serviceCount; row++)
+    {
+        for (slot = leftSlot; slot < leftSlot + EPG_GRID_SLOTS; slot++)
+        {
+            /* after a scroll by one row or slot, every tile but the new edge is found here */
+            tile = findTile(grid, row, slot);
+            if (tile == NULL)
+            {
+                tile = recycleTile(grid);
+                renderTile(grid, epg, tile, row, slot);
+                grid->stats.tileRenderCount++;
+            }
+            else
+            {
+                grid->stats.tileReuseCount++;
+            }
+            tile->lastUse = grid->frame;
+
+            grid->backend->blit(destination, tile->surface, x + (slot - leftSlot) * EPG_GRID_TILE_WIDTH,
+                                y + (row - topRow) * EPG_GRID_TILE_HEIGHT, false);
+        }
+    }
+}
+
+void epgGridCursorSpan(const Epg* epg, int32_t row, uint32_t time, uint32_t* start, uint32_t* end)
+{
+    int32_t position = -1;
+
+    if (row >= 0 && row < epg->serviceCount)
+    {
+        position = epgFindEvent(epg, row, time);
+    }
+
+    if (position >= 0)
+    {
+        *start = epg->services[row].events[position].start;
+        *end = *start + epg->services[row].events[position].duration;
+    }
+    else
+    {
+        *start = time - time % EPG_GRID_SLOT_SECONDS;
+        *end = *start + EPG_GRID_SLOT_SECONDS;
+    }
+}
+
+EpgTile* findTile(EpgGrid* grid, int32_t row, int32_t slot)
+{
+    uint8_t i = 0;
+
+    for (i = 0; i < EPG_GRID_TILE_COUNT; i++)
+    {
+        if (grid->tiles[i].valid && grid->tiles[i].row == row && grid->tiles[i].slot == slot)
+        {
+            return &grid->tiles[i];
+        }
+    }
+
+    return NULL;
+}
+
+EpgTile* recycleTile(EpgGrid* grid)
+{
+    EpgTile* oldest = NULL;
+    uint8_t i = 0;
+
+    /* there are more tiles than visible ones, so one not drawn in this frame is always left */
+    for (i = 0; i < EPG_GRID_TILE_COUNT; i++)
+    {
+        if (grid->tiles[i].lastUse == grid->frame)
+        {
+            continue;
+        }
+        if (!grid->tiles[i].valid)
+        {
+            return &grid->tiles[i];
+        }
+        if (oldest == NULL || grid->tiles[i].lastUse < oldest->lastUse)
+        {
+            oldest = &grid->tiles[i];
+        }
+    }
+
+    return oldest;
+}
+
+void renderTile(EpgGrid* grid, const Epg* epg, EpgTile* tile, int32_t row, int32_t slot)
+{
+    const EpgService* service = &epg->services[row];
+    const EpgEvent* event = NULL;
+    OsdRectangle area = {0, 0, EPG_GRID_TILE_WIDTH, EPG_GRID_TILE_HEIGHT};
+    OsdRectangle box;
+    uint32_t slotStart = (uint32_t)slot * EPG_GRID_SLOT_SECONDS;
+    uint32_t slotEnd = slotStart + EPG_GRID_SLOT_SECONDS;
+    uint32_t eventEnd = 0;
+    uint16_t i = 0;
+    bool highlighted = false;
+
+    grid->backend->fill(tile->surface, &area, EPG_GRID_GAP_COLOR);
+
+    /* cursor on a time with nothing scheduled */
+    if (row == grid->cursorRow && grid->cursorStart < slotEnd && grid->cursorEnd > slotStart &&
+        epgFindEvent(epg, row, grid->cursorStart) < 0)
+    {
+        box.x = timeToPixel(grid->cursorStart, slotStart) + EPG_GRID_GAP;
+        box.y = 0;
+        box.w = timeToPixel(grid->cursorEnd, slotStart) - box.x;
+        box.h = EPG_GRID_TILE_HEIGHT - EPG_GRID_GAP;
+        grid->backend->fill(tile->surface, &box, EPG_GRID_CURSOR_COLOR);
+    }
+
+    for (i = epgFirstEventAfter(epg, row, slotStart); i < service->eventCount && service->events[i].start < slotEnd; i++)
+    {
+        event = &service->events[i];
+        eventEnd = event->start + event->duration;
+        highlighted = row == grid->cursorRow && event->start < grid->cursorEnd && eventEnd > grid->cursorStart;
+
+        /* events running into the slot from before have no gap at the left edge */
+        box.x = (event->start >= slotStart) ? timeToPixel(event->start, slotStart) + EPG_GRID_GAP : 0;
+        box.y = 0;
+        box.w = timeToPixel(eventEnd, slotStart) - box.x;
+        box.h = EPG_GRID_TILE_HEIGHT - EPG_GRID_GAP;
+        if (box.w <= 0)
+        {
+            continue;
+        }
+        grid->backend->fill(tile->surface, &box, highlighted ? EPG_GRID_CURSOR_COLOR : EPG_GRID_EVENT_COLOR);
+
+        /* name starts at event start even when that is in an earlier tile, so it runs on across tiles */
+        grid->backend->setClip(tile->surface, &box);
+        grid->backend->drawString(tile->surface, grid->font, event->name,
+                                  timeToPixel(event->start, slotStart) + EPG_GRID_GAP + EPG_GRID_TEXT_MARGIN,
+                                  (box.h - grid->fontHeight) / 2, EPG_GRID_TEXT_COLOR);
+        grid->backend->setClip(tile->surface, NULL);
+    }
+
+    tile->row = row;
+    tile->slot = slot;
+    tile->valid = true;
+}
+
+int32_t timeToPixel(uint32_t time, uint32_t slotStart)
+{
+    int64_t offset = (int64_t)time - slotStart;
+
+    /* only the event start of the name is needed outside the tile, further away is clamped */
+    if (offset < -(int64_t)EPG_GRID_SLOT_SECONDS * 16)
+    {
+        offset = -(int64_t)EPG_GRID_SLOT_SECONDS * 16;
+    }
+    if (offset > EPG_GRID_SLOT_SECONDS)
+    {
+        offset = EPG_GRID_SLOT_SECONDS;
+    }
+
+    return (int32_t)(offset * EPG_GRID_TILE_WIDTH / EPG_GRID_SLOT_SECONDS);
+}
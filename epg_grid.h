@@ -0,0 +1,128 @@
+#ifndef __EPG_GRID_H__
+#define __EPG_GRID_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "osd_backend.h"
+#include "epg.h"
+
+#define EPG_GRID_SLOT_SECONDS 1800                  /* Time covered by one tile */
+#define EPG_GRID_TILE_WIDTH 240
+#define EPG_GRID_TILE_HEIGHT 70
+#define EPG_GRID_ROWS 8                             /* Visible service rows */
+#define EPG_GRID_SLOTS 6                            /* Visible time slots */
+#define EPG_GRID_TILE_COUNT ((EPG_GRID_ROWS + 1) * (EPG_GRID_SLOTS + 1))    /* Visible tiles and last edge scrolled out */
+#define EPG_GRID_ALL_ROWS -1
+
+/**
+ * @brief Structure that defines EPG grid error
+ */
+typedef enum _EpgGridError
+{
+    EPG_GRID_NO_ERROR = 0,
+    EPG_GRID_ERROR
+}EpgGridError;
+
+/**
+ * @brief Structure that holds one rendered tile, events of one row in one time slot
+ */
+typedef struct _EpgTile
+{
+    OsdSurface* surface;
+    int32_t row;                                    /* -1 if tile holds nothing */
+    int32_t slot;                                   /* Start time divided by EPG_GRID_SLOT_SECONDS */
+    bool valid;                                     /* Cleared when events or cursor in tile change */
+    uint32_t lastUse;                               /* Frame tile was last drawn in, least recently used tile is recycled */
+}EpgTile;
+
+/**
+ * @brief Structure that holds EPG grid statistics
+ */
+typedef struct _EpgGridStats
+{
+    uint32_t tileRenderCount;                       /* Tiles rendered from events */
+    uint32_t tileReuseCount;                        /* Tiles blitted as rendered before */
+    uint32_t invalidatedCount;                      /* Tiles dropped because events or cursor changed */
+}EpgGridStats;
+
+/**
+ * @brief Structure that holds tile cache of EPG grid
+ */
+typedef struct _EpgGrid
+{
+    const OsdBackend* backend;
+    OsdFont* font;
+    int32_t fontHeight;
+    EpgTile tiles[EPG_GRID_TILE_COUNT];
+    int32_t cursorRow;                              /* Cursor the tiles are rendered with, -1 before first draw */
+    uint32_t cursorStart;
+    uint32_t cursorEnd;
+    uint32_t frame;
+    EpgGridStats stats;
+}EpgGrid;
+
+/**
+ * @brief Initializes EPG grid and creates its tiles
+ *
+ * @param [out] grid - EPG grid
+ * @param [in]  backend - backend tiles are created and drawn with
+ * @param [in]  font - font of event names
+ * @return EPG grid error code
+ */
+EpgGridError epgGridInit(EpgGrid* grid, const OsdBackend* backend, OsdFont* font);
+
+/**
+ * @brief Releases tiles of EPG grid
+ *
+ * @param [in] grid - EPG grid
+ */
+void epgGridDeinit(EpgGrid* grid);
+
+/**
+ * @brief Drops rendered tiles of a row that overlap given time span
+ *
+ * @param [in] grid - EPG grid
+ * @param [in] row - row of service, EPG_GRID_ALL_ROWS for every row
+ * @param [in] start - UTC, seconds since 1970
+ * @param [in] end - UTC, seconds since 1970
+ */
+void epgGridInvalidate(EpgGrid* grid, int32_t row, uint32_t start, uint32_t end);
+
+/**
+ * @brief Drops rendered tiles of given row and every row below it, used when rows move
+ *
+ * @param [in] grid - EPG grid
+ * @param [in] firstRow - first row to drop
+ */
+void epgGridInvalidateRows(EpgGrid* grid, int32_t firstRow);
+
+/**
+ * @brief Draws visible part of grid, tiles rendered before are blitted and only missing ones are rendered
+ *
+ * @param [in] grid - EPG grid
+ * @param [in] epg - events, must not change while grid is drawn
+ * @param [in] destination - surface grid is drawn on
+ * @param [in] x - left edge of grid on destination
+ * @param [in] y - top edge of grid on destination
+ * @param [in] topRow - first visible row
+ * @param [in] leftSlot - first visible time slot
+ * @param [in] cursorRow - row of cursor
+ * @param [in] cursorTime - UTC time of cursor, event running then is highlighted
+ */
+void epgGridDraw(EpgGrid* grid, const Epg* epg, OsdSurface* destination, int32_t x, int32_t y,
+                 int32_t topRow, int32_t leftSlot, int32_t cursorRow, uint32_t cursorTime);
+
+/**
+ * @brief Returns span highlighted by cursor, the running event or the time slot when nothing runs
+ *
+ * @param [in]  epg - EPG
+ * @param [in]  row - row of cursor
+ * @param [in]  time - UTC time of cursor
+ * @param [out] start - start of span
+ * @param [out] end - end of span
+ */
+void epgGridCursorSpan(const Epg* epg, int32_t row, uint32_t time, uint32_t* start, uint32_t* end);
+
+#endif /* __EPG_GRID_H__ */
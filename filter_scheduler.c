@@ -0,0 +1,543 @@
+#include "filter_scheduler.h"
+
+#define RESIDENT(priority) ((priority) <= FILTER_PRIORITY_PAT)
+
+/**
+ * @brief Physical filter change decided under mutex and done without it
+ */
+typedef struct _SlotChange
+{
+    uint8_t entry;
+    uint32_t generation;
+    uint16_t pid;
+    uint8_t tableId;
+}SlotChange;
+
+static const char* priorityNames[FILTER_PRIORITY_COUNT] =
+{
+    "current PMT",
+    "PAT",
+    "EIT p/f",
+    "PMT prefetch",
+    "EIT schedule"
+};
+
+static void* filterSchedulerTask(void* arg);
+static uint64_t schedule(FilterScheduler* scheduler, uint64_t now, SlotChange* sets, uint8_t* setCount, uint32_t* frees, uint8_t* freeCount);
+static void releaseSlot(FilterScheduler* scheduler, FilterEntry* entry, uint32_t* frees, uint8_t* freeCount);
+static bool entryMatches(const FilterEntry* entry, const uint8_t* section);
+static void addLatency(FilterRequestStats* stats, uint32_t latency);
+static uint64_t nowMilliseconds();
+static void deadlineAt(struct timespec* deadline, uint64_t milliseconds);
+
+FilterSchedulerError filterSchedulerInit(FilterScheduler* scheduler, uint32_t playerHandle, uint8_t slotCount)
+{
+    pthread_condattr_t condAttr;
+
+    if (scheduler == NULL || slotCount == 0)
+    {
+        printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+        return FS_ERROR;
+    }
+
+    memset(scheduler, 0x0, sizeof(FilterScheduler));
+    scheduler->playerHandle = playerHandle;
+    scheduler->slotCount = (slotCount > FILTER_SCHEDULER_MAX_SLOTS) ? FILTER_SCHEDULER_MAX_SLOTS : slotCount;
+    pthread_mutex_init(&scheduler->mutex, NULL);
+
+    pthread_condattr_init(&condAttr);
+    pthread_condattr_setclock(&condAttr, CLOCK_MONOTONIC);
+    pthread_cond_init(&scheduler->cond, &condAttr);
+    pthread_condattr_destroy(&condAttr);
+
+    if (pthread_create(&scheduler->thread, NULL, &filterSchedulerTask, scheduler))
+    {
+        printf("\n%s : ERROR pthread_create() fail\n", __FUNCTION__);
+        pthread_cond_destroy(&scheduler->cond);
+        pthread_mutex_destroy(&scheduler->mutex);
+        return FS_ERROR;
+    }
+    scheduler->initialized = true;
+
+    return FS_NO_ERROR;
+}
+
+void filterSchedulerDeinit(FilterScheduler* scheduler)
+{
+    uint8_t i = 0;
+
+    if (scheduler == NULL || !scheduler->initialized)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&scheduler->mutex);
+    scheduler->threadExit = true;
+    pthread_cond_signal(&scheduler->cond);
+    pthread_mutex_unlock(&scheduler->mutex);
+    pthread_join(scheduler->thread, NULL);
+
+    for (i = 0; i < FILTER_SCHEDULER_MAX_REQUESTS; i++)
+    {
+        if (scheduler->entries[i].state == FILTER_REQUEST_ACTIVE && scheduler->entries[i].filterHandle != 0)
+        {
+            Demux_Free_Filter(scheduler->playerHandle, scheduler->entries[i].filterHandle);
+        }
+        scheduler->entries[i].state = FILTER_REQUEST_FREE;
+    }
+
+    pthread_cond_destroy(&scheduler->cond);
+    pthread_mutex_destroy(&scheduler->mutex);
+    scheduler->initialized = false;
+}
+
+FilterSchedulerError filterSchedulerAdd(FilterScheduler* scheduler, const FilterRequest* request, uint8_t* requestId)
+{
+    FilterEntry* entry = NULL;
+    uint8_t i = 0;
+
+    if (scheduler == NULL || !scheduler->initialized || request == NULL || requestId == NULL || request->priority >= FILTER_PRIORITY_COUNT)
+    {
+        printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+        return FS_ERROR;
+    }
+
+    pthread_mutex_lock(&scheduler->mutex);
+    for (i = 0; i < FILTER_SCHEDULER_MAX_REQUESTS; i++)
+    {
+        if (scheduler->entries[i].state == FILTER_REQUEST_FREE)
+        {
+            break;
+        }
+    }
+
+    if (i == FILTER_SCHEDULER_MAX_REQUESTS)
+    {
+        pthread_mutex_unlock(&scheduler->mutex);
+        printf("\n%s : ERROR only %d filter requests can exist at once\n", __FUNCTION__, FILTER_SCHEDULER_MAX_REQUESTS);
+        return FS_ERROR;
+    }
+
+    entry = &scheduler->entries[i];
+    memset(&entry->stats, 0x0, sizeof(FilterRequestStats));
+    entry->request = *request;
+    entry->state = FILTER_REQUEST_WAITING;
+    entry->generation++;
+    entry->filterHandle = 0;
+    entry->waitStart = nowMilliseconds();
+    entry->queuedSince = entry->waitStart;
+    entry->sectionArrived = false;
+    entry->starving = false;
+    *requestId = i;
+
+    pthread_cond_signal(&scheduler->cond);
+    pthread_mutex_unlock(&scheduler->mutex);
+
+    return FS_NO_ERROR;
+}
+
+void filterSchedulerRemove(FilterScheduler* scheduler, uint8_t requestId)
+{
+    uint32_t handle = 0;
+    uint8_t freeCount = 0;
+
+    if (scheduler == NULL || !scheduler->initialized || requestId >= FILTER_SCHEDULER_MAX_REQUESTS)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&scheduler->mutex);
+    if (scheduler->entries[requestId].state == FILTER_REQUEST_ACTIVE)
+    {
+        /* a filter still being set is freed by the task once it sees the new generation */
+        releaseSlot(scheduler, &scheduler->entries[requestId], &handle, &freeCount);
+    }
+    scheduler->entries[requestId].state = FILTER_REQUEST_FREE;
+    scheduler->entries[requestId].generation++;
+    pthread_cond_signal(&scheduler->cond);
+    pthread_mutex_unlock(&scheduler->mutex);
+
+    /* demux is not called under mutex, section callback may be waiting for it */
+    if (freeCount > 0)
+    {
+        Demux_Free_Filter(scheduler->playerHandle, handle);
+    }
+}
+
+void filterSchedulerSetPriority(FilterScheduler* scheduler, uint8_t requestId, FilterPriority priority)
+{
+    if (scheduler == NULL || !scheduler->initialized || requestId >= FILTER_SCHEDULER_MAX_REQUESTS || priority >= FILTER_PRIORITY_COUNT)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&scheduler->mutex);
+    if (scheduler->entries[requestId].state != FILTER_REQUEST_FREE)
+    {
+        scheduler->entries[requestId].request.priority = priority;
+
+        /* served time-sliced request that becomes resident needs its slot back right away */
+        if (RESIDENT(priority) && scheduler->entries[requestId].state == FILTER_REQUEST_IDLE)
+        {
+            scheduler->entries[requestId].state = FILTER_REQUEST_WAITING;
+            scheduler->entries[requestId].waitStart = nowMilliseconds();
+            scheduler->entries[requestId].queuedSince = scheduler->entries[requestId].waitStart;
+            scheduler->entries[requestId].sectionArrived = false;
+            scheduler->entries[requestId].starving = false;
+        }
+        pthread_cond_signal(&scheduler->cond);
+    }
+    pthread_mutex_unlock(&scheduler->mutex);
+}
+
+void filterSchedulerSectionReceived(FilterScheduler* scheduler, const uint8_t* section)
+{
+    FilterEntry* entry = NULL;
+    uint64_t now = 0;
+    uint32_t latency = 0;
+    uint8_t i = 0;
+
+    if (scheduler == NULL || !scheduler->initialized || section == NULL)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&scheduler->mutex);
+    for (i = 0; i < FILTER_SCHEDULER_MAX_REQUESTS; i++)
+    {
+        entry = &scheduler->entries[i];
+        if (entry->state != FILTER_REQUEST_ACTIVE || !entryMatches(entry, section))
+        {
+            continue;
+        }
+
+        entry->stats.sectionCount++;
+        scheduler->priorityStats[entry->request.priority].sectionCount++;
+        if (entry->sectionArrived)
+        {
+            continue;
+        }
+
+        if (now == 0)
+        {
+            now = nowMilliseconds();
+        }
+        latency = (uint32_t) (now - entry->waitStart);
+        entry->sectionArrived = true;
+        addLatency(&entry->stats, latency);
+        addLatency(&scheduler->priorityStats[entry->request.priority], latency);
+
+        /* time-sliced request is done, its slot goes to the next one */
+        if (!RESIDENT(entry->request.priority))
+        {
+            pthread_cond_signal(&scheduler->cond);
+        }
+    }
+    pthread_mutex_unlock(&scheduler->mutex);
+}
+
+void filterSchedulerGetStats(FilterScheduler* scheduler, uint8_t requestId, FilterRequestStats* stats)
+{
+    if (scheduler == NULL || !scheduler->initialized || requestId >= FILTER_SCHEDULER_MAX_REQUESTS || stats == NULL)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&scheduler->mutex);
+    *stats = scheduler->entries[requestId].stats;
+    pthread_mutex_unlock(&scheduler->mutex);
+}
+
+void filterSchedulerPrintStats(FilterScheduler* scheduler)
+{
+    FilterRequestStats* stats = NULL;
+    uint8_t i = 0;
+
+    if (scheduler == NULL || !scheduler->initialized)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&scheduler->mutex);
+    printf("\n%s : INFO %d slots, filters set %u, preemptions %u\n", __FUNCTION__, scheduler->slotCount,
+           scheduler->slotSwitchCount, scheduler->preemptionCount);
+    for (i = 0; i < FILTER_PRIORITY_COUNT; i++)
+    {
+        stats = &scheduler->priorityStats[i];
+        if (stats->sectionCount == 0 && stats->starvationCount == 0)
+        {
+            continue;
+        }
+        printf("\n%s : INFO %s sections %u, served %u, latency avg %u ms, worst case %u ms, starved %u\n", __FUNCTION__,
+               priorityNames[i], stats->sectionCount, stats->servedCount,
+               (stats->servedCount > 0) ? (uint32_t) (stats->totalLatency / stats->servedCount) : 0, stats->maxLatency, stats->starvationCount);
+    }
+    pthread_mutex_unlock(&scheduler->mutex);
+}
+
+/* Assigns slots whenever a request is added, served or its turn ends */
+static void* filterSchedulerTask(void* arg)
+{
+    FilterScheduler* scheduler = (FilterScheduler*) arg;
+    SlotChange sets[FILTER_SCHEDULER_MAX_SLOTS];
+    uint32_t frees[FILTER_SCHEDULER_MAX_REQUESTS];
+    uint32_t handle = 0;
+    uint8_t setCount = 0;
+    uint8_t freeCount = 0;
+    uint64_t wakeup = 0;
+    struct timespec deadline;
+    uint8_t i = 0;
+
+    pthread_mutex_lock(&scheduler->mutex);
+    while (!scheduler->threadExit)
+    {
+        wakeup = schedule(scheduler, nowMilliseconds(), sets, &setCount, frees, &freeCount);
+
+        if (setCount > 0 || freeCount > 0)
+        {
+            /* demux is not called under mutex, section callback may be waiting for it */
+            pthread_mutex_unlock(&scheduler->mutex);
+            for (i = 0; i < freeCount; i++)
+            {
+                Demux_Free_Filter(scheduler->playerHandle, frees[i]);
+            }
+            for (i = 0; i < setCount; i++)
+            {
+                if (Demux_Set_Filter(scheduler->playerHandle, sets[i].pid, sets[i].tableId, &handle))
+                {
+                    printf("\n%s : ERROR Demux_Set_Filter() fail\n", __FUNCTION__);
+                    handle = 0;
+                }
+                pthread_mutex_lock(&scheduler->mutex);
+                if (scheduler->entries[sets[i].entry].generation == sets[i].generation &&
+                    scheduler->entries[sets[i].entry].state == FILTER_REQUEST_ACTIVE && handle != 0)
+                {
+                    scheduler->entries[sets[i].entry].filterHandle = handle;
+                    handle = 0;
+                }
+                else if (scheduler->entries[sets[i].entry].generation == sets[i].generation &&
+                         scheduler->entries[sets[i].entry].state == FILTER_REQUEST_ACTIVE)
+                {
+                    /* retried after one repetition interval */
+                    scheduler->entries[sets[i].entry].state = FILTER_REQUEST_IDLE;
+                    scheduler->entries[sets[i].entry].idleUntil = nowMilliseconds() + scheduler->entries[sets[i].entry].request.repetitionInterval;
+                    scheduler->usedSlots--;
+                }
+                pthread_mutex_unlock(&scheduler->mutex);
+
+                /* request was removed or lost its slot while filter was being set */
+                if (handle != 0)
+                {
+                    Demux_Free_Filter(scheduler->playerHandle, handle);
+                }
+            }
+            pthread_mutex_lock(&scheduler->mutex);
+            continue;
+        }
+
+        if (wakeup == UINT64_MAX)
+        {
+            pthread_cond_wait(&scheduler->cond, &scheduler->mutex);
+        }
+        else
+        {
+            deadlineAt(&deadline, wakeup);
+            pthread_cond_timedwait(&scheduler->cond, &scheduler->mutex, &deadline);
+        }
+    }
+    pthread_mutex_unlock(&scheduler->mutex);
+
+    return NULL;
+}
+
+/* Ends turns, wakes idle requests and hands free or preempted slots to best waiting requests,
+ * returns time of next turn change in ms
+ */
+static uint64_t schedule(FilterScheduler* scheduler, uint64_t now, SlotChange* sets, uint8_t* setCount, uint32_t* frees, uint8_t* freeCount)
+{
+    FilterEntry* entry = NULL;
+    FilterEntry* best = NULL;
+    FilterEntry* victim = NULL;
+    uint64_t wakeup = UINT64_MAX;
+    uint64_t limit = 0;
+    uint8_t i = 0;
+
+    *setCount = 0;
+    *freeCount = 0;
+
+    for (i = 0; i < FILTER_SCHEDULER_MAX_REQUESTS; i++)
+    {
+        entry = &scheduler->entries[i];
+        if (entry->state == FILTER_REQUEST_ACTIVE && !RESIDENT(entry->request.priority) && entry->filterHandle != 0)
+        {
+            if (entry->sectionArrived)
+            {
+                releaseSlot(scheduler, entry, frees, freeCount);
+                entry->state = FILTER_REQUEST_IDLE;
+                entry->idleUntil = now + entry->request.refreshInterval;
+            }
+            else if (now - entry->slotStart >= entry->request.repetitionInterval)
+            {
+                /* table did not arrive in its turn, next turn comes after the other waiting requests */
+                releaseSlot(scheduler, entry, frees, freeCount);
+                entry->state = FILTER_REQUEST_WAITING;
+                entry->queuedSince = now;
+            }
+        }
+
+        if (entry->state == FILTER_REQUEST_IDLE && now >= entry->idleUntil)
+        {
+            entry->state = FILTER_REQUEST_WAITING;
+            entry->waitStart = now;
+            entry->queuedSince = now;
+            entry->sectionArrived = false;
+            entry->starving = false;
+        }
+    }
+
+    while (*setCount < FILTER_SCHEDULER_MAX_SLOTS)
+    {
+        best = NULL;
+        for (i = 0; i < FILTER_SCHEDULER_MAX_REQUESTS; i++)
+        {
+            entry = &scheduler->entries[i];
+            if (entry->state == FILTER_REQUEST_WAITING && (best == NULL || entry->request.priority < best->request.priority ||
+                (entry->request.priority == best->request.priority && entry->queuedSince < best->queuedSince)))
+            {
+                best = entry;
+            }
+        }
+        if (best == NULL)
+        {
+            break;
+        }
+
+        if (scheduler->usedSlots == scheduler->slotCount)
+        {
+            /* lowest priority time-sliced request gives its slot away */
+            victim = NULL;
+            for (i = 0; i < FILTER_SCHEDULER_MAX_REQUESTS; i++)
+            {
+                entry = &scheduler->entries[i];
+                if (entry->state == FILTER_REQUEST_ACTIVE && !RESIDENT(entry->request.priority) && entry->filterHandle != 0 &&
+                    entry->request.priority > best->request.priority && (victim == NULL || entry->request.priority > victim->request.priority))
+                {
+                    victim = entry;
+                }
+            }
+            if (victim == NULL)
+            {
+                break;
+            }
+            releaseSlot(scheduler, victim, frees, freeCount);
+            victim->state = FILTER_REQUEST_WAITING;
+            victim->queuedSince = now;
+            scheduler->preemptionCount++;
+        }
+
+        best->state = FILTER_REQUEST_ACTIVE;
+        best->filterHandle = 0;
+        best->slotStart = now;
+        best->sectionArrived = false;
+        scheduler->usedSlots++;
+        scheduler->slotSwitchCount++;
+        sets[*setCount].entry = best - scheduler->entries;
+        sets[*setCount].generation = best->generation;
+        sets[*setCount].pid = best->request.pid;
+        sets[*setCount].tableId = best->request.tableId;
+        (*setCount)++;
+    }
+
+    for (i = 0; i < FILTER_SCHEDULER_MAX_REQUESTS; i++)
+    {
+        entry = &scheduler->entries[i];
+        switch (entry->state)
+        {
+            case FILTER_REQUEST_ACTIVE:
+                if (!RESIDENT(entry->request.priority) && !entry->sectionArrived)
+                {
+                    limit = entry->slotStart + entry->request.repetitionInterval;
+                    wakeup = (limit < wakeup) ? limit : wakeup;
+                }
+                break;
+            case FILTER_REQUEST_IDLE:
+                wakeup = (entry->idleUntil < wakeup) ? entry->idleUntil : wakeup;
+                break;
+            case FILTER_REQUEST_WAITING:
+                limit = entry->waitStart + (uint64_t) entry->request.repetitionInterval * FILTER_SCHEDULER_STARVATION_FACTOR;
+                if (entry->starving)
+                {
+                    break;
+                }
+                if (now >= limit)
+                {
+                    entry->starving = true;
+                    entry->stats.starvationCount++;
+                    scheduler->priorityStats[entry->request.priority].starvationCount++;
+                    printf("\n%s : WARNING %s filter on pid %d table 0x%.2x waits for a slot for %u ms\n", __FUNCTION__,
+                           priorityNames[entry->request.priority], entry->request.pid, entry->request.tableId, (uint32_t) (now - entry->waitStart));
+                }
+                else
+                {
+                    wakeup = (limit < wakeup) ? limit : wakeup;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    return wakeup;
+}
+
+static void releaseSlot(FilterScheduler* scheduler, FilterEntry* entry, uint32_t* frees, uint8_t* freeCount)
+{
+    if (entry->filterHandle != 0)
+    {
+        frees[(*freeCount)++] = entry->filterHandle;
+        entry->filterHandle = 0;
+    }
+    scheduler->usedSlots--;
+}
+
+static bool entryMatches(const FilterEntry* entry, const uint8_t* section)
+{
+    if (section[0] != entry->request.tableId)
+    {
+        return false;
+    }
+
+    if (entry->request.tableIdExtension == FILTER_SCHEDULER_ANY_EXTENSION)
+    {
+        return true;
+    }
+
+    /* only long sections (section_syntax_indicator set) carry table_id_extension */
+    return (section[1] & 0x80) && ((uint16_t) ((section[3] << 8) + section[4]) == entry->request.tableIdExtension);
+}
+
+static void addLatency(FilterRequestStats* stats, uint32_t latency)
+{
+    stats->servedCount++;
+    stats->lastLatency = latency;
+    stats->totalLatency += latency;
+    if (latency > stats->maxLatency)
+    {
+        stats->maxLatency = latency;
+    }
+}
+
+static uint64_t nowMilliseconds()
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t) now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+static void deadlineAt(struct timespec* deadline, uint64_t milliseconds)
+{
+    deadline->tv_sec = milliseconds / 1000;
+    deadline->tv_nsec = (milliseconds % 1000) * 1000000L;
+}
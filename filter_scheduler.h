@@ -0,0 +1,186 @@
+#ifndef __FILTER_SCHEDULER_H__
+#define __FILTER_SCHEDULER_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include "pthread.h"
+#include "tdp_api.h"
+
+#define FILTER_SCHEDULER_MAX_REQUESTS 16            /* Max number of logical filter requests */
+#define FILTER_SCHEDULER_MAX_SLOTS 16               /* Max number of physical section filters */
+#define FILTER_SCHEDULER_DEFAULT_SLOTS 6            /* Physical section filters when config does not set them */
+#define FILTER_SCHEDULER_STARVATION_FACTOR 4        /* Waiting longer than this many repetition intervals is reported */
+#define FILTER_SCHEDULER_ANY_EXTENSION -1           /* Section is matched by table id only */
+#define FILTER_SCHEDULER_NO_REQUEST -1              /* Request id holders use it when nothing is requested */
+
+/**
+ * @brief Structure that defines filter scheduler error
+ */
+typedef enum _FilterSchedulerError
+{
+    FS_NO_ERROR = 0,
+    FS_ERROR
+}FilterSchedulerError;
+
+/**
+ * @brief Priority of logical filter, lower value wins a physical slot
+ *
+ * Current PMT and PAT hold their slot while they exist, other requests share the remaining slots in turns.
+ */
+typedef enum _FilterPriority
+{
+    FILTER_PRIORITY_CURRENT_PMT = 0,
+    FILTER_PRIORITY_PAT,
+    FILTER_PRIORITY_EIT_PRESENT_FOLLOWING,
+    FILTER_PRIORITY_PMT_PREFETCH,
+    FILTER_PRIORITY_EIT_SCHEDULE,
+    FILTER_PRIORITY_COUNT
+}FilterPriority;
+
+/**
+ * @brief Structure that describes logical filter
+ */
+typedef struct _FilterRequest
+{
+    uint16_t pid;
+    uint8_t tableId;
+    int32_t tableIdExtension;                       /* e.g. program_number of PMT, or FILTER_SCHEDULER_ANY_EXTENSION */
+    FilterPriority priority;
+    uint32_t repetitionInterval;                    /* Time in ms the table takes to repeat, a time-sliced request holds its slot this long */
+    uint32_t refreshInterval;                       /* Time in ms a served time-sliced request waits before it needs a slot again */
+}FilterRequest;
+
+/**
+ * @brief Structure that holds latency statistics of a request or a priority
+ */
+typedef struct _FilterRequestStats
+{
+    uint32_t sectionCount;                          /* Sections matched */
+    uint32_t servedCount;                           /* Waits that ended with a section */
+    uint32_t lastLatency;                           /* From start of wait to section in ms */
+    uint32_t maxLatency;
+    uint64_t totalLatency;
+    uint32_t starvationCount;                       /* Waits that exceeded starvation limit */
+}FilterRequestStats;
+
+/**
+ * @brief State of logical filter
+ */
+typedef enum _FilterRequestState
+{
+    FILTER_REQUEST_FREE = 0,
+    FILTER_REQUEST_WAITING,                         /* Needs a slot */
+    FILTER_REQUEST_ACTIVE,                          /* Holds a slot */
+    FILTER_REQUEST_IDLE                             /* Served, needs a slot again after refresh interval */
+}FilterRequestState;
+
+/**
+ * @brief Structure that holds logical filter and its slot
+ */
+typedef struct _FilterEntry
+{
+    FilterRequest request;
+    FilterRequestState state;
+    uint32_t generation;                            /* Incremented on add and remove, detects reuse while demux is called unlocked */
+    uint32_t filterHandle;                          /* 0 while slot is being set */
+    uint64_t waitStart;                             /* In ms, wait for a section began */
+    uint64_t queuedSince;                           /* In ms, order of waiting requests with equal priority */
+    uint64_t slotStart;
+    uint64_t idleUntil;
+    bool sectionArrived;                            /* In current wait */
+    bool starving;                                  /* Warning was printed for current wait */
+    FilterRequestStats stats;
+}FilterEntry;
+
+/**
+ * @brief Structure that holds state of one filter scheduler, one per player handle
+ */
+typedef struct _FilterScheduler
+{
+    uint32_t playerHandle;
+    uint8_t slotCount;
+    uint8_t usedSlots;
+    bool initialized;
+    bool threadExit;
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    FilterEntry entries[FILTER_SCHEDULER_MAX_REQUESTS];
+    FilterRequestStats priorityStats[FILTER_PRIORITY_COUNT];
+    uint32_t preemptionCount;                       /* Slots taken from lower priority requests */
+    uint32_t slotSwitchCount;                       /* Physical filters set */
+}FilterScheduler;
+
+/**
+ * @brief Initializes filter scheduler and starts its task
+ *
+ * @param [out] scheduler - filter scheduler
+ * @param [in]  playerHandle - player handle used for demux filters
+ * @param [in]  slotCount - physical section filters the scheduler may use
+ * @return filter scheduler error code
+ */
+FilterSchedulerError filterSchedulerInit(FilterScheduler* scheduler, uint32_t playerHandle, uint8_t slotCount);
+
+/**
+ * @brief Stops task of filter scheduler and frees all physical filters
+ *
+ * @param [in] scheduler - filter scheduler
+ */
+void filterSchedulerDeinit(FilterScheduler* scheduler);
+
+/**
+ * @brief Adds logical filter, physical filter is set when a slot is available
+ *
+ * @param [in]  scheduler - filter scheduler
+ * @param [in]  request - logical filter
+ * @param [out] requestId - id of logical filter
+ * @return filter scheduler error code
+ */
+FilterSchedulerError filterSchedulerAdd(FilterScheduler* scheduler, const FilterRequest* request, uint8_t* requestId);
+
+/**
+ * @brief Removes logical filter and frees its slot
+ *
+ * @param [in] scheduler - filter scheduler
+ * @param [in] requestId - id of logical filter
+ */
+void filterSchedulerRemove(FilterScheduler* scheduler, uint8_t requestId);
+
+/**
+ * @brief Changes priority of logical filter, physical filter is kept
+ *
+ * @param [in] scheduler - filter scheduler
+ * @param [in] requestId - id of logical filter
+ * @param [in] priority - new priority
+ */
+void filterSchedulerSetPriority(FilterScheduler* scheduler, uint8_t requestId, FilterPriority priority);
+
+/**
+ * @brief Passes received section to scheduler, must be called from section filter callback
+ *
+ * @param [in] scheduler - filter scheduler
+ * @param [in] section - received section
+ */
+void filterSchedulerSectionReceived(FilterScheduler* scheduler, const uint8_t* section);
+
+/**
+ * @brief Returns latency statistics of logical filter
+ *
+ * @param [in]  scheduler - filter scheduler
+ * @param [in]  requestId - id of logical filter
+ * @param [out] stats - statistics
+ */
+void filterSchedulerGetStats(FilterScheduler* scheduler, uint8_t requestId, FilterRequestStats* stats);
+
+/**
+ * @brief Prints latency statistics of every priority
+ *
+ * @param [in] scheduler - filter scheduler
+ */
+void filterSchedulerPrintStats(FilterScheduler* scheduler);
+
+#endif /* __FILTER_SCHEDULER_H__ */
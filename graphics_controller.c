@@ -1,82 +1,178 @@
 #include "graphics_controller.h"
-#include <directfb.h>
-#include <signal.h>
 #include <stdio.h>
 #include <time.h>
+#include <unistd.h>
 #include "pthread.h"
+#include "image_cache.h"
+#include "asset_pack.h"
+#include "text_cache.h"
+#include "service_index.h"
+#include "epg.h"
+#include "epg_grid.h"
 
+#define VOLUME_LEVELS 11	/* Volume bar images, volume_0.png to volume_10.png */
+#define PROGRAM_NUMBER_X 100
+#define PROGRAM_NUMBER_Y 100
+#define PROGRAM_NUMBER_WIDTH 200
+#define PROGRAM_NUMBER_HEIGHT 100
+#define TEXT_COLOR 0xFF000000	/* ARGB */
+#define PANEL_COLOR 0xEFE091D7	/* ARGB */
+#define FONT_PATH "/home/galois/fonts/DejaVuSans.ttf"
+#define FONT_PACK_PATH "/home/galois/fonts/DejaVuSans.dgiff"	/* Glyphs pre-rasterized by make assets, used instead of FONT_PATH if present */
+#define ASSET_PACK_PATH "osd_assets.pack"	/* Images pre-decoded by make assets, missing images are decoded from files */
+#define FONT_HEIGHT 50
+#define PROGRAM_NUMBER_TIMEOUT 4000	/* Time in ms the program number stays on screen */
+#define VOLUME_TIMEOUT 3000			/* Time in ms the volume bar stays on screen */
+#define INFO_TIMEOUT 3000			/* Time in ms the info banner stays on screen */
+#define CHANNEL_DIAL_TIMEOUT 8000	/* Time in ms the channel list stays on screen after last key */
+#define CHANNEL_LIST_X 100
+#define CHANNEL_LIST_Y 250
+#define CHANNEL_LIST_ROW_WIDTH 700
+#define CHANNEL_LIST_ROW_HEIGHT 60
+#define CHANNEL_LIST_ROWS 10		/* Visible rows, also number of row surfaces */
+#define CHANNEL_LIST_NAME_X 150		/* Name position in row, number is left of it */
+#define SELECTION_COLOR 0xEF9050C0	/* ARGB */
+#define CHANNEL_DATABASE_PATH_LENGTH 256
+#define EPG_X 90
+#define EPG_Y 150
+#define EPG_CHANNEL_WIDTH 300		/* Service names in front of the grid */
+#define EPG_HEADER_HEIGHT 70		/* Date and slot times above the grid */
+#define EPG_DAYS 7
+#define EPG_FRAME_BUDGET 16666667	/* Nanoseconds of one refresh period at 60 Hz */
 
-static IDirectFBSurface* primary = NULL;
-static IDirectFB* dfbInterface = NULL;
-static DFBSurfaceDescription surfaceDesc;
-static DFBFontDescription fontDesc;
-static IDirectFBFont* fontInterface = NULL;
+/**
+ * @brief OSD elements, each one is cleared and redrawn only when it changes
+ */
+typedef enum _OsdElement
+{
+	OSD_ELEMENT_EPG = 0,
+	OSD_ELEMENT_PROGRAM_NUMBER,
+	OSD_ELEMENT_VOLUME,
+	OSD_ELEMENT_INFO,
+	OSD_ELEMENT_CHANNEL_DIAL,
+	OSD_ELEMENT_COUNT
+}OsdElement;
+
+/**
+ * @brief Surface holding one drawn channel list row, reused for another row once it scrolls out
+ */
+typedef struct _ChannelRow
+{
+	OsdSurface* surface;
+	int32_t row;					/* Row drawn in surface, -1 if none */
+	uint32_t generation;			/* Service index generation the row was drawn from */
+	bool used;						/* Blitted in current frame */
+}ChannelRow;
+
+
+static const OsdBackend* backend = NULL;
+static OsdSurface* primary = NULL;
+static OsdFont* fontInterface = NULL;
 static int32_t screenWidth = 0;
 static int32_t screenHeight = 0;
-static uint8_t stopDrawing = 0;
+static bool stopDrawing = false;
+static bool redrawNeeded = false;		/* Set with graphicsMutex held when componentsToDraw changes */
 
 static pthread_t gcThread;
 static pthread_mutex_t graphicsMutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_cond_t graphicsCond = PTHREAD_COND_INITIALIZER;
 static DrawComponents componentsToDraw;
 
-static timer_t programNumberTimer;
-static struct itimerspec programTimerSpec;
-static struct itimerspec programTimerSpecOld;
-static struct sigevent programSignalEvent;
+static TimerWheel* timerWheel = NULL;
+static WheelTimer programNumberTimer;
+static WheelTimer volumeTimer;
+static WheelTimer infoTimer;
+static WheelTimer channelDialTimer;
+
+static void removeProgramNumber(void* data);
+static void removeVolumeBar(void* data);
+static void removeInfo(void* data);
+static void removeChannelDial(void* data);
+static GraphicsControllerError loadChannels();
+static void scrollChannelList(DrawComponents* components);
+static void scrollEpg(DrawComponents* components);
+static void findServiceName(uint16_t transportStreamId, uint16_t serviceId, uint16_t* number, char* name);
+static void* renderThread();
+static void wipeRectangle(const OsdRectangle* rectangle);
+static void layoutElement(OsdElement element, const DrawComponents* components, OsdRectangle* box);
+static bool elementChanged(OsdElement element, const DrawComponents* components, const DrawComponents* drawn);
+static void renderElement(OsdElement element, const DrawComponents* components);
+static void renderProgramNumber(const DrawComponents* components);
+static void renderVolumeBar(const DrawComponents* components);
+static void renderInfo(const DrawComponents* components);
+static void renderChannelList(const DrawComponents* components);
+static ChannelRow* findChannelRow(int32_t row, uint32_t generation);
+static ChannelRow* recycleChannelRow(int32_t top, int32_t bottom);
+static void drawChannelRow(ChannelRow* channelRow, int32_t row);
+static void renderEpg(const DrawComponents* components);
+static void renderText(const char* text, int32_t x, int32_t y);
+static void unionRectangle(OsdRectangle* target, const OsdRectangle* rectangle);
+static uint64_t intersectionArea(const OsdRectangle* first, const OsdRectangle* second);
+static void requestRedraw();
 
-static timer_t volumeTimer;
-static struct itimerspec volumeTimerSpec;
-static struct itimerspec volumeTimerSpecOld;
-static struct sigevent volumeSignalEvent;
+static const char* volumeAssets[VOLUME_LEVELS] =
+{
+	"volume_0.png", "volume_1.png", "volume_2.png", "volume_3.png", "volume_4.png", "volume_5.png",
+	"volume_6.png", "volume_7.png", "volume_8.png", "volume_9.png", "volume_10.png"
+};
+static const char* monthNames[12] =
+{
+	"January", "February", "March", "April", "May", "June",
+	"July", "August", "September", "October", "November", "December"
+};
+static ImageCache imageCache;
+static AssetPack assetPack;
+static TextCache textCache;
+static int32_t fontAscender = 0;
+static int32_t fontHeight = 0;
+static ChannelRow channelRows[CHANNEL_LIST_ROWS];
+static ServiceIndex serviceIndex;				/* Read by render thread while it draws rows, so guarded by its own mutex */
+static pthread_mutex_t serviceIndexMutex = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t serviceIndexGeneration = 0;
+static char channelDatabasePath[CHANNEL_DATABASE_PATH_LENGTH];
+static Epg epg;									/* Written by section worker, read by render thread */
+static EpgGrid epgGrid;							/* Tiles are invalidated by section worker, guarded with epg by epgMutex */
+static pthread_mutex_t epgMutex = PTHREAD_MUTEX_INITIALIZER;
+static int32_t epgFirstSlot = 0;				/* Guide covers EPG_DAYS from the slot it was opened at */
+static bool epgReady = false;					/* Sections arriving before init or after deinit are dropped, they repeat */
+static FrameStats frameStats;
+static OsdRectangle drawnBoxes[OSD_ELEMENT_COUNT];	/* Bounding box of each element on screen, empty when hidden */
 
-static timer_t infoTimer;
-static struct itimerspec infoTimerSpec;
-static struct itimerspec infoTimerSpecOld;
-static struct sigevent infoSignalEvent;
+static uint64_t monotonicNanoseconds();
+static uint64_t threadCpuNanoseconds();
+static void printGraphicsStats();
 
-static int32_t timerFlags = 0;
+GraphicsControllerError graphicsControllerInit(TimerWheel* wheel, const OsdBackend* osdBackend)
+{
+	GraphicsControllerError result = GC_NO_ERROR;
 
-static void removeProgramNumber();
-static void removeVolumeBar();
-static void removeInfo();
-static void* renderThread();
-static void setTimerParams();
-static void wipeScreen();
-static uint16_t YearToDraw = 1000;
-static uint8_t tmpMonthToDraw = 0;
-static uint8_t dayToDraw = 0;
-//static uint8_t hoursToDraw = 0;
-//static uint8_t minutesToDraw = 0;
-static int16_t audioPidToDraw = 0;
-static int16_t videoPidToDraw = 0;
-static IDirectFBImageProvider *provider;
-static IDirectFBSurface *logoSurface = NULL;
-static int32_t logoHeight;
-static int32_t logoWidth;
-
-/* helper macro for error checking */
-#define DFBCHECK(x...)                                      \
-{                                                           \
-DFBResult err = x;                                          \
-                                                            \
-if (err != DFB_OK)                                          \
-  {                                                         \
-    fprintf( stderr, "%s <%d>:\n\t", __FILE__, __LINE__ );  \
-    DirectFBErrorFatal( #x, err );                          \
-  }                                                         \
-}
-
-
-GraphicsControllerError graphicsControllerInit()
-{
-	/* initialize DirectFB */
-	if (DirectFBInit(0, NULL))
+	graphicsControllerPrepare(wheel, osdBackend);
+	result = graphicsControllerInitBackend();
+	if (result == GC_NO_ERROR)
 	{
-		return GC_ERROR;
+		result = graphicsControllerLoadFont();
 	}
+	if (result == GC_NO_ERROR)
+	{
+		result = graphicsControllerLoadAssets();
+	}
+	if (result == GC_NO_ERROR)
+	{
+		result = graphicsControllerStart();
+	}
+
+	return result;
+}
 
-	setTimerParams();
+void graphicsControllerPrepare(TimerWheel* wheel, const OsdBackend* osdBackend)
+{
+	/* OSD elements are hidden by timers of the shared timer wheel */
+	backend = osdBackend;
+	timerWheel = wheel;
+	timerWheelSetup(&programNumberTimer, removeProgramNumber, NULL);
+	timerWheelSetup(&volumeTimer, removeVolumeBar, NULL);
+	timerWheelSetup(&infoTimer, removeInfo, NULL);
+	timerWheelSetup(&channelDialTimer, removeChannelDial, NULL);
 
 	componentsToDraw.showProgramNumber = false;
 	componentsToDraw.showVolume = false;
@@ -84,38 +180,109 @@ GraphicsControllerError graphicsControllerInit()
 	componentsToDraw.showChannelDial = false;
 	componentsToDraw.programNumber = 0;
 	componentsToDraw.volume = 0;
+	componentsToDraw.year = 1000;
+	componentsToDraw.month = 0;
+	componentsToDraw.day = 0;
+	componentsToDraw.audioPid = 0;
+	componentsToDraw.videoPid = 0;
+	componentsToDraw.channelCount = 0;
+	componentsToDraw.channelTop = 0;
+	componentsToDraw.channelSelected = 0;
+	componentsToDraw.channelGeneration = 0;
+	componentsToDraw.showEpg = false;
+	componentsToDraw.epgTopRow = 0;
+	componentsToDraw.epgLeftSlot = 0;
+	componentsToDraw.epgCursorRow = 0;
+	componentsToDraw.epgCursorTime = 0;
+	componentsToDraw.epgRowCount = 0;
+	componentsToDraw.epgGeneration = 0;
+	/* first frame clears the screen */
+	redrawNeeded = true;
+}
 
-	/* fetch the DirectFB interface */
-	if (DirectFBCreate(&dfbInterface))
+GraphicsControllerError graphicsControllerInitBackend()
+{
+	/* initialize the backend and take the full screen */
+	if (backend->init(&primary, &screenWidth, &screenHeight) != OB_NO_ERROR)
 	{
+		printf("\n%s : ERROR cannot initialize %s backend!\n", __FUNCTION__, backend->name);
 		return GC_ERROR;
 	}
 
-	/* tell the DirectFB to take the full screen for this application */
-	if (dfbInterface->SetCooperativeLevel(dfbInterface, DFSCL_FULLSCREEN))
+	/* decoded images are kept, the render loop only blits them */
+	imageCacheInit(&imageCache, backend, IMAGE_CACHE_DEFAULT_BUDGET);
+
+	return GC_NO_ERROR;
+}
+
+GraphicsControllerError graphicsControllerLoadFont()
+{
+	/* pre-rasterized glyphs are mapped, TrueType glyphs are rasterized on first use */
+	fontInterface = backend->loadFont(access(FONT_PACK_PATH, R_OK) == 0 ? FONT_PACK_PATH : FONT_PATH, FONT_HEIGHT);
+	if (fontInterface == NULL)
 	{
 		return GC_ERROR;
 	}
+	backend->getFontMetrics(fontInterface, &fontHeight, &fontAscender);
+
+	return GC_NO_ERROR;
+}
+
+GraphicsControllerError graphicsControllerLoadAssets()
+{
+	int32_t width = 0;
+	int32_t height = 0;
+	uint8_t i = 0;
 
-    /* create primary surface with double buffering enabled */
-	surfaceDesc.flags = DSDESC_CAPS;
-	surfaceDesc.caps = DSCAPS_PRIMARY | DSCAPS_FLIPPING;
-	if (dfbInterface->CreateSurface(dfbInterface, &surfaceDesc, &primary))
+	/* images in the pack are blitted straight from the mapping, without a copy */
+	if (assetPackMap(&assetPack, ASSET_PACK_PATH) == AP_NO_ERROR)
 	{
-		return GC_ERROR;
-	}    
-    
-    /* fetch the screen size */
-    if (primary->GetSize(primary, &screenWidth, &screenHeight))
+		imageCacheSetPack(&imageCache, &assetPack);
+	}
+	else
 	{
-		return GC_ERROR;
+		printf("\n%s : INFO no asset pack %s, images are decoded\n", __FUNCTION__, ASSET_PACK_PATH);
+	}
+
+	/* decoded before render thread starts, so first volume key press does not wait for PNG decoding */
+	for (i = 0; i < VOLUME_LEVELS; i++)
+	{
+		if (imageCacheGet(&imageCache, volumeAssets[i], &width, &height) == NULL)
+		{
+			printf("\n%s : ERROR cannot decode %s, it is decoded again on first use\n", __FUNCTION__, volumeAssets[i]);
+		}
 	}
 
-	fontDesc.flags = DFDESC_HEIGHT;
-	fontDesc.height = 50;
+	return GC_NO_ERROR;
+}
+
+GraphicsControllerError graphicsControllerStart()
+{
+	uint8_t i = 0;
+
+	/* strings that rarely change are rendered once and blitted */
+	textCacheInit(&textCache, backend);
+
+	/* programme guide is drawn from tiles, one per service and time slot */
+	pthread_mutex_lock(&epgMutex);
+	epgClear(&epg);
+	epgReady = epgGridInit(&epgGrid, backend, fontInterface) == EPG_GRID_NO_ERROR;
+	pthread_mutex_unlock(&epgMutex);
+	if (!epgReady)
+	{
+		return GC_ERROR;
+	}
 
-	DFBCHECK(dfbInterface->CreateFont(dfbInterface, "/home/galois/fonts/DejaVuSans.ttf", &fontDesc, &fontInterface));
-	DFBCHECK(primary->SetFont(primary, fontInterface));
+	/* channel list draws only visible rows, into surfaces reused as rows scroll out */
+	for (i = 0; i < CHANNEL_LIST_ROWS; i++)
+	{
+		channelRows[i].surface = backend->createSurface(CHANNEL_LIST_ROW_WIDTH, CHANNEL_LIST_ROW_HEIGHT);
+		channelRows[i].row = -1;
+		if (channelRows[i].surface == NULL)
+		{
+			return GC_ERROR;
+		}
+	}
 
 
 	if (pthread_create(&gcThread, NULL, &renderThread, NULL))
@@ -129,12 +296,12 @@ GraphicsControllerError graphicsControllerInit()
 
 GraphicsControllerError graphicsControllerDeinit()
 {
-	stopDrawing = 1;
+	uint8_t i = 0;
 
-	if (ETIMEDOUT == pthread_cond_wait(&graphicsCond, &graphicsMutex))
-	{
-		printf("Error neki koji god\n");
-	}
+	pthread_mutex_lock(&graphicsMutex);
+	stopDrawing = true;
+	pthread_cond_signal(&graphicsCond);
+	pthread_mutex_unlock(&graphicsMutex);
 
 	if (pthread_join(gcThread, NULL))
     {
@@ -144,247 +311,999 @@ GraphicsControllerError graphicsControllerDeinit()
 
 	printf("GCTHREAD joined!\n");
 
-	timer_delete(programNumberTimer);
-	timer_delete(volumeTimer);
-	timer_delete(infoTimer);
+	timerWheelCancel(timerWheel, &programNumberTimer);
+	timerWheelCancel(timerWheel, &volumeTimer);
+	timerWheelCancel(timerWheel, &infoTimer);
+	timerWheelCancel(timerWheel, &channelDialTimer);
+
+	printGraphicsStats();
+	imageCacheDeinit(&imageCache);
+	assetPackUnmap(&assetPack);
+	textCacheDeinit(&textCache);
+	serviceIndexClose(&serviceIndex);
+	pthread_mutex_lock(&epgMutex);
+	epgReady = false;
+	epgGridDeinit(&epgGrid);
+	pthread_mutex_unlock(&epgMutex);
+	for (i = 0; i < CHANNEL_LIST_ROWS; i++)
+	{
+		backend->releaseSurface(channelRows[i].surface);
+	}
 
-	primary->Release(primary);
-	dfbInterface->Release(dfbInterface);
+	backend->releaseFont(fontInterface);
+	backend->releaseSurface(primary);
+	backend->deinit();
 	return GC_NO_ERROR;
 
 }
 
 void* renderThread()
 {
-	char tempString[10];
+	DrawComponents components;
+	DrawComponents drawnComponents;
+	OsdRectangle boxes[OSD_ELEMENT_COUNT];
+	OsdRectangle damage;
+	bool firstFrame = true;
+	uint64_t frameStart = 0;
+	uint64_t frameTime = 0;
+	bool epgDrawn = false;
+	uint8_t i = 0;
 
-	while (!stopDrawing)
+	memset(&drawnComponents, 0x0, sizeof(DrawComponents));
+	memset(drawnBoxes, 0x0, sizeof(drawnBoxes));
+	frameStats.startNanoseconds = monotonicNanoseconds();
+
+	while (true)
 	{
-		wipeScreen();
+		/* sleep until something on screen changes, idle OSD costs no frames */
+		pthread_mutex_lock(&graphicsMutex);
+		while (!redrawNeeded && !stopDrawing)
+		{
+			pthread_cond_wait(&graphicsCond, &graphicsMutex);
+		}
+		if (stopDrawing)
+		{
+			pthread_mutex_unlock(&graphicsMutex);
+			break;
+		}
+		components = componentsToDraw;
+		redrawNeeded = false;
+		pthread_mutex_unlock(&graphicsMutex);
+
+		frameStart = monotonicNanoseconds();
 
-		if (componentsToDraw.showVolume)
+		/* damage is where changed elements were and where they are now */
+		memset(&damage, 0x0, sizeof(OsdRectangle));
+		for (i = 0; i < OSD_ELEMENT_COUNT; i++)
 		{
-    		/* create the image provider for the specified file */
-			switch (componentsToDraw.volume)
+			layoutElement(i, &components, &boxes[i]);
+			if (elementChanged(i, &components, &drawnComponents) || memcmp(&boxes[i], &drawnBoxes[i], sizeof(OsdRectangle)))
 			{
-				case 0:
-					DFBCHECK(dfbInterface->CreateImageProvider(dfbInterface, "volume_0.png", &provider));
-					break;
-				case 1:
-					DFBCHECK(dfbInterface->CreateImageProvider(dfbInterface, "volume_1.png", &provider));
-					break;
-				case 2:
-					DFBCHECK(dfbInterface->CreateImageProvider(dfbInterface, "volume_2.png", &provider));
-					break;
-				case 3:
-					DFBCHECK(dfbInterface->CreateImageProvider(dfbInterface, "volume_3.png", &provider));
-					break;
-				case 4:
-					DFBCHECK(dfbInterface->CreateImageProvider(dfbInterface, "volume_4.png", &provider));
-					break;
-				case 5:
-					DFBCHECK(dfbInterface->CreateImageProvider(dfbInterface, "volume_5.png", &provider));
-					break;
-				case 6:
-					DFBCHECK(dfbInterface->CreateImageProvider(dfbInterface, "volume_6.png", &provider));
-					break;
-				case 7:
-					DFBCHECK(dfbInterface->CreateImageProvider(dfbInterface, "volume_7.png", &provider));
-					break;
-				case 8:
-					DFBCHECK(dfbInterface->CreateImageProvider(dfbInterface, "volume_8.png", &provider));
-					break;
-				case 9:
-					DFBCHECK(dfbInterface->CreateImageProvider(dfbInterface, "volume_9.png", &provider));
-					break;
-				case 10:
-					DFBCHECK(dfbInterface->CreateImageProvider(dfbInterface, "volume_10.png", &provider));
-					break;
+				unionRectangle(&damage, &drawnBoxes[i]);
+				unionRectangle(&damage, &boxes[i]);
 			}
-
-    		/* get surface descriptor for the surface where the image will be rendered */
-			DFBCHECK(provider->GetSurfaceDescription(provider, &surfaceDesc));
-    		/* create the surface for the image */
-			DFBCHECK(dfbInterface->CreateSurface(dfbInterface, &surfaceDesc, &logoSurface));
-    		/* render the image to the surface */
-			DFBCHECK(provider->RenderTo(provider, logoSurface, NULL));
-	
-    		/* cleanup the provider after rendering the image to the surface */
-			provider->Release(provider);
-	
-    		/* fetch the logo size and add (blit) it to the screen */
-			DFBCHECK(logoSurface->GetSize(logoSurface, &logoWidth, &logoHeight));
-		DFBCHECK(primary->Blit(primary, logoSurface, NULL, screenWidth - logoWidth - 100, 350));
 		}
+		if (firstFrame)
+		{
+			/* both buffers start with undefined content */
+			damage.x = 0;
+			damage.y = 0;
+			damage.w = screenWidth;
+			damage.h = screenHeight;
+			firstFrame = false;
+		}
+
+		epgDrawn = intersectionArea(&boxes[OSD_ELEMENT_EPG], &damage) > 0;
+		if (damage.w > 0 && damage.h > 0)
+		{
+			backend->setClip(primary, &damage);
+			wipeRectangle(&damage);
+			frameStats.filledPixels += (uint64_t)damage.w * damage.h;
+			frameStats.fullFramePixels += (uint64_t)screenWidth * screenHeight;
+
+			/* elements are redrawn in full but clipped, so overlapping ones stay intact */
+			for (i = 0; i < OSD_ELEMENT_COUNT; i++)
+			{
+				if (boxes[i].w > 0 && boxes[i].h > 0)
+				{
+					frameStats.filledPixels += intersectionArea(&boxes[i], &damage);
+					frameStats.fullFramePixels += (uint64_t)boxes[i].w * boxes[i].h;
+					if (intersectionArea(&boxes[i], &damage))
+					{
+						renderElement(i, &components);
+					}
+				}
+			}
+			backend->setClip(primary, NULL);
 
-		if (componentsToDraw.showInfo)
+			/* only the damage is copied to the front buffer, back buffer keeps the whole frame */
+			backend->flip(primary, &damage);
+		}
+		else
 		{
-			primary->SetColor(primary, 0xe0, 0x91, 0xd7, 0xEF);
-    		primary->FillRectangle(primary, 3*screenWidth/10, 3*screenHeight/4, 4*screenWidth/10, screenHeight/5);
+			frameStats.skippedFrameCount++;
+		}
+
+		memcpy(drawnBoxes, boxes, sizeof(drawnBoxes));
+		drawnComponents = components;
 
-			DFBCHECK(primary->SetColor(primary, 0x00, 0x00, 0x00, 0xFF));
+		frameTime = monotonicNanoseconds() - frameStart;
+		frameStats.frameCount++;
+		frameStats.totalNanoseconds += frameTime;
+		if (frameTime > frameStats.maxNanoseconds)
+		{
+			frameStats.maxNanoseconds = frameTime;
+		}
+		if (epgDrawn)
+		{
+			frameStats.epgFrameCount++;
+			frameStats.epgTotalNanoseconds += frameTime;
+			if (frameTime > frameStats.epgMaxNanoseconds)
+			{
+				frameStats.epgMaxNanoseconds = frameTime;
+			}
+			if (frameTime > EPG_FRAME_BUDGET)
+			{
+				frameStats.epgLateFrameCount++;
+			}
+		}
+	}
 
-			sprintf(tempString, "Video PID : %d", videoPidToDraw);
+	frameStats.wallNanoseconds = monotonicNanoseconds() - frameStats.startNanoseconds;
+	frameStats.cpuNanoseconds = threadCpuNanoseconds();
 
-			DFBCHECK(primary->DrawString(primary, tempString, -1, 3*screenWidth/9 - 50, 3*screenHeight/4 + 40, DSTF_LEFT));
+	return NULL;
+}
 
-			sprintf(tempString, "Audio PID : %d", audioPidToDraw);
+void layoutElement(OsdElement element, const DrawComponents* components, OsdRectangle* box)
+{
+	int32_t volumeWidth = 0;
+	int32_t volumeHeight = 0;
 
-			DFBCHECK(primary->DrawString(primary, tempString, -1, 3*screenWidth/9 - 50, 3*screenHeight/4 + 80, DSTF_LEFT));
+	memset(box, 0x0, sizeof(OsdRectangle));
 
-			if (YearToDraw == 0)
+	switch (element)
+	{
+		case OSD_ELEMENT_EPG:
+			if (components->showEpg)
+			{
+				box->x = EPG_X;
+				box->y = EPG_Y;
+				box->w = EPG_CHANNEL_WIDTH + EPG_GRID_SLOTS * EPG_GRID_TILE_WIDTH;
+				box->h = EPG_HEADER_HEIGHT + EPG_GRID_TILE_HEIGHT * ((components->epgRowCount - components->epgTopRow < EPG_GRID_ROWS) ?
+						 components->epgRowCount - components->epgTopRow : EPG_GRID_ROWS);
+				if (components->epgRowCount == 0)
+				{
+					box->h += EPG_GRID_TILE_HEIGHT;
+				}
+			}
+			break;
+		case OSD_ELEMENT_PROGRAM_NUMBER:
+			if (components->showProgramNumber)
+			{
+				box->x = PROGRAM_NUMBER_X;
+				box->y = PROGRAM_NUMBER_Y;
+				box->w = PROGRAM_NUMBER_WIDTH;
+				box->h = PROGRAM_NUMBER_HEIGHT;
+			}
+			break;
+		case OSD_ELEMENT_VOLUME:
+			if (components->showVolume && components->volume >= 0 && components->volume < VOLUME_LEVELS
+				&& imageCacheGet(&imageCache, volumeAssets[components->volume], &volumeWidth, &volumeHeight) != NULL)
 			{
-				sprintf(tempString, "Date not available");
+				box->x = screenWidth - volumeWidth - 100;
+				box->y = 350;
+				box->w = volumeWidth;
+				box->h = volumeHeight;
 			}
-			else
+			break;
+		case OSD_ELEMENT_INFO:
+			if (components->showInfo)
 			{
-				switch(tmpMonthToDraw)
-			   	{ 
-			 	case 1:
-			    		sprintf(tempString, "January/%.2d/%.4d", dayToDraw, YearToDraw);
-			 		  	break;
-			 	case 2:
-			    		sprintf(tempString, "February/%.2d/%.4d", dayToDraw, YearToDraw);
-			 		  	break;
-			 	case 3:
-			    		sprintf(tempString, "March/%.2d/%.4d", dayToDraw, YearToDraw);
-			 		  	break;
-			 	case 4:
-			    		sprintf(tempString, "April/%.2d/%.4d", dayToDraw, YearToDraw);
-			 		  	break;
-			 	case 5:
-			    		sprintf(tempString, "May/%.2d/%.4d", dayToDraw, YearToDraw);
-			 		  	break;
-			 	case 6:
-			    		sprintf(tempString, "June/%.2d/%.4d", dayToDraw, YearToDraw);
-			 		  	break;
-				case 7:
-			    		sprintf(tempString, "July/%.2d/%.4d", dayToDraw, YearToDraw);
-			 		  	break;
-				case 8:
-			    		sprintf(tempString, "August/%.2d/%.4d", dayToDraw, YearToDraw);
-			 		  	break;
-				case 9:
-			    		sprintf(tempString, "September/%.2d/%.4d", dayToDraw, YearToDraw);
-			 		  	break;
-				case 10:
-			    		sprintf(tempString, "October/%.2d/%.4d", dayToDraw, YearToDraw);
-			 		  	break;
-				case 11:
-			    		sprintf(tempString, "November/%.2d/%.4d", dayToDraw, YearToDraw);
-			 		  	break;
-				case 12:
-			    		sprintf(tempString, "December/%.2d/%.4d", dayToDraw, YearToDraw);
-			 		  	break;
-			 	}
+				/* panel and the date line below it */
+				box->x = 3*screenWidth/10;
+				box->y = 3*screenHeight/4;
+				box->w = 4*screenWidth/10;
+				box->h = screenHeight - 3*screenHeight/4;
 			}
+			break;
+		case OSD_ELEMENT_CHANNEL_DIAL:
+			if (components->showChannelDial && components->channelCount > 0)
+			{
+				box->x = CHANNEL_LIST_X;
+				box->y = CHANNEL_LIST_Y;
+				box->w = CHANNEL_LIST_ROW_WIDTH;
+				box->h = CHANNEL_LIST_ROW_HEIGHT * ((components->channelCount - components->channelTop < CHANNEL_LIST_ROWS) ?
+						 components->channelCount - components->channelTop : CHANNEL_LIST_ROWS);
+			}
+			break;
+		default:
+			break;
+	}
+}
+
+bool elementChanged(OsdElement element, const DrawComponents* components, const DrawComponents* drawn)
+{
+	switch (element)
+	{
+		case OSD_ELEMENT_EPG:
+			return components->showEpg != drawn->showEpg || components->epgTopRow != drawn->epgTopRow
+				|| components->epgLeftSlot != drawn->epgLeftSlot || components->epgCursorRow != drawn->epgCursorRow
+				|| components->epgCursorTime != drawn->epgCursorTime || components->epgRowCount != drawn->epgRowCount
+				|| components->epgGeneration != drawn->epgGeneration;
+		case OSD_ELEMENT_PROGRAM_NUMBER:
+			return components->showProgramNumber != drawn->showProgramNumber
+				|| components->programNumber != drawn->programNumber;
+		case OSD_ELEMENT_VOLUME:
+			return components->showVolume != drawn->showVolume || components->volume != drawn->volume;
+		case OSD_ELEMENT_INFO:
+			return components->showInfo != drawn->showInfo || components->audioPid != drawn->audioPid
+				|| components->videoPid != drawn->videoPid || components->year != drawn->year
+				|| components->month != drawn->month || components->day != drawn->day;
+		case OSD_ELEMENT_CHANNEL_DIAL:
+			return components->showChannelDial != drawn->showChannelDial || components->channelCount != drawn->channelCount
+				|| components->channelTop != drawn->channelTop || components->channelSelected != drawn->channelSelected
+				|| components->channelGeneration != drawn->channelGeneration;
+		default:
+			return false;
+	}
+}
+
+void renderElement(OsdElement element, const DrawComponents* components)
+{
+	switch (element)
+	{
+		case OSD_ELEMENT_EPG:
+			renderEpg(components);
+			break;
+		case OSD_ELEMENT_PROGRAM_NUMBER:
+			renderProgramNumber(components);
+			break;
+		case OSD_ELEMENT_VOLUME:
+			renderVolumeBar(components);
+			break;
+		case OSD_ELEMENT_INFO:
+			renderInfo(components);
+			break;
+		case OSD_ELEMENT_CHANNEL_DIAL:
+			renderChannelList(components);
+			break;
+		default:
+			break;
+	}
+}
+
+void renderProgramNumber(const DrawComponents* components)
+{
+	OsdRectangle panel = {PROGRAM_NUMBER_X, PROGRAM_NUMBER_Y, PROGRAM_NUMBER_WIDTH, PROGRAM_NUMBER_HEIGHT};
+	char numberString[12];
+
+	snprintf(numberString, sizeof(numberString), "%d", components->programNumber);
+
+	backend->fill(primary, &panel, PANEL_COLOR);
+	renderText(numberString, PROGRAM_NUMBER_X + 30, PROGRAM_NUMBER_Y + 70);
+}
+
+void renderVolumeBar(const DrawComponents* components)
+{
+	OsdSurface* volumeSurface = NULL;
+	int32_t volumeWidth = 0;
+	int32_t volumeHeight = 0;
+
+	volumeSurface = imageCacheGet(&imageCache, volumeAssets[components->volume], &volumeWidth, &volumeHeight);
+	if (volumeSurface != NULL)
+	{
+		backend->blit(primary, volumeSurface, screenWidth - volumeWidth - 100, 350, false);
+	}
+}
+
+void renderInfo(const DrawComponents* components)
+{
+	OsdRectangle panel = {3*screenWidth/10, 3*screenHeight/4, 4*screenWidth/10, screenHeight/5};
+	char line[TEXT_CACHE_MAX_TEXT_LENGTH];
+
+	backend->fill(primary, &panel, PANEL_COLOR);
+
+	snprintf(line, sizeof(line), "Video PID : %d", components->videoPid);
+	renderText(line, 3*screenWidth/9 - 50, 3*screenHeight/4 + 40);
+
+	snprintf(line, sizeof(line), "Audio PID : %d", components->audioPid);
+	renderText(line, 3*screenWidth/9 - 50, 3*screenHeight/4 + 80);
+
+	if (components->year == 0 || components->month < 1 || components->month > 12)
+	{
+		snprintf(line, sizeof(line), "Date not available");
+	}
+	else
+	{
+		snprintf(line, sizeof(line), "%s/%.2d/%.4d", monthNames[components->month - 1], components->day, components->year);
+	}
+	renderText(line, 3*screenWidth/9 - 50, screenHeight - 60);
+}
+
+void renderText(const char* text, int32_t x, int32_t y)
+{
+	OsdSurface* textSurface = NULL;
+	int32_t textWidth = 0;
+	int32_t textHeight = 0;
+
+	/* y is the baseline, as with DrawString */
+	textSurface = textCacheGet(&textCache, text, fontInterface, TEXT_COLOR, &textWidth, &textHeight);
+	if (textSurface != NULL)
+	{
+		backend->blit(primary, textSurface, x, y - fontAscender, true);
+	}
+}
+
+void renderChannelList(const DrawComponents* components)
+{
+	OsdRectangle panel;
+	OsdRectangle selection = {CHANNEL_LIST_X, CHANNEL_LIST_Y, CHANNEL_LIST_ROW_WIDTH, CHANNEL_LIST_ROW_HEIGHT};
+	ChannelRow* channelRow = NULL;
+	int32_t bottom = 0;
+	int32_t row = 0;
+	uint8_t i = 0;
+
+	layoutElement(OSD_ELEMENT_CHANNEL_DIAL, components, &panel);
+	backend->fill(primary, &panel, PANEL_COLOR);
+	selection.y += (components->channelSelected - components->channelTop) * CHANNEL_LIST_ROW_HEIGHT;
+	backend->fill(primary, &selection, SELECTION_COLOR);
+
+	/* only rows on screen are drawn, the index may have been reloaded since components were taken */
+	pthread_mutex_lock(&serviceIndexMutex);
+	bottom = components->channelTop + panel.h / CHANNEL_LIST_ROW_HEIGHT;
+	if (bottom > serviceIndex.count)
+	{
+		bottom = serviceIndex.count;
+	}
+	for (i = 0; i < CHANNEL_LIST_ROWS; i++)
+	{
+		channelRows[i].used = false;
+	}
+
+	for (row = components->channelTop; row < bottom; row++)
+	{
+		channelRow = findChannelRow(row, serviceIndexGeneration);
+		if (channelRow == NULL)
+		{
+			channelRow = recycleChannelRow(components->channelTop, bottom);
+			drawChannelRow(channelRow, row);
+			frameStats.channelRowDrawCount++;
+		}
+		else
+		{
+			frameStats.channelRowReuseCount++;
+		}
+		channelRow->used = true;
+
+		/* rows are transparent but for the text, so selection shows through */
+		backend->blit(primary, channelRow->surface, CHANNEL_LIST_X,
+					  CHANNEL_LIST_Y + (row - components->channelTop) * CHANNEL_LIST_ROW_HEIGHT, true);
+	}
+	pthread_mutex_unlock(&serviceIndexMutex);
+}
+
+ChannelRow* findChannelRow(int32_t row, uint32_t generation)
+{
+	uint8_t i = 0;
 
-			DFBCHECK(primary->DrawString(primary, tempString, -1, 3*screenWidth/9 - 50, screenHeight - 60, DSTF_LEFT));
+	for (i = 0; i < CHANNEL_LIST_ROWS; i++)
+	{
+		if (channelRows[i].row == row && channelRows[i].generation == generation)
+		{
+			return &channelRows[i];
 		}
+	}
+
+	return NULL;
+}
 
-		if (componentsToDraw.showChannelDial)
+ChannelRow* recycleChannelRow(int32_t top, int32_t bottom)
+{
+	uint8_t i = 0;
+
+	/* there are as many surfaces as visible rows, so one always holds a row that is off screen or stale */
+	for (i = 0; i < CHANNEL_LIST_ROWS; i++)
+	{
+		if (!channelRows[i].used && (channelRows[i].row < top || channelRows[i].row >= bottom
+			|| channelRows[i].generation != serviceIndexGeneration))
 		{
+			return &channelRows[i];
 		}
-		DFBCHECK(primary->Flip(primary, NULL, 0));
 	}
 
-	pthread_mutex_lock(&graphicsMutex);
-	pthread_cond_signal(&graphicsCond);
-	pthread_mutex_unlock(&graphicsMutex);
+	return NULL;
+}
+
+void drawChannelRow(ChannelRow* channelRow, int32_t row)
+{
+	OsdRectangle area = {0, 0, CHANNEL_LIST_ROW_WIDTH, CHANNEL_LIST_ROW_HEIGHT};
+	char numberString[8];
+	int32_t textY = (CHANNEL_LIST_ROW_HEIGHT - fontHeight) / 2;
+
+	snprintf(numberString, sizeof(numberString), "%u", serviceIndex.entries[row].number);
+
+	/* name is drawn straight from the mapped database, called with serviceIndexMutex held */
+	backend->fill(channelRow->surface, &area, 0x00000000);
+	backend->drawString(channelRow->surface, fontInterface, numberString, 10, textY, TEXT_COLOR);
+	backend->drawString(channelRow->surface, fontInterface, serviceIndexService(&serviceIndex, row)->name,
+						CHANNEL_LIST_NAME_X, textY, TEXT_COLOR);
+
+	channelRow->row = row;
+	channelRow->generation = serviceIndexGeneration;
+}
+
+void renderEpg(const DrawComponents* components)
+{
+	OsdRectangle panel;
+	OsdRectangle area;
+	char line[TEXT_CACHE_MAX_TEXT_LENGTH];
+	struct tm slotDate;
+	time_t slotTime = 0;
+	int32_t textOffset = (EPG_GRID_TILE_HEIGHT - fontHeight) / 2 + fontAscender;
+	int32_t rowCount = 0;
+	int32_t row = 0;
+	int32_t slot = 0;
+
+	/* header and service names, the grid itself is covered by tiles */
+	layoutElement(OSD_ELEMENT_EPG, components, &panel);
+	rowCount = (panel.h - EPG_HEADER_HEIGHT) / EPG_GRID_TILE_HEIGHT;
+	area = panel;
+	area.h = EPG_HEADER_HEIGHT;
+	backend->fill(primary, &area, PANEL_COLOR);
+	area.y += EPG_HEADER_HEIGHT;
+	area.w = EPG_CHANNEL_WIDTH;
+	area.h = panel.h - EPG_HEADER_HEIGHT;
+	backend->fill(primary, &area, PANEL_COLOR);
+
+	slotTime = (time_t)components->epgLeftSlot * EPG_GRID_SLOT_SECONDS;
+	localtime_r(&slotTime, &slotDate);
+	strftime(line, sizeof(line), "%a %d.%m", &slotDate);
+	renderText(line, panel.x + 10, panel.y + textOffset);
+	for (slot = 0; slot < EPG_GRID_SLOTS; slot++)
+	{
+		slotTime = (time_t)(components->epgLeftSlot + slot) * EPG_GRID_SLOT_SECONDS;
+		localtime_r(&slotTime, &slotDate);
+		strftime(line, sizeof(line), "%H:%M", &slotDate);
+		renderText(line, panel.x + EPG_CHANNEL_WIDTH + slot * EPG_GRID_TILE_WIDTH + 10, panel.y + textOffset);
+	}
+
+	pthread_mutex_lock(&epgMutex);
+	if (epg.serviceCount == 0)
+	{
+		area.x = panel.x + EPG_CHANNEL_WIDTH;
+		area.w = panel.w - EPG_CHANNEL_WIDTH;
+		backend->fill(primary, &area, PANEL_COLOR);
+		renderText("No programme guide", area.x + 10, area.y + textOffset);
+	}
+
+	/* rows added since components were taken are left to the next frame */
+	for (row = 0; row < rowCount && components->epgTopRow + row < epg.serviceCount; row++)
+	{
+		renderText(epg.services[components->epgTopRow + row].name, panel.x + 10,
+				   panel.y + EPG_HEADER_HEIGHT + row * EPG_GRID_TILE_HEIGHT + textOffset);
+	}
+	if (rowCount > 0 && epg.serviceCount > 0)
+	{
+		epgGridDraw(&epgGrid, &epg, primary, panel.x + EPG_CHANNEL_WIDTH, panel.y + EPG_HEADER_HEIGHT,
+					components->epgTopRow, components->epgLeftSlot, components->epgCursorRow, components->epgCursorTime);
+	}
+	pthread_mutex_unlock(&epgMutex);
+}
+
+void wipeRectangle(const OsdRectangle* rectangle)
+{
+    /* clear part of screen */
+    backend->fill(primary, rectangle, 0x00000000);
+}
+
+void unionRectangle(OsdRectangle* target, const OsdRectangle* rectangle)
+{
+	int32_t x2 = 0;
+	int32_t y2 = 0;
+
+	if (rectangle->w <= 0 || rectangle->h <= 0)
+	{
+		return;
+	}
+	if (target->w <= 0 || target->h <= 0)
+	{
+		*target = *rectangle;
+		return;
+	}
+
+	x2 = (target->x + target->w > rectangle->x + rectangle->w) ? target->x + target->w : rectangle->x + rectangle->w;
+	y2 = (target->y + target->h > rectangle->y + rectangle->h) ? target->y + target->h : rectangle->y + rectangle->h;
+	target->x = (target->x < rectangle->x) ? target->x : rectangle->x;
+	target->y = (target->y < rectangle->y) ? target->y : rectangle->y;
+	target->w = x2 - target->x;
+	target->h = y2 - target->y;
+}
+
+uint64_t intersectionArea(const OsdRectangle* first, const OsdRectangle* second)
+{
+	int32_t x1 = (first->x > second->x) ? first->x : second->x;
+	int32_t y1 = (first->y > second->y) ? first->y : second->y;
+	int32_t x2 = (first->x + first->w < second->x + second->w) ? first->x + first->w : second->x + second->w;
+	int32_t y2 = (first->y + first->h < second->y + second->h) ? first->y + first->h : second->y + second->h;
+
+	if (x2 <= x1 || y2 <= y1)
+	{
+		return 0;
+	}
+
+	return (uint64_t)(x2 - x1) * (y2 - y1);
 }
 
-void wipeScreen()
+void requestRedraw()
 {
-    /* clear screen */
-    DFBCHECK(primary->SetColor(primary, 0x00, 0x00, 0x00, 0x00));
-    DFBCHECK(primary->FillRectangle(primary, 0, 0, screenWidth, screenHeight));
+	/* called with graphicsMutex held */
+	redrawNeeded = true;
+	pthread_cond_signal(&graphicsCond);
 }
 
-void drawProgramNumber()
+void drawProgramNumber(int32_t programNumber)
 {
+	timerWheelArm(timerWheel, &programNumberTimer, PROGRAM_NUMBER_TIMEOUT);
 
-	timer_settime(programNumberTimer, timerFlags, &programTimerSpec, &programTimerSpecOld);
+	pthread_mutex_lock(&graphicsMutex);
+	componentsToDraw.programNumber = programNumber;
 	componentsToDraw.showProgramNumber = true;
+	requestRedraw();
+	pthread_mutex_unlock(&graphicsMutex);
 }
 
 void drawVolumeBar(uint8_t volumeValue)
 {
+	timerWheelArm(timerWheel, &volumeTimer, VOLUME_TIMEOUT);
+
+	pthread_mutex_lock(&graphicsMutex);
 	componentsToDraw.volume = volumeValue;
-	timer_settime(volumeTimer, timerFlags, &volumeTimerSpec, &volumeTimerSpecOld);
 	componentsToDraw.showVolume = true;
+	requestRedraw();
+	pthread_mutex_unlock(&graphicsMutex);
 }
 
 void drawInfoRect(uint8_t tmpMonth, uint8_t day, uint16_t Year, int16_t audioPid, int16_t videoPid)
 {
-	timer_settime(infoTimer, timerFlags, &infoTimerSpec, &infoTimerSpecOld);
-
-	audioPidToDraw = audioPid;
-	videoPidToDraw = videoPid;
+	timerWheelArm(timerWheel, &infoTimer, INFO_TIMEOUT);
 
-	YearToDraw = Year;
-	tmpMonthToDraw = tmpMonth;
-	dayToDraw = day;
-	/*hoursToDraw = hours;
-	minutesToDraw = minutes;
-	*/
+	pthread_mutex_lock(&graphicsMutex);
+	componentsToDraw.audioPid = audioPid;
+	componentsToDraw.videoPid = videoPid;
+	componentsToDraw.year = Year;
+	componentsToDraw.month = tmpMonth;
+	componentsToDraw.day = day;
 	componentsToDraw.showInfo = true;
+	requestRedraw();
+	pthread_mutex_unlock(&graphicsMutex);
+}
+
+void graphicsControllerSetChannelDatabase(const char* path)
+{
+	pthread_mutex_lock(&serviceIndexMutex);
+	snprintf(channelDatabasePath, sizeof(channelDatabasePath), "%s", path);
+	pthread_mutex_unlock(&serviceIndexMutex);
+
+	/* programme guide takes service names from the list, so it is loaded right away */
+	loadChannels();
+}
+
+void channelDial(int32_t step)
+{
+	bool opening = false;
+
+	pthread_mutex_lock(&graphicsMutex);
+	opening = !componentsToDraw.showChannelDial;
+	pthread_mutex_unlock(&graphicsMutex);
+
+	/* database may have changed while list was closed, it is loaded again on every opening */
+	if (opening)
+	{
+		loadChannels();
+	}
+
+	timerWheelArm(timerWheel, &channelDialTimer, CHANNEL_DIAL_TIMEOUT);
+
+	pthread_mutex_lock(&graphicsMutex);
+	if (!componentsToDraw.showChannelDial)
+	{
+		componentsToDraw.showChannelDial = true;
+	}
+	else if (componentsToDraw.channelCount > 0)
+	{
+		componentsToDraw.channelSelected = ((componentsToDraw.channelSelected + step) % componentsToDraw.channelCount
+											+ componentsToDraw.channelCount) % componentsToDraw.channelCount;
+	}
+	scrollChannelList(&componentsToDraw);
+	requestRedraw();
+	pthread_mutex_unlock(&graphicsMutex);
+}
+
+bool channelDialSelection(uint32_t* frequency, int32_t* channelNumber)
+{
+	bool selected = false;
+	uint16_t row = 0;
+	uint32_t generation = 0;
+
+	pthread_mutex_lock(&graphicsMutex);
+	selected = componentsToDraw.showChannelDial && componentsToDraw.channelCount > 0;
+	row = componentsToDraw.channelSelected;
+	generation = componentsToDraw.channelGeneration;
+	pthread_mutex_unlock(&graphicsMutex);
+
+	if (!selected)
+	{
+		return false;
+	}
+
+	pthread_mutex_lock(&serviceIndexMutex);
+	selected = generation == serviceIndexGeneration && row < serviceIndex.count;
+	if (selected)
+	{
+		*frequency = serviceIndexFrequency(&serviceIndex, row);
+		*channelNumber = serviceIndexService(&serviceIndex, row)->patIndex - 1;
+	}
+	pthread_mutex_unlock(&serviceIndexMutex);
+
+	return selected;
+}
+
+GraphicsControllerError loadChannels()
+{
+	ServiceIndexError result = SERVICE_INDEX_NO_ERROR;
+	uint32_t generation = 0;
+	uint16_t count = 0;
+
+	pthread_mutex_lock(&serviceIndexMutex);
+	serviceIndexClose(&serviceIndex);
+	if (channelDatabasePath[0] != '\0')
+	{
+		result = serviceIndexOpen(&serviceIndex, channelDatabasePath);
+	}
+	count = serviceIndex.count;
+	generation = ++serviceIndexGeneration;
+	pthread_mutex_unlock(&serviceIndexMutex);
+
+	pthread_mutex_lock(&graphicsMutex);
+	componentsToDraw.channelCount = count;
+	componentsToDraw.channelGeneration = generation;
+	if (componentsToDraw.channelSelected >= count)
+	{
+		componentsToDraw.channelSelected = 0;
+	}
+	scrollChannelList(&componentsToDraw);
+	requestRedraw();
+	pthread_mutex_unlock(&graphicsMutex);
+
+	return (result == SERVICE_INDEX_NO_ERROR) ? GC_NO_ERROR : GC_ERROR;
+}
+
+void scrollChannelList(DrawComponents* components)
+{
+	/* called with graphicsMutex held, list scrolls just enough to keep selection visible */
+	if (components->channelSelected < components->channelTop)
+	{
+		components->channelTop = components->channelSelected;
+	}
+	else if (components->channelSelected >= components->channelTop + CHANNEL_LIST_ROWS)
+	{
+		components->channelTop = components->channelSelected - CHANNEL_LIST_ROWS + 1;
+	}
+	if (components->channelTop >= components->channelCount)
+	{
+		components->channelTop = 0;
+	}
+}
+
+void graphicsControllerStoreEvents(const EitTable* eitTable)
+{
+	char name[TABLES_MAX_NAME_LENGTH];
+	EpgChange change;
+	uint16_t number = 0;
+	uint16_t rowCount = 0;
+	int32_t row = 0;
+	int32_t addedRow = -1;
+	bool visible = false;
+
+	change.changed = false;
+
+	pthread_mutex_lock(&epgMutex);
+	if (!epgReady)
+	{
+		pthread_mutex_unlock(&epgMutex);
+		return;
+	}
+	row = epgFindService(&epg, eitTable->transportStreamId, eitTable->serviceId);
+	pthread_mutex_unlock(&epgMutex);
+
+	/* name and number come from channel list, looked up once when service gets its row */
+	if (row < 0)
+	{
+		findServiceName(eitTable->transportStreamId, eitTable->serviceId, &number, name);
+	}
+
+	pthread_mutex_lock(&epgMutex);
+	if (!epgReady)
+	{
+		pthread_mutex_unlock(&epgMutex);
+		return;
+	}
+	if (row < 0)
+	{
+		/* row may have been added meanwhile, epgAddService then returns it */
+		rowCount = epg.serviceCount;
+		if (epgAddService(&epg, eitTable->transportStreamId, eitTable->serviceId, number, name, &row) != EPG_NO_ERROR)
+		{
+			pthread_mutex_unlock(&epgMutex);
+			return;
+		}
+		if (epg.serviceCount != rowCount)
+		{
+			addedRow = row;
+			epgGridInvalidateRows(&epgGrid, row);
+		}
+	}
+	epgStoreEvents(&epg, row, eitTable, &change);
+	if (change.changed)
+	{
+		epgGridInvalidate(&epgGrid, row, change.start, change.end);
+	}
+	rowCount = epg.serviceCount;
+	pthread_mutex_unlock(&epgMutex);
+
+	if (addedRow < 0 && !change.changed)
+	{
+		return;
+	}
+
+	/* sections keep arriving while guide is open, only changes on screen cost a frame */
+	pthread_mutex_lock(&graphicsMutex);
+	componentsToDraw.epgRowCount = rowCount;
+	if (addedRow >= 0 && addedRow <= componentsToDraw.epgCursorRow && rowCount > 1)
+	{
+		componentsToDraw.epgCursorRow++;
+	}
+	if (componentsToDraw.showEpg)
+	{
+		visible = (addedRow >= 0 && addedRow < componentsToDraw.epgTopRow + EPG_GRID_ROWS) ||
+				  (change.changed && row >= componentsToDraw.epgTopRow && row < componentsToDraw.epgTopRow + EPG_GRID_ROWS &&
+				   change.start < (uint32_t)(componentsToDraw.epgLeftSlot + EPG_GRID_SLOTS) * EPG_GRID_SLOT_SECONDS &&
+				   change.end > (uint32_t)componentsToDraw.epgLeftSlot * EPG_GRID_SLOT_SECONDS);
+		scrollEpg(&componentsToDraw);
+	}
+	if (visible)
+	{
+		componentsToDraw.epgGeneration++;
+		requestRedraw();
+	}
+	pthread_mutex_unlock(&graphicsMutex);
+}
+
+void drawEpgGrid(bool show)
+{
+	time_t now = time(NULL);
+
+	/* guide covers channel list, list is closed when guide opens */
+	if (show)
+	{
+		timerWheelCancel(timerWheel, &channelDialTimer);
+	}
+
+	pthread_mutex_lock(&graphicsMutex);
+	if (show && !componentsToDraw.showEpg)
+	{
+		componentsToDraw.showChannelDial = false;
+		epgFirstSlot = now / EPG_GRID_SLOT_SECONDS;
+		componentsToDraw.epgLeftSlot = epgFirstSlot;
+		componentsToDraw.epgCursorTime = now;
+		scrollEpg(&componentsToDraw);
+	}
+	componentsToDraw.showEpg = show;
+	requestRedraw();
+	pthread_mutex_unlock(&graphicsMutex);
+}
+
+bool isEpgGridShown()
+{
+	bool shown = false;
+
+	pthread_mutex_lock(&graphicsMutex);
+	shown = componentsToDraw.showEpg;
+	pthread_mutex_unlock(&graphicsMutex);
+
+	return shown;
 }
 
-void setTimerParams()
+void moveEpgCursor(int32_t rowStep, int32_t eventStep)
 {
-	/* Setting timer for program number */
-	programSignalEvent.sigev_notify = SIGEV_THREAD;
-	programSignalEvent.sigev_notify_function = removeProgramNumber;
-	programSignalEvent.sigev_value.sival_ptr = NULL;
-	programSignalEvent.sigev_notify_attributes = NULL;
-	timer_create(CLOCK_REALTIME, &programSignalEvent, &programNumberTimer);
+	uint32_t start = 0;
+	uint32_t end = 0;
+	uint32_t time = 0;
+	uint32_t firstTime = 0;
+	uint32_t lastTime = 0;
+	int32_t row = 0;
+	bool shown = false;
+
+	pthread_mutex_lock(&graphicsMutex);
+	shown = componentsToDraw.showEpg;
+	row = componentsToDraw.epgCursorRow + rowStep;
+	time = componentsToDraw.epgCursorTime;
+	firstTime = (uint32_t)epgFirstSlot * EPG_GRID_SLOT_SECONDS;
+	pthread_mutex_unlock(&graphicsMutex);
+
+	if (!shown)
+	{
+		return;
+	}
+
+	/* cursor moves from event to event, and by one slot where nothing is scheduled */
+	pthread_mutex_lock(&epgMutex);
+	if (row >= epg.serviceCount)
+	{
+		row = epg.serviceCount - 1;
+	}
+	if (row < 0)
+	{
+		row = 0;
+	}
+	for (; eventStep > 0; eventStep--)
+	{
+		epgGridCursorSpan(&epg, row, time, &start, &end);
+		time = end;
+	}
+	for (; eventStep < 0; eventStep++)
+	{
+		epgGridCursorSpan(&epg, row, time, &start, &end);
+		epgGridCursorSpan(&epg, row, start - 1, &start, &end);
+		time = start;
+	}
+	pthread_mutex_unlock(&epgMutex);
+
+	lastTime = firstTime + EPG_DAYS * 24 * 3600 - 1;
+	if (time < firstTime)
+	{
+		time = firstTime;
+	}
+	if (time > lastTime)
+	{
+		time = lastTime;
+	}
+
+	pthread_mutex_lock(&graphicsMutex);
+	componentsToDraw.epgCursorRow = row;
+	componentsToDraw.epgCursorTime = time;
+	scrollEpg(&componentsToDraw);
+	requestRedraw();
+	pthread_mutex_unlock(&graphicsMutex);
+}
 
-	/*  */
-	memset(&programTimerSpec, 0, sizeof(programTimerSpec));
-	programTimerSpec.it_value.tv_sec = 4;
-	programTimerSpec.it_value.tv_nsec = 0;
+void scrollEpg(DrawComponents* components)
+{
+	int32_t slot = components->epgCursorTime / EPG_GRID_SLOT_SECONDS;
 
-	/* Setting timer for volume bar */
-	volumeSignalEvent.sigev_notify = SIGEV_THREAD;
-	volumeSignalEvent.sigev_notify_function = removeVolumeBar;
-	volumeSignalEvent.sigev_value.sival_ptr = NULL;
-	volumeSignalEvent.sigev_notify_attributes = NULL;
-	timer_create(CLOCK_REALTIME, &volumeSignalEvent, &volumeTimer);
+	/* called with graphicsMutex held, grid scrolls just enough to keep cursor visible */
+	if (slot < components->epgLeftSlot)
+	{
+		components->epgLeftSlot = slot;
+	}
+	else if (slot >= components->epgLeftSlot + EPG_GRID_SLOTS)
+	{
+		components->epgLeftSlot = slot - EPG_GRID_SLOTS + 1;
+	}
 
-    /* */
-	memset(&volumeTimerSpec, 0, sizeof(volumeTimerSpec));
-	volumeTimerSpec.it_value.tv_sec = 3;
-	volumeTimerSpec.it_value.tv_nsec = 0;
+	if (components->epgCursorRow >= components->epgRowCount)
+	{
+		components->epgCursorRow = (components->epgRowCount > 0) ? components->epgRowCount - 1 : 0;
+	}
+	if (components->epgCursorRow < components->epgTopRow)
+	{
+		components->epgTopRow = components->epgCursorRow;
+	}
+	else if (components->epgCursorRow >= components->epgTopRow + EPG_GRID_ROWS)
+	{
+		components->epgTopRow = components->epgCursorRow - EPG_GRID_ROWS + 1;
+	}
+}
 
-	/* Setting timer for info bar */
-	infoSignalEvent.sigev_notify = SIGEV_THREAD;
-	infoSignalEvent.sigev_notify_function = removeInfo;
-	infoSignalEvent.sigev_value.sival_ptr = NULL;
-	infoSignalEvent.sigev_notify_attributes = NULL;
-	timer_create(CLOCK_REALTIME, &infoSignalEvent, &infoTimer);
+void findServiceName(uint16_t transportStreamId, uint16_t serviceId, uint16_t* number, char* name)
+{
+	int32_t row = 0;
 
-	/* */
-	memset(&infoTimerSpec, 0, sizeof(infoTimerSpec));
-	infoTimerSpec.it_value.tv_sec = 3;
-	infoTimerSpec.it_value.tv_nsec = 0;
+	pthread_mutex_lock(&serviceIndexMutex);
+	row = serviceIndexFind(&serviceIndex, transportStreamId, serviceId);
+	if (row >= 0)
+	{
+		*number = serviceIndex.entries[row].number;
+		snprintf(name, TABLES_MAX_NAME_LENGTH, "%s", serviceIndexService(&serviceIndex, row)->name);
+	}
+	else
+	{
+		/* services missing from the list go last */
+		*number = 0xFFFF;
+		snprintf(name, TABLES_MAX_NAME_LENGTH, "Service %u", serviceId);
+	}
+	pthread_mutex_unlock(&serviceIndexMutex);
 }
 
-void removeProgramNumber()
+void removeProgramNumber(void* data)
 {
+	pthread_mutex_lock(&graphicsMutex);
 	componentsToDraw.showProgramNumber = false;
+	requestRedraw();
+	pthread_mutex_unlock(&graphicsMutex);
 }
 
-void removeVolumeBar()
+void removeVolumeBar(void* data)
 {
+	pthread_mutex_lock(&graphicsMutex);
 	componentsToDraw.showVolume = false;
+	requestRedraw();
+	pthread_mutex_unlock(&graphicsMutex);
 }
 
-void removeInfo()
+void removeInfo(void* data)
 {
+	pthread_mutex_lock(&graphicsMutex);
 	componentsToDraw.showInfo = false;
+	requestRedraw();
+	pthread_mutex_unlock(&graphicsMutex);
 }
 
-void removeChannelDial()
+void removeChannelDial(void* data)
 {
+	pthread_mutex_lock(&graphicsMutex);
 	componentsToDraw.showChannelDial = false;
+	requestRedraw();
+	pthread_mutex_unlock(&graphicsMutex);
+}
+
+void printGraphicsStats()
+{
+	ImageCacheStats cacheStats;
+	TextCacheStats textStats;
+
+	imageCacheGetStats(&imageCache, &cacheStats);
+	textCacheGetStats(&textCache, &textStats);
+
+	printf("\n%s : INFO %u frames, average %llu us, worst %llu us\n", __FUNCTION__, frameStats.frameCount,
+			frameStats.frameCount ? (unsigned long long)(frameStats.totalNanoseconds / frameStats.frameCount / 1000) : 0ULL,
+			(unsigned long long)(frameStats.maxNanoseconds / 1000));
+	printf("%s : INFO %llu pixels filled, %llu with full screen redraw (%.1f%%), %u frames without damage\n", __FUNCTION__,
+			(unsigned long long)frameStats.filledPixels, (unsigned long long)frameStats.fullFramePixels,
+			frameStats.fullFramePixels ? 100.0 * frameStats.filledPixels / frameStats.fullFramePixels : 0.0, frameStats.skippedFrameCount);
+	printf("%s : INFO render thread used %llu ms of CPU in %llu ms (%.2f%%)\n", __FUNCTION__,
+			(unsigned long long)(frameStats.cpuNanoseconds / 1000000), (unsigned long long)(frameStats.wallNanoseconds / 1000000),
+			frameStats.wallNanoseconds ? 100.0 * frameStats.cpuNanoseconds / frameStats.wallNanoseconds : 0.0);
+	printf("%s : INFO channel list %u rows drawn, %u rows reused from row surfaces\n", __FUNCTION__,
+			frameStats.channelRowDrawCount, frameStats.channelRowReuseCount);
+	printf("%s : INFO programme guide %u frames, average %llu us, worst %llu us, %u over %llu us\n", __FUNCTION__,
+			frameStats.epgFrameCount,
+			frameStats.epgFrameCount ? (unsigned long long)(frameStats.epgTotalNanoseconds / frameStats.epgFrameCount / 1000) : 0ULL,
+			(unsigned long long)(frameStats.epgMaxNanoseconds / 1000), frameStats.epgLateFrameCount, (unsigned long long)(EPG_FRAME_BUDGET / 1000));
+	printf("%s : INFO programme guide %u tiles rendered, %u tiles reused, %u tiles invalidated\n", __FUNCTION__,
+			epgGrid.stats.tileRenderCount, epgGrid.stats.tileReuseCount, epgGrid.stats.invalidatedCount);
+	printf("%s : INFO text cache %u hits, %u renders, %u evictions, surfaces %u bytes\n", __FUNCTION__,
+			textStats.hitCount, textStats.missCount, textStats.evictionCount, textStats.bytesInUse);
+	printf("%s : INFO image cache %u hits, %u misses, %u from asset pack (%llu us), %u evictions, surfaces %u bytes, peak %u of %u bytes\n",
+			__FUNCTION__, cacheStats.hitCount, cacheStats.missCount, cacheStats.packCount, (unsigned long long)(cacheStats.decodeNanoseconds / 1000),
+			cacheStats.evictionCount, cacheStats.bytesInUse, cacheStats.peakBytes, imageCache.budget);
+}
+
+uint64_t monotonicNanoseconds()
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+uint64_t threadCpuNanoseconds()
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+
+	return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
 }
@@ -3,6 +3,9 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "timer_wheel.h"
+#include "osd_backend.h"
+#include "tables.h"
 
 /**
  * @brief Structure that defines stream controller error
@@ -25,29 +28,111 @@ typedef struct _DrawComponents
 	bool showChannelDial;
 	int32_t programNumber;
 	int32_t volume;
+	uint16_t year;
+	uint8_t month;
+	uint8_t day;
+	int16_t audioPid;
+	int16_t videoPid;
+	uint16_t channelCount;						/* Services in channel list */
+	uint16_t channelTop;						/* First visible row of channel list */
+	uint16_t channelSelected;					/* Selected row of channel list */
+	uint32_t channelGeneration;					/* Changes every time channel list is loaded */
+	bool showEpg;
+	int32_t epgTopRow;							/* First visible row of programme guide */
+	int32_t epgLeftSlot;						/* First visible time slot, UTC seconds divided by slot length */
+	int32_t epgCursorRow;
+	uint32_t epgCursorTime;						/* UTC, event running at this time is selected */
+	uint16_t epgRowCount;						/* Services with a schedule */
+	uint32_t epgGeneration;						/* Changes when events in visible part of guide change */
 }DrawComponents;
 
+/**
+ * @brief Structure that holds render loop statistics
+ */
+typedef struct _FrameStats
+{
+	uint32_t frameCount;
+	uint64_t totalNanoseconds;
+	uint64_t maxNanoseconds;
+	uint64_t startNanoseconds;					/* Render thread start */
+	uint64_t wallNanoseconds;					/* Render thread lifetime */
+	uint64_t cpuNanoseconds;					/* CPU time used by render thread */
+	uint64_t filledPixels;						/* Pixels cleared and drawn */
+	uint64_t fullFramePixels;					/* Pixels full screen clear and redraw would have filled */
+	uint32_t skippedFrameCount;					/* Wakeups where nothing visible changed */
+	uint32_t channelRowDrawCount;				/* Channel list rows drawn into a row surface */
+	uint32_t channelRowReuseCount;				/* Channel list rows blitted from a row surface drawn before */
+	uint32_t epgFrameCount;						/* Frames that redrew programme guide */
+	uint64_t epgTotalNanoseconds;
+	uint64_t epgMaxNanoseconds;
+	uint32_t epgLateFrameCount;					/* Programme guide frames longer than one refresh period */
+}FrameStats;
+
 
 /**
- * @brief Initializes graphics controller module
+ * @brief Initializes graphics controller module, runs every startup stage below one after another
  *
+ * @param [in] wheel - timer wheel that hides OSD elements, must outlive graphics controller
+ * @param [in] osdBackend - backend the OSD is drawn with
  * @return graphics controller error code
  */
-GraphicsControllerError graphicsControllerInit();
+GraphicsControllerError graphicsControllerInit(TimerWheel* wheel, const OsdBackend* osdBackend);
 
 /**
- * @brief Deinitializes graphics controller module
+ * @brief First startup stage, sets up state only, so draw calls may be made from then on
+ *
+ * Draw calls made before graphicsControllerStart are shown with the first frame.
+ *
+ * @param [in] wheel - timer wheel that hides OSD elements, must outlive graphics controller
+ * @param [in] osdBackend - backend the OSD is drawn with
+ */
+void graphicsControllerPrepare(TimerWheel* wheel, const OsdBackend* osdBackend);
+
+/**
+ * @brief Startup stage that initializes the backend, after graphicsControllerPrepare
  *
  * @return graphics controller error code
  */
-GraphicsControllerError graphicsControllerDeinit();
+GraphicsControllerError graphicsControllerInitBackend();
+
+/**
+ * @brief Startup stage that loads the font, after graphicsControllerInitBackend
+ *
+ * May run at the same time as graphicsControllerLoadAssets.
+ *
+ * @return graphics controller error code
+ */
+GraphicsControllerError graphicsControllerLoadFont();
+
+/**
+ * @brief Startup stage that maps asset pack and decodes images it lacks into image cache, after graphicsControllerInitBackend
+ *
+ * May run at the same time as graphicsControllerLoadFont. Images that fail are decoded again on first use.
+ *
+ * @return graphics controller error code
+ */
+GraphicsControllerError graphicsControllerLoadAssets();
+
+/**
+ * @brief Last startup stage, creates surfaces and starts render thread, OSD is ready when it returns
+ *
+ * @return graphics controller error code
+ */
+GraphicsControllerError graphicsControllerStart();
 
 /**
  * @brief Deinitializes graphics controller module
  *
  * @return graphics controller error code
  */
-void drawProgramNumber();
+GraphicsControllerError graphicsControllerDeinit();
+
+/**
+ * @brief Shows program number for a few seconds
+ *
+ * @param [in] programNumber - number to show
+ */
+void drawProgramNumber(int32_t programNumber);
 
 /**
  * @brief Deinitializes graphics controller module
@@ -63,6 +148,54 @@ void drawVolumeBar(uint8_t volumeValue);
  */
 void drawInfoRect(uint8_t tmpMonth, uint8_t day, uint16_t Year, int16_t audioPid, int16_t videoPid);
 
-void channelDial();
+/**
+ * @brief Sets channel database the channel list is read from, list is loaded each time it is opened
+ *
+ * @param [in] path - path of channel database file
+ */
+void graphicsControllerSetChannelDatabase(const char* path);
+
+/**
+ * @brief Opens channel list for a few seconds, moves selection when list is already open
+ *
+ * @param [in] step - rows to move selection by, negative moves up, selection wraps around
+ */
+void channelDial(int32_t step);
+
+/**
+ * @brief Returns service selected in channel list
+ *
+ * @param [out] frequency - frequency of multiplex carrying the service in Hz
+ * @param [out] channelNumber - channel number used by stream controller, position of service in PAT minus one
+ * @return true if channel list is open and a service is selected
+ */
+bool channelDialSelection(uint32_t* frequency, int32_t* channelNumber);
+
+/**
+ * @brief Stores events of an EIT section for the programme guide, only tiles showing changed events are rendered again
+ *
+ * @param [in] eitTable - parsed EIT section
+ */
+void graphicsControllerStoreEvents(const EitTable* eitTable);
+
+/**
+ * @brief Opens or closes programme guide, it opens at current time and covers the next seven days
+ *
+ * @param [in] show - true to open guide
+ */
+void drawEpgGrid(bool show);
+
+/**
+ * @brief Returns true while programme guide is open
+ */
+bool isEpgGridShown();
+
+/**
+ * @brief Moves programme guide cursor, grid scrolls to keep it visible
+ *
+ * @param [in] rowStep - services to move by, negative moves up
+ * @param [in] eventStep - events to move by, negative moves to earlier events
+ */
+void moveEpgCursor(int32_t rowStep, int32_t eventStep);
 
 #endif /* __GRAPHICS_CONTROLLER_H__ */
@@ -0,0 +1,211 @@
+#include "image_cache.h"
+
+static ImageCacheEntry* findEntry(ImageCache* cache, const char* asset);
+static ImageCacheEntry* decodeImage(ImageCache* cache, const char* asset);
+static OsdSurface* wrapPackedImage(ImageCache* cache, const char* asset, int32_t* width, int32_t* height);
+static void evictEntries(ImageCache* cache, uint32_t neededBytes);
+static ImageCacheEntry* evictOldest(ImageCache* cache);
+static void releaseEntry(ImageCache* cache, ImageCacheEntry* entry);
+static uint64_t monotonicNanoseconds();
+
+void imageCacheInit(ImageCache* cache, const OsdBackend* backend, uint32_t budget)
+{
+    memset(cache, 0x0, sizeof(ImageCache));
+    cache->backend = backend;
+    cache->budget = budget;
+}
+
+void imageCacheDeinit(ImageCache* cache)
+{
+    uint8_t i = 0;
+
+    for (i = 0; i < IMAGE_CACHE_MAX_ENTRIES; i++)
+    {
+        if (cache->entries[i].surface != NULL)
+        {
+            releaseEntry(cache, &cache->entries[i]);
+        }
+    }
+}
+
+void imageCacheSetPack(ImageCache* cache, const AssetPack* pack)
+{
+    cache->pack = pack;
+}
+
+OsdSurface* imageCacheGet(ImageCache* cache, const char* asset, int32_t* width, int32_t* height)
+{
+    ImageCacheEntry* entry = findEntry(cache, asset);
+
+    if (entry != NULL)
+    {
+        cache->stats.hitCount++;
+    }
+    else
+    {
+        cache->stats.missCount++;
+        entry = decodeImage(cache, asset);
+        if (entry == NULL)
+        {
+            return NULL;
+        }
+    }
+
+    entry->lastUse = ++cache->useClock;
+    *width = entry->width;
+    *height = entry->height;
+
+    return entry->surface;
+}
+
+void imageCacheGetStats(ImageCache* cache, ImageCacheStats* stats)
+{
+    *stats = cache->stats;
+}
+
+ImageCacheEntry* findEntry(ImageCache* cache, const char* asset)
+{
+    uint8_t i = 0;
+
+    for (i = 0; i < IMAGE_CACHE_MAX_ENTRIES; i++)
+    {
+        if (cache->entries[i].surface != NULL && strcmp(cache->entries[i].asset, asset) == 0)
+        {
+            return &cache->entries[i];
+        }
+    }
+
+    return NULL;
+}
+
+ImageCacheEntry* decodeImage(ImageCache* cache, const char* asset)
+{
+    OsdSurface* surface = NULL;
+    ImageCacheEntry* entry = NULL;
+    uint64_t decodeStart = monotonicNanoseconds();
+    int32_t width = 0;
+    int32_t height = 0;
+    uint32_t bytes = 0;
+    uint8_t i = 0;
+
+    if (strlen(asset) >= IMAGE_CACHE_MAX_ASSET_LENGTH)
+    {
+        printf("\n%s : ERROR asset id %s too long!\n", __FUNCTION__, asset);
+        return NULL;
+    }
+
+    surface = wrapPackedImage(cache, asset, &width, &height);
+    if (surface != NULL)
+    {
+        /* pixels stay in the mapping, shared with page cache, so they take nothing from the budget */
+        cache->stats.packCount++;
+    }
+    else
+    {
+        surface = cache->backend->loadImage(asset, &width, &height);
+        if (surface == NULL)
+        {
+            return NULL;
+        }
+
+        /* decoded surfaces are ARGB */
+        bytes = (uint32_t)width * height * 4;
+    }
+    evictEntries(cache, bytes);
+
+    for (i = 0; i < IMAGE_CACHE_MAX_ENTRIES; i++)
+    {
+        if (cache->entries[i].surface == NULL)
+        {
+            entry = &cache->entries[i];
+            break;
+        }
+    }
+
+    if (entry == NULL)
+    {
+        /* every entry is taken by small images, least recently used one gives its place */
+        entry = evictOldest(cache);
+    }
+
+    strcpy(entry->asset, asset);
+    entry->surface = surface;
+    entry->width = width;
+    entry->height = height;
+    entry->bytes = bytes;
+
+    cache->stats.bytesInUse += bytes;
+    if (cache->stats.bytesInUse > cache->stats.peakBytes)
+    {
+        cache->stats.peakBytes = cache->stats.bytesInUse;
+    }
+    if (bytes > cache->budget)
+    {
+        printf("\n%s : WARNING image %s is larger than cache budget!\n", __FUNCTION__, asset);
+    }
+    cache->stats.decodeNanoseconds += monotonicNanoseconds() - decodeStart;
+
+    return entry;
+}
+
+OsdSurface* wrapPackedImage(ImageCache* cache, const char* asset, int32_t* width, int32_t* height)
+{
+    const uint32_t* pixels = NULL;
+    int32_t pitch = 0;
+
+    if (cache->pack == NULL || cache->backend->wrapPixels == NULL)
+    {
+        return NULL;
+    }
+
+    pixels = assetPackFind(cache->pack, asset, width, height, &pitch);
+    if (pixels == NULL)
+    {
+        return NULL;
+    }
+
+    return cache->backend->wrapPixels(pixels, *width, *height, pitch);
+}
+
+void evictEntries(ImageCache* cache, uint32_t neededBytes)
+{
+    while (cache->stats.bytesInUse > 0 && cache->stats.bytesInUse + neededBytes > cache->budget)
+    {
+        evictOldest(cache);
+    }
+}
+
+ImageCacheEntry* evictOldest(ImageCache* cache)
+{
+    ImageCacheEntry* oldest = NULL;
+    uint8_t i = 0;
+
+    for (i = 0; i < IMAGE_CACHE_MAX_ENTRIES; i++)
+    {
+        if (cache->entries[i].surface != NULL && (oldest == NULL || cache->entries[i].lastUse < oldest->lastUse))
+        {
+            oldest = &cache->entries[i];
+        }
+    }
+
+    releaseEntry(cache, oldest);
+    cache->stats.evictionCount++;
+
+    return oldest;
+}
+
+void releaseEntry(ImageCache* cache, ImageCacheEntry* entry)
+{
+    cache->backend->releaseSurface(entry->surface);
+    cache->stats.bytesInUse -= entry->bytes;
+    memset(entry, 0x0, sizeof(ImageCacheEntry));
+}
+
+uint64_t monotonicNanoseconds()
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
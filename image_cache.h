@@ -0,0 +1,113 @@
+#ifndef __IMAGE_CACHE_H__
+#define __IMAGE_CACHE_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include "osd_backend.h"
+#include "asset_pack.h"
+
+#define IMAGE_CACHE_MAX_ENTRIES 32                  /* Max number of decoded images kept at once */
+#define IMAGE_CACHE_MAX_ASSET_LENGTH 64             /* Max length of asset id, the image file path */
+#define IMAGE_CACHE_DEFAULT_BUDGET (4 * 1024 * 1024) /* Bytes of decoded surfaces kept before least recently used are released */
+
+/**
+ * @brief Structure that defines image cache error
+ */
+typedef enum _ImageCacheError
+{
+    IC_NO_ERROR = 0,
+    IC_ERROR
+}ImageCacheError;
+
+/**
+ * @brief Structure that holds one decoded image
+ */
+typedef struct _ImageCacheEntry
+{
+    char asset[IMAGE_CACHE_MAX_ASSET_LENGTH];
+    OsdSurface* surface;                            /* NULL while entry is free */
+    int32_t width;
+    int32_t height;
+    uint32_t bytes;                                 /* Size of decoded pixels, 0 for pixels in asset pack */
+    uint64_t lastUse;                               /* Value of use clock at last lookup */
+}ImageCacheEntry;
+
+/**
+ * @brief Structure that holds image cache statistics
+ */
+typedef struct _ImageCacheStats
+{
+    uint32_t hitCount;
+    uint32_t missCount;                             /* Lookups that decoded the image or took it from pack */
+    uint32_t packCount;                             /* Misses served from asset pack without decoding */
+    uint32_t evictionCount;                         /* Images released to stay within budget */
+    uint32_t bytesInUse;
+    uint32_t peakBytes;
+    uint64_t decodeNanoseconds;                     /* Time spent decoding on misses */
+}ImageCacheStats;
+
+/**
+ * @brief Structure that holds images decoded into surfaces, keyed by asset id, within a byte budget
+ *
+ * Used by one thread at a time, the startup step that preloads images and then the one that draws.
+ * Images found in asset pack are wrapped in place and do not count against the budget.
+ */
+typedef struct _ImageCache
+{
+    const OsdBackend* backend;
+    const AssetPack* pack;                          /* NULL if images are decoded from files */
+    uint32_t budget;
+    uint64_t useClock;
+    ImageCacheEntry entries[IMAGE_CACHE_MAX_ENTRIES];
+    ImageCacheStats stats;
+}ImageCache;
+
+/**
+ * @brief Initializes image cache
+ *
+ * @param [out] cache - image cache
+ * @param [in]  backend - rendering backend that decodes images
+ * @param [in]  budget - max bytes of decoded surfaces
+ */
+void imageCacheInit(ImageCache* cache, const OsdBackend* backend, uint32_t budget);
+
+/**
+ * @brief Releases every decoded image
+ *
+ * @param [in] cache - image cache
+ */
+void imageCacheDeinit(ImageCache* cache);
+
+/**
+ * @brief Sets asset pack images are looked up in before they are decoded
+ *
+ * @param [in] cache - image cache
+ * @param [in] pack - mapped asset pack, must stay mapped until cache is deinitialized
+ */
+void imageCacheSetPack(ImageCache* cache, const AssetPack* pack);
+
+/**
+ * @brief Returns decoded image, takes it from asset pack or decodes it on first use
+ *
+ * Surface stays owned by the cache and is valid until next lookup, which may evict it.
+ *
+ * @param [in]  cache - image cache
+ * @param [in]  asset - asset id, the image file path
+ * @param [out] width - image width
+ * @param [out] height - image height
+ * @return surface, NULL if image could not be decoded
+ */
+OsdSurface* imageCacheGet(ImageCache* cache, const char* asset, int32_t* width, int32_t* height);
+
+/**
+ * @brief Returns image cache statistics
+ *
+ * @param [in]  cache - image cache
+ * @param [out] stats - statistics
+ */
+void imageCacheGetStats(ImageCache* cache, ImageCacheStats* stats);
+
+#endif /* __IMAGE_CACHE_H__ */
@@ -0,0 +1,95 @@
+#ifndef __OSD_BACKEND_H__
+#define __OSD_BACKEND_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Structure that defines OSD backend error
+ */
+typedef enum _OsdBackendError
+{
+    OB_NO_ERROR = 0,
+    OB_ERROR
+}OsdBackendError;
+
+/**
+ * @brief Surface of a backend, its content is known to the backend only
+ */
+typedef struct _OsdSurface OsdSurface;
+
+/**
+ * @brief Font of a backend, its content is known to the backend only
+ */
+typedef struct _OsdFont OsdFont;
+
+/**
+ * @brief Structure that defines rectangle in pixels
+ */
+typedef struct _OsdRectangle
+{
+    int32_t x;
+    int32_t y;
+    int32_t w;
+    int32_t h;
+}OsdRectangle;
+
+/**
+ * @brief Structure that holds operations of a rendering backend
+ *
+ * Colours are ARGB with straight alpha. Fill writes the colour as is, blit and text can blend over the destination.
+ * Drawing is clipped to the clip rectangle of the destination surface. Wrapped pixels are premultiplied ARGB
+ * owned by the caller, such surfaces are only blitted from and must be released before the pixels go away.
+ */
+typedef struct _OsdBackend
+{
+    const char* name;
+
+    /* creates full screen primary surface */
+    OsdBackendError (*init)(OsdSurface** primary, int32_t* width, int32_t* height);
+    void (*deinit)();
+
+    OsdSurface* (*createSurface)(int32_t width, int32_t height);
+    OsdSurface* (*loadImage)(const char* path, int32_t* width, int32_t* height);
+    OsdSurface* (*wrapPixels)(const uint32_t* pixels, int32_t width, int32_t height, int32_t pitch); /* pitch in bytes, nothing is copied */
+    void (*releaseSurface)(OsdSurface* surface);
+
+    void (*setClip)(OsdSurface* surface, const OsdRectangle* clip);   /* NULL clip is whole surface */
+    void (*fill)(OsdSurface* surface, const OsdRectangle* rectangle, uint32_t color);
+    void (*blit)(OsdSurface* destination, OsdSurface* source, int32_t x, int32_t y, bool blend);
+    void (*flip)(OsdSurface* primary, const OsdRectangle* region);    /* Only region is shown, back buffer keeps its content */
+
+    OsdFont* (*loadFont)(const char* path, int32_t height);
+    void (*releaseFont)(OsdFont* font);
+    void (*getFontMetrics)(OsdFont* font, int32_t* height, int32_t* ascender);
+    int32_t (*getStringWidth)(OsdFont* font, const char* text);
+    void (*drawString)(OsdSurface* surface, OsdFont* font, const char* text, int32_t x, int32_t y, uint32_t color); /* y is top of text */
+}OsdBackend;
+
+/**
+ * @brief Backend drawing with DirectFB on the OSD layer, linked into the set-top box application
+ */
+extern const OsdBackend directfbBackend;
+
+/**
+ * @brief Backend drawing into ARGB memory with a bundled bitmap font, runs on any Linux host
+ */
+extern const OsdBackend softwareBackend;
+
+/**
+ * @brief Sets screen size of software backend, must be called before init
+ *
+ * @param [in] width - screen width
+ * @param [in] height - screen height
+ */
+void softwareBackendSetScreenSize(int32_t width, int32_t height);
+
+/**
+ * @brief Makes software backend write every flipped frame into directory as frame_NNNNN.pam
+ *
+ * @param [in] directory - existing directory, NULL stops writing frames
+ */
+void softwareBackendSetDumpDirectory(const char* directory);
+
+#endif /* __OSD_BACKEND_H__ */
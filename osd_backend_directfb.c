@@ -0,0 +1,301 @@
+#include "osd_backend.h"
+#include <directfb.h>
+
+/* backend surfaces and fonts are DirectFB interfaces */
+#define DFB_SURFACE(x) ((IDirectFBSurface*)(x))
+#define DFB_FONT(x) ((IDirectFBFont*)(x))
+
+/* helper macro for error checking */
+#define DFBCHECK(x...)                                      \
+{                                                           \
+DFBResult err = x;                                          \
+                                                            \
+if (err != DFB_OK)                                          \
+  {                                                         \
+    fprintf( stderr, "%s <%d>:\n\t", __FILE__, __LINE__ );  \
+    DirectFBErrorFatal( #x, err );                          \
+  }                                                         \
+}
+
+static IDirectFB* dfbInterface = NULL;
+
+static OsdBackendError directfbInit(OsdSurface** primary, int32_t* width, int32_t* height);
+static void directfbDeinit();
+static OsdSurface* directfbCreateSurface(int32_t width, int32_t height);
+static OsdSurface* directfbLoadImage(const char* path, int32_t* width, int32_t* height);
+static OsdSurface* directfbWrapPixels(const uint32_t* pixels, int32_t width, int32_t height, int32_t pitch);
+static void directfbReleaseSurface(OsdSurface* surface);
+static void directfbSetClip(OsdSurface* surface, const OsdRectangle* clip);
+static void directfbFill(OsdSurface* surface, const OsdRectangle* rectangle, uint32_t color);
+static void directfbBlit(OsdSurface* destination, OsdSurface* source, int32_t x, int32_t y, bool blend);
+static void directfbFlip(OsdSurface* primary, const OsdRectangle* region);
+static OsdFont* directfbLoadFont(const char* path, int32_t height);
+static void directfbReleaseFont(OsdFont* font);
+static void directfbGetFontMetrics(OsdFont* font, int32_t* height, int32_t* ascender);
+static int32_t directfbGetStringWidth(OsdFont* font, const char* text);
+static void directfbDrawString(OsdSurface* surface, OsdFont* font, const char* text, int32_t x, int32_t y, uint32_t color);
+static void toRegion(const OsdRectangle* rectangle, DFBRegion* region);
+
+const OsdBackend directfbBackend =
+{
+    "directfb",
+    directfbInit,
+    directfbDeinit,
+    directfbCreateSurface,
+    directfbLoadImage,
+    directfbWrapPixels,
+    directfbReleaseSurface,
+    directfbSetClip,
+    directfbFill,
+    directfbBlit,
+    directfbFlip,
+    directfbLoadFont,
+    directfbReleaseFont,
+    directfbGetFontMetrics,
+    directfbGetStringWidth,
+    directfbDrawString
+};
+
+OsdBackendError directfbInit(OsdSurface** primary, int32_t* width, int32_t* height)
+{
+    DFBSurfaceDescription surfaceDesc;
+    IDirectFBSurface* primarySurface = NULL;
+
+    /* initialize DirectFB */
+    if (DirectFBInit(0, NULL))
+    {
+        return OB_ERROR;
+    }
+
+    /* fetch the DirectFB interface */
+    if (DirectFBCreate(&dfbInterface))
+    {
+        return OB_ERROR;
+    }
+
+    /* tell the DirectFB to take the full screen for this application */
+    if (dfbInterface->SetCooperativeLevel(dfbInterface, DFSCL_FULLSCREEN))
+    {
+        return OB_ERROR;
+    }
+
+    /* create primary surface with double buffering enabled */
+    surfaceDesc.flags = DSDESC_CAPS;
+    surfaceDesc.caps = DSCAPS_PRIMARY | DSCAPS_FLIPPING;
+    if (dfbInterface->CreateSurface(dfbInterface, &surfaceDesc, &primarySurface))
+    {
+        return OB_ERROR;
+    }
+
+    /* fetch the screen size */
+    if (primarySurface->GetSize(primarySurface, width, height))
+    {
+        return OB_ERROR;
+    }
+
+    *primary = (OsdSurface*)primarySurface;
+
+    return OB_NO_ERROR;
+}
+
+void directfbDeinit()
+{
+    dfbInterface->Release(dfbInterface);
+    dfbInterface = NULL;
+}
+
+OsdSurface* directfbCreateSurface(int32_t width, int32_t height)
+{
+    DFBSurfaceDescription description;
+    IDirectFBSurface* surface = NULL;
+
+    description.flags = DSDESC_WIDTH | DSDESC_HEIGHT | DSDESC_PIXELFORMAT;
+    description.width = width;
+    description.height = height;
+    description.pixelformat = DSPF_ARGB;
+    if (dfbInterface->CreateSurface(dfbInterface, &description, &surface))
+    {
+        printf("\n%s : ERROR cannot create %dx%d surface!\n", __FUNCTION__, width, height);
+        return NULL;
+    }
+
+    return (OsdSurface*)surface;
+}
+
+OsdSurface* directfbLoadImage(const char* path, int32_t* width, int32_t* height)
+{
+    IDirectFBImageProvider* provider = NULL;
+    IDirectFBSurface* surface = NULL;
+    DFBSurfaceDescription description;
+
+    /* create the image provider for the specified file */
+    if (dfbInterface->CreateImageProvider(dfbInterface, path, &provider))
+    {
+        printf("\n%s : ERROR cannot open image %s!\n", __FUNCTION__, path);
+        return NULL;
+    }
+
+    /* get surface descriptor for the surface where the image will be rendered */
+    if (provider->GetSurfaceDescription(provider, &description)
+        || dfbInterface->CreateSurface(dfbInterface, &description, &surface))
+    {
+        printf("\n%s : ERROR cannot create surface for image %s!\n", __FUNCTION__, path);
+        provider->Release(provider);
+        return NULL;
+    }
+
+    /* render the image to the surface */
+    if (provider->RenderTo(provider, surface, NULL))
+    {
+        printf("\n%s : ERROR cannot decode image %s!\n", __FUNCTION__, path);
+        surface->Release(surface);
+        provider->Release(provider);
+        return NULL;
+    }
+    provider->Release(provider);
+
+    *width = description.width;
+    *height = description.height;
+
+    return (OsdSurface*)surface;
+}
+
+OsdSurface* directfbWrapPixels(const uint32_t* pixels, int32_t width, int32_t height, int32_t pitch)
+{
+    DFBSurfaceDescription description;
+    IDirectFBSurface* surface = NULL;
+
+    /* preallocated surface uses the pixels where they are, they are never written as they are only blitted from */
+    description.flags = DSDESC_WIDTH | DSDESC_HEIGHT | DSDESC_PIXELFORMAT | DSDESC_CAPS | DSDESC_PREALLOCATED;
+    description.width = width;
+    description.height = height;
+    description.pixelformat = DSPF_ARGB;
+    description.caps = DSCAPS_PREMULTIPLIED;
+    description.preallocated[0].data = (void*)pixels;
+    description.preallocated[0].pitch = pitch;
+    description.preallocated[1].data = NULL;
+    description.preallocated[1].pitch = 0;
+    if (dfbInterface->CreateSurface(dfbInterface, &description, &surface))
+    {
+        printf("\n%s : ERROR cannot wrap %dx%d pixels!\n", __FUNCTION__, width, height);
+        return NULL;
+    }
+
+    return (OsdSurface*)surface;
+}
+
+void directfbReleaseSurface(OsdSurface* surface)
+{
+    DFB_SURFACE(surface)->Release(DFB_SURFACE(surface));
+}
+
+void directfbSetClip(OsdSurface* surface, const OsdRectangle* clip)
+{
+    DFBRegion region;
+
+    if (clip == NULL)
+    {
+        DFBCHECK(DFB_SURFACE(surface)->SetClip(DFB_SURFACE(surface), NULL));
+        return;
+    }
+
+    toRegion(clip, &region);
+    DFBCHECK(DFB_SURFACE(surface)->SetClip(DFB_SURFACE(surface), &region));
+}
+
+void directfbFill(OsdSurface* surface, const OsdRectangle* rectangle, uint32_t color)
+{
+    DFBCHECK(DFB_SURFACE(surface)->SetColor(DFB_SURFACE(surface), (color >> 16) & 0xFF, (color >> 8) & 0xFF, color & 0xFF, (color >> 24) & 0xFF));
+    DFBCHECK(DFB_SURFACE(surface)->FillRectangle(DFB_SURFACE(surface), rectangle->x, rectangle->y, rectangle->w, rectangle->h));
+}
+
+void directfbBlit(OsdSurface* destination, OsdSurface* source, int32_t x, int32_t y, bool blend)
+{
+    DFBSurfaceCapabilities caps = DSCAPS_NONE;
+
+    if (blend)
+    {
+        /* wrapped pixels are premultiplied, their colour is added as is */
+        DFBCHECK(DFB_SURFACE(source)->GetCapabilities(DFB_SURFACE(source), &caps));
+        if (caps & DSCAPS_PREMULTIPLIED)
+        {
+            DFBCHECK(DFB_SURFACE(destination)->SetSrcBlendFunction(DFB_SURFACE(destination), DSBF_ONE));
+        }
+        DFBCHECK(DFB_SURFACE(destination)->SetBlittingFlags(DFB_SURFACE(destination), DSBLIT_BLEND_ALPHACHANNEL));
+    }
+    DFBCHECK(DFB_SURFACE(destination)->Blit(DFB_SURFACE(destination), DFB_SURFACE(source), NULL, x, y));
+    if (blend)
+    {
+        DFBCHECK(DFB_SURFACE(destination)->SetBlittingFlags(DFB_SURFACE(destination), DSBLIT_NOFX));
+        if (caps & DSCAPS_PREMULTIPLIED)
+        {
+            DFBCHECK(DFB_SURFACE(destination)->SetSrcBlendFunction(DFB_SURFACE(destination), DSBF_SRCALPHA));
+        }
+    }
+}
+
+void directfbFlip(OsdSurface* primary, const OsdRectangle* region)
+{
+    DFBRegion flipRegion;
+
+    /* blit flip copies only the region to the front buffer, back buffer keeps the whole frame */
+    if (region == NULL)
+    {
+        DFBCHECK(DFB_SURFACE(primary)->Flip(DFB_SURFACE(primary), NULL, DSFLIP_BLIT));
+        return;
+    }
+
+    toRegion(region, &flipRegion);
+    DFBCHECK(DFB_SURFACE(primary)->Flip(DFB_SURFACE(primary), &flipRegion, DSFLIP_BLIT));
+}
+
+OsdFont* directfbLoadFont(const char* path, int32_t height)
+{
+    DFBFontDescription fontDesc;
+    IDirectFBFont* font = NULL;
+
+    fontDesc.flags = DFDESC_HEIGHT;
+    fontDesc.height = height;
+    if (dfbInterface->CreateFont(dfbInterface, path, &fontDesc, &font))
+    {
+        printf("\n%s : ERROR cannot load font %s!\n", __FUNCTION__, path);
+        return NULL;
+    }
+
+    return (OsdFont*)font;
+}
+
+void directfbReleaseFont(OsdFont* font)
+{
+    DFB_FONT(font)->Release(DFB_FONT(font));
+}
+
+void directfbGetFontMetrics(OsdFont* font, int32_t* height, int32_t* ascender)
+{
+    DFBCHECK(DFB_FONT(font)->GetHeight(DFB_FONT(font), height));
+    DFBCHECK(DFB_FONT(font)->GetAscender(DFB_FONT(font), ascender));
+}
+
+int32_t directfbGetStringWidth(OsdFont* font, const char* text)
+{
+    int32_t width = 0;
+
+    DFBCHECK(DFB_FONT(font)->GetStringWidth(DFB_FONT(font), text, -1, &width));
+
+    return width;
+}
+
+void directfbDrawString(OsdSurface* surface, OsdFont* font, const char* text, int32_t x, int32_t y, uint32_t color)
+{
+    DFBCHECK(DFB_SURFACE(surface)->SetFont(DFB_SURFACE(surface), DFB_FONT(font)));
+    DFBCHECK(DFB_SURFACE(surface)->SetColor(DFB_SURFACE(surface), (color >> 16) & 0xFF, (color >> 8) & 0xFF, color & 0xFF, (color >> 24) & 0xFF));
+    DFBCHECK(DFB_SURFACE(surface)->DrawString(DFB_SURFACE(surface), text, -1, x, y, DSTF_LEFT | DSTF_TOP));
+}
+
+void toRegion(const OsdRectangle* rectangle, DFBRegion* region)
+{
+    region->x1 = rectangle->x;
+    region->y1 = rectangle->y;
+    region->x2 = rectangle->x + rectangle->w - 1;
+    region->y2 = rectangle->y + rectangle->h - 1;
+}
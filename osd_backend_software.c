@@ -0,0 +1,629 @@
+#include "osd_backend.h"
+#include "osd_pixel.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define SOFTWARE_DEFAULT_WIDTH 1920
+#define SOFTWARE_DEFAULT_HEIGHT 1080
+#define SOFTWARE_MAX_PATH 256
+#define GLYPH_FIRST 32                              /* First character of bundled font, space */
+#define GLYPH_COUNT 95                              /* Printable ASCII */
+#define GLYPH_WIDTH 5
+#define GLYPH_HEIGHT 7
+#define CELL_WIDTH 6                                /* Glyph and one column of spacing */
+#define CELL_HEIGHT 9                               /* Glyph with one row above and one below */
+#define CELL_ASCENDER 8                             /* Baseline is below last glyph row */
+
+/**
+ * @brief Surface in memory, pixels are premultiplied ARGB
+ */
+struct _OsdSurface
+{
+    int32_t width;
+    int32_t height;
+    int32_t pitch;                                  /* Pixels from one row to the next */
+    uint32_t* pixels;
+    bool owned;                                     /* False for wrapped pixels, they are not freed */
+    OsdRectangle clip;
+};
+
+/**
+ * @brief Bundled bitmap font scaled to requested height
+ */
+struct _OsdFont
+{
+    int32_t scale;
+};
+
+/* 5x7 glyphs of printable ASCII, one byte per row, bit 4 is the leftmost column */
+static const uint8_t glyphs[GLYPH_COUNT][GLYPH_HEIGHT] =
+{
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   /* ' ' */
+    { 0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04 },   /* '!' */
+    { 0x0A, 0x0A, 0x0A, 0x00, 0x00, 0x00, 0x00 },   /* '"' */
+    { 0x0A, 0x0A, 0x1F, 0x0A, 0x1F, 0x0A, 0x0A },   /* '#' */
+    { 0x04, 0x0F, 0x14, 0x0E, 0x05, 0x1E, 0x04 },   /* '$' */
+    { 0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03 },   /* '%' */
+    { 0x0C, 0x12, 0x14, 0x08, 0x15, 0x12, 0x0D },   /* '&' */
+    { 0x04, 0x04, 0x08, 0x00, 0x00, 0x00, 0x00 },   /* 'quote' */
+    { 0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02 },   /* '(' */
+    { 0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08 },   /* ')' */
+    { 0x00, 0x04, 0x15, 0x0E, 0x15, 0x04, 0x00 },   /* '*' */
+    { 0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00 },   /* '+' */
+    { 0x00, 0x00, 0x00, 0x00, 0x0C, 0x04, 0x08 },   /* ',' */
+    { 0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00 },   /* '-' */
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C },   /* '.' */
+    { 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00 },   /* '/' */
+    { 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E },   /* '0' */
+    { 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E },   /* '1' */
+    { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F },   /* '2' */
+    { 0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E },   /* '3' */
+    { 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02 },   /* '4' */
+    { 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E },   /* '5' */
+    { 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E },   /* '6' */
+    { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 },   /* '7' */
+    { 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E },   /* '8' */
+    { 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C },   /* '9' */
+    { 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00 },   /* ':' */
+    { 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x04, 0x08 },   /* ';' */
+    { 0x02, 0x04, 0x08, 0x10, 0x08, 0x04, 0x02 },   /* '<' */
+    { 0x00, 0x00, 0x1F, 0x00, 0x1F, 0x00, 0x00 },   /* '=' */
+    { 0x08, 0x04, 0x02, 0x01, 0x02, 0x04, 0x08 },   /* '>' */
+    { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04 },   /* '?' */
+    { 0x0E, 0x11, 0x01, 0x0D, 0x15, 0x15, 0x0E },   /* '@' */
+    { 0x0E, 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11 },   /* 'A' */
+    { 0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E },   /* 'B' */
+    { 0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E },   /* 'C' */
+    { 0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C },   /* 'D' */
+    { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F },   /* 'E' */
+    { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10 },   /* 'F' */
+    { 0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F },   /* 'G' */
+    { 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 },   /* 'H' */
+    { 0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E },   /* 'I' */
+    { 0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C },   /* 'J' */
+    { 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11 },   /* 'K' */
+    { 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F },   /* 'L' */
+    { 0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11 },   /* 'M' */
+    { 0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11 },   /* 'N' */
+    { 0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E },   /* 'O' */
+    { 0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10 },   /* 'P' */
+    { 0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D },   /* 'Q' */
+    { 0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11 },   /* 'R' */
+    { 0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E },   /* 'S' */
+    { 0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 },   /* 'T' */
+    { 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E },   /* 'U' */
+    { 0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04 },   /* 'V' */
+    { 0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A },   /* 'W' */
+    { 0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11 },   /* 'X' */
+    { 0x11, 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04 },   /* 'Y' */
+    { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F },   /* 'Z' */
+    { 0x0E, 0x08, 0x08, 0x08, 0x08, 0x08, 0x0E },   /* '[' */
+    { 0x00, 0x10, 0x08, 0x04, 0x02, 0x01, 0x00 },   /* backslash */
+    { 0x0E, 0x02, 0x02, 0x02, 0x02, 0x02, 0x0E },   /* ']' */
+    { 0x04, 0x0A, 0x11, 0x00, 0x00, 0x00, 0x00 },   /* '^' */
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F },   /* '_' */
+    { 0x08, 0x04, 0x02, 0x00, 0x00, 0x00, 0x00 },   /* '`' */
+    { 0x00, 0x00, 0x0E, 0x01, 0x0F, 0x11, 0x0F },   /* 'a' */
+    { 0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x1E },   /* 'b' */
+    { 0x00, 0x00, 0x0E, 0x10, 0x10, 0x11, 0x0E },   /* 'c' */
+    { 0x01, 0x01, 0x0D, 0x13, 0x11, 0x11, 0x0F },   /* 'd' */
+    { 0x00, 0x00, 0x0E, 0x11, 0x1F, 0x10, 0x0E },   /* 'e' */
+    { 0x06, 0x09, 0x08, 0x1C, 0x08, 0x08, 0x08 },   /* 'f' */
+    { 0x00, 0x0F, 0x11, 0x11, 0x0F, 0x01, 0x0E },   /* 'g' */
+    { 0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x11 },   /* 'h' */
+    { 0x04, 0x00, 0x0C, 0x04, 0x04, 0x04, 0x0E },   /* 'i' */
+    { 0x02, 0x00, 0x06, 0x02, 0x02, 0x12, 0x0C },   /* 'j' */
+    { 0x10, 0x10, 0x12, 0x14, 0x18, 0x14, 0x12 },   /* 'k' */
+    { 0x0C, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E },   /* 'l' */
+    { 0x00, 0x00, 0x1A, 0x15, 0x15, 0x11, 0x11 },   /* 'm' */
+    { 0x00, 0x00, 0x16, 0x19, 0x11, 0x11, 0x11 },   /* 'n' */
+    { 0x00, 0x00, 0x0E, 0x11, 0x11, 0x11, 0x0E },   /* 'o' */
+    { 0x00, 0x00, 0x1E, 0x11, 0x1E, 0x10, 0x10 },   /* 'p' */
+    { 0x00, 0x00, 0x0D, 0x13, 0x0F, 0x01, 0x01 },   /* 'q' */
+    { 0x00, 0x00, 0x16, 0x19, 0x10, 0x10, 0x10 },   /* 'r' */
+    { 0x00, 0x00, 0x0E, 0x10, 0x0E, 0x01, 0x1E },   /* 's' */
+    { 0x08, 0x08, 0x1C, 0x08, 0x08, 0x09, 0x06 },   /* 't' */
+    { 0x00, 0x00, 0x11, 0x11, 0x11, 0x13, 0x0D },   /* 'u' */
+    { 0x00, 0x00, 0x11, 0x11, 0x11, 0x0A, 0x04 },   /* 'v' */
+    { 0x00, 0x00, 0x11, 0x11, 0x15, 0x15, 0x0A },   /* 'w' */
+    { 0x00, 0x00, 0x11, 0x0A, 0x04, 0x0A, 0x11 },   /* 'x' */
+    { 0x00, 0x00, 0x11, 0x11, 0x0F, 0x01, 0x0E },   /* 'y' */
+    { 0x00, 0x00, 0x1F, 0x02, 0x04, 0x08, 0x1F },   /* 'z' */
+    { 0x02, 0x04, 0x04, 0x08, 0x04, 0x04, 0x02 },   /* '{' */
+    { 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 },   /* '|' */
+    { 0x08, 0x04, 0x04, 0x02, 0x04, 0x04, 0x08 },   /* '}' */
+    { 0x00, 0x00, 0x08, 0x15, 0x02, 0x00, 0x00 },   /* '~' */
+};
+
+static int32_t screenWidth = SOFTWARE_DEFAULT_WIDTH;
+static int32_t screenHeight = SOFTWARE_DEFAULT_HEIGHT;
+static char dumpDirectory[SOFTWARE_MAX_PATH];
+static uint32_t frameCount = 0;
+static const PixelKernels* kernels = NULL;
+
+static OsdBackendError softwareInit(OsdSurface** primary, int32_t* width, int32_t* height);
+static void softwareDeinit();
+static OsdSurface* softwareCreateSurface(int32_t width, int32_t height);
+static OsdSurface* softwareLoadImage(const char* path, int32_t* width, int32_t* height);
+static OsdSurface* softwareWrapPixels(const uint32_t* pixels, int32_t width, int32_t height, int32_t pitch);
+static void softwareReleaseSurface(OsdSurface* surface);
+static void softwareSetClip(OsdSurface* surface, const OsdRectangle* clip);
+static void softwareFill(OsdSurface* surface, const OsdRectangle* rectangle, uint32_t color);
+static void softwareBlit(OsdSurface* destination, OsdSurface* source, int32_t x, int32_t y, bool blend);
+static void softwareFlip(OsdSurface* primary, const OsdRectangle* region);
+static OsdFont* softwareLoadFont(const char* path, int32_t height);
+static void softwareReleaseFont(OsdFont* font);
+static void softwareGetFontMetrics(OsdFont* font, int32_t* height, int32_t* ascender);
+static int32_t softwareGetStringWidth(OsdFont* font, const char* text);
+static void softwareDrawString(OsdSurface* surface, OsdFont* font, const char* text, int32_t x, int32_t y, uint32_t color);
+static bool clipRectangle(const OsdSurface* surface, OsdRectangle* rectangle);
+static uint32_t premultiply(uint32_t color);
+static OsdSurface* readPam(const char* path);
+static bool readPamHeader(FILE* file, int32_t* width, int32_t* height, int32_t* depth);
+static void writePam(const OsdSurface* surface, const char* path);
+
+const OsdBackend softwareBackend =
+{
+    "software",
+    softwareInit,
+    softwareDeinit,
+    softwareCreateSurface,
+    softwareLoadImage,
+    softwareWrapPixels,
+    softwareReleaseSurface,
+    softwareSetClip,
+    softwareFill,
+    softwareBlit,
+    softwareFlip,
+    softwareLoadFont,
+    softwareReleaseFont,
+    softwareGetFontMetrics,
+    softwareGetStringWidth,
+    softwareDrawString
+};
+
+void softwareBackendSetScreenSize(int32_t width, int32_t height)
+{
+    screenWidth = width;
+    screenHeight = height;
+}
+
+void softwareBackendSetDumpDirectory(const char* directory)
+{
+    if (directory == NULL)
+    {
+        dumpDirectory[0] = '\0';
+        return;
+    }
+
+    snprintf(dumpDirectory, sizeof(dumpDirectory), "%s", directory);
+}
+
+OsdBackendError softwareInit(OsdSurface** primary, int32_t* width, int32_t* height)
+{
+    /* fastest kernels the CPU runs, every set draws the same pixels */
+    kernels = pixelKernelsBest();
+
+    *primary = softwareCreateSurface(screenWidth, screenHeight);
+    if (*primary == NULL)
+    {
+        return OB_ERROR;
+    }
+
+    *width = screenWidth;
+    *height = screenHeight;
+    frameCount = 0;
+
+    return OB_NO_ERROR;
+}
+
+void softwareDeinit()
+{
+    if (dumpDirectory[0] != '\0')
+    {
+        printf("\n%s : INFO %u frames written to %s\n", __FUNCTION__, frameCount, dumpDirectory);
+    }
+}
+
+OsdSurface* softwareCreateSurface(int32_t width, int32_t height)
+{
+    OsdSurface* surface = NULL;
+
+    if (width <= 0 || height <= 0)
+    {
+        printf("\n%s : ERROR invalid size %dx%d!\n", __FUNCTION__, width, height);
+        return NULL;
+    }
+
+    surface = (OsdSurface*)malloc(sizeof(OsdSurface));
+    if (surface == NULL)
+    {
+        printf("\n%s : ERROR cannot allocate surface!\n", __FUNCTION__);
+        return NULL;
+    }
+
+    surface->pixels = (uint32_t*)calloc((size_t)width * height, sizeof(uint32_t));
+    if (surface->pixels == NULL)
+    {
+        printf("\n%s : ERROR cannot allocate %dx%d pixels!\n", __FUNCTION__, width, height);
+        free(surface);
+        return NULL;
+    }
+
+    surface->width = width;
+    surface->height = height;
+    surface->pitch = width;
+    surface->owned = true;
+    softwareSetClip(surface, NULL);
+
+    return surface;
+}
+
+OsdSurface* softwareLoadImage(const char* path, int32_t* width, int32_t* height)
+{
+    char pamPath[SOFTWARE_MAX_PATH];
+    const char* extension = strrchr(path, '.');
+    OsdSurface* surface = NULL;
+
+    /* no PNG decoder is bundled, PNG assets are read from PAM files converted next to them */
+    if (extension != NULL && strcmp(extension, ".png") == 0)
+    {
+        snprintf(pamPath, sizeof(pamPath), "%.*s.pam", (int)(extension - path), path);
+        surface = readPam(pamPath);
+    }
+    else
+    {
+        surface = readPam(path);
+    }
+
+    if (surface == NULL)
+    {
+        printf("\n%s : ERROR cannot load image %s!\n", __FUNCTION__, path);
+        return NULL;
+    }
+
+    *width = surface->width;
+    *height = surface->height;
+
+    return surface;
+}
+
+OsdSurface* softwareWrapPixels(const uint32_t* pixels, int32_t width, int32_t height, int32_t pitch)
+{
+    OsdSurface* surface = NULL;
+
+    /* kernels address rows by pixels, pitch must hold whole pixels */
+    if (width <= 0 || height <= 0 || pitch % 4 != 0 || pitch / 4 < width)
+    {
+        printf("\n%s : ERROR invalid size %dx%d, pitch %d!\n", __FUNCTION__, width, height, pitch);
+        return NULL;
+    }
+
+    surface = (OsdSurface*)malloc(sizeof(OsdSurface));
+    if (surface == NULL)
+    {
+        printf("\n%s : ERROR cannot allocate surface!\n", __FUNCTION__);
+        return NULL;
+    }
+
+    /* pixels are already premultiplied like every surface of this backend, they are only read */
+    surface->pixels = (uint32_t*)pixels;
+    surface->width = width;
+    surface->height = height;
+    surface->pitch = pitch / 4;
+    surface->owned = false;
+    softwareSetClip(surface, NULL);
+
+    return surface;
+}
+
+void softwareReleaseSurface(OsdSurface* surface)
+{
+    if (surface->owned)
+    {
+        free(surface->pixels);
+    }
+    free(surface);
+}
+
+void softwareSetClip(OsdSurface* surface, const OsdRectangle* clip)
+{
+    OsdRectangle area;
+
+    surface->clip.x = 0;
+    surface->clip.y = 0;
+    surface->clip.w = surface->width;
+    surface->clip.h = surface->height;
+
+    /* clip is kept within the surface */
+    if (clip != NULL)
+    {
+        area = *clip;
+        if (!clipRectangle(surface, &area))
+        {
+            memset(&area, 0x0, sizeof(OsdRectangle));
+        }
+        surface->clip = area;
+    }
+}
+
+void softwareFill(OsdSurface* surface, const OsdRectangle* rectangle, uint32_t color)
+{
+    OsdRectangle area = *rectangle;
+    uint32_t pixel = premultiply(color);
+    int32_t j = 0;
+
+    if (!clipRectangle(surface, &area))
+    {
+        return;
+    }
+
+    for (j = area.y; j < area.y + area.h; j++)
+    {
+        kernels->fill(surface->pixels + (size_t)j * surface->pitch + area.x, pixel, area.w);
+    }
+}
+
+void softwareBlit(OsdSurface* destination, OsdSurface* source, int32_t x, int32_t y, bool blend)
+{
+    OsdRectangle area;
+    const uint32_t* sourceRow = NULL;
+    uint32_t* destinationRow = NULL;
+    int32_t j = 0;
+
+    area.x = x;
+    area.y = y;
+    area.w = source->width;
+    area.h = source->height;
+    if (!clipRectangle(destination, &area))
+    {
+        return;
+    }
+
+    for (j = area.y; j < area.y + area.h; j++)
+    {
+        sourceRow = source->pixels + (size_t)(j - y) * source->pitch + (area.x - x);
+        destinationRow = destination->pixels + (size_t)j * destination->pitch + area.x;
+        if (blend)
+        {
+            kernels->blend(destinationRow, sourceRow, area.w);
+        }
+        else
+        {
+            kernels->copy(destinationRow, sourceRow, area.w);
+        }
+    }
+}
+
+void softwareFlip(OsdSurface* primary, const OsdRectangle* region)
+{
+    char path[SOFTWARE_MAX_PATH + 32];
+
+    /* single buffer, the whole frame is what would be shown after the flip */
+    if (dumpDirectory[0] != '\0')
+    {
+        snprintf(path, sizeof(path), "%s/frame_%05u.pam", dumpDirectory, frameCount);
+        writePam(primary, path);
+    }
+    frameCount++;
+}
+
+OsdFont* softwareLoadFont(const char* path, int32_t height)
+{
+    OsdFont* font = (OsdFont*)malloc(sizeof(OsdFont));
+
+    /* path names the font of the target, bundled font is used instead */
+    if (font == NULL)
+    {
+        printf("\n%s : ERROR cannot allocate font!\n", __FUNCTION__);
+        return NULL;
+    }
+
+    font->scale = (height >= CELL_HEIGHT) ? height / CELL_HEIGHT : 1;
+
+    return font;
+}
+
+void softwareReleaseFont(OsdFont* font)
+{
+    free(font);
+}
+
+void softwareGetFontMetrics(OsdFont* font, int32_t* height, int32_t* ascender)
+{
+    *height = CELL_HEIGHT * font->scale;
+    *ascender = CELL_ASCENDER * font->scale;
+}
+
+int32_t softwareGetStringWidth(OsdFont* font, const char* text)
+{
+    return (int32_t)strlen(text) * CELL_WIDTH * font->scale;
+}
+
+void softwareDrawString(OsdSurface* surface, OsdFont* font, const char* text, int32_t x, int32_t y, uint32_t color)
+{
+    const uint8_t* glyph = NULL;
+    OsdRectangle dot;
+    uint32_t pixel = premultiply(color);
+    int32_t glyphRow = 0;
+    int32_t glyphColumn = 0;
+    int32_t j = 0;
+
+    for (; *text != '\0'; text++, x += CELL_WIDTH * font->scale)
+    {
+        if ((uint8_t)*text < GLYPH_FIRST || (uint8_t)*text >= GLYPH_FIRST + GLYPH_COUNT)
+        {
+            continue;
+        }
+        glyph = glyphs[(uint8_t)*text - GLYPH_FIRST];
+
+        /* each set bit of the glyph is a scale x scale block blended over the surface */
+        for (glyphRow = 0; glyphRow < GLYPH_HEIGHT; glyphRow++)
+        {
+            for (glyphColumn = 0; glyphColumn < GLYPH_WIDTH; glyphColumn++)
+            {
+                if (!(glyph[glyphRow] & (0x10 >> glyphColumn)))
+                {
+                    continue;
+                }
+                dot.x = x + glyphColumn * font->scale;
+                dot.y = y + (glyphRow + 1) * font->scale;
+                dot.w = font->scale;
+                dot.h = font->scale;
+                if (!clipRectangle(surface, &dot))
+                {
+                    continue;
+                }
+                for (j = dot.y; j < dot.y + dot.h; j++)
+                {
+                    kernels->blendSolid(surface->pixels + (size_t)j * surface->pitch + dot.x, pixel, dot.w);
+                }
+            }
+        }
+    }
+}
+
+bool clipRectangle(const OsdSurface* surface, OsdRectangle* rectangle)
+{
+    int32_t x1 = (rectangle->x > surface->clip.x) ? rectangle->x : surface->clip.x;
+    int32_t y1 = (rectangle->y > surface->clip.y) ? rectangle->y : surface->clip.y;
+    int32_t x2 = (rectangle->x + rectangle->w < surface->clip.x + surface->clip.w) ? rectangle->x + rectangle->w : surface->clip.x + surface->clip.w;
+    int32_t y2 = (rectangle->y + rectangle->h < surface->clip.y + surface->clip.h) ? rectangle->y + rectangle->h : surface->clip.y + surface->clip.h;
+
+    if (x2 <= x1 || y2 <= y1)
+    {
+        return false;
+    }
+
+    rectangle->x = x1;
+    rectangle->y = y1;
+    rectangle->w = x2 - x1;
+    rectangle->h = y2 - y1;
+
+    return true;
+}
+
+uint32_t premultiply(uint32_t color)
+{
+    uint32_t pixel = 0;
+
+    kernels->premultiply(&pixel, &color, 1);
+
+    return pixel;
+}
+
+OsdSurface* readPam(const char* path)
+{
+    FILE* file = fopen(path, "rb");
+    OsdSurface* surface = NULL;
+    uint8_t sample[4];
+    int32_t width = 0;
+    int32_t height = 0;
+    int32_t depth = 0;
+    int32_t i = 0;
+
+    if (file == NULL)
+    {
+        return NULL;
+    }
+
+    if (!readPamHeader(file, &width, &height, &depth) || (depth != 3 && depth != 4))
+    {
+        printf("\n%s : ERROR %s is not an 8 bit RGB or RGB_ALPHA PAM file!\n", __FUNCTION__, path);
+        fclose(file);
+        return NULL;
+    }
+
+    surface = softwareCreateSurface(width, height);
+    if (surface == NULL)
+    {
+        fclose(file);
+        return NULL;
+    }
+
+    sample[3] = 0xFF;
+    for (i = 0; i < width * height; i++)
+    {
+        if (fread(sample, 1, depth, file) != (size_t)depth)
+        {
+            printf("\n%s : ERROR %s is truncated!\n", __FUNCTION__, path);
+            softwareReleaseSurface(surface);
+            fclose(file);
+            return NULL;
+        }
+        surface->pixels[i] = ((uint32_t)sample[3] << 24) | ((uint32_t)sample[0] << 16) | ((uint32_t)sample[1] << 8) | sample[2];
+    }
+    kernels->premultiply(surface->pixels, surface->pixels, width * height);
+
+    fclose(file);
+
+    return surface;
+}
+
+bool readPamHeader(FILE* file, int32_t* width, int32_t* height, int32_t* depth)
+{
+    char line[SOFTWARE_MAX_PATH];
+    int32_t maxValue = 0;
+
+    if (fgets(line, sizeof(line), file) == NULL || strncmp(line, "P7", 2) != 0)
+    {
+        return false;
+    }
+
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        if (strncmp(line, "ENDHDR", 6) == 0)
+        {
+            return *width > 0 && *height > 0 && maxValue == 255;
+        }
+        sscanf(line, "WIDTH %d", width);
+        sscanf(line, "HEIGHT %d", height);
+        sscanf(line, "DEPTH %d", depth);
+        sscanf(line, "MAXVAL %d", &maxValue);
+    }
+
+    return false;
+}
+
+void writePam(const OsdSurface* surface, const char* path)
+{
+    FILE* file = NULL;
+    uint32_t* pixels = NULL;
+    uint8_t* samples = NULL;
+    int32_t i = 0;
+    int32_t j = 0;
+
+    pixels = (uint32_t*)malloc((size_t)surface->width * sizeof(uint32_t));
+    samples = (uint8_t*)malloc((size_t)surface->width * 4);
+    file = fopen(path, "wb");
+    if (pixels == NULL || samples == NULL || file == NULL)
+    {
+        printf("\n%s : ERROR cannot create %s!\n", __FUNCTION__, path);
+        free(pixels);
+        free(samples);
+        if (file != NULL)
+        {
+            fclose(file);
+        }
+        return;
+    }
+
+    /* a row at a time, PAM samples are straight alpha in R, G, B, A order */
+    fprintf(file, "P7\nWIDTH %d\nHEIGHT %d\nDEPTH 4\nMAXVAL 255\nTUPLTYPE RGB_ALPHA\nENDHDR\n", surface->width, surface->height);
+    for (j = 0; j < surface->height; j++)
+    {
+        kernels->unpremultiply(pixels, surface->pixels + (size_t)j * surface->pitch, surface->width);
+        for (i = 0; i < surface->width; i++)
+        {
+            samples[4 * i] = (pixels[i] >> 16) & 0xFF;
+            samples[4 * i + 1] = (pixels[i] >> 8) & 0xFF;
+            samples[4 * i + 2] = pixels[i] & 0xFF;
+            samples[4 * i + 3] = pixels[i] >> 24;
+        }
+        fwrite(samples, 1, (size_t)surface->width * 4, file);
+    }
+
+    free(pixels);
+    free(samples);
+    fclose(file);
+}
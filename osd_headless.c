@@ -0,0 +1,411 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include "graphics_controller.h"
+#include "channel_database.h"
+#include "timer_wheel.h"
+#include "osd_backend.h"
+#include "tables.h"
+#include "startup_graph.h"
+
+#define SCREEN_WIDTH 1920
+#define SCREEN_HEIGHT 1080
+#define ZAP_COUNT 20                                /* Channel changes in the scripted session */
+#define ZAP_INTERVAL 150                            /* Time in ms between channel changes */
+#define VOLUME_STEP_INTERVAL 40                     /* Time in ms between volume key presses */
+#define HIDE_WAIT 8500                              /* Time in ms for every OSD element to time out */
+#define VOLUME_ASSET_WIDTH 40
+#define VOLUME_ASSET_HEIGHT 300
+#define CHANNELS_PATH "channels.db"                 /* Generated in the working directory */
+#define CHANNELS_MULTIPLEX_COUNT 30
+#define CHANNELS_PER_MULTIPLEX 100
+#define LIST_SCROLL_ROWS 400                        /* Rows the channel list is scrolled down and up again */
+#define LIST_SCROLL_INTERVAL 20                     /* Time in ms between list key presses, key auto repeat rate */
+#define EPG_SERVICE_COUNT 24                        /* Services of first multiplex with a schedule */
+#define EPG_DAYS 7
+#define EPG_SEGMENT_SECONDS 10800                   /* Schedule sections carry three hours of events each */
+#define EPG_UPDATE_INTERVAL 250                     /* Time in ms between EIT sections that change an event */
+#define EPG_ROW_MOVES 12                            /* Rows the cursor moves down while scrolling through the week */
+#define STARTUP_THREADS 3
+#define MEMORY_STATS_PATH "/proc/self/smaps_rollup"
+#define MEMORY_STATS_LINE 128
+
+#define ERRORCHECK(x)                                                       \
+{                                                                           \
+    if (x != 0)                                                             \
+    {                                                                       \
+        printf("\nError in function %s, line %d\n", __FUNCTION__, __LINE__);\
+        return -1;                                                          \
+    }                                                                       \
+}
+
+static void writeVolumeAssets();
+static void writeChannels();
+static void runSession();
+static void* zapWhileScrolling(void* data);
+static void sendSchedule(uint32_t now);
+static void runEpgSession();
+static void* updateWhileScrolling(void* data);
+static int32_t initOsdBackend(void* data);
+static int32_t loadOsdFont(void* data);
+static int32_t loadOsdAssets(void* data);
+static int32_t startOsd(void* data);
+static int32_t loadChannelList(void* data);
+static unsigned long privateDirtyKilobytes();
+
+/*
+ * Runs the OSD on the software backend, with no set-top box and no DirectFB.
+ * Usage: osd_headless [frame dump directory]
+ */
+int main(int argc, char** argv)
+{
+    TimerWheel timerWheel;
+    StartupGraph startup;
+    int8_t osdBackendStep = 0;
+    int8_t fontStep = 0;
+    int8_t assetStep = 0;
+
+    startupTraceInit();
+    softwareBackendSetScreenSize(SCREEN_WIDTH, SCREEN_HEIGHT);
+    if (argc > 1)
+    {
+        softwareBackendSetDumpDirectory(argv[1]);
+    }
+
+    /* volume bar images are looked up in the working directory */
+    writeVolumeAssets();
+    writeChannels();
+
+    ERRORCHECK(timerWheelInit(&timerWheel));
+    graphicsControllerPrepare(&timerWheel, &softwareBackend);
+
+    /* same startup graph as on the set-top box, without tuner and remote */
+    startupGraphInit(&startup);
+    osdBackendStep = startupGraphAddStep(&startup, "osd backend", initOsdBackend, NULL, 0);
+    fontStep = startupGraphAddStep(&startup, "font", loadOsdFont, NULL, STARTUP_STEP(osdBackendStep));
+    assetStep = startupGraphAddStep(&startup, "osd assets", loadOsdAssets, NULL, STARTUP_STEP(osdBackendStep));
+    startupGraphAddStep(&startup, "osd start", startOsd, NULL, STARTUP_STEP(fontStep) | STARTUP_STEP(assetStep));
+    startupGraphAddStep(&startup, "channel list", loadChannelList, NULL, 0);
+    ERRORCHECK(startupGraphRun(&startup, STARTUP_THREADS));
+
+    runSession();
+    runEpgSession();
+
+    ERRORCHECK(graphicsControllerDeinit());
+    timerWheelPrintStats(&timerWheel);
+    ERRORCHECK(timerWheelDeinit(&timerWheel));
+
+    return 0;
+}
+
+int32_t initOsdBackend(void* data)
+{
+    return graphicsControllerInitBackend();
+}
+
+int32_t loadOsdFont(void* data)
+{
+    return graphicsControllerLoadFont();
+}
+
+int32_t loadOsdAssets(void* data)
+{
+    unsigned long before = privateDirtyKilobytes();
+    int32_t result = graphicsControllerLoadAssets();
+
+    /* decoded images are dirty heap, images mapped from asset pack are clean pages of the file */
+    printf("%s : INFO osd assets took %ld kB of private dirty memory\n", __FUNCTION__, (long)(privateDirtyKilobytes() - before));
+
+    return result;
+}
+
+int32_t startOsd(void* data)
+{
+    return graphicsControllerStart();
+}
+
+int32_t loadChannelList(void* data)
+{
+    graphicsControllerSetChannelDatabase(CHANNELS_PATH);
+    return 0;
+}
+
+unsigned long privateDirtyKilobytes()
+{
+    FILE* file = fopen(MEMORY_STATS_PATH, "r");
+    char line[MEMORY_STATS_LINE];
+    unsigned long privateDirty = 0;
+
+    if (file == NULL)
+    {
+        return 0;
+    }
+
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        sscanf(line, "Private_Dirty: %lu kB", &privateDirty);
+    }
+    fclose(file);
+
+    return privateDirty;
+}
+
+void runSession()
+{
+    pthread_t zapThread;
+    bool zapping = true;
+    int32_t i = 0;
+
+    /* zapping, every channel change shows program number and info banner */
+    for (i = 0; i < ZAP_COUNT; i++)
+    {
+        drawProgramNumber(i + 1);
+        drawInfoRect(10, 18, 2026, 101 + i, 201 + i);
+        usleep(ZAP_INTERVAL * 1000);
+    }
+
+    /* volume up to maximum and back to mute */
+    for (i = 0; i <= 10; i++)
+    {
+        drawVolumeBar(i);
+        usleep(VOLUME_STEP_INTERVAL * 1000);
+    }
+    for (i = 10; i >= 0; i--)
+    {
+        drawVolumeBar(i);
+        usleep(VOLUME_STEP_INTERVAL * 1000);
+    }
+
+    /* channel list scrolled through thousands of services while channels change underneath */
+    channelDial(0);
+    pthread_create(&zapThread, NULL, zapWhileScrolling, &zapping);
+    for (i = 0; i < LIST_SCROLL_ROWS; i++)
+    {
+        channelDial(1);
+        usleep(LIST_SCROLL_INTERVAL * 1000);
+    }
+    for (i = 0; i < LIST_SCROLL_ROWS; i++)
+    {
+        channelDial(-1);
+        usleep(LIST_SCROLL_INTERVAL * 1000);
+    }
+    channelDial(-1);
+    usleep(LIST_SCROLL_INTERVAL * 1000);
+    zapping = false;
+    pthread_join(zapThread, NULL);
+
+    /* every element disappears on its own */
+    usleep(HIDE_WAIT * 1000);
+}
+
+void* zapWhileScrolling(void* data)
+{
+    volatile bool* zapping = (volatile bool*)data;
+    int32_t channel = 0;
+
+    while (*zapping)
+    {
+        drawProgramNumber(++channel);
+        usleep(ZAP_INTERVAL * 1000);
+    }
+
+    return NULL;
+}
+
+void sendSchedule(uint32_t now)
+{
+    static EitTable eitTable;
+    uint32_t start = 0;
+    uint32_t end = now - now % EPG_SEGMENT_SECONDS + EPG_DAYS * 24 * 3600;
+    uint16_t eventId = 0;
+    int32_t i = 0;
+
+    /* random programme lengths, so events start and end anywhere inside tiles */
+    srand(1);
+    for (i = 0; i < EPG_SERVICE_COUNT; i++)
+    {
+        memset(&eitTable, 0x0, sizeof(EitTable));
+        eitTable.tableId = 0x50;
+        eitTable.transportStreamId = 1;
+        eitTable.serviceId = i + 1;
+        start = now - now % EPG_SEGMENT_SECONDS;
+        eventId = 0;
+        while (start < end)
+        {
+            eitTable.eitEventInfoArray[eitTable.eventInfoCount].eventId = ++eventId;
+            eitTable.eitEventInfoArray[eitTable.eventInfoCount].startTime = start;
+            eitTable.eitEventInfoArray[eitTable.eventInfoCount].duration = (15 + rand() % 22 * 5) * 60;
+            snprintf(eitTable.eitEventInfoArray[eitTable.eventInfoCount].eventName, TABLES_MAX_NAME_LENGTH,
+                     "Programme %u of channel %d", eventId, i + 1);
+            start += eitTable.eitEventInfoArray[eitTable.eventInfoCount].duration;
+            eitTable.eventInfoCount++;
+
+            if (start / EPG_SEGMENT_SECONDS != eitTable.eitEventInfoArray[0].startTime / EPG_SEGMENT_SECONDS || start >= end)
+            {
+                graphicsControllerStoreEvents(&eitTable);
+                eitTable.sectionNumber++;
+                eitTable.eventInfoCount = 0;
+            }
+        }
+    }
+}
+
+void runEpgSession()
+{
+    pthread_t updateThread;
+    bool updating = true;
+    uint32_t now = time(NULL);
+    int32_t i = 0;
+
+    /* whole week is received before guide opens, as sections repeat long before anyone presses EPG */
+    sendSchedule(now);
+
+    drawEpgGrid(true);
+    usleep(LIST_SCROLL_INTERVAL * 1000);
+
+    /* sections keep arriving, repeated ones change nothing and every few a programme is renamed */
+    pthread_create(&updateThread, NULL, updateWhileScrolling, &updating);
+
+    /* through the week with auto repeat, stepping one row down now and then */
+    for (i = 0; i < EPG_DAYS * 24 * 60 / 67; i++)
+    {
+        moveEpgCursor(0, 1);
+        if (i % (EPG_DAYS * 24 * 60 / 67 / EPG_ROW_MOVES) == 0)
+        {
+            moveEpgCursor(1, 0);
+        }
+        usleep(LIST_SCROLL_INTERVAL * 1000);
+    }
+    for (i = 0; i < EPG_SERVICE_COUNT; i++)
+    {
+        moveEpgCursor(-1, 0);
+        usleep(LIST_SCROLL_INTERVAL * 1000);
+    }
+    for (i = 0; i < 48; i++)
+    {
+        moveEpgCursor(0, -1);
+        usleep(LIST_SCROLL_INTERVAL * 1000);
+    }
+
+    updating = false;
+    pthread_join(updateThread, NULL);
+    drawEpgGrid(false);
+    usleep(LIST_SCROLL_INTERVAL * 1000);
+}
+
+void* updateWhileScrolling(void* data)
+{
+    static EitTable eitTable;
+    volatile bool* updating = (volatile bool*)data;
+    uint32_t now = time(NULL);
+    uint32_t update = 0;
+
+    memset(&eitTable, 0x0, sizeof(EitTable));
+    eitTable.tableId = 0x4E;
+    eitTable.transportStreamId = 1;
+    eitTable.eventInfoCount = 1;
+
+    /* a late change to an event in the next hours, on a different service every time */
+    while (*updating)
+    {
+        update++;
+        eitTable.serviceId = update % EPG_SERVICE_COUNT + 1;
+        eitTable.eitEventInfoArray[0].eventId = 1000 + update;
+        eitTable.eitEventInfoArray[0].startTime = now - now % 1800 + (update % 8) * 1800;
+        eitTable.eitEventInfoArray[0].duration = 1800;
+        snprintf(eitTable.eitEventInfoArray[0].eventName, TABLES_MAX_NAME_LENGTH, "News flash %u", update);
+        graphicsControllerStoreEvents(&eitTable);
+
+        sendSchedule(now);
+        usleep(EPG_UPDATE_INTERVAL * 1000);
+    }
+
+    return NULL;
+}
+
+void writeChannels()
+{
+    static ChannelDatabase database;
+    ChannelMultiplex multiplex;
+    ChannelService service;
+    uint16_t multiplexIndex = 0;
+    int32_t i = 0;
+    int32_t j = 0;
+
+    /* numbers interleave across multiplexes, as after a scan of several networks */
+    channelDatabaseClear(&database);
+    for (i = 0; i < CHANNELS_MULTIPLEX_COUNT; i++)
+    {
+        memset(&multiplex, 0x0, sizeof(ChannelMultiplex));
+        multiplex.frequency = 474000000 + i * 8000000;
+        multiplex.bandwidth = 8;
+        multiplex.transportStreamId = i + 1;
+        channelDatabaseAddMultiplex(&database, &multiplex, &multiplexIndex);
+
+        for (j = 0; j < CHANNELS_PER_MULTIPLEX; j++)
+        {
+            memset(&service, 0x0, sizeof(ChannelService));
+            service.multiplexIndex = multiplexIndex;
+            service.serviceId = j + 1;
+            service.patIndex = j + 1;
+            service.logicalChannelNumber = j * CHANNELS_MULTIPLEX_COUNT + i + 1;
+            service.serviceType = (j % 10 == 9) ? 0x02 : 0x01;
+            snprintf(service.name, sizeof(service.name), "Channel %d on %u MHz", service.logicalChannelNumber,
+                     multiplex.frequency / 1000000);
+            channelDatabaseAddService(&database, &service);
+        }
+    }
+    channelDatabaseSort(&database);
+
+    if (channelDatabaseSave(&database, CHANNELS_PATH) != CDB_NO_ERROR)
+    {
+        printf("\n%s : WARNING cannot write %s, channel list is empty!\n", __FUNCTION__, CHANNELS_PATH);
+    }
+}
+
+void writeVolumeAssets()
+{
+    char path[32];
+    FILE* file = NULL;
+    uint8_t sample[4];
+    int32_t level = 0;
+    int32_t x = 0;
+    int32_t y = 0;
+
+    /* bars filled from the bottom, level tenths of the height, only where no asset exists yet */
+    for (level = 0; level <= 10; level++)
+    {
+        snprintf(path, sizeof(path), "volume_%d.pam", level);
+        if (access(path, F_OK) == 0)
+        {
+            continue;
+        }
+
+        file = fopen(path, "wb");
+        if (file == NULL)
+        {
+            printf("\n%s : WARNING cannot write %s, volume bar is not shown!\n", __FUNCTION__, path);
+            continue;
+        }
+
+        fprintf(file, "P7\nWIDTH %d\nHEIGHT %d\nDEPTH 4\nMAXVAL 255\nTUPLTYPE RGB_ALPHA\nENDHDR\n",
+                VOLUME_ASSET_WIDTH, VOLUME_ASSET_HEIGHT);
+        for (y = 0; y < VOLUME_ASSET_HEIGHT; y++)
+        {
+            for (x = 0; x < VOLUME_ASSET_WIDTH; x++)
+            {
+                bool filled = (VOLUME_ASSET_HEIGHT - y) * 10 <= level * VOLUME_ASSET_HEIGHT;
+
+                sample[0] = filled ? 0x30 : 0x60;
+                sample[1] = filled ? 0xC0 : 0x60;
+                sample[2] = filled ? 0x30 : 0x60;
+                sample[3] = filled ? 0xFF : 0x80;
+                fwrite(sample, 1, sizeof(sample), file);
+            }
+        }
+        fclose(file);
+    }
+}
@@ -0,0 +1,190 @@
+#include "osd_pixel.h"
+#if defined(__arm__) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
+static void scalarFill(uint32_t* destination, uint32_t pixel, int32_t count);
+static void scalarCopy(uint32_t* destination, const uint32_t* source, int32_t count);
+static void scalarBlend(uint32_t* destination, const uint32_t* source, int32_t count);
+static void scalarBlendSolid(uint32_t* destination, uint32_t pixel, int32_t count);
+static void scalarPremultiply(uint32_t* destination, const uint32_t* source, int32_t count);
+static void scalarUnpremultiply(uint32_t* destination, const uint32_t* source, int32_t count);
+static uint32_t blendPixel(uint32_t destination, uint32_t source);
+static bool cpuSupports(PixelKernelSet set);
+
+const PixelKernels scalarPixelKernels =
+{
+    "scalar",
+    scalarFill,
+    scalarCopy,
+    scalarBlend,
+    scalarBlendSolid,
+    scalarPremultiply,
+    scalarUnpremultiply
+};
+
+static const PixelKernels* bestKernels = NULL;
+
+const PixelKernels* pixelKernelsGet(PixelKernelSet set)
+{
+    if (!cpuSupports(set))
+    {
+        return NULL;
+    }
+
+    switch (set)
+    {
+        case PIXEL_KERNELS_SCALAR:
+            return &scalarPixelKernels;
+#if defined(__x86_64__) || defined(__i386__)
+        case PIXEL_KERNELS_SSE2:
+            return &sse2PixelKernels;
+        case PIXEL_KERNELS_AVX2:
+            return &avx2PixelKernels;
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+        case PIXEL_KERNELS_NEON:
+            return &neonPixelKernels;
+#endif
+        default:
+            return NULL;
+    }
+}
+
+const PixelKernels* pixelKernelsBest()
+{
+    int32_t set = 0;
+
+    /* racing first calls pick the same set, so no lock is needed */
+    if (bestKernels == NULL)
+    {
+        for (set = PIXEL_KERNELS_COUNT - 1; set >= PIXEL_KERNELS_SCALAR; set--)
+        {
+            if (pixelKernelsGet((PixelKernelSet)set) != NULL)
+            {
+                bestKernels = pixelKernelsGet((PixelKernelSet)set);
+                break;
+            }
+        }
+        printf("\n%s : INFO using %s pixel kernels\n", __FUNCTION__, bestKernels->name);
+    }
+
+    return bestKernels;
+}
+
+bool cpuSupports(PixelKernelSet set)
+{
+    switch (set)
+    {
+        case PIXEL_KERNELS_SCALAR:
+            return true;
+#if defined(__x86_64__) || defined(__i386__)
+        case PIXEL_KERNELS_SSE2:
+            return __builtin_cpu_supports("sse2");
+        case PIXEL_KERNELS_AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+#if defined(__aarch64__)
+        case PIXEL_KERNELS_NEON:
+            /* part of the base architecture */
+            return true;
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+        case PIXEL_KERNELS_NEON:
+            return (getauxval(AT_HWCAP) & HWCAP_NEON) != 0;
+#endif
+        default:
+            return false;
+    }
+}
+
+void scalarFill(uint32_t* destination, uint32_t pixel, int32_t count)
+{
+    int32_t i = 0;
+
+    for (i = 0; i < count; i++)
+    {
+        destination[i] = pixel;
+    }
+}
+
+void scalarCopy(uint32_t* destination, const uint32_t* source, int32_t count)
+{
+    /* libc copy is already vectorized on every target */
+    memcpy(destination, source, (size_t)count * sizeof(uint32_t));
+}
+
+void scalarBlend(uint32_t* destination, const uint32_t* source, int32_t count)
+{
+    int32_t i = 0;
+
+    for (i = 0; i < count; i++)
+    {
+        destination[i] = blendPixel(destination[i], source[i]);
+    }
+}
+
+void scalarBlendSolid(uint32_t* destination, uint32_t pixel, int32_t count)
+{
+    int32_t i = 0;
+
+    for (i = 0; i < count; i++)
+    {
+        destination[i] = blendPixel(destination[i], pixel);
+    }
+}
+
+void scalarPremultiply(uint32_t* destination, const uint32_t* source, int32_t count)
+{
+    uint32_t alpha = 0;
+    uint32_t redBlue = 0;
+    uint32_t green = 0;
+    int32_t i = 0;
+
+    for (i = 0; i < count; i++)
+    {
+        alpha = source[i] >> 24;
+        redBlue = (source[i] & 0x00FF00FF) * alpha + 0x00800080;
+        green = ((source[i] >> 8) & 0xFF) * alpha + 0x80;
+
+        /* x / 255 rounded, without a division */
+        redBlue = ((redBlue + ((redBlue >> 8) & 0x00FF00FF)) >> 8) & 0x00FF00FF;
+        green = (green + (green >> 8)) >> 8;
+
+        destination[i] = (alpha << 24) | redBlue | (green << 8);
+    }
+}
+
+void scalarUnpremultiply(uint32_t* destination, const uint32_t* source, int32_t count)
+{
+    uint32_t alpha = 0;
+    uint32_t pixel = 0;
+    int32_t i = 0;
+
+    for (i = 0; i < count; i++)
+    {
+        pixel = source[i];
+        alpha = pixel >> 24;
+        if (alpha == 0)
+        {
+            destination[i] = 0;
+            continue;
+        }
+
+        destination[i] = (alpha << 24) | ((((pixel >> 16) & 0xFF) * 255 / alpha) << 16)
+                         | ((((pixel >> 8) & 0xFF) * 255 / alpha) << 8) | ((pixel & 0xFF) * 255 / alpha);
+    }
+}
+
+uint32_t blendPixel(uint32_t destination, uint32_t source)
+{
+    uint32_t inverse = 255 - (source >> 24);
+    uint32_t redBlue = (destination & 0x00FF00FF) * inverse + 0x00800080;
+    uint32_t alphaGreen = ((destination >> 8) & 0x00FF00FF) * inverse + 0x00800080;
+
+    /* source over destination, two channels per multiply */
+    redBlue = ((redBlue + ((redBlue >> 8) & 0x00FF00FF)) >> 8) & 0x00FF00FF;
+    alphaGreen = (alphaGreen + ((alphaGreen >> 8) & 0x00FF00FF)) & 0xFF00FF00;
+
+    return source + redBlue + alphaGreen;
+}
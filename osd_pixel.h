@@ -0,0 +1,63 @@
+#ifndef __OSD_PIXEL_H__
+#define __OSD_PIXEL_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+/**
+ * @brief Structure that defines pixel kernel sets, in order of preference
+ */
+typedef enum _PixelKernelSet
+{
+    PIXEL_KERNELS_SCALAR = 0,
+    PIXEL_KERNELS_SSE2,
+    PIXEL_KERNELS_NEON,
+    PIXEL_KERNELS_AVX2,
+    PIXEL_KERNELS_COUNT
+}PixelKernelSet;
+
+/**
+ * @brief Structure that holds row kernels of the software compositor
+ *
+ * Pixels are ARGB, one uint32_t each, premultiplied unless stated otherwise. Every set gives results
+ * identical to the scalar one, down to the last bit.
+ */
+typedef struct _PixelKernels
+{
+    const char* name;
+    void (*fill)(uint32_t* destination, uint32_t pixel, int32_t count);
+    void (*copy)(uint32_t* destination, const uint32_t* source, int32_t count);
+    void (*blend)(uint32_t* destination, const uint32_t* source, int32_t count);       /* Source over destination */
+    void (*blendSolid)(uint32_t* destination, uint32_t pixel, int32_t count);           /* One pixel over every destination */
+    void (*premultiply)(uint32_t* destination, const uint32_t* source, int32_t count);  /* Straight alpha source */
+    void (*unpremultiply)(uint32_t* destination, const uint32_t* source, int32_t count); /* Straight alpha destination */
+}PixelKernels;
+
+/**
+ * @brief Returns kernel set if it is built in and the CPU runs it
+ *
+ * @param [in] set - kernel set
+ * @return kernels, NULL if not available
+ */
+const PixelKernels* pixelKernelsGet(PixelKernelSet set);
+
+/**
+ * @brief Returns fastest kernel set the CPU runs, checked once at first call
+ *
+ * @return kernels
+ */
+const PixelKernels* pixelKernelsBest();
+
+/* kernel sets, available through pixelKernelsGet only */
+extern const PixelKernels scalarPixelKernels;
+#if defined(__x86_64__) || defined(__i386__)
+extern const PixelKernels sse2PixelKernels;
+extern const PixelKernels avx2PixelKernels;
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+extern const PixelKernels neonPixelKernels;
+#endif
+
+#endif /* __OSD_PIXEL_H__ */
@@ -0,0 +1,244 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "osd_pixel.h"
+
+#define BENCH_MIN_NANOSECONDS 300000000ULL          /* Each kernel runs on full frames for at least this long */
+#define BENCH_KERNEL_COUNT 6
+#define PANEL_PIXEL 0xEFE091D7                      /* Info banner colour, premultiplied at start */
+
+/**
+ * @brief Structure that holds one measured resolution
+ */
+typedef struct _BenchFrame
+{
+    const char* name;
+    int32_t width;
+    int32_t height;
+}BenchFrame;
+
+static const BenchFrame frames[] =
+{
+    { "720p", 1280, 720 },
+    { "1080p", 1920, 1080 }
+};
+static const char* kernelNames[BENCH_KERNEL_COUNT] =
+{
+    "fill", "copy", "blend", "blendSolid", "premultiply", "unpremultiply"
+};
+
+static void runKernel(const PixelKernels* kernels, int32_t kernel, uint32_t* destination, const uint32_t* source,
+                      uint32_t pixel, int32_t width, int32_t height);
+static double measureKernel(const PixelKernels* kernels, int32_t kernel, uint32_t* destination, const uint32_t* source,
+                            uint32_t pixel, int32_t width, int32_t height);
+static bool checkKernel(const PixelKernels* kernels, int32_t kernel, uint32_t* destination, uint32_t* expected,
+                        const uint32_t* source, const uint32_t* background, uint32_t pixel, int32_t width, int32_t height);
+static void randomPixels(uint32_t* pixels, size_t count);
+static uint64_t monotonicNanoseconds();
+
+/*
+ * Reports megapixels per second of every pixel kernel set the CPU runs, and checks each one
+ * gives the same pixels as the scalar set.
+ */
+int main()
+{
+    const PixelKernels* kernels = NULL;
+    uint32_t* source = NULL;
+    uint32_t* background = NULL;
+    uint32_t* destination = NULL;
+    uint32_t* expected = NULL;
+    uint32_t panel = PANEL_PIXEL;
+    uint32_t pixel = 0;
+    size_t count = 0;
+    bool identical = true;
+    int32_t frame = 0;
+    int32_t set = 0;
+    int32_t kernel = 0;
+
+    scalarPixelKernels.premultiply(&pixel, &panel, 1);
+    printf("best kernels: %s\n", pixelKernelsBest()->name);
+
+    for (frame = 0; frame < (int32_t)(sizeof(frames) / sizeof(frames[0])); frame++)
+    {
+        count = (size_t)frames[frame].width * frames[frame].height;
+        source = (uint32_t*)malloc(count * sizeof(uint32_t));
+        background = (uint32_t*)malloc(count * sizeof(uint32_t));
+        destination = (uint32_t*)malloc(count * sizeof(uint32_t));
+        expected = (uint32_t*)malloc(count * sizeof(uint32_t));
+        if (source == NULL || background == NULL || destination == NULL || expected == NULL)
+        {
+            printf("\n%s : ERROR cannot allocate %s frames!\n", __FUNCTION__, frames[frame].name);
+            return -1;
+        }
+
+        srand(frame + 1);
+        randomPixels(source, count);
+        randomPixels(background, count);
+
+        printf("\n%s (%dx%d), Mpx/s\n%-14s", frames[frame].name, frames[frame].width, frames[frame].height, "");
+        for (set = 0; set < PIXEL_KERNELS_COUNT; set++)
+        {
+            if (pixelKernelsGet((PixelKernelSet)set) != NULL)
+            {
+                printf("%10s", pixelKernelsGet((PixelKernelSet)set)->name);
+            }
+        }
+        printf("\n");
+
+        for (kernel = 0; kernel < BENCH_KERNEL_COUNT; kernel++)
+        {
+            printf("%-14s", kernelNames[kernel]);
+            for (set = 0; set < PIXEL_KERNELS_COUNT; set++)
+            {
+                kernels = pixelKernelsGet((PixelKernelSet)set);
+                if (kernels == NULL)
+                {
+                    continue;
+                }
+                if (!checkKernel(kernels, kernel, destination, expected, source, background, pixel,
+                                 frames[frame].width, frames[frame].height))
+                {
+                    identical = false;
+                    printf("%10s", "MISMATCH");
+                    continue;
+                }
+                memcpy(destination, background, count * sizeof(uint32_t));
+                printf("%10.0f", measureKernel(kernels, kernel, destination, source, pixel, frames[frame].width, frames[frame].height));
+                fflush(stdout);
+            }
+            printf("\n");
+        }
+
+        free(source);
+        free(background);
+        free(destination);
+        free(expected);
+    }
+
+    printf("\n%s\n", identical ? "all kernel sets match scalar" : "ERROR kernel sets differ from scalar");
+
+    return identical ? 0 : -1;
+}
+
+void runKernel(const PixelKernels* kernels, int32_t kernel, uint32_t* destination, const uint32_t* source,
+               uint32_t pixel, int32_t width, int32_t height)
+{
+    int32_t j = 0;
+
+    /* row by row, as the software backend calls them */
+    for (j = 0; j < height; j++)
+    {
+        switch (kernel)
+        {
+            case 0:
+                kernels->fill(destination, pixel, width);
+                break;
+            case 1:
+                kernels->copy(destination, source, width);
+                break;
+            case 2:
+                kernels->blend(destination, source, width);
+                break;
+            case 3:
+                kernels->blendSolid(destination, pixel, width);
+                break;
+            case 4:
+                kernels->premultiply(destination, source, width);
+                break;
+            case 5:
+                kernels->unpremultiply(destination, source, width);
+                break;
+            default:
+                break;
+        }
+        destination += width;
+        source += width;
+    }
+}
+
+double measureKernel(const PixelKernels* kernels, int32_t kernel, uint32_t* destination, const uint32_t* source,
+                     uint32_t pixel, int32_t width, int32_t height)
+{
+    uint64_t start = monotonicNanoseconds();
+    uint64_t elapsed = 0;
+    uint32_t runs = 0;
+
+    do
+    {
+        runKernel(kernels, kernel, destination, source, pixel, width, height);
+        runs++;
+        elapsed = monotonicNanoseconds() - start;
+    } while (elapsed < BENCH_MIN_NANOSECONDS);
+
+    return (double)runs * width * height * 1000.0 / elapsed;
+}
+
+bool checkKernel(const PixelKernels* kernels, int32_t kernel, uint32_t* destination, uint32_t* expected,
+                 const uint32_t* source, const uint32_t* background, uint32_t pixel, int32_t width, int32_t height)
+{
+    size_t count = (size_t)width * height;
+    int32_t offset = 0;
+
+    memcpy(expected, background, count * sizeof(uint32_t));
+    runKernel(&scalarPixelKernels, kernel, expected, source, pixel, width, height);
+    memcpy(destination, background, count * sizeof(uint32_t));
+    runKernel(kernels, kernel, destination, source, pixel, width, height);
+    if (memcmp(destination, expected, count * sizeof(uint32_t)) != 0)
+    {
+        return false;
+    }
+
+    /* rows that start unaligned and end with a tail shorter than a vector */
+    for (offset = 1; offset < 8; offset++)
+    {
+        memcpy(expected, background, count * sizeof(uint32_t));
+        runKernel(&scalarPixelKernels, kernel, expected + offset, source + offset, pixel, width - 8, 1);
+        memcpy(destination, background, count * sizeof(uint32_t));
+        runKernel(kernels, kernel, destination + offset, source + offset, pixel, width - 8, 1);
+        if (memcmp(destination, expected, (size_t)width * sizeof(uint32_t)) != 0)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void randomPixels(uint32_t* pixels, size_t count)
+{
+    uint32_t alpha = 0;
+    uint32_t colour = 0;
+    size_t i = 0;
+
+    for (i = 0; i < count; i++)
+    {
+        /* transparent and opaque pixels are common in OSD graphics */
+        switch (rand() % 4)
+        {
+            case 0:
+                alpha = 0;
+                break;
+            case 1:
+                alpha = 255;
+                break;
+            default:
+                alpha = rand() & 0xFF;
+                break;
+        }
+        colour = ((uint32_t)rand() << 8) ^ (uint32_t)rand();
+        pixels[i] = (alpha << 24) | (colour & 0x00FFFFFF);
+    }
+
+    /* blend and unpremultiply expect premultiplied pixels */
+    scalarPixelKernels.premultiply(pixels, pixels, (int32_t)count);
+}
+
+uint64_t monotonicNanoseconds()
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
@@ -0,0 +1,122 @@
+#include "osd_pixel.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+
+static void neonFill(uint32_t* destination, uint32_t pixel, int32_t count);
+static void neonCopy(uint32_t* destination, const uint32_t* source, int32_t count);
+static void neonBlend(uint32_t* destination, const uint32_t* source, int32_t count);
+static void neonBlendSolid(uint32_t* destination, uint32_t pixel, int32_t count);
+static void neonPremultiply(uint32_t* destination, const uint32_t* source, int32_t count);
+static void neonUnpremultiply(uint32_t* destination, const uint32_t* source, int32_t count);
+static uint8x8_t neonMultiply(uint8x8_t value, uint8x8_t factor);
+
+const PixelKernels neonPixelKernels =
+{
+    "neon",
+    neonFill,
+    neonCopy,
+    neonBlend,
+    neonBlendSolid,
+    neonPremultiply,
+    neonUnpremultiply
+};
+
+void neonFill(uint32_t* destination, uint32_t pixel, int32_t count)
+{
+    uint32x4_t value = vdupq_n_u32(pixel);
+    int32_t i = 0;
+
+    for (i = 0; i + 4 <= count; i += 4)
+    {
+        vst1q_u32(destination + i, value);
+    }
+    scalarPixelKernels.fill(destination + i, pixel, count - i);
+}
+
+void neonCopy(uint32_t* destination, const uint32_t* source, int32_t count)
+{
+    memcpy(destination, source, (size_t)count * sizeof(uint32_t));
+}
+
+void neonBlend(uint32_t* destination, const uint32_t* source, int32_t count)
+{
+    uint8x8x4_t below;
+    uint8x8x4_t above;
+    uint8x8_t inverse;
+    int32_t channel = 0;
+    int32_t i = 0;
+
+    /* eight pixels split into planes of blue, green, red and alpha */
+    for (i = 0; i + 8 <= count; i += 8)
+    {
+        below = vld4_u8((const uint8_t*)(destination + i));
+        above = vld4_u8((const uint8_t*)(source + i));
+        inverse = vmvn_u8(above.val[3]);
+        for (channel = 0; channel < 4; channel++)
+        {
+            below.val[channel] = vadd_u8(above.val[channel], neonMultiply(below.val[channel], inverse));
+        }
+        vst4_u8((uint8_t*)(destination + i), below);
+    }
+    scalarPixelKernels.blend(destination + i, source + i, count - i);
+}
+
+void neonBlendSolid(uint32_t* destination, uint32_t pixel, int32_t count)
+{
+    uint8x8x4_t below;
+    uint8x8_t above[4];
+    uint8x8_t inverse = vdup_n_u8(255 - (pixel >> 24));
+    int32_t channel = 0;
+    int32_t i = 0;
+
+    for (channel = 0; channel < 4; channel++)
+    {
+        above[channel] = vdup_n_u8((pixel >> (8 * channel)) & 0xFF);
+    }
+
+    for (i = 0; i + 8 <= count; i += 8)
+    {
+        below = vld4_u8((const uint8_t*)(destination + i));
+        for (channel = 0; channel < 4; channel++)
+        {
+            below.val[channel] = vadd_u8(above[channel], neonMultiply(below.val[channel], inverse));
+        }
+        vst4_u8((uint8_t*)(destination + i), below);
+    }
+    scalarPixelKernels.blendSolid(destination + i, pixel, count - i);
+}
+
+void neonPremultiply(uint32_t* destination, const uint32_t* source, int32_t count)
+{
+    uint8x8x4_t value;
+    int32_t channel = 0;
+    int32_t i = 0;
+
+    for (i = 0; i + 8 <= count; i += 8)
+    {
+        value = vld4_u8((const uint8_t*)(source + i));
+        for (channel = 0; channel < 3; channel++)
+        {
+            value.val[channel] = neonMultiply(value.val[channel], value.val[3]);
+        }
+        vst4_u8((uint8_t*)(destination + i), value);
+    }
+    scalarPixelKernels.premultiply(destination + i, source + i, count - i);
+}
+
+void neonUnpremultiply(uint32_t* destination, const uint32_t* source, int32_t count)
+{
+    /* needs a division per channel, only used when frames are written out */
+    scalarPixelKernels.unpremultiply(destination, source, count);
+}
+
+uint8x8_t neonMultiply(uint8x8_t value, uint8x8_t factor)
+{
+    uint16x8_t product = vmull_u8(value, factor);
+
+    /* (x + 128 + ((x + 128) >> 8)) >> 8, x / 255 rounded as in scalar kernels */
+    return vraddhn_u16(product, vrshrq_n_u16(product, 8));
+}
+
+#endif /* __ARM_NEON || __ARM_NEON__ */
@@ -0,0 +1,251 @@
+#include "osd_pixel.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+/* kernels are built for their instruction set whatever the compiler flags, dispatch makes sure the CPU has it */
+#define SSE2_TARGET __attribute__((target("sse2")))
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+static SSE2_TARGET void sse2Fill(uint32_t* destination, uint32_t pixel, int32_t count);
+static void sse2Copy(uint32_t* destination, const uint32_t* source, int32_t count);
+static SSE2_TARGET void sse2Blend(uint32_t* destination, const uint32_t* source, int32_t count);
+static SSE2_TARGET void sse2BlendSolid(uint32_t* destination, uint32_t pixel, int32_t count);
+static SSE2_TARGET void sse2Premultiply(uint32_t* destination, const uint32_t* source, int32_t count);
+static void sse2Unpremultiply(uint32_t* destination, const uint32_t* source, int32_t count);
+static SSE2_TARGET __m128i sse2Divide255(__m128i value);
+static SSE2_TARGET __m128i sse2Alpha(__m128i pixels);
+static SSE2_TARGET __m128i sse2BlendFour(__m128i destination, __m128i source);
+
+static AVX2_TARGET void avx2Fill(uint32_t* destination, uint32_t pixel, int32_t count);
+static AVX2_TARGET void avx2Blend(uint32_t* destination, const uint32_t* source, int32_t count);
+static AVX2_TARGET void avx2BlendSolid(uint32_t* destination, uint32_t pixel, int32_t count);
+static AVX2_TARGET void avx2Premultiply(uint32_t* destination, const uint32_t* source, int32_t count);
+static AVX2_TARGET __m256i avx2Divide255(__m256i value);
+static AVX2_TARGET __m256i avx2Alpha(__m256i pixels);
+static AVX2_TARGET __m256i avx2BlendEight(__m256i destination, __m256i source);
+
+const PixelKernels sse2PixelKernels =
+{
+    "sse2",
+    sse2Fill,
+    sse2Copy,
+    sse2Blend,
+    sse2BlendSolid,
+    sse2Premultiply,
+    sse2Unpremultiply
+};
+
+/* copy and unpremultiply gain nothing from wider registers, they are shared with sse2 */
+const PixelKernels avx2PixelKernels =
+{
+    "avx2",
+    avx2Fill,
+    sse2Copy,
+    avx2Blend,
+    avx2BlendSolid,
+    avx2Premultiply,
+    sse2Unpremultiply
+};
+
+void sse2Fill(uint32_t* destination, uint32_t pixel, int32_t count)
+{
+    __m128i value = _mm_set1_epi32((int32_t)pixel);
+    int32_t i = 0;
+
+    for (i = 0; i + 4 <= count; i += 4)
+    {
+        _mm_storeu_si128((__m128i*)(destination + i), value);
+    }
+    scalarPixelKernels.fill(destination + i, pixel, count - i);
+}
+
+void sse2Copy(uint32_t* destination, const uint32_t* source, int32_t count)
+{
+    memcpy(destination, source, (size_t)count * sizeof(uint32_t));
+}
+
+void sse2Blend(uint32_t* destination, const uint32_t* source, int32_t count)
+{
+    __m128i result;
+    int32_t i = 0;
+
+    for (i = 0; i + 4 <= count; i += 4)
+    {
+        result = sse2BlendFour(_mm_loadu_si128((const __m128i*)(destination + i)), _mm_loadu_si128((const __m128i*)(source + i)));
+        _mm_storeu_si128((__m128i*)(destination + i), result);
+    }
+    scalarPixelKernels.blend(destination + i, source + i, count - i);
+}
+
+void sse2BlendSolid(uint32_t* destination, uint32_t pixel, int32_t count)
+{
+    __m128i zero = _mm_setzero_si128();
+    __m128i source = _mm_set1_epi32((int32_t)pixel);
+    __m128i inverse = _mm_set1_epi16((int16_t)(255 - (pixel >> 24)));
+    __m128i low;
+    __m128i high;
+    __m128i value;
+    int32_t i = 0;
+
+    for (i = 0; i + 4 <= count; i += 4)
+    {
+        value = _mm_loadu_si128((const __m128i*)(destination + i));
+        low = sse2Divide255(_mm_mullo_epi16(_mm_unpacklo_epi8(value, zero), inverse));
+        high = sse2Divide255(_mm_mullo_epi16(_mm_unpackhi_epi8(value, zero), inverse));
+        _mm_storeu_si128((__m128i*)(destination + i), _mm_add_epi8(source, _mm_packus_epi16(low, high)));
+    }
+    scalarPixelKernels.blendSolid(destination + i, pixel, count - i);
+}
+
+void sse2Premultiply(uint32_t* destination, const uint32_t* source, int32_t count)
+{
+    __m128i zero = _mm_setzero_si128();
+    __m128i colourMask = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+    __m128i alphaFactor = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+    __m128i value;
+    __m128i low;
+    __m128i high;
+    int32_t i = 0;
+
+    /* colour channels are multiplied by alpha, alpha by 255 so it stays as is */
+    for (i = 0; i + 4 <= count; i += 4)
+    {
+        value = _mm_loadu_si128((const __m128i*)(source + i));
+        low = _mm_unpacklo_epi8(value, zero);
+        high = _mm_unpackhi_epi8(value, zero);
+        low = sse2Divide255(_mm_mullo_epi16(low, _mm_or_si128(_mm_and_si128(sse2Alpha(low), colourMask), alphaFactor)));
+        high = sse2Divide255(_mm_mullo_epi16(high, _mm_or_si128(_mm_and_si128(sse2Alpha(high), colourMask), alphaFactor)));
+        _mm_storeu_si128((__m128i*)(destination + i), _mm_packus_epi16(low, high));
+    }
+    scalarPixelKernels.premultiply(destination + i, source + i, count - i);
+}
+
+void sse2Unpremultiply(uint32_t* destination, const uint32_t* source, int32_t count)
+{
+    /* needs a division per channel, only used when frames are written out */
+    scalarPixelKernels.unpremultiply(destination, source, count);
+}
+
+__m128i sse2Divide255(__m128i value)
+{
+    /* x / 255 rounded for x up to 255 * 255, same as scalar kernels */
+    value = _mm_add_epi16(value, _mm_set1_epi16(0x80));
+
+    return _mm_srli_epi16(_mm_add_epi16(value, _mm_srli_epi16(value, 8)), 8);
+}
+
+__m128i sse2Alpha(__m128i pixels)
+{
+    /* two pixels of 16 bit channels, alpha copied to every channel */
+    return _mm_shufflehi_epi16(_mm_shufflelo_epi16(pixels, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+__m128i sse2BlendFour(__m128i destination, __m128i source)
+{
+    __m128i zero = _mm_setzero_si128();
+    __m128i full = _mm_set1_epi16(255);
+    __m128i low = _mm_unpacklo_epi8(destination, zero);
+    __m128i high = _mm_unpackhi_epi8(destination, zero);
+
+    low = sse2Divide255(_mm_mullo_epi16(low, _mm_sub_epi16(full, sse2Alpha(_mm_unpacklo_epi8(source, zero)))));
+    high = sse2Divide255(_mm_mullo_epi16(high, _mm_sub_epi16(full, sse2Alpha(_mm_unpackhi_epi8(source, zero)))));
+
+    /* premultiplied source plus what shows through never exceeds 255 */
+    return _mm_add_epi8(source, _mm_packus_epi16(low, high));
+}
+
+void avx2Fill(uint32_t* destination, uint32_t pixel, int32_t count)
+{
+    __m256i value = _mm256_set1_epi32((int32_t)pixel);
+    int32_t i = 0;
+
+    for (i = 0; i + 8 <= count; i += 8)
+    {
+        _mm256_storeu_si256((__m256i*)(destination + i), value);
+    }
+    scalarPixelKernels.fill(destination + i, pixel, count - i);
+}
+
+void avx2Blend(uint32_t* destination, const uint32_t* source, int32_t count)
+{
+    __m256i result;
+    int32_t i = 0;
+
+    for (i = 0; i + 8 <= count; i += 8)
+    {
+        result = avx2BlendEight(_mm256_loadu_si256((const __m256i*)(destination + i)), _mm256_loadu_si256((const __m256i*)(source + i)));
+        _mm256_storeu_si256((__m256i*)(destination + i), result);
+    }
+    scalarPixelKernels.blend(destination + i, source + i, count - i);
+}
+
+void avx2BlendSolid(uint32_t* destination, uint32_t pixel, int32_t count)
+{
+    __m256i zero = _mm256_setzero_si256();
+    __m256i source = _mm256_set1_epi32((int32_t)pixel);
+    __m256i inverse = _mm256_set1_epi16((int16_t)(255 - (pixel >> 24)));
+    __m256i low;
+    __m256i high;
+    __m256i value;
+    int32_t i = 0;
+
+    for (i = 0; i + 8 <= count; i += 8)
+    {
+        value = _mm256_loadu_si256((const __m256i*)(destination + i));
+        low = avx2Divide255(_mm256_mullo_epi16(_mm256_unpacklo_epi8(value, zero), inverse));
+        high = avx2Divide255(_mm256_mullo_epi16(_mm256_unpackhi_epi8(value, zero), inverse));
+        _mm256_storeu_si256((__m256i*)(destination + i), _mm256_add_epi8(source, _mm256_packus_epi16(low, high)));
+    }
+    scalarPixelKernels.blendSolid(destination + i, pixel, count - i);
+}
+
+void avx2Premultiply(uint32_t* destination, const uint32_t* source, int32_t count)
+{
+    __m256i zero = _mm256_setzero_si256();
+    __m256i colourMask = _mm256_set_epi16(0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1);
+    __m256i alphaFactor = _mm256_set_epi16(255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0);
+    __m256i value;
+    __m256i low;
+    __m256i high;
+    int32_t i = 0;
+
+    for (i = 0; i + 8 <= count; i += 8)
+    {
+        value = _mm256_loadu_si256((const __m256i*)(source + i));
+        low = _mm256_unpacklo_epi8(value, zero);
+        high = _mm256_unpackhi_epi8(value, zero);
+        low = avx2Divide255(_mm256_mullo_epi16(low, _mm256_or_si256(_mm256_and_si256(avx2Alpha(low), colourMask), alphaFactor)));
+        high = avx2Divide255(_mm256_mullo_epi16(high, _mm256_or_si256(_mm256_and_si256(avx2Alpha(high), colourMask), alphaFactor)));
+        _mm256_storeu_si256((__m256i*)(destination + i), _mm256_packus_epi16(low, high));
+    }
+    scalarPixelKernels.premultiply(destination + i, source + i, count - i);
+}
+
+__m256i avx2Divide255(__m256i value)
+{
+    value = _mm256_add_epi16(value, _mm256_set1_epi16(0x80));
+
+    return _mm256_srli_epi16(_mm256_add_epi16(value, _mm256_srli_epi16(value, 8)), 8);
+}
+
+__m256i avx2Alpha(__m256i pixels)
+{
+    return _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(pixels, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+__m256i avx2BlendEight(__m256i destination, __m256i source)
+{
+    __m256i zero = _mm256_setzero_si256();
+    __m256i full = _mm256_set1_epi16(255);
+    __m256i low = _mm256_unpacklo_epi8(destination, zero);
+    __m256i high = _mm256_unpackhi_epi8(destination, zero);
+
+    /* unpack and pack work within 128 bit lanes, so pixel order is kept */
+    low = avx2Divide255(_mm256_mullo_epi16(low, _mm256_sub_epi16(full, avx2Alpha(_mm256_unpacklo_epi8(source, zero)))));
+    high = avx2Divide255(_mm256_mullo_epi16(high, _mm256_sub_epi16(full, avx2Alpha(_mm256_unpackhi_epi8(source, zero)))));
+
+    return _mm256_add_epi8(source, _mm256_packus_epi16(low, high));
+}
+
+#endif /* __x86_64__ || __i386__ */
@@ -0,0 +1,255 @@
+#include "pmt_prefetch.h"
+
+/**
+ * @brief Structure that holds one cached PMT
+ */
+typedef struct _PmtCacheEntry
+{
+    bool valid;
+    time_t receivedTime;
+    PmtTable pmtTable;
+}PmtCacheEntry;
+
+static PmtCacheEntry pmtCache[PMT_PREFETCH_MAX_SERVICES];
+static uint16_t zapHistory[PMT_PREFETCH_MAX_SERVICES][PMT_PREFETCH_MAX_SERVICES];
+static PmtPrefetchStats prefetchStats;
+static pthread_mutex_t prefetchMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static time_t monotonicSeconds();
+
+void pmtPrefetchReset()
+{
+    pthread_mutex_lock(&prefetchMutex);
+    memset(pmtCache, 0x0, sizeof(pmtCache));
+    pthread_mutex_unlock(&prefetchMutex);
+}
+
+void pmtPrefetchStore(const PmtTable* pmtTable)
+{
+    uint8_t i = 0;
+    uint8_t freeEntry = PMT_PREFETCH_MAX_SERVICES;
+    uint8_t oldestEntry = 0;
+
+    if (pmtTable == NULL)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&prefetchMutex);
+    for (i = 0; i < PMT_PREFETCH_MAX_SERVICES; i++)
+    {
+        if (pmtCache[i].valid && pmtCache[i].pmtTable.pmtHeader.programNumber == pmtTable->pmtHeader.programNumber)
+        {
+            break;
+        }
+        if (!pmtCache[i].valid && freeEntry == PMT_PREFETCH_MAX_SERVICES)
+        {
+            freeEntry = i;
+        }
+        if (pmtCache[i].receivedTime < pmtCache[oldestEntry].receivedTime)
+        {
+            oldestEntry = i;
+        }
+    }
+
+    if (i == PMT_PREFETCH_MAX_SERVICES)
+    {
+        i = (freeEntry != PMT_PREFETCH_MAX_SERVICES) ? freeEntry : oldestEntry;
+    }
+
+    pmtCache[i].valid = true;
+    pmtCache[i].receivedTime = monotonicSeconds();
+    pmtCache[i].pmtTable = *pmtTable;
+    pthread_mutex_unlock(&prefetchMutex);
+}
+
+bool pmtPrefetchRefresh(uint16_t programNumber, uint8_t versionNumber)
+{
+    bool cached = false;
+    uint8_t i = 0;
+
+    pthread_mutex_lock(&prefetchMutex);
+    for (i = 0; i < PMT_PREFETCH_MAX_SERVICES; i++)
+    {
+        if (pmtCache[i].valid && pmtCache[i].pmtTable.pmtHeader.programNumber == programNumber)
+        {
+            cached = pmtCache[i].pmtTable.pmtHeader.versionNumber == versionNumber;
+            if (cached)
+            {
+                pmtCache[i].receivedTime = monotonicSeconds();
+            }
+            break;
+        }
+    }
+    pthread_mutex_unlock(&prefetchMutex);
+
+    return cached;
+}
+
+bool pmtPrefetchLookup(uint16_t programNumber, PmtTable* pmtTable)
+{
+    bool found = false;
+    uint8_t i = 0;
+
+    if (pmtTable == NULL)
+    {
+        return false;
+    }
+
+    pthread_mutex_lock(&prefetchMutex);
+    for (i = 0; i < PMT_PREFETCH_MAX_SERVICES; i++)
+    {
+        if (pmtCache[i].valid && pmtCache[i].pmtTable.pmtHeader.programNumber == programNumber &&
+            monotonicSeconds() - pmtCache[i].receivedTime <= PMT_PREFETCH_MAX_AGE)
+        {
+            *pmtTable = pmtCache[i].pmtTable;
+            found = true;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&prefetchMutex);
+
+    return found;
+}
+
+void pmtPrefetchRecordZap(uint8_t fromChannel, uint8_t toChannel)
+{
+    if (fromChannel >= PMT_PREFETCH_MAX_SERVICES || toChannel >= PMT_PREFETCH_MAX_SERVICES || fromChannel == toChannel)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&prefetchMutex);
+    if (zapHistory[fromChannel][toChannel] < UINT16_MAX)
+    {
+        zapHistory[fromChannel][toChannel]++;
+    }
+    pthread_mutex_unlock(&prefetchMutex);
+}
+
+uint8_t pmtPrefetchRank(uint8_t currentChannel, uint8_t channelCount, uint8_t neighbourCount, uint8_t* candidates)
+{
+    uint32_t scores[PMT_PREFETCH_MAX_SERVICES];
+    uint8_t channels[PMT_PREFETCH_MAX_SERVICES];
+    uint8_t count = 0;
+    uint8_t channel = 0;
+    uint8_t i = 0;
+    uint8_t j = 0;
+
+    if (candidates == NULL || currentChannel >= channelCount || channelCount > PMT_PREFETCH_MAX_SERVICES)
+    {
+        return 0;
+    }
+
+    pthread_mutex_lock(&prefetchMutex);
+    for (channel = 0; channel < channelCount; channel++)
+    {
+        if (channel == currentChannel)
+        {
+            continue;
+        }
+
+        channels[count] = channel;
+        scores[count] = zapHistory[currentChannel][channel];
+        if (channel == (currentChannel + 1) % channelCount || (channel + 1) % channelCount == currentChannel)
+        {
+            scores[count] += PMT_PREFETCH_ADJACENT_WEIGHT;
+        }
+        count++;
+    }
+    pthread_mutex_unlock(&prefetchMutex);
+
+    if (neighbourCount > count)
+    {
+        neighbourCount = count;
+    }
+
+    /* partial selection sort, ties keep channel order after current channel (P+ first) */
+    for (i = 0; i < neighbourCount; i++)
+    {
+        uint8_t best = i;
+
+        for (j = i + 1; j < count; j++)
+        {
+            uint8_t distanceJ = (channels[j] + channelCount - currentChannel) % channelCount;
+            uint8_t distanceBest = (channels[best] + channelCount - currentChannel) % channelCount;
+
+            if (scores[j] > scores[best] || (scores[j] == scores[best] && distanceJ < distanceBest))
+            {
+                best = j;
+            }
+        }
+
+        candidates[i] = channels[best];
+        channels[best] = channels[i];
+        scores[best] = scores[i];
+        channels[i] = candidates[i];
+    }
+
+    return neighbourCount;
+}
+
+void pmtPrefetchRecordZapTime(bool hit, double seconds)
+{
+    pthread_mutex_lock(&prefetchMutex);
+    if (hit)
+    {
+        prefetchStats.hitCount++;
+        prefetchStats.hitZapSeconds += seconds;
+    }
+    else
+    {
+        prefetchStats.missCount++;
+        prefetchStats.missZapSeconds += seconds;
+    }
+    pthread_mutex_unlock(&prefetchMutex);
+}
+
+void pmtPrefetchGetStats(PmtPrefetchStats* stats)
+{
+    if (stats == NULL)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&prefetchMutex);
+    *stats = prefetchStats;
+    pthread_mutex_unlock(&prefetchMutex);
+}
+
+void pmtPrefetchPrintStats()
+{
+    PmtPrefetchStats stats;
+    uint32_t zapCount = 0;
+    double hitAverage = 0;
+    double missAverage = 0;
+
+    pmtPrefetchGetStats(&stats);
+    zapCount = stats.hitCount + stats.missCount;
+    if (zapCount == 0)
+    {
+        return;
+    }
+
+    hitAverage = stats.hitCount ? stats.hitZapSeconds / stats.hitCount : 0;
+    missAverage = stats.missCount ? stats.missZapSeconds / stats.missCount : 0;
+
+    printf("\n********************PMT PREFETCH********************\n");
+    printf("zaps: %u, hits: %u, hit rate: %.1f %%\n", zapCount, stats.hitCount, 100.0 * stats.hitCount / zapCount);
+    printf("average zap time: hit %.3f s, miss %.3f s\n", hitAverage, missAverage);
+    if (stats.hitCount && stats.missCount)
+    {
+        printf("zap time saved: %.3f s per hit, %.3f s total\n", missAverage - hitAverage,
+               (missAverage - hitAverage) * stats.hitCount);
+    }
+    printf("\n********************PMT PREFETCH********************\n");
+}
+
+static time_t monotonicSeconds()
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec;
+}
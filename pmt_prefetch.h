@@ -0,0 +1,99 @@
+#ifndef __PMT_PREFETCH_H__
+#define __PMT_PREFETCH_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include "pthread.h"
+#include "tables.h"
+
+#define PMT_PREFETCH_MAX_SERVICES TABLES_MAX_NUMBER_OF_PIDS_IN_PAT   /* Max number of cached PMTs and channels in zap history */
+#define PMT_PREFETCH_MAX_NEIGHBOURS 4               /* Max number of services prefetched at once */
+#define PMT_PREFETCH_MAX_AGE 30                     /* Cached PMT older than this (in s) is not used */
+#define PMT_PREFETCH_ADJACENT_WEIGHT 2              /* Prior of adjacent channel, in zaps */
+
+/**
+ * @brief Structure that holds prefetch statistics
+ */
+typedef struct _PmtPrefetchStats
+{
+    uint32_t hitCount;                              /* Zaps that found PMT in cache */
+    uint32_t missCount;                             /* Zaps that waited for PMT */
+    double hitZapSeconds;                           /* Sum of zap times of hits */
+    double missZapSeconds;                          /* Sum of zap times of misses */
+}PmtPrefetchStats;
+
+/**
+ * @brief Drops all cached PMTs, called when PAT changes
+ */
+void pmtPrefetchReset();
+
+/**
+ * @brief Stores received PMT in cache
+ *
+ * @param [in] pmtTable - parsed PMT
+ */
+void pmtPrefetchStore(const PmtTable* pmtTable);
+
+/**
+ * @brief Keeps cached PMT fresh when a repetition of the same version arrives, so it need not be parsed again
+ *
+ * @param [in] programNumber - program number of service
+ * @param [in] versionNumber - version_number of received PMT section
+ * @return true if cache holds this version, false if PMT must be parsed and stored
+ */
+bool pmtPrefetchRefresh(uint16_t programNumber, uint8_t versionNumber);
+
+/**
+ * @brief Looks up cached PMT of a service
+ *
+ * @param [in]  programNumber - program number of service
+ * @param [out] pmtTable - cached PMT
+ * @return true if fresh PMT was found
+ */
+bool pmtPrefetchLookup(uint16_t programNumber, PmtTable* pmtTable);
+
+/**
+ * @brief Adds zap to history
+ *
+ * @param [in] fromChannel - channel zapped from
+ * @param [in] toChannel - channel zapped to
+ */
+void pmtPrefetchRecordZap(uint8_t fromChannel, uint8_t toChannel);
+
+/**
+ * @brief Ranks channels most likely to be zapped to next from the current channel
+ *
+ * Adjacent channels get a prior, the rest of the score is number of zaps from current channel in history.
+ *
+ * @param [in]  currentChannel - current channel
+ * @param [in]  channelCount - number of channels
+ * @param [in]  neighbourCount - number of channels to return
+ * @param [out] candidates - ranked channels, most likely first
+ * @return number of returned channels
+ */
+uint8_t pmtPrefetchRank(uint8_t currentChannel, uint8_t channelCount, uint8_t neighbourCount, uint8_t* candidates);
+
+/**
+ * @brief Adds zap time to statistics
+ *
+ * @param [in] hit - true if PMT was taken from cache
+ * @param [in] seconds - time from zap request to stream creation
+ */
+void pmtPrefetchRecordZapTime(bool hit, double seconds);
+
+/**
+ * @brief Returns prefetch statistics
+ *
+ * @param [out] stats - statistics
+ */
+void pmtPrefetchGetStats(PmtPrefetchStats* stats);
+
+/**
+ * @brief Prints hit rate and zap time saved by prefetching
+ */
+void pmtPrefetchPrintStats();
+
+#endif /* __PMT_PREFETCH_H__ */
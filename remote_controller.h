@@ -28,6 +28,18 @@
 #define KEYCODE_9 10
 #define KEYCODE_0 11
 #define KEYCODE_MUTE 60
+#define KEYCODE_PLAY 207
+#define KEYCODE_PAUSE 119
+#define KEYCODE_STOP 128
+#define KEYCODE_REWIND 168
+#define KEYCODE_FAST_FORWARD 208
+#define KEYCODE_RECORD 167
+#define KEYCODE_UP 103
+#define KEYCODE_DOWN 108
+#define KEYCODE_OK 352
+#define KEYCODE_LEFT 105
+#define KEYCODE_RIGHT 106
+#define KEYCODE_EPG 365
 /* input event values for 'EV_KEY' type */
 #define EV_VALUE_RELEASE    0
 #define EV_VALUE_KEYPRESS   1
@@ -0,0 +1,101 @@
+#include "section_queue.h"
+
+#define QUEUE_MASK (SECTION_QUEUE_SIZE - 1)
+
+void sectionQueueInit(SectionQueue* queue)
+{
+    uint32_t i = 0;
+
+    memset(queue, 0x0, sizeof(SectionQueue));
+
+    /* cell i is free for the producer that reserves position i */
+    for (i = 0; i < SECTION_QUEUE_SIZE; i++)
+    {
+        queue->cells[i].sequence = i;
+    }
+}
+
+bool sectionQueuePush(SectionQueue* queue, const uint8_t* section)
+{
+    SectionCell* cell = NULL;
+    uint32_t position = 0;
+    uint32_t sequence = 0;
+    int32_t difference = 0;
+    uint16_t sectionSize = 3 + ((((*(section + 1)) << 8) + (*(section + 2))) & 0x0FFF);
+
+    if (sectionSize > SECTION_QUEUE_MAX_SECTION_SIZE)
+    {
+        __atomic_fetch_add(&queue->stats.oversizeCount, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+
+    position = __atomic_load_n(&queue->enqueuePosition, __ATOMIC_RELAXED);
+    for (;;)
+    {
+        cell = &queue->cells[position & QUEUE_MASK];
+        sequence = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+        difference = (int32_t) (sequence - position);
+
+        if (difference == 0)
+        {
+            /* cell is free, reserve it unless another producer was faster */
+            if (__atomic_compare_exchange_n(&queue->enqueuePosition, &position, position + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            {
+                break;
+            }
+        }
+        else if (difference < 0)
+        {
+            /* consumer still holds the cell from previous round */
+            __atomic_fetch_add(&queue->stats.overflowCount, 1, __ATOMIC_RELAXED);
+            return false;
+        }
+        else
+        {
+            position = __atomic_load_n(&queue->enqueuePosition, __ATOMIC_RELAXED);
+        }
+    }
+
+    memcpy(cell->data, section, sectionSize);
+    cell->size = sectionSize;
+    __atomic_store_n(&cell->sequence, position + 1, __ATOMIC_RELEASE);
+    __atomic_fetch_add(&queue->stats.pushedCount, 1, __ATOMIC_RELAXED);
+
+    return true;
+}
+
+uint8_t* sectionQueueFront(SectionQueue* queue)
+{
+    SectionCell* cell = &queue->cells[queue->dequeuePosition & QUEUE_MASK];
+    uint32_t used = 0;
+
+    if (__atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE) != queue->dequeuePosition + 1)
+    {
+        return NULL;
+    }
+
+    used = __atomic_load_n(&queue->enqueuePosition, __ATOMIC_RELAXED) - queue->dequeuePosition;
+    if (used > queue->stats.highWater)
+    {
+        queue->stats.highWater = used;
+    }
+
+    return cell->data;
+}
+
+void sectionQueuePop(SectionQueue* queue)
+{
+    SectionCell* cell = &queue->cells[queue->dequeuePosition & QUEUE_MASK];
+
+    /* cell is free again for the producer one round later */
+    __atomic_store_n(&cell->sequence, queue->dequeuePosition + SECTION_QUEUE_SIZE, __ATOMIC_RELEASE);
+    queue->dequeuePosition++;
+}
+
+void sectionQueueGetStats(SectionQueue* queue, SectionQueueStats* stats)
+{
+    stats->pushedCount = __atomic_load_n(&queue->stats.pushedCount, __ATOMIC_RELAXED);
+    stats->overflowCount = __atomic_load_n(&queue->stats.overflowCount, __ATOMIC_RELAXED);
+    stats->oversizeCount = __atomic_load_n(&queue->stats.oversizeCount, __ATOMIC_RELAXED);
+    stats->highWater = queue->stats.highWater;
+}
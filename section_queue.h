@@ -0,0 +1,85 @@
+#ifndef __SECTION_QUEUE_H__
+#define __SECTION_QUEUE_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define SECTION_QUEUE_SIZE 64                       /* Number of preallocated sections, power of two */
+#define SECTION_QUEUE_MAX_SECTION_SIZE 4096         /* Max size of PSI section, EIT sections are up to 4096 bytes */
+
+/**
+ * @brief Structure that holds one preallocated section of the pool
+ */
+typedef struct _SectionCell
+{
+    uint32_t sequence;                              /* Position the cell is free or ready for */
+    uint16_t size;
+    uint8_t data[SECTION_QUEUE_MAX_SECTION_SIZE];
+}SectionCell;
+
+/**
+ * @brief Structure that holds section queue statistics
+ */
+typedef struct _SectionQueueStats
+{
+    uint32_t pushedCount;
+    uint32_t overflowCount;                         /* Sections dropped because every cell was in use */
+    uint32_t oversizeCount;                         /* Sections dropped because they do not fit in a cell */
+    uint32_t highWater;                             /* Most cells in use at once */
+}SectionQueueStats;
+
+/**
+ * @brief Structure that holds bounded lock free queue of sections, any number of producers and one consumer
+ *
+ * Cells are preallocated, a section is copied once on push and processed in place by the consumer.
+ */
+typedef struct _SectionQueue
+{
+    SectionCell cells[SECTION_QUEUE_SIZE];
+    uint32_t enqueuePosition;
+    uint32_t dequeuePosition;
+    SectionQueueStats stats;
+}SectionQueue;
+
+/**
+ * @brief Initializes section queue
+ *
+ * @param [out] queue - section queue
+ */
+void sectionQueueInit(SectionQueue* queue);
+
+/**
+ * @brief Copies section into a free cell, never blocks
+ *
+ * @param [in] queue - section queue
+ * @param [in] section - section, its size is taken from section_length
+ * @return true if section was queued, false if it was dropped
+ */
+bool sectionQueuePush(SectionQueue* queue, const uint8_t* section);
+
+/**
+ * @brief Returns oldest queued section without removing it, called by the consumer only
+ *
+ * @param [in] queue - section queue
+ * @return section, NULL if queue is empty
+ */
+uint8_t* sectionQueueFront(SectionQueue* queue);
+
+/**
+ * @brief Gives cell of oldest section back to the pool, called by the consumer only
+ *
+ * @param [in] queue - section queue
+ */
+void sectionQueuePop(SectionQueue* queue);
+
+/**
+ * @brief Returns section queue statistics
+ *
+ * @param [in]  queue - section queue
+ * @param [out] stats - statistics
+ */
+void sectionQueueGetStats(SectionQueue* queue, SectionQueueStats* stats);
+
+#endif /* __SECTION_QUEUE_H__ */
@@ -0,0 +1,92 @@
+#include "service_index.h"
+
+static bool isListed(const ChannelService* service, uint16_t multiplexCount);
+
+ServiceIndexError serviceIndexOpen(ServiceIndex* index, const char* path)
+{
+    const ChannelService* service = NULL;
+    uint16_t i = 0;
+
+    index->count = 0;
+    if (channelDatabaseMap(&index->view, path))
+    {
+        printf("\n%s : ERROR cannot map channel database %s!\n", __FUNCTION__, path);
+        return SERVICE_INDEX_ERROR;
+    }
+
+    /* database keeps services sorted by logical channel number, list keeps that order */
+    for (i = 0; i < index->view.serviceCount; i++)
+    {
+        service = &index->view.services[i];
+        if (!isListed(service, index->view.multiplexCount))
+        {
+            continue;
+        }
+
+        index->entries[index->count].number = (service->logicalChannelNumber != CHANNEL_DATABASE_NO_LCN) ?
+                                              service->logicalChannelNumber : service->patIndex;
+        index->entries[index->count].position = i;
+        index->count++;
+    }
+
+    return SERVICE_INDEX_NO_ERROR;
+}
+
+void serviceIndexClose(ServiceIndex* index)
+{
+    channelDatabaseUnmap(&index->view);
+    index->count = 0;
+}
+
+const ChannelService* serviceIndexService(const ServiceIndex* index, uint16_t row)
+{
+    return &index->view.services[index->entries[row].position];
+}
+
+uint32_t serviceIndexFrequency(const ServiceIndex* index, uint16_t row)
+{
+    return index->view.multiplexes[serviceIndexService(index, row)->multiplexIndex].frequency;
+}
+
+int32_t serviceIndexFind(const ServiceIndex* index, uint16_t transportStreamId, uint16_t serviceId)
+{
+    const ChannelService* service = NULL;
+    uint16_t i = 0;
+
+    for (i = 0; i < index->count; i++)
+    {
+        service = serviceIndexService(index, i);
+        if (service->serviceId == serviceId &&
+            index->view.multiplexes[service->multiplexIndex].transportStreamId == transportStreamId)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+bool isListed(const ChannelService* service, uint16_t multiplexCount)
+{
+    /* names are drawn straight from the mapping, so they must be terminated within the record */
+    if (service->multiplexIndex >= multiplexCount || memchr(service->name, '\0', TABLES_MAX_NAME_LENGTH) == NULL)
+    {
+        return false;
+    }
+
+    /* services stored from live PAT have no type yet, SDT types other than TV and radio are data */
+    switch (service->serviceType)
+    {
+        case 0x00:
+        case 0x01:                                  /* digital television */
+        case 0x02:                                  /* digital radio */
+        case 0x0A:                                  /* advanced codec radio */
+        case 0x11:                                  /* MPEG-2 HD television */
+        case 0x16:                                  /* advanced codec SD television */
+        case 0x19:                                  /* advanced codec HD television */
+        case 0x1F:                                  /* HEVC television */
+            return true;
+        default:
+            return false;
+    }
+}
@@ -0,0 +1,84 @@
+#ifndef __SERVICE_INDEX_H__
+#define __SERVICE_INDEX_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "channel_database.h"
+
+/**
+ * @brief Structure that defines service index error
+ */
+typedef enum _ServiceIndexError
+{
+    SERVICE_INDEX_NO_ERROR = 0,
+    SERVICE_INDEX_ERROR
+}ServiceIndexError;
+
+/**
+ * @brief Structure that holds one listed service, 4 bytes
+ */
+typedef struct _ServiceIndexEntry
+{
+    uint16_t number;                                /* Logical channel number, position in PAT if not signalled */
+    uint16_t position;                              /* Position of service record in mapped database */
+}ServiceIndexEntry;
+
+/**
+ * @brief Structure that holds TV and radio services of mapped channel database in list order
+ *
+ * Service records, names included, are read from the mapping in place, the index only holds their positions.
+ */
+typedef struct _ServiceIndex
+{
+    ChannelDatabaseView view;
+    ServiceIndexEntry entries[CHANNEL_DATABASE_MAX_SERVICES];
+    uint16_t count;
+}ServiceIndex;
+
+/**
+ * @brief Maps channel database and lists its TV and radio services
+ *
+ * @param [out] index - service index, empty on error
+ * @param [in]  path - path of channel database file
+ * @return service index error code
+ */
+ServiceIndexError serviceIndexOpen(ServiceIndex* index, const char* path);
+
+/**
+ * @brief Unmaps channel database, index is empty afterwards
+ *
+ * @param [in] index - service index
+ */
+void serviceIndexClose(ServiceIndex* index);
+
+/**
+ * @brief Returns service record of a listed service, valid until index is closed
+ *
+ * @param [in] index - service index
+ * @param [in] row - position in list, less than count
+ * @return service record in mapped database
+ */
+const ChannelService* serviceIndexService(const ServiceIndex* index, uint16_t row);
+
+/**
+ * @brief Returns frequency of multiplex carrying a listed service
+ *
+ * @param [in] index - service index
+ * @param [in] row - position in list, less than count
+ * @return frequency in Hz
+ */
+uint32_t serviceIndexFrequency(const ServiceIndex* index, uint16_t row);
+
+/**
+ * @brief Finds listed service by its DVB identifiers
+ *
+ * @param [in] index - service index
+ * @param [in] transportStreamId - transport_stream_id of multiplex carrying the service
+ * @param [in] serviceId - service_id
+ * @return position in list, -1 if service is not listed
+ */
+int32_t serviceIndexFind(const ServiceIndex* index, uint16_t transportStreamId, uint16_t serviceId);
+
+#endif /* __SERVICE_INDEX_H__ */
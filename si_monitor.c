@@ -0,0 +1,169 @@
+#include "si_monitor.h"
+
+#define PAT_TABLE_ID 0x00
+#define PMT_TABLE_ID 0x02
+
+static uint64_t threadCpuNanoseconds();
+static uint32_t millisecondsSince(const struct timespec* start);
+
+void siMonitorInit(SiMonitor* monitor)
+{
+    memset(monitor, 0x0, sizeof(SiMonitor));
+    pthread_mutex_init(&monitor->mutex, NULL);
+    monitor->patVersion = SI_MONITOR_UNKNOWN_VERSION;
+    monitor->programNumber = SI_MONITOR_NO_PROGRAM;
+    monitor->pmtVersion = SI_MONITOR_UNKNOWN_VERSION;
+}
+
+void siMonitorDeinit(SiMonitor* monitor)
+{
+    pthread_mutex_destroy(&monitor->mutex);
+}
+
+void siMonitorWatchPat(SiMonitor* monitor, int16_t version)
+{
+    pthread_mutex_lock(&monitor->mutex);
+    monitor->patVersion = version;
+    monitor->patPending = false;
+    pthread_mutex_unlock(&monitor->mutex);
+}
+
+void siMonitorWatchPmt(SiMonitor* monitor, int32_t programNumber, int16_t version)
+{
+    pthread_mutex_lock(&monitor->mutex);
+    monitor->programNumber = programNumber;
+    monitor->pmtVersion = version;
+    monitor->pmtPending = false;
+    pthread_mutex_unlock(&monitor->mutex);
+}
+
+bool siMonitorSectionReceived(SiMonitor* monitor, const uint8_t* section)
+{
+    uint64_t checkStart = 0;
+    uint16_t sectionSize = 0;
+    uint16_t tableIdExtension = 0;
+    int16_t version = 0;
+    bool pending = false;
+
+    /* only current long sections of PAT and PMT are watched */
+    if ((section[0] != PAT_TABLE_ID && section[0] != PMT_TABLE_ID) || !(section[1] & 0x80) || !(section[5] & 0x01))
+    {
+        return false;
+    }
+
+    checkStart = threadCpuNanoseconds();
+    sectionSize = 3 + ((((*(section + 1)) << 8) + (*(section + 2))) & 0x0FFF);
+    tableIdExtension = (uint16_t) ((section[3] << 8) + section[4]);
+    version = (section[5] >> 1) & 0x1F;
+
+    pthread_mutex_lock(&monitor->mutex);
+    monitor->stats.sectionCount++;
+
+    if (sectionSize <= SI_MONITOR_MAX_SECTION_SIZE)
+    {
+        if (section[0] == PAT_TABLE_ID && monitor->patVersion != SI_MONITOR_UNKNOWN_VERSION && version != monitor->patVersion)
+        {
+            /* newer version replaces a pending one, detection time of the first is kept */
+            memcpy(monitor->patSection, section, sectionSize);
+            if (!monitor->patPending)
+            {
+                clock_gettime(CLOCK_MONOTONIC, &monitor->patDetected);
+            }
+            monitor->patVersion = version;
+            monitor->patPending = true;
+            monitor->stats.patChangeCount++;
+        }
+        else if (section[0] == PMT_TABLE_ID && monitor->programNumber == tableIdExtension && version != monitor->pmtVersion)
+        {
+            memcpy(monitor->pmtSection, section, sectionSize);
+            if (!monitor->pmtPending)
+            {
+                clock_gettime(CLOCK_MONOTONIC, &monitor->pmtDetected);
+            }
+            monitor->pmtVersion = version;
+            monitor->pmtPending = true;
+            monitor->stats.pmtChangeCount++;
+        }
+    }
+
+    pending = monitor->patPending || monitor->pmtPending;
+    monitor->stats.checkNanoseconds += threadCpuNanoseconds() - checkStart;
+    pthread_mutex_unlock(&monitor->mutex);
+
+    return pending;
+}
+
+bool siMonitorPending(SiMonitor* monitor)
+{
+    bool pending = false;
+
+    pthread_mutex_lock(&monitor->mutex);
+    pending = monitor->patPending || monitor->pmtPending;
+    pthread_mutex_unlock(&monitor->mutex);
+
+    return pending;
+}
+
+SiMonitorChange siMonitorTakeChange(SiMonitor* monitor, uint8_t* section, struct timespec* detected)
+{
+    SiMonitorChange change = SI_MONITOR_NO_CHANGE;
+
+    pthread_mutex_lock(&monitor->mutex);
+    /* PAT first, it may move or remove the service whose PMT is pending */
+    if (monitor->patPending)
+    {
+        memcpy(section, monitor->patSection, SI_MONITOR_MAX_SECTION_SIZE);
+        *detected = monitor->patDetected;
+        monitor->patPending = false;
+        change = SI_MONITOR_PAT_CHANGED;
+    }
+    else if (monitor->pmtPending)
+    {
+        memcpy(section, monitor->pmtSection, SI_MONITOR_MAX_SECTION_SIZE);
+        *detected = monitor->pmtDetected;
+        monitor->pmtPending = false;
+        change = SI_MONITOR_PMT_CHANGED;
+    }
+    pthread_mutex_unlock(&monitor->mutex);
+
+    return change;
+}
+
+void siMonitorChangeApplied(SiMonitor* monitor, const struct timespec* detected, uint64_t applyNanoseconds)
+{
+    uint32_t reaction = millisecondsSince(detected);
+
+    pthread_mutex_lock(&monitor->mutex);
+    monitor->stats.applyNanoseconds += applyNanoseconds;
+    monitor->stats.lastReactionMilliseconds = reaction;
+    if (reaction > monitor->stats.maxReactionMilliseconds)
+    {
+        monitor->stats.maxReactionMilliseconds = reaction;
+    }
+    pthread_mutex_unlock(&monitor->mutex);
+}
+
+void siMonitorGetStats(SiMonitor* monitor, SiMonitorStats* stats)
+{
+    pthread_mutex_lock(&monitor->mutex);
+    *stats = monitor->stats;
+    pthread_mutex_unlock(&monitor->mutex);
+}
+
+static uint64_t threadCpuNanoseconds()
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+static uint32_t millisecondsSince(const struct timespec* start)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (now.tv_sec - start->tv_sec) * 1000 + (now.tv_nsec - start->tv_nsec) / 1000000;
+}
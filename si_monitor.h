@@ -0,0 +1,133 @@
+#ifndef __SI_MONITOR_H__
+#define __SI_MONITOR_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include "pthread.h"
+
+#define SI_MONITOR_MAX_SECTION_SIZE 1024            /* Max size of PSI section */
+#define SI_MONITOR_NO_PROGRAM -1                    /* No PMT is watched */
+#define SI_MONITOR_UNKNOWN_VERSION -1               /* First section received is reported as change */
+
+/**
+ * @brief Enumeration of changes found by SI monitor
+ */
+typedef enum _SiMonitorChange
+{
+    SI_MONITOR_NO_CHANGE = 0,
+    SI_MONITOR_PAT_CHANGED,
+    SI_MONITOR_PMT_CHANGED
+}SiMonitorChange;
+
+/**
+ * @brief Structure that holds SI monitor statistics
+ */
+typedef struct _SiMonitorStats
+{
+    uint32_t sectionCount;                          /* Sections whose version was checked */
+    uint32_t patChangeCount;
+    uint32_t pmtChangeCount;
+    uint64_t checkNanoseconds;                      /* CPU time of version checks on callback thread */
+    uint64_t applyNanoseconds;                      /* CPU time of parsing and applying changes */
+    uint32_t lastReactionMilliseconds;              /* From changed section to applied change */
+    uint32_t maxReactionMilliseconds;
+}SiMonitorStats;
+
+/**
+ * @brief Structure that holds state of SI monitor of one service
+ */
+typedef struct _SiMonitor
+{
+    pthread_mutex_t mutex;
+    int16_t patVersion;                             /* Version applied or pending, SI_MONITOR_UNKNOWN_VERSION before PAT is known */
+    int32_t programNumber;                          /* Service whose PMT is watched */
+    int16_t pmtVersion;
+    bool patPending;
+    bool pmtPending;
+    uint8_t patSection[SI_MONITOR_MAX_SECTION_SIZE];
+    uint8_t pmtSection[SI_MONITOR_MAX_SECTION_SIZE];
+    struct timespec patDetected;
+    struct timespec pmtDetected;
+    SiMonitorStats stats;
+}SiMonitor;
+
+/**
+ * @brief Initializes SI monitor, nothing is watched until versions are set
+ *
+ * @param [out] monitor - SI monitor
+ */
+void siMonitorInit(SiMonitor* monitor);
+
+/**
+ * @brief Deinitializes SI monitor
+ *
+ * @param [in] monitor - SI monitor
+ */
+void siMonitorDeinit(SiMonitor* monitor);
+
+/**
+ * @brief Sets PAT version currently applied
+ *
+ * @param [in] monitor - SI monitor
+ * @param [in] version - version_number of applied PAT
+ */
+void siMonitorWatchPat(SiMonitor* monitor, int16_t version);
+
+/**
+ * @brief Sets service whose PMT is watched and drops pending PMT change of previous service
+ *
+ * @param [in] monitor - SI monitor
+ * @param [in] programNumber - program_number of service, SI_MONITOR_NO_PROGRAM to stop watching
+ * @param [in] version - version_number of applied PMT, or SI_MONITOR_UNKNOWN_VERSION
+ */
+void siMonitorWatchPmt(SiMonitor* monitor, int32_t programNumber, int16_t version);
+
+/**
+ * @brief Checks version of received section and stores its copy when it changed, called from section filter callback
+ *
+ * Only the section header is read, sections with unchanged version are not parsed.
+ *
+ * @param [in] monitor - SI monitor
+ * @param [in] section - received section
+ * @return true if a change is waiting to be applied
+ */
+bool siMonitorSectionReceived(SiMonitor* monitor, const uint8_t* section);
+
+/**
+ * @brief Returns true if a change is waiting to be applied
+ *
+ * @param [in] monitor - SI monitor
+ */
+bool siMonitorPending(SiMonitor* monitor);
+
+/**
+ * @brief Takes oldest kind of pending change, PAT before PMT
+ *
+ * @param [in]  monitor - SI monitor
+ * @param [out] section - copy of changed section, SI_MONITOR_MAX_SECTION_SIZE bytes
+ * @param [out] detected - time change was received
+ * @return kind of change, SI_MONITOR_NO_CHANGE if nothing is pending
+ */
+SiMonitorChange siMonitorTakeChange(SiMonitor* monitor, uint8_t* section, struct timespec* detected);
+
+/**
+ * @brief Adds applied change to statistics
+ *
+ * @param [in] monitor - SI monitor
+ * @param [in] detected - time change was received
+ * @param [in] applyNanoseconds - CPU time spent applying change
+ */
+void siMonitorChangeApplied(SiMonitor* monitor, const struct timespec* detected, uint64_t applyNanoseconds);
+
+/**
+ * @brief Returns SI monitor statistics
+ *
+ * @param [in]  monitor - SI monitor
+ * @param [out] stats - statistics
+ */
+void siMonitorGetStats(SiMonitor* monitor, SiMonitorStats* stats);
+
+#endif /* __SI_MONITOR_H__ */
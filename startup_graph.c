@@ -0,0 +1,228 @@
+#include "startup_graph.h"
+
+/**
+ * @brief Structure that holds one boot trace event
+ */
+typedef struct _StartupTraceEvent
+{
+    const char* name;
+    uint64_t startNanoseconds;                      /* Since startupTraceInit */
+    uint64_t endNanoseconds;
+}StartupTraceEvent;
+
+static void* startupWorker(void* arg);
+static int32_t takeReadyStep(StartupGraph* graph);
+static uint64_t monotonicNanoseconds();
+
+static StartupTraceEvent traceEvents[STARTUP_TRACE_MAX_EVENTS];
+static uint8_t traceEventCount = 0;
+static uint64_t traceOrigin = 0;
+static pthread_mutex_t traceMutex = PTHREAD_MUTEX_INITIALIZER;
+
+void startupTraceInit()
+{
+    pthread_mutex_lock(&traceMutex);
+    traceOrigin = monotonicNanoseconds();
+    traceEventCount = 0;
+    pthread_mutex_unlock(&traceMutex);
+}
+
+int32_t startupTraceBegin(const char* name)
+{
+    int32_t event = -1;
+
+    pthread_mutex_lock(&traceMutex);
+    if (traceEventCount < STARTUP_TRACE_MAX_EVENTS)
+    {
+        event = traceEventCount++;
+        traceEvents[event].name = name;
+        traceEvents[event].startNanoseconds = monotonicNanoseconds() - traceOrigin;
+        traceEvents[event].endNanoseconds = 0;
+    }
+    pthread_mutex_unlock(&traceMutex);
+
+    return event;
+}
+
+void startupTraceEnd(int32_t event, bool success)
+{
+    StartupTraceEvent ended;
+
+    if (event < 0)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&traceMutex);
+    traceEvents[event].endNanoseconds = monotonicNanoseconds() - traceOrigin;
+    ended = traceEvents[event];
+    pthread_mutex_unlock(&traceMutex);
+
+    /* printed as events end, steps on other threads show up in between */
+    printf("%s : INFO boot %-20s %8.1f ms - %8.1f ms (%.1f ms)%s\n", __FUNCTION__, ended.name,
+           ended.startNanoseconds / 1e6, ended.endNanoseconds / 1e6,
+           (ended.endNanoseconds - ended.startNanoseconds) / 1e6, success ? "" : " FAILED");
+}
+
+void startupTraceMark(const char* name)
+{
+    startupTraceEnd(startupTraceBegin(name), true);
+}
+
+void startupGraphInit(StartupGraph* graph)
+{
+    memset(graph, 0x0, sizeof(StartupGraph));
+    pthread_mutex_init(&graph->mutex, NULL);
+    pthread_cond_init(&graph->cond, NULL);
+}
+
+int8_t startupGraphAddStep(StartupGraph* graph, const char* name, StartupStepFunction function, void* data, uint32_t dependencies)
+{
+    StartupStep* step = NULL;
+
+    /* only steps added before may be waited for */
+    if (graph->stepCount >= STARTUP_GRAPH_MAX_STEPS || function == NULL ||
+        (dependencies & ~(STARTUP_STEP(graph->stepCount) - 1)) != 0)
+    {
+        printf("\n%s : ERROR cannot add step %s\n", __FUNCTION__, name);
+        return -1;
+    }
+
+    step = &graph->steps[graph->stepCount];
+    step->name = name;
+    step->function = function;
+    step->data = data;
+    step->dependencies = dependencies;
+    step->state = STARTUP_STEP_WAITING;
+
+    return graph->stepCount++;
+}
+
+StartupGraphError startupGraphRun(StartupGraph* graph, uint8_t threadCount)
+{
+    pthread_t threads[STARTUP_GRAPH_MAX_THREADS];
+    StartupGraphError result = SG_NO_ERROR;
+    uint8_t started = 0;
+    uint8_t i = 0;
+
+    if (threadCount == 0 || threadCount > STARTUP_GRAPH_MAX_THREADS)
+    {
+        threadCount = STARTUP_GRAPH_MAX_THREADS;
+    }
+
+    for (started = 0; started < threadCount; started++)
+    {
+        if (pthread_create(&threads[started], NULL, &startupWorker, graph))
+        {
+            printf("\n%s : ERROR pthread_create fail!\n", __FUNCTION__);
+            break;
+        }
+    }
+
+    /* steps run on the threads that were started, with none every step is left undone */
+    if (started == 0)
+    {
+        pthread_mutex_destroy(&graph->mutex);
+        pthread_cond_destroy(&graph->cond);
+        return SG_THREAD_ERROR;
+    }
+
+    for (i = 0; i < started; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+
+    if (graph->failed || graph->endedCount < graph->stepCount)
+    {
+        result = SG_ERROR;
+    }
+
+    pthread_mutex_destroy(&graph->mutex);
+    pthread_cond_destroy(&graph->cond);
+
+    return result;
+}
+
+void* startupWorker(void* arg)
+{
+    StartupGraph* graph = (StartupGraph*)arg;
+    StartupStep* step = NULL;
+    int32_t index = 0;
+    int32_t event = 0;
+    int32_t result = 0;
+
+    pthread_mutex_lock(&graph->mutex);
+    while (true)
+    {
+        index = takeReadyStep(graph);
+        if (index < 0)
+        {
+            /* nothing will become ready once every step ended, or nothing is running after a failure */
+            if (graph->endedCount == graph->stepCount || (graph->failed && graph->runningCount == 0))
+            {
+                break;
+            }
+            pthread_cond_wait(&graph->cond, &graph->mutex);
+            continue;
+        }
+
+        step = &graph->steps[index];
+        step->state = STARTUP_STEP_RUNNING;
+        graph->runningCount++;
+        pthread_mutex_unlock(&graph->mutex);
+
+        event = startupTraceBegin(step->name);
+        result = step->function(step->data);
+        startupTraceEnd(event, result == 0);
+
+        pthread_mutex_lock(&graph->mutex);
+        graph->runningCount--;
+        graph->endedCount++;
+        if (result == 0)
+        {
+            step->state = STARTUP_STEP_DONE;
+            graph->doneSteps |= STARTUP_STEP(index);
+        }
+        else
+        {
+            step->state = STARTUP_STEP_FAILED;
+            graph->failed = true;
+        }
+        pthread_cond_broadcast(&graph->cond);
+    }
+    pthread_cond_broadcast(&graph->cond);
+    pthread_mutex_unlock(&graph->mutex);
+
+    return NULL;
+}
+
+int32_t takeReadyStep(StartupGraph* graph)
+{
+    uint8_t i = 0;
+
+    if (graph->failed)
+    {
+        return -1;
+    }
+
+    /* steps are taken in the order they were added, so steps on the critical path go first */
+    for (i = 0; i < graph->stepCount; i++)
+    {
+        if (graph->steps[i].state == STARTUP_STEP_WAITING &&
+            (graph->steps[i].dependencies & graph->doneSteps) == graph->steps[i].dependencies)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+uint64_t monotonicNanoseconds()
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
@@ -0,0 +1,129 @@
+#ifndef __STARTUP_GRAPH_H__
+#define __STARTUP_GRAPH_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include "pthread.h"
+
+#define STARTUP_GRAPH_MAX_STEPS 16
+#define STARTUP_GRAPH_MAX_THREADS 4                 /* Startup thread pool size limit */
+#define STARTUP_TRACE_MAX_EVENTS 32                 /* Events recorded after this many are not traced */
+#define STARTUP_STEP(index) (1U << (index))         /* Dependency mask of one step */
+
+/**
+ * @brief Structure that defines startup graph error
+ */
+typedef enum _StartupGraphError
+{
+    SG_NO_ERROR = 0,
+    SG_ERROR,
+    SG_THREAD_ERROR
+}StartupGraphError;
+
+/**
+ * @brief Startup step, returns 0 on success like module init functions do
+ */
+typedef int32_t(*StartupStepFunction)(void* data);
+
+/**
+ * @brief Structure that defines state of a startup step
+ */
+typedef enum _StartupStepState
+{
+    STARTUP_STEP_WAITING = 0,
+    STARTUP_STEP_RUNNING,
+    STARTUP_STEP_DONE,
+    STARTUP_STEP_FAILED
+}StartupStepState;
+
+/**
+ * @brief Structure that holds one startup step
+ */
+typedef struct _StartupStep
+{
+    const char* name;
+    StartupStepFunction function;
+    void* data;
+    uint32_t dependencies;                          /* STARTUP_STEP() of every step that must be done first */
+    StartupStepState state;
+}StartupStep;
+
+/**
+ * @brief Structure that holds startup steps and their dependencies, run by a pool of threads
+ *
+ * A step depends on steps added before it only, so the graph has no cycles.
+ */
+typedef struct _StartupGraph
+{
+    StartupStep steps[STARTUP_GRAPH_MAX_STEPS];
+    uint8_t stepCount;
+    uint32_t doneSteps;                             /* STARTUP_STEP() of every step done */
+    uint8_t endedCount;                             /* Steps done or failed */
+    uint8_t runningCount;
+    bool failed;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+}StartupGraph;
+
+/**
+ * @brief Sets time trace events are measured from, called first thing in main
+ */
+void startupTraceInit();
+
+/**
+ * @brief Records start of a boot trace event, from any thread
+ *
+ * @param [in] name - event name, must outlive the trace
+ * @return event, -1 if trace is full
+ */
+int32_t startupTraceBegin(const char* name);
+
+/**
+ * @brief Records end of a boot trace event and prints its start and end time
+ *
+ * @param [in] event - event returned by startupTraceBegin, -1 is ignored
+ * @param [in] success - false if step failed
+ */
+void startupTraceEnd(int32_t event, bool success);
+
+/**
+ * @brief Records a boot milestone, an event that starts and ends at once
+ *
+ * @param [in] name - milestone name, must outlive the trace
+ */
+void startupTraceMark(const char* name);
+
+/**
+ * @brief Initializes empty startup graph
+ *
+ * @param [out] graph - startup graph
+ */
+void startupGraphInit(StartupGraph* graph);
+
+/**
+ * @brief Adds step to startup graph
+ *
+ * @param [in] graph - startup graph
+ * @param [in] name - step name shown in boot trace
+ * @param [in] function - step
+ * @param [in] data - passed to step
+ * @param [in] dependencies - STARTUP_STEP() of every step that must be done first, 0 for none
+ * @return step index used in dependencies of later steps, -1 on error
+ */
+int8_t startupGraphAddStep(StartupGraph* graph, const char* name, StartupStepFunction function, void* data, uint32_t dependencies);
+
+/**
+ * @brief Runs every step as soon as its dependencies are done, on a pool of threads
+ *
+ * Returns when every step ended. After a step fails no further step is started.
+ *
+ * @param [in] graph - startup graph
+ * @param [in] threadCount - threads of the pool, at most STARTUP_GRAPH_MAX_THREADS
+ * @return startup graph error code, SG_ERROR if a step failed
+ */
+StartupGraphError startupGraphRun(StartupGraph* graph, uint8_t threadCount);
+
+#endif /* __STARTUP_GRAPH_H__ */
@@ -1,302 +1,1674 @@
 #include "stream_controller.h"
+#include <fcntl.h>
+#include <unistd.h>
 
-static PatTable *patTable;
-static PmtTable *pmtTable;
-static TdtTable *tdtTable;
-static TotTable *totTable;
+/**
+ * @brief Structure that holds channel change request waiting for stream controller task
+ */
+typedef struct _ChannelChangeRequest
+{
+    uint32_t requestId;
+    int32_t channelNumber;                          /* Used when step is 0 */
+    int8_t step;
+}ChannelChangeRequest;
+
+/**
+ * @brief Structure that maps PMT stream_type to player codec
+ */
+typedef struct _StreamTypeInfo
+{
+    uint8_t streamType;
+    bool isVideo;
+    tStreamType codec;
+}StreamTypeInfo;
+
+/* stream types the player can decode, HEVC (0x24) has no player codec and is skipped */
+static const StreamTypeInfo streamTypeTable[] =
+{
+    {0x01, true, VIDEO_TYPE_MPEG2},                 /* MPEG-1 video is decoded by MPEG-2 decoder */
+    {0x02, true, VIDEO_TYPE_MPEG2},
+    {0x10, true, VIDEO_TYPE_MPEG4},
+    {0x1b, true, VIDEO_TYPE_H264},
+    {0x03, false, AUDIO_TYPE_MPEG_AUDIO},
+    {0x04, false, AUDIO_TYPE_MPEG_AUDIO},
+    {0x0f, false, AUDIO_TYPE_HE_AAC},               /* AAC in ADTS */
+    {0x11, false, AUDIO_TYPE_HE_AAC},               /* AAC in LATM */
+    {0x81, false, AUDIO_TYPE_DOLBY_AC3}             /* AC-3 as signalled by ATSC */
+};
+
+/**
+ * @brief Structure that holds elementary streams selected for playback
+ */
+typedef struct _ServiceStreams
+{
+    int16_t videoPid;
+    tStreamType videoCodec;
+    uint8_t videoStreamType;                        /* PMT stream_type of video, used by recording index */
+    int16_t audioPid;
+    tStreamType audioCodec;
+}ServiceStreams;
+
+/**
+ * @brief Structure that holds execution time of section handling
+ */
+typedef struct _SectionTiming
+{
+    uint32_t count;
+    uint64_t totalNanoseconds;
+    uint64_t maxNanoseconds;
+}SectionTiming;
+
+/**
+ * @brief Structure that publishes channel info to reader threads
+ *
+ * Seqlock on its own cache line, readers copy info without writing shared memory.
+ */
+typedef struct _ChannelPublication
+{
+    uint32_t sequence;                              /* Odd while a writer copies info */
+    ChannelInfo info;
+}__attribute__((aligned(CACHE_LINE_SIZE))) ChannelPublication;
+
+/**
+ * @brief Structure that holds state of one stream controller instance
+ */
+struct _StreamController
+{
+    bool decoding;                                  /* Live instance, owns player streams, timeshift and volume */
+    InitialInfo configFile;
+    PatTable *patTable;
+    PmtTable *pmtTable;
+    TdtTable *tdtTable;
+    TotTable *totTable;
+
+    uint32_t playerHandle;
+    uint32_t sourceHandle;
+    uint32_t streamHandleA;
+    uint32_t streamHandleV;
+    int16_t pmtFilterRequest;                       /* PMT filter of current service, kept for SI monitor */
+    int16_t patFilterRequest;                       /* PAT filter, kept for SI monitor */
+    uint8_t threadExit;
+    int16_t programNumber;
+    ChannelInfo currentChannel;                     /* Written under publishMutex, readers use publishedChannel */
+    pthread_mutex_t publishMutex;                   /* Serializes writers, readers never take it */
+    ChannelPublication publishedChannel;
+    bool isInitialized;
+    bool timeTablesRecieved;
+    CurrentDate currentDate;
+    uint32_t currentVolume;
+    pthread_t scThread;
+    bool threadStarted;
+
+    DateCallback dateRecievedCallback;
+    ChannelChangeCallback channelChangeCallback;
+    VolumeCallback volumeReportCallback;
+    EpgCallback epgCallback;
+    PlaybackSource playbackSource;
+    int32_t playbackFileDesc;                       /* Playback file or FIFO while playing from timeshift buffer */
+    bool playbackWriteFailed;
+
+    uint16_t servicePids[5];
+    uint8_t servicePidCount;
+    ServiceStreams activeStreams;                   /* Streams currently created in player */
+
+    FILE* recordingFile;
+    TsIndexer recordingIndexer;
+    pthread_mutex_t recordingMutex;
+
+    ChannelDatabaseView channelDatabase;
+
+    TableAcquisition acquisition;
+    bool acquisitionReady;                          /* Sections are passed to acquisition, guarded by controllersMutex */
+    uint8_t acquiredSection[TABLE_ACQUISITION_MAX_SECTION_SIZE];
+    FilterScheduler filterScheduler;
+    uint8_t prefetchRequests[PMT_PREFETCH_MAX_NEIGHBOURS];
+    uint16_t prefetchPids[PMT_PREFETCH_MAX_NEIGHBOURS];
+    uint8_t prefetchRequestCount;
+    SiMonitor siMonitor;
+
+    ChannelChangeRequest channelChangeQueue[CHANNEL_CHANGE_QUEUE_SIZE];
+    uint8_t channelChangeCount;
+    uint32_t lastRequestId;
+    uint32_t activeRequestId;
+    pthread_mutex_t channelChangeMutex;
+    pthread_cond_t channelChangeCond;
+    ZapStats zapStats;
+};
+
+/* instance driven by the module level API, callbacks may be registered on it before it is started */
+static StreamController liveController;
+
+/* every running instance, tdp_api sections and captured packets are passed to all of them */
+static StreamController* controllers[STREAM_CONTROLLER_MAX_INSTANCES];
+static pthread_mutex_t controllersMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* tuner is shared by all instances */
+static pthread_mutex_t tunerMutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_cond_t statusCondition = PTHREAD_COND_INITIALIZER;
 static pthread_mutex_t statusMutex = PTHREAD_MUTEX_INITIALIZER;
+static uint8_t tunerUserCount = 0;
+static uint32_t tunerFrequency = 0;
+static bool tunerLocked = false;
+static uint32_t tunerLockLossCount = 0;
+
+/* driver callback only copies sections into the queue, section worker parses and dispatches them */
+static SectionQueue sectionQueue;
+static sem_t sectionSemaphore;
+static pthread_t sectionWorker;
+static bool sectionWorkerExit = false;
+static SectionTiming callbackTiming;
+static SectionTiming dispatchTiming;
+
+static struct timespec bootTime;
+static bool bootReported = false;
 
 static int32_t sectionReceivedCallback(uint8_t *buffer);
+static void* sectionWorkerTask(void* arg);
+static void dispatchSection(uint8_t* section);
+static void publishEvent(const EitTable* eitTable);
+static void addSectionTiming(SectionTiming* timing, uint64_t nanoseconds);
+static uint64_t monotonicNanoseconds();
+static void printSectionQueueStats();
 static int32_t tunerStatusCallback(t_LockStatus status);
 
-static uint32_t playerHandle = 0;
-static uint32_t sourceHandle = 0;
-static uint32_t streamHandleA = 0;
-static uint32_t streamHandleV = 0;
-static uint32_t filterHandle = 0;
-static uint8_t threadExit = 0;
-static bool changeChannel = false;
-static int16_t programNumber = 0;
-static ChannelInfo currentChannel;
-static bool isInitialized = false;
-static bool timeTablesRecieved = false;
-
-static DateCallback dateRecievedCallback = NULL;
-static VolumeCallback volumeReportCallback = NULL;
-
-static struct timespec lockStatusWaitTime;
-static struct timeval now;
-static pthread_t scThread;
-static pthread_cond_t demuxCond = PTHREAD_COND_INITIALIZER;
-static pthread_mutex_t demuxMutex = PTHREAD_MUTEX_INITIALIZER;
-
-static void* streamControllerTask();
+static StreamControllerError startController(StreamController* controller, const InitialInfo* initialInfo, bool decoding);
+static StreamControllerError stopController(StreamController* controller);
+static bool addController(StreamController* controller);
+static void removeController(StreamController* controller);
+static void setAcquisitionReady(StreamController* controller, bool ready);
+static StreamControllerError acquireTuner(const InitialInfo* initialInfo);
+static StreamControllerError waitForTunerLock();
+static void releaseTuner();
+static void freeTables(StreamController* controller);
+static void* streamControllerTask(void* arg);
 static void removeWhiteSpaces(char* string);
-static void startChannel(int32_t channelNumber);
+static void startChannel(StreamController* controller, int32_t channelNumber);
 static StreamControllerError loadConfigFile(char* filename, InitialInfo* configInfo);
-static StreamControllerError parseTimeTables();
+static StreamControllerError parseTimeTables(StreamController* controller);
+static void feedTransportPackets(const uint8_t* packets, uint32_t packetCount);
+static void timeshiftOutput(const uint8_t* packets, uint32_t packetCount);
+static void leaveTimeshift();
+static void recordPackets(StreamController* controller, const uint8_t* packets, uint32_t packetCount);
+static bool playService(StreamController* controller, int32_t channelNumber, uint16_t pmtPid, uint16_t pcrPid, const ServiceStreams* streams);
+static bool startStoredChannel(StreamController* controller, int32_t channelNumber);
+static const ChannelService* findStoredService(StreamController* controller, int32_t channelNumber);
+static void storeLiveService(StreamController* controller, int32_t channelNumber);
+static const StreamTypeInfo* lookupStreamType(uint8_t streamType);
+static void selectStream(ServiceStreams* streams, uint16_t pid, uint8_t streamType);
+static void reportBootTime(const char* source);
+static void updatePrefetch(StreamController* controller, int32_t channelNumber);
+static bool takePrefetchRequest(StreamController* controller, uint16_t pmtPid, uint8_t* requestId);
+static bool addPrefetchRequest(StreamController* controller, int32_t channelNumber);
+static void setPmtFilter(StreamController* controller, uint16_t pmtPid, uint16_t serviceProgramNumber);
+static void clearPmtFilter(StreamController* controller);
+static void addEpgFilters(StreamController* controller);
+static void publishChannel(StreamController* controller);
+static double secondsSince(const struct timespec* start);
+static void printTableAcquisitionStats(StreamController* controller);
+static uint32_t queueChannelChange(StreamController* controller, int32_t channelNumber, int8_t step);
+static void processChannelChanges(StreamController* controller);
+static void notifyChannelChange(StreamController* controller, ChannelChangeStatus status, int32_t channelNumber);
+static void speculativePmtFetch(StreamController* controller, int32_t channelNumber);
+static void printZapStats(StreamController* controller);
+static void selectServiceStreams(const PmtTable* pmtTable, ServiceStreams* streams);
+static void applySiChanges(StreamController* controller);
+static void applyPatChange(StreamController* controller);
+static void applyPmtChange(StreamController* controller);
+static uint64_t threadCpuNanoseconds();
+static void printSiMonitorStats(StreamController* controller);
+
+static InitialInfo initialInfo;
 
-static InitialInfo configFile;
-static CurrentDate currentDate;
-
-static uint32_t currentVolume = 5;
 static uint32_t volumeConstant = 160400000;
 
 StreamControllerError streamControllerInit()
 {
-    if (pthread_create(&scThread, NULL, &streamControllerTask, NULL))
+    clock_gettime(CLOCK_MONOTONIC, &bootTime);
+
+    return startController(&liveController, &initialInfo, true);
+}
+
+StreamControllerError streamControllerDeinit()
+{
+    return stopController(&liveController);
+}
+
+StreamControllerError streamControllerCreate(StreamController** controller, const InitialInfo* initialInfo)
+{
+    StreamController* instance = NULL;
+    StreamControllerError result = SC_NO_ERROR;
+
+    if (controller == NULL || initialInfo == NULL)
+    {
+        printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+        return SC_ERROR;
+    }
+
+    /* tuning itself is done by the task, mismatch with shared tuner is reported right away */
+    pthread_mutex_lock(&tunerMutex);
+    if ((tunerUserCount > 0) && (tunerFrequency != initialInfo->tuneFrequency))
+    {
+        pthread_mutex_unlock(&tunerMutex);
+        printf("\n%s : ERROR tuner is locked to %u Hz by another stream controller\n", __FUNCTION__, tunerFrequency);
+        return SC_ERROR;
+    }
+    pthread_mutex_unlock(&tunerMutex);
+
+    /* published channel info must not share a cache line with other data */
+    if (posix_memalign((void**) &instance, CACHE_LINE_SIZE, sizeof(StreamController)))
+    {
+        printf("\n%s : ERROR Cannot allocate memory\n", __FUNCTION__);
+        return SC_ERROR;
+    }
+    memset(instance, 0x0, sizeof(StreamController));
+
+    result = startController(instance, initialInfo, false);
+    if (result != SC_NO_ERROR)
+    {
+        free(instance);
+        return result;
+    }
+
+    *controller = instance;
+
+    return SC_NO_ERROR;
+}
+
+StreamControllerError streamControllerDestroy(StreamController* controller)
+{
+    StreamControllerError result = SC_NO_ERROR;
+
+    if (controller == NULL || controller == &liveController)
+    {
+        printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+        return SC_ERROR;
+    }
+
+    result = stopController(controller);
+    free(controller);
+
+    return result;
+}
+
+/* Starts task of an instance, the task tunes, acquires PAT and starts the first channel */
+StreamControllerError startController(StreamController* controller, const InitialInfo* initialInfo, bool decoding)
+{
+    DateCallback dateCallback = controller->dateRecievedCallback;
+    ChannelChangeCallback changeCallback = controller->channelChangeCallback;
+    VolumeCallback volumeCallback = controller->volumeReportCallback;
+    EpgCallback epgCallback = controller->epgCallback;
+
+    if (controller->threadStarted)
+    {
+        printf("\n%s : ERROR stream controller is already started\n", __FUNCTION__);
+        return SC_ERROR;
+    }
+
+    /* callbacks registered before start are kept */
+    memset(controller, 0x0, sizeof(StreamController));
+    controller->dateRecievedCallback = dateCallback;
+    controller->channelChangeCallback = changeCallback;
+    controller->volumeReportCallback = volumeCallback;
+    controller->epgCallback = epgCallback;
+
+    controller->decoding = decoding;
+    controller->configFile = *initialInfo;
+    controller->programNumber = initialInfo->programNumber;
+    controller->currentVolume = 5;
+    controller->activeStreams.videoPid = -1;
+    controller->activeStreams.audioPid = -1;
+    controller->playbackFileDesc = -1;
+    controller->pmtFilterRequest = FILTER_SCHEDULER_NO_REQUEST;
+    controller->patFilterRequest = FILTER_SCHEDULER_NO_REQUEST;
+    pthread_mutex_init(&controller->recordingMutex, NULL);
+    pthread_mutex_init(&controller->publishMutex, NULL);
+    pthread_mutex_init(&controller->channelChangeMutex, NULL);
+    pthread_cond_init(&controller->channelChangeCond, NULL);
+    siMonitorInit(&controller->siMonitor);
+
+    if (!addController(controller))
+    {
+        printf("\n%s : ERROR only %d stream controllers can run at once\n", __FUNCTION__, STREAM_CONTROLLER_MAX_INSTANCES);
+        return SC_ERROR;
+    }
+
+    if (pthread_create(&controller->scThread, NULL, &streamControllerTask, controller))
     {
         printf("Error creating input event task!\n");
+        removeController(controller);
         return SC_THREAD_ERROR;
     }
+    controller->threadStarted = true;
 
     return SC_NO_ERROR;
 }
 
-StreamControllerError streamControllerDeinit()
+StreamControllerError stopController(StreamController* controller)
 {
-    if (!isInitialized) 
+    if (!controller->threadStarted) 
     {
         printf("\n%s : ERROR streamControllerDeinit() fail, module is not initialized!\n", __FUNCTION__);
         return SC_ERROR;
     }
     
-    threadExit = 1;
-    if (pthread_join(scThread, NULL))
+    pthread_mutex_lock(&controller->channelChangeMutex);
+    controller->threadExit = 1;
+    pthread_cond_signal(&controller->channelChangeCond);
+    pthread_mutex_unlock(&controller->channelChangeMutex);
+    tableAcquisitionCancel(&controller->acquisition);
+
+    if (pthread_join(controller->scThread, NULL))
     {
         printf("\n%s : ERROR pthread_join fail!\n", __FUNCTION__);
         return SC_THREAD_ERROR;
     }
+    controller->threadStarted = false;
+
+    if (!controller->isInitialized)
+    {
+        /* task failed to start and released everything it had */
+        removeController(controller);
+        return SC_ERROR;
+    }
+
+    /* no more sections may reach acquisition of this instance */
+    setAcquisitionReady(controller, false);
+    tableAcquisitionDeinit(&controller->acquisition);
+
+    /* stop capture, recording and timeshift playback, unmap buffer */
+    if (controller->decoding)
+    {
+        tsFileSourceStop();
+    }
+    streamControllerRecordingStop(controller);
+    removeController(controller);
+    if (controller->decoding)
+    {
+        leaveTimeshift();
+        timeshiftDeinit();
+    }
+    channelDatabaseUnmap(&controller->channelDatabase);
     
-    /* free demux filter */  
-    Demux_Free_Filter(playerHandle, filterHandle);
+    /* free demux filters */  
+    filterSchedulerPrintStats(&controller->filterScheduler);
+    filterSchedulerDeinit(&controller->filterScheduler);
+    controller->pmtFilterRequest = FILTER_SCHEDULER_NO_REQUEST;
+    controller->patFilterRequest = FILTER_SCHEDULER_NO_REQUEST;
+    controller->prefetchRequestCount = 0;
+    if (controller->decoding)
+    {
+        pmtPrefetchPrintStats();
+    }
+    printTableAcquisitionStats(controller);
+    printZapStats(controller);
+    printSiMonitorStats(controller);
 
 	/* remove audio stream */
-	Player_Stream_Remove(playerHandle, sourceHandle, streamHandleA);
+	Player_Stream_Remove(controller->playerHandle, controller->sourceHandle, controller->streamHandleA);
+    controller->streamHandleA = 0;
     
     /* remove video stream */
-    Player_Stream_Remove(playerHandle, sourceHandle, streamHandleV);
+    Player_Stream_Remove(controller->playerHandle, controller->sourceHandle, controller->streamHandleV);
+    controller->streamHandleV = 0;
     
     /* close player source */
-    Player_Source_Close(playerHandle, sourceHandle);
+    Player_Source_Close(controller->playerHandle, controller->sourceHandle);
     
     /* deinitialize player */
-    Player_Deinit(playerHandle);
+    Player_Deinit(controller->playerHandle);
     
-    /* deinitialize tuner device */
-    Tuner_Deinit();    
+    /* deinitialize tuner device when no other instance uses it */
+    releaseTuner();
 
     /* free allocated memory */  
-    free(patTable);
-    free(pmtTable);
-	free(tdtTable);
-	free(totTable);
+    freeTables(controller);
+
+    pthread_mutex_destroy(&controller->recordingMutex);
+    pthread_mutex_destroy(&controller->publishMutex);
+    pthread_mutex_destroy(&controller->channelChangeMutex);
+    pthread_cond_destroy(&controller->channelChangeCond);
+    siMonitorDeinit(&controller->siMonitor);
+
+    /* set isInitialized flag */
+    controller->isInitialized = false;
+
+    return SC_NO_ERROR;
+}
+
+bool addController(StreamController* controller)
+{
+    bool added = false;
+    uint8_t i = 0;
+
+    pthread_mutex_lock(&controllersMutex);
+    for (i = 0; i < STREAM_CONTROLLER_MAX_INSTANCES; i++)
+    {
+        if (controllers[i] == NULL)
+        {
+            controllers[i] = controller;
+            added = true;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&controllersMutex);
+
+    return added;
+}
+
+void removeController(StreamController* controller)
+{
+    uint8_t i = 0;
+
+    pthread_mutex_lock(&controllersMutex);
+    for (i = 0; i < STREAM_CONTROLLER_MAX_INSTANCES; i++)
+    {
+        if (controllers[i] == controller)
+        {
+            controllers[i] = NULL;
+        }
+    }
+    pthread_mutex_unlock(&controllersMutex);
+}
+
+void setAcquisitionReady(StreamController* controller, bool ready)
+{
+    pthread_mutex_lock(&controllersMutex);
+    controller->acquisitionReady = ready;
+    pthread_mutex_unlock(&controllersMutex);
+}
+
+/* Only instances tuned to the same frequency can run at once, tdp_api has a single tuner */
+StreamControllerError acquireTuner(const InitialInfo* initialInfo)
+{
+    pthread_mutex_lock(&tunerMutex);
+    if (tunerUserCount == 0)
+    {
+        /* initialize tuner device */
+        if (Tuner_Init())
+        {
+            printf("\n%s : ERROR Tuner_Init() fail\n", __FUNCTION__);
+            pthread_mutex_unlock(&tunerMutex);
+            return SC_ERROR;
+        }
+
+        /* register tuner status callback */
+        if (Tuner_Register_Status_Callback(tunerStatusCallback))
+        {
+            printf("\n%s : ERROR Tuner_Register_Status_Callback() fail\n", __FUNCTION__);
+        }
+
+        pthread_mutex_lock(&statusMutex);
+        tunerLocked = false;
+        pthread_mutex_unlock(&statusMutex);
+
+        /* lock to frequency */
+        if (!Tuner_Lock_To_Frequency(initialInfo->tuneFrequency, initialInfo->tuneBandwidth, initialInfo->tuneModule))
+        {
+            printf("\n%s: INFO Tuner_Lock_To_Frequency(): %d Hz - success!\n",__FUNCTION__, initialInfo->tuneFrequency);
+        }
+        else
+        {
+            printf("\n%s: ERROR Tuner_Lock_To_Frequency(): %d Hz - fail!\n",__FUNCTION__, initialInfo->tuneFrequency);
+            Tuner_Deinit();
+            pthread_mutex_unlock(&tunerMutex);
+            return SC_ERROR;
+        }
+        tunerFrequency = initialInfo->tuneFrequency;
+
+        /* sections of every instance are parsed by one worker while the tuner is in use */
+        sectionQueueInit(&sectionQueue);
+        memset(&callbackTiming, 0x0, sizeof(SectionTiming));
+        memset(&dispatchTiming, 0x0, sizeof(SectionTiming));
+        sectionWorkerExit = false;
+        sem_init(&sectionSemaphore, 0, 0);
+        if (pthread_create(&sectionWorker, NULL, &sectionWorkerTask, NULL))
+        {
+            printf("\n%s : ERROR pthread_create() fail\n", __FUNCTION__);
+            Tuner_Deinit();
+            sem_destroy(&sectionSemaphore);
+            pthread_mutex_unlock(&tunerMutex);
+            return SC_THREAD_ERROR;
+        }
+    }
+    else if (tunerFrequency != initialInfo->tuneFrequency)
+    {
+        printf("\n%s : ERROR tuner is locked to %u Hz by another stream controller\n", __FUNCTION__, tunerFrequency);
+        pthread_mutex_unlock(&tunerMutex);
+        return SC_ERROR;
+    }
+    tunerUserCount++;
+    pthread_mutex_unlock(&tunerMutex);
+
+    return SC_NO_ERROR;
+}
+
+StreamControllerError waitForTunerLock()
+{
+    struct timespec lockStatusWaitTime;
+    struct timeval now;
+    bool locked = false;
+
+    gettimeofday(&now,NULL);
+    lockStatusWaitTime.tv_sec = now.tv_sec+10;
+    lockStatusWaitTime.tv_nsec = now.tv_usec * 1000;
+
+    /* wait for tuner to lock */
+    pthread_mutex_lock(&statusMutex);
+    while (!tunerLocked)
+    {
+        if (ETIMEDOUT == pthread_cond_timedwait(&statusCondition, &statusMutex, &lockStatusWaitTime))
+        {
+            break;
+        }
+    }
+    locked = tunerLocked;
+    pthread_mutex_unlock(&statusMutex);
+
+    if (!locked)
+    {
+        printf("\n%s : ERROR Lock timeout exceeded!\n",__FUNCTION__);
+        releaseTuner();
+        return SC_ERROR;
+    }
+
+    return SC_NO_ERROR;
+}
+
+void releaseTuner()
+{
+    pthread_mutex_lock(&tunerMutex);
+    if (tunerUserCount > 0 && --tunerUserCount == 0)
+    {
+        /* no section may be posted once the semaphore is gone, so demux delivery stops first */
+        if (Demux_Unregister_Section_Filter_Callback(sectionReceivedCallback))
+        {
+            printf("\n%s : ERROR Demux_Unregister_Section_Filter_Callback() fail\n", __FUNCTION__);
+        }
+
+        /* stop section worker, queued sections have no instance left to go to */
+        __atomic_store_n(&sectionWorkerExit, true, __ATOMIC_RELEASE);
+        sem_post(&sectionSemaphore);
+        pthread_join(sectionWorker, NULL);
+        printSectionQueueStats();
+
+        /* deinitialize tuner device */
+        Tuner_Deinit();
+        sem_destroy(&sectionSemaphore);
+    }
+    pthread_mutex_unlock(&tunerMutex);
+}
+
+void freeTables(StreamController* controller)
+{
+    free(controller->patTable);
+    free(controller->pmtTable);
+    free(controller->tdtTable);
+    free(controller->totTable);
+    controller->patTable = NULL;
+    controller->pmtTable = NULL;
+    controller->tdtTable = NULL;
+    controller->totTable = NULL;
+}
+
+StreamControllerError channelUp()
+{   
+    return channelChangeStep(1) ? SC_NO_ERROR : SC_ERROR;
+}
+
+StreamControllerError channelDown()
+{
+    return channelChangeStep(-1) ? SC_NO_ERROR : SC_ERROR;
+}
+
+uint32_t channelChangeRequest(int32_t channelNumber)
+{
+    return queueChannelChange(&liveController, channelNumber, 0);
+}
+
+uint32_t channelChangeStep(int8_t step)
+{
+    return queueChannelChange(&liveController, 0, step);
+}
+
+uint32_t streamControllerChannelChangeRequest(StreamController* controller, int32_t channelNumber)
+{
+    if (controller == NULL)
+    {
+        printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+        return 0;
+    }
+
+    return queueChannelChange(controller, channelNumber, 0);
+}
+
+StreamControllerError getChannelInfo(ChannelInfo* channelInfo)
+{
+    return streamControllerGetChannelInfo(&liveController, channelInfo);
+}
+
+StreamControllerError streamControllerGetChannelInfo(StreamController* controller, ChannelInfo* channelInfo)
+{
+    uint32_t sequence = 0;
+
+    if (controller == NULL || channelInfo == NULL)
+    {
+        printf("\n Error wrong parameter\n", __FUNCTION__);
+        return SC_ERROR;
+    }
+    
+    /* copy is retried when a writer was active before or during it */
+    do
+    {
+        sequence = __atomic_load_n(&controller->publishedChannel.sequence, __ATOMIC_ACQUIRE);
+        *channelInfo = controller->publishedChannel.info;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while ((sequence & 1) || (sequence != __atomic_load_n(&controller->publishedChannel.sequence, __ATOMIC_RELAXED)));
+    
+    return SC_NO_ERROR;
+}
+
+/* Copies current channel to readers, must be called with publishMutex locked */
+void publishChannel(StreamController* controller)
+{
+    uint32_t sequence = controller->publishedChannel.sequence;
+
+    __atomic_store_n(&controller->publishedChannel.sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    controller->publishedChannel.info = controller->currentChannel;
+    __atomic_store_n(&controller->publishedChannel.sequence, sequence + 2, __ATOMIC_RELEASE);
+}
+
+/* Sets filter to receive current channel PMT table
+ * Parses current channel PMT table when it arrives
+ * Creates streams with current channel audio and video pids
+ */
+void startChannel(StreamController* controller, int32_t channelNumber)
+{
+    struct timespec zapStart;
+    bool prefetchHit = false;
+    TableRequest pmtRequest;
+    uint16_t pmtPid = controller->patTable->patServiceInfoArray[channelNumber + 1].pid;
+    uint16_t serviceProgramNumber = controller->patTable->patServiceInfoArray[channelNumber + 1].programNumber;
+
+    clock_gettime(CLOCK_MONOTONIC, &zapStart);
+
+    /* zapping always returns to live and ends recording of previous service, streams of new service are created below */
+    if (controller->decoding)
+    {
+        leaveTimeshift();
+    }
+    streamControllerRecordingStop(controller);
+
+    if (controller->decoding && (controller->currentChannel.programNumber > 0))
+    {
+        pmtPrefetchRecordZap(controller->currentChannel.programNumber - 1, channelNumber);
+    }
+
+    /* stop watching PMT of previous channel and free its filter */
+    siMonitorWatchPmt(&controller->siMonitor, SI_MONITOR_NO_PROGRAM, SI_MONITOR_UNKNOWN_VERSION);
+    clearPmtFilter(controller);
+
+    prefetchHit = pmtPrefetchLookup(serviceProgramNumber, controller->pmtTable);
+    if (!prefetchHit)
+    {
+        pmtRequest.pid = pmtPid;
+        pmtRequest.tableId = 0x02;
+        pmtRequest.tableIdExtension = serviceProgramNumber;
+        pmtRequest.timeout = PSI_TIMEOUT;
+        pmtRequest.retries = PSI_RETRIES;
+        pmtRequest.backoff = PSI_BACKOFF;
+
+        /* wait for a PMT table, a newer zap cancels the wait */
+        switch (tableAcquire(&controller->acquisition, &pmtRequest, controller->acquiredSection, NULL))
+        {
+            case TA_NO_ERROR:
+                break;
+            case TA_CANCELLED:
+                printf("\n%s : INFO zap to channel %d cancelled by newer zap\n", __FUNCTION__, channelNumber + 1);
+                controller->zapStats.abortedCount++;
+                controller->zapStats.abortedSeconds += secondsSince(&zapStart);
+                notifyChannelChange(controller, CHANNEL_CHANGE_CANCELLED, channelNumber);
+                return;
+            default:
+                printf("\n%s : ERROR PMT of channel %d not received\n", __FUNCTION__, channelNumber + 1);
+                notifyChannelChange(controller, CHANNEL_CHANGE_FAILED, channelNumber);
+                return;
+        }
+
+        if (parsePmtTable(controller->acquiredSection, controller->pmtTable) != TABLES_PARSE_OK)
+        {
+            printf("\n%s : ERROR parsing PMT of channel %d\n", __FUNCTION__, channelNumber + 1);
+            notifyChannelChange(controller, CHANNEL_CHANGE_FAILED, channelNumber);
+            return;
+        }
+    }
+    notifyChannelChange(controller, CHANNEL_CHANGE_PMT_ACQUIRED, channelNumber);
+
+    /* PMT filter stays set, newer versions are applied while the channel plays */
+    setPmtFilter(controller, pmtPid, serviceProgramNumber);
+    siMonitorWatchPmt(&controller->siMonitor, serviceProgramNumber, controller->pmtTable->pmtHeader.versionNumber);
+    
+    /* select audio and video streams */
+    ServiceStreams streams;
+    selectServiceStreams(controller->pmtTable, &streams);
+
+    /* channel started from channel database keeps its streams when live PMT confirms stored pids */
+    if (!playService(controller, channelNumber, controller->patTable->patServiceInfoArray[channelNumber + 1].pid, controller->pmtTable->pmtHeader.pcrPid, &streams))
+    {
+        notifyChannelChange(controller, CHANNEL_CHANGE_FAILED, channelNumber);
+        return;
+    }
+    notifyChannelChange(controller, CHANNEL_CHANGE_STREAMS_CREATED, channelNumber);
+
+    if (controller->decoding)
+    {
+        reportBootTime("live PAT and PMT");
+        pmtPrefetchRecordZapTime(prefetchHit, secondsSince(&zapStart));
+
+        /* keep channel database in sync with live tables */
+        storeLiveService(controller, channelNumber);
+
+        /* warm up PMTs of channels most likely to be zapped to next */
+        updatePrefetch(controller, channelNumber);
+    }
+
+	if (controller->timeTablesRecieved == false)
+	{
+		parseTimeTables(controller);
+	}
+}
+
+/* Stores service pids for timeshift and recording
+ * Creates streams with audio and video pids of a service on live instance, returns false if a stream cannot be created
+ */
+bool playService(StreamController* controller, int32_t channelNumber, uint16_t pmtPid, uint16_t pcrPid, const ServiceStreams* streams)
+{
+    const ChannelService* stored = findStoredService(controller, channelNumber);
+    uint16_t serviceId = (stored != NULL) ? stored->serviceId : controller->patTable->patServiceInfoArray[channelNumber + 1].programNumber;
+
+    /* store and publish current channel info */
+    pthread_mutex_lock(&controller->publishMutex);
+    if (serviceId != controller->currentChannel.serviceId)
+    {
+        /* now/next of new service come with its EIT present/following */
+        memset(&controller->currentChannel.nowEvent, 0x0, sizeof(EitEventInfo));
+        memset(&controller->currentChannel.nextEvent, 0x0, sizeof(EitEventInfo));
+    }
+    controller->currentChannel.programNumber = channelNumber + 1;
+    controller->currentChannel.audioPid = streams->audioPid;
+    controller->currentChannel.videoPid = streams->videoPid;
+    controller->currentChannel.audioCodec = streams->audioCodec;
+    controller->currentChannel.videoCodec = streams->videoCodec;
+    controller->currentChannel.pmtPid = pmtPid;
+    controller->currentChannel.pcrPid = pcrPid;
+    controller->currentChannel.serviceId = serviceId;
+    controller->currentChannel.serviceName[0] = '\0';
+    if (stored != NULL)
+    {
+        strncpy(controller->currentChannel.serviceName, stored->name, TABLES_MAX_NAME_LENGTH - 1);
+        controller->currentChannel.serviceName[TABLES_MAX_NAME_LENGTH - 1] = '\0';
+    }
+    publishChannel(controller);
+    pthread_mutex_unlock(&controller->publishMutex);
+
+    /* timeshift buffer and recordings store PAT, PMT, elementary streams and PCR of new service */
+    pthread_mutex_lock(&controller->recordingMutex);
+    controller->servicePidCount = 0;
+    controller->servicePids[controller->servicePidCount++] = TS_PAT_PID;
+    controller->servicePids[controller->servicePidCount++] = pmtPid;
+    if (streams->videoPid != -1)
+    {
+        controller->servicePids[controller->servicePidCount++] = streams->videoPid;
+    }
+    if (streams->audioPid != -1)
+    {
+        controller->servicePids[controller->servicePidCount++] = streams->audioPid;
+    }
+    /* PCR on its own pid indexes the buffer, paces its playback and keeps recordings playable */
+    if ((pcrPid != streams->videoPid) && (pcrPid != streams->audioPid) && (pcrPid != TS_NULL_PID))
+    {
+        controller->servicePids[controller->servicePidCount++] = pcrPid;
+    }
+    pthread_mutex_unlock(&controller->recordingMutex);
+
+    /* background instances only record, player streams and timeshift belong to live instance */
+    if (!controller->decoding)
+    {
+        controller->activeStreams = *streams;
+        return true;
+    }
+
+    /* decoder is kept running when new service has the same video pid and codec */
+    if ((controller->streamHandleV != 0) && (streams->videoPid == controller->activeStreams.videoPid) && (streams->videoCodec == controller->activeStreams.videoCodec))
+    {
+        controller->zapStats.reusedStreamCount++;
+    }
+    else
+    {
+        /* remove previous video stream */
+        if (controller->streamHandleV != 0)
+        {
+            Player_Stream_Remove(controller->playerHandle, controller->sourceHandle, controller->streamHandleV);
+            controller->streamHandleV = 0;
+        }
+
+        if (streams->videoPid != -1)
+        {
+            /* create video stream */
+            if (Player_Stream_Create(controller->playerHandle, controller->sourceHandle, streams->videoPid, streams->videoCodec, &controller->streamHandleV))
+            {
+                /* task keeps running, next zap or PMT version creates the stream again */
+                printf("\n%s : ERROR Cannot create video stream\n", __FUNCTION__);
+                controller->streamHandleV = 0;
+                return false;
+            }
+            controller->zapStats.createdStreamCount++;
+        }
+        else
+        {
+            MV_PE_ClearScreen(controller->playerHandle, 1);
+        }
+    }
+
+    if ((controller->streamHandleA != 0) && (streams->audioPid == controller->activeStreams.audioPid) && (streams->audioCodec == controller->activeStreams.audioCodec))
+    {
+        controller->zapStats.reusedStreamCount++;
+    }
+    else
+    {
+        /* remove previous audio stream */
+        if (controller->streamHandleA != 0)
+        {
+            Player_Stream_Remove(controller->playerHandle, controller->sourceHandle, controller->streamHandleA);
+            controller->streamHandleA = 0;
+        }
+
+        if (streams->audioPid != -1)
+        {
+            /* create audio stream */
+            if (Player_Stream_Create(controller->playerHandle, controller->sourceHandle, streams->audioPid, streams->audioCodec, &controller->streamHandleA))
+            {
+                /* task keeps running, next zap or PMT version creates the stream again */
+                printf("\n%s : ERROR Cannot create audio stream\n", __FUNCTION__);
+                controller->streamHandleA = 0;
+                return false;
+            }
+            controller->zapStats.createdStreamCount++;
+        }
+    }
+    controller->activeStreams = *streams;
+
+    timeshiftSetService(pcrPid, controller->servicePids, controller->servicePidCount);
+
+    return true;
+}
+
+/* Starts channel from pids stored in channel database, live PAT and PMT are checked later by startChannel */
+bool startStoredChannel(StreamController* controller, int32_t channelNumber)
+{
+    const ChannelService* service = findStoredService(controller, channelNumber);
+    ServiceStreams streams = {-1, 0, 0, -1, 0};
+    uint8_t i = 0;
+
+    if (service == NULL)
+    {
+        printf("\n%s : INFO channel %d is not in channel database\n", __FUNCTION__, channelNumber + 1);
+        return false;
+    }
+
+    for (i = 0; i < service->streamCount; i++)
+    {
+        selectStream(&streams, service->streams[i].pid, service->streams[i].streamType);
+    }
+
+    /* live PAT and PMT start the channel again if streams cannot be created now */
+    if (!playService(controller, channelNumber, service->pmtPid, service->pcrPid, &streams))
+    {
+        return false;
+    }
+    reportBootTime("channel database");
+
+    return true;
+}
+
+/* Finds service on tuned multiplex by its position in PAT */
+const ChannelService* findStoredService(StreamController* controller, int32_t channelNumber)
+{
+    uint16_t multiplexIndex = 0;
+    uint16_t i = 0;
+
+    for (multiplexIndex = 0; multiplexIndex < controller->channelDatabase.multiplexCount; multiplexIndex++)
+    {
+        if (controller->channelDatabase.multiplexes[multiplexIndex].frequency == controller->configFile.tuneFrequency)
+        {
+            break;
+        }
+    }
+
+    for (i = 0; i < controller->channelDatabase.serviceCount; i++)
+    {
+        if ((controller->channelDatabase.services[i].multiplexIndex == multiplexIndex) &&
+            (controller->channelDatabase.services[i].patIndex == channelNumber + 1))
+        {
+            return &controller->channelDatabase.services[i];
+        }
+    }
+
+    return NULL;
+}
+
+/* Writes live PAT and PMT of current channel to channel database when they differ from stored ones */
+void storeLiveService(StreamController* controller, int32_t channelNumber)
+{
+    const ChannelService* stored = findStoredService(controller, channelNumber);
+    ChannelDatabase* database = NULL;
+    ChannelService service;
+    ChannelMultiplex multiplex;
+    uint16_t multiplexIndex = 0;
+    uint16_t i = 0;
+    uint8_t j = 0;
+
+    if (controller->configFile.channelDatabaseFile[0] == '\0')
+    {
+        return;
+    }
+
+    memset(&service, 0x0, sizeof(ChannelService));
+    if ((stored != NULL) && (stored->serviceId == controller->patTable->patServiceInfoArray[channelNumber + 1].programNumber))
+    {
+        service = *stored;
+    }
+    else
+    {
+        service.logicalChannelNumber = CHANNEL_DATABASE_NO_LCN;
+        snprintf(service.name, TABLES_MAX_NAME_LENGTH, "Service %d", controller->patTable->patServiceInfoArray[channelNumber + 1].programNumber);
+    }
+
+    service.serviceId = controller->patTable->patServiceInfoArray[channelNumber + 1].programNumber;
+    service.pmtPid = controller->patTable->patServiceInfoArray[channelNumber + 1].pid;
+    service.patIndex = channelNumber + 1;
+    service.pcrPid = controller->pmtTable->pmtHeader.pcrPid;
+    service.pmtVersion = controller->pmtTable->pmtHeader.versionNumber;
+    memset(service.streams, 0x0, sizeof(service.streams));
+    for (j = 0; j < controller->pmtTable->elementaryInfoCount && j < CHANNEL_DATABASE_MAX_STREAMS; j++)
+    {
+        service.streams[j].pid = controller->pmtTable->pmtElementaryInfoArray[j].elementaryPid;
+        service.streams[j].streamType = controller->pmtTable->pmtElementaryInfoArray[j].streamType;
+    }
+    service.streamCount = j;
+
+    if ((stored != NULL) && (memcmp(stored, &service, sizeof(ChannelService)) == 0))
+    {
+        return;
+    }
+
+    database = (ChannelDatabase*) malloc(sizeof(ChannelDatabase));
+    if (database == NULL)
+    {
+        printf("\n%s : ERROR Cannot allocate memory\n", __FUNCTION__);
+        return;
+    }
+
+    if (channelDatabaseLoad(database, controller->configFile.channelDatabaseFile))
+    {
+        channelDatabaseClear(database);
+    }
+
+    for (multiplexIndex = 0; multiplexIndex < database->multiplexCount; multiplexIndex++)
+    {
+        if (database->multiplexes[multiplexIndex].frequency == controller->configFile.tuneFrequency)
+        {
+            break;
+        }
+    }
+
+    if (multiplexIndex == database->multiplexCount)
+    {
+        memset(&multiplex, 0x0, sizeof(ChannelMultiplex));
+        multiplex.frequency = controller->configFile.tuneFrequency;
+        multiplex.bandwidth = controller->configFile.tuneBandwidth;
+        multiplex.transportStreamId = controller->patTable->patHeader.transportStreamId;
+        multiplex.patVersion = controller->patTable->patHeader.versionNumber;
+        if (channelDatabaseAddMultiplex(database, &multiplex, &multiplexIndex))
+        {
+            free(database);
+            return;
+        }
+    }
+    else
+    {
+        database->multiplexes[multiplexIndex].transportStreamId = controller->patTable->patHeader.transportStreamId;
+        database->multiplexes[multiplexIndex].patVersion = controller->patTable->patHeader.versionNumber;
+    }
+    service.multiplexIndex = multiplexIndex;
+
+    /* service that used to be on this PAT position is gone */
+    for (i = 0; i < database->serviceCount; i++)
+    {
+        if ((database->services[i].multiplexIndex == multiplexIndex) && (database->services[i].patIndex == service.patIndex) &&
+            (database->services[i].serviceId != service.serviceId))
+        {
+            database->services[i] = database->services[database->serviceCount - 1];
+            database->serviceCount--;
+            i--;
+        }
+    }
+
+    if (channelDatabaseAddService(database, &service) == CDB_NO_ERROR)
+    {
+        channelDatabaseSort(database);
+        if (channelDatabaseSave(database, controller->configFile.channelDatabaseFile) == CDB_NO_ERROR)
+        {
+            printf("\n%s : INFO channel database updated (generation %u)\n", __FUNCTION__, database->generation);
+        }
+    }
+    free(database);
+
+    channelDatabaseUnmap(&controller->channelDatabase);
+    channelDatabaseMap(&controller->channelDatabase, controller->configFile.channelDatabaseFile);
+}
+
+/* Sets PMT filters on channels most likely to be zapped to from current channel */
+void updatePrefetch(StreamController* controller, int32_t channelNumber)
+{
+    uint8_t candidates[PMT_PREFETCH_MAX_NEIGHBOURS];
+    uint8_t candidateCount = 0;
+    uint8_t channelCount = (controller->patTable->serviceInfoCount > 0) ? controller->patTable->serviceInfoCount - 1 : 0;
+    uint8_t i = 0;
+
+    for (i = 0; i < controller->prefetchRequestCount; i++)
+    {
+        filterSchedulerRemove(&controller->filterScheduler, controller->prefetchRequests[i]);
+    }
+    controller->prefetchRequestCount = 0;
+
+    candidateCount = pmtPrefetchRank(channelNumber, channelCount, controller->configFile.prefetchCount, candidates);
+    for (i = 0; i < candidateCount; i++)
+    {
+        if (!addPrefetchRequest(controller, candidates[i]))
+        {
+            break;
+        }
+    }
+}
+
+/* Requests PMT of a channel for prefetch cache, filter scheduler gives it a slot in turns with other background tables */
+bool addPrefetchRequest(StreamController* controller, int32_t channelNumber)
+{
+    FilterRequest request;
+
+    request.pid = controller->patTable->patServiceInfoArray[channelNumber + 1].pid;
+    request.tableId = 0x02;
+    request.tableIdExtension = controller->patTable->patServiceInfoArray[channelNumber + 1].programNumber;
+    request.priority = FILTER_PRIORITY_PMT_PREFETCH;
+    request.repetitionInterval = PSI_TIMEOUT;
+    request.refreshInterval = PREFETCH_REFRESH_INTERVAL;
+
+    if (filterSchedulerAdd(&controller->filterScheduler, &request, &controller->prefetchRequests[controller->prefetchRequestCount]) != FS_NO_ERROR)
+    {
+        return false;
+    }
+    controller->prefetchPids[controller->prefetchRequestCount] = request.pid;
+    controller->prefetchRequestCount++;
+
+    return true;
+}
+
+/* Hands prefetch request on given pid over to caller */
+bool takePrefetchRequest(StreamController* controller, uint16_t pmtPid, uint8_t* requestId)
+{
+    uint8_t i = 0;
+
+    for (i = 0; i < controller->prefetchRequestCount; i++)
+    {
+        if (controller->prefetchPids[i] == pmtPid)
+        {
+            *requestId = controller->prefetchRequests[i];
+            controller->prefetchRequestCount--;
+            controller->prefetchRequests[i] = controller->prefetchRequests[controller->prefetchRequestCount];
+            controller->prefetchPids[i] = controller->prefetchPids[controller->prefetchRequestCount];
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* Keeps PMT filter of current service set, filter of prefetched service is promoted instead of setting a new one */
+void setPmtFilter(StreamController* controller, uint16_t pmtPid, uint16_t serviceProgramNumber)
+{
+    FilterRequest request;
+    uint8_t requestId = 0;
+
+    clearPmtFilter(controller);
+
+    if (takePrefetchRequest(controller, pmtPid, &requestId))
+    {
+        filterSchedulerSetPriority(&controller->filterScheduler, requestId, FILTER_PRIORITY_CURRENT_PMT);
+        controller->pmtFilterRequest = requestId;
+        return;
+    }
+
+    request.pid = pmtPid;
+    request.tableId = 0x02;
+    request.tableIdExtension = serviceProgramNumber;
+    request.priority = FILTER_PRIORITY_CURRENT_PMT;
+    request.repetitionInterval = PSI_TIMEOUT;
+    request.refreshInterval = 0;
+
+    if (filterSchedulerAdd(&controller->filterScheduler, &request, &requestId) == FS_NO_ERROR)
+    {
+        controller->pmtFilterRequest = requestId;
+    }
+}
+
+/* EIT is received in turns with other background tables, the guide fills up over a few turns
+ * Present/following gives now/next of channel info, schedule is received only for the guide
+ */
+void addEpgFilters(StreamController* controller)
+{
+    FilterRequest request;
+    uint8_t requestId = 0;
+    uint8_t i = 0;
+
+    request.pid = EIT_PID;
+    request.tableId = 0x4E;
+    request.tableIdExtension = FILTER_SCHEDULER_ANY_EXTENSION;
+    request.priority = FILTER_PRIORITY_EIT_PRESENT_FOLLOWING;
+    request.repetitionInterval = EIT_PRESENT_FOLLOWING_INTERVAL;
+    request.refreshInterval = EIT_PRESENT_FOLLOWING_INTERVAL;
+    filterSchedulerAdd(&controller->filterScheduler, &request, &requestId);
+
+    if (controller->epgCallback == NULL)
+    {
+        return;
+    }
+
+    for (i = 0; i < EIT_SCHEDULE_TABLES; i++)
+    {
+        request.tableId = 0x50 + i;
+        request.priority = FILTER_PRIORITY_EIT_SCHEDULE;
+        request.repetitionInterval = EIT_SCHEDULE_INTERVAL;
+        request.refreshInterval = 0;
+        filterSchedulerAdd(&controller->filterScheduler, &request, &requestId);
+    }
+}
+
+void clearPmtFilter(StreamController* controller)
+{
+    if (controller->pmtFilterRequest != FILTER_SCHEDULER_NO_REQUEST)
+    {
+        filterSchedulerRemove(&controller->filterScheduler, controller->pmtFilterRequest);
+        controller->pmtFilterRequest = FILTER_SCHEDULER_NO_REQUEST;
+    }
+}
+
+double secondsSince(const struct timespec* start)
+{
+    struct timespec currentTime;
+
+    clock_gettime(CLOCK_MONOTONIC, &currentTime);
+
+    return (currentTime.tv_sec - start->tv_sec) + (currentTime.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+void printTableAcquisitionStats(StreamController* controller)
+{
+    TableAcquisitionStats stats;
+
+    tableAcquisitionGetStats(&controller->acquisition, &stats);
+    printf("\n%s : INFO tables acquired %u, timeouts %u, cancelled %u, retries %u, worst case %u ms\n", __FUNCTION__,
+           stats.acquiredCount, stats.timeoutCount, stats.cancelledCount, stats.retryCount, stats.maxMilliseconds);
+}
+
+/* Adds request to queue and cancels table acquisition of the zap in progress */
+uint32_t queueChannelChange(StreamController* controller, int32_t channelNumber, int8_t step)
+{
+    uint32_t requestId = 0;
+
+    pthread_mutex_lock(&controller->channelChangeMutex);
+    if (controller->channelChangeCount < CHANNEL_CHANGE_QUEUE_SIZE)
+    {
+        /* 0 is reserved for channel started at boot */
+        if (++controller->lastRequestId == 0)
+        {
+            controller->lastRequestId = 1;
+        }
+        requestId = controller->lastRequestId;
+
+        controller->channelChangeQueue[controller->channelChangeCount].requestId = requestId;
+        controller->channelChangeQueue[controller->channelChangeCount].channelNumber = channelNumber;
+        controller->channelChangeQueue[controller->channelChangeCount].step = step;
+        controller->channelChangeCount++;
+
+        tableAcquisitionCancel(&controller->acquisition);
+        pthread_cond_signal(&controller->channelChangeCond);
+    }
+    pthread_mutex_unlock(&controller->channelChangeMutex);
+
+    if (requestId == 0)
+    {
+        printf("\n%s : ERROR channel change queue is full\n", __FUNCTION__);
+    }
+
+    return requestId;
+}
+
+/* Waits for channel change requests and executes the newest one, older ones are cancelled
+ * While channels are scrolled with P+/P- tuning waits for the settle time and only the PMT of the target is fetched
+ */
+void processChannelChanges(StreamController* controller)
+{
+    ChannelChangeRequest requests[CHANNEL_CHANGE_QUEUE_SIZE];
+    uint8_t requestCount = 0;
+    uint8_t channelCount = (controller->patTable->serviceInfoCount > 0) ? controller->patTable->serviceInfoCount - 1 : 0;
+    int32_t target = controller->programNumber;
+    uint32_t targetRequestId = 0;
+    bool scrolling = false;
+    struct timespec settleDeadline;
+    uint8_t i = 0;
+
+    pthread_mutex_lock(&controller->channelChangeMutex);
+    while (controller->channelChangeCount == 0 && !controller->threadExit && !siMonitorPending(&controller->siMonitor))
+    {
+        pthread_cond_wait(&controller->channelChangeCond, &controller->channelChangeMutex);
+    }
+
+    /* zap requests go first, tables of the new channel are acquired anyway */
+    if (controller->channelChangeCount == 0)
+    {
+        pthread_mutex_unlock(&controller->channelChangeMutex);
+        if (!controller->threadExit)
+        {
+            applySiChanges(controller);
+        }
+        return;
+    }
+
+    while (controller->channelChangeCount > 0 && !controller->threadExit)
+    {
+        requestCount = controller->channelChangeCount;
+        memcpy(requests, controller->channelChangeQueue, requestCount * sizeof(ChannelChangeRequest));
+        controller->channelChangeCount = 0;
+        pthread_mutex_unlock(&controller->channelChangeMutex);
+
+        for (i = 0; i < requestCount; i++)
+        {
+            /* previous target is replaced before it was tuned */
+            if (targetRequestId != 0)
+            {
+                controller->activeRequestId = targetRequestId;
+                notifyChannelChange(controller, CHANNEL_CHANGE_CANCELLED, target);
+                controller->zapStats.avoidedCount++;
+            }
+
+            if (requests[i].step != 0 && channelCount > 0)
+            {
+                target = ((target + requests[i].step) % channelCount + channelCount) % channelCount;
+            }
+            else if (requests[i].step == 0)
+            {
+                target = requests[i].channelNumber;
+            }
+            targetRequestId = requests[i].requestId;
+            scrolling = (requests[i].step != 0);
+            controller->zapStats.requestCount++;
+        }
+
+        if (!scrolling || controller->configFile.zapSettleTime == 0 || channelCount == 0)
+        {
+            pthread_mutex_lock(&controller->channelChangeMutex);
+            break;
+        }
+
+        /* user may still be scrolling, fetch PMT of target and wait for settle time */
+        speculativePmtFetch(controller, target);
+
+        clock_gettime(CLOCK_REALTIME, &settleDeadline);
+        settleDeadline.tv_sec += controller->configFile.zapSettleTime / 1000;
+        settleDeadline.tv_nsec += (controller->configFile.zapSettleTime % 1000) * 1000000L;
+        if (settleDeadline.tv_nsec >= 1000000000L)
+        {
+            settleDeadline.tv_sec++;
+            settleDeadline.tv_nsec -= 1000000000L;
+        }
+
+        pthread_mutex_lock(&controller->channelChangeMutex);
+        while (controller->channelChangeCount == 0 && !controller->threadExit)
+        {
+            if (pthread_cond_timedwait(&controller->channelChangeCond, &controller->channelChangeMutex, &settleDeadline) == ETIMEDOUT)
+            {
+                break;
+            }
+        }
+    }
+
+    /* cancel was meant for the zap that is being replaced now */
+    tableAcquisitionResetCancel(&controller->acquisition);
+    pthread_mutex_unlock(&controller->channelChangeMutex);
+
+    if (targetRequestId == 0 || controller->threadExit)
+    {
+        return;
+    }
+
+    controller->activeRequestId = targetRequestId;
+    if ((target < 0) || (target >= channelCount))
+    {
+        printf("\n%s : ERROR channel %d does not exist\n", __FUNCTION__, target);
+        notifyChannelChange(controller, CHANNEL_CHANGE_FAILED, target);
+        return;
+    }
+
+    controller->zapStats.tuneCount++;
+    controller->programNumber = target;
+    startChannel(controller, controller->programNumber);
+}
+
+/* Sets PMT filter on channel the user scrolled to, PMT lands in prefetch cache before the tune starts */
+void speculativePmtFetch(StreamController* controller, int32_t channelNumber)
+{
+    uint16_t pmtPid = controller->patTable->patServiceInfoArray[channelNumber + 1].pid;
+    uint8_t i = 0;
+
+    for (i = 0; i < controller->prefetchRequestCount; i++)
+    {
+        if (controller->prefetchPids[i] == pmtPid)
+        {
+            return;
+        }
+    }
+
+    /* least likely prefetched channel gives its request away */
+    if (controller->prefetchRequestCount == PMT_PREFETCH_MAX_NEIGHBOURS)
+    {
+        controller->prefetchRequestCount--;
+        filterSchedulerRemove(&controller->filterScheduler, controller->prefetchRequests[controller->prefetchRequestCount]);
+    }
+
+    if (addPrefetchRequest(controller, channelNumber))
+    {
+        controller->zapStats.speculativeFetchCount++;
+    }
+}
+
+StreamControllerError getZapStats(ZapStats* stats)
+{
+    if (stats == NULL)
+    {
+        printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+        return SC_ERROR;
+    }
 
-    /* set isInitialized flag */
-    isInitialized = false;
+    *stats = liveController.zapStats;
 
     return SC_NO_ERROR;
 }
 
-StreamControllerError channelUp()
-{   
-    if (programNumber >= patTable->serviceInfoCount - 2)
-    {
-        programNumber = 0;
-    } 
-    else
+void printZapStats(StreamController* controller)
+{
+    PmtPrefetchStats prefetchStats;
+    uint32_t completedCount = 0;
+    double averageZapSeconds = 0;
+    double savedSeconds = 0;
+
+    /* a tune that was avoided or aborted would have taken an average zap */
+    pmtPrefetchGetStats(&prefetchStats);
+    completedCount = prefetchStats.hitCount + prefetchStats.missCount;
+    if (completedCount > 0)
     {
-        programNumber++;
+        averageZapSeconds = (prefetchStats.hitZapSeconds + prefetchStats.missZapSeconds) / completedCount;
+        savedSeconds = (controller->zapStats.avoidedCount + controller->zapStats.abortedCount) * averageZapSeconds - controller->zapStats.abortedSeconds;
     }
 
-    /* set flag to start current channel */
-    changeChannel = true;
-
-    return SC_NO_ERROR;
+    printf("\n%s : INFO zap requests %u, tunes %u, avoided %u, aborted %u, speculative PMT fetches %u, time saved %.3f s\n",
+           __FUNCTION__, controller->zapStats.requestCount, controller->zapStats.tuneCount, controller->zapStats.avoidedCount, controller->zapStats.abortedCount,
+           controller->zapStats.speculativeFetchCount, (savedSeconds > 0) ? savedSeconds : 0);
+    printf("\n%s : INFO player streams reused %u, created %u\n", __FUNCTION__, controller->zapStats.reusedStreamCount,
+           controller->zapStats.createdStreamCount);
 }
 
-StreamControllerError channelDown()
+void notifyChannelChange(StreamController* controller, ChannelChangeStatus status, int32_t channelNumber)
 {
-    if (programNumber <= 0)
+    if (controller->channelChangeCallback != NULL)
     {
-        programNumber = patTable->serviceInfoCount - 2;
-    } 
-    else
+        controller->channelChangeCallback(controller->activeRequestId, status, channelNumber);
+    }
+}
+
+const StreamTypeInfo* lookupStreamType(uint8_t streamType)
+{
+    uint8_t i = 0;
+
+    for (i = 0; i < sizeof(streamTypeTable) / sizeof(streamTypeTable[0]); i++)
     {
-        programNumber--;
+        if (streamTypeTable[i].streamType == streamType)
+        {
+            return &streamTypeTable[i];
+        }
     }
-   
-    /* set flag to start current channel */
-    changeChannel = true;
 
-    return SC_NO_ERROR;
+    return NULL;
 }
 
-StreamControllerError getChannelInfo(ChannelInfo* channelInfo)
+/* First decodable video and first decodable audio stream of a service are selected */
+void selectStream(ServiceStreams* streams, uint16_t pid, uint8_t streamType)
 {
-    if (channelInfo == NULL)
+    const StreamTypeInfo* info = lookupStreamType(streamType);
+
+    if (info == NULL)
     {
-        printf("\n Error wrong parameter\n", __FUNCTION__);
-        return SC_ERROR;
+        return;
+    }
+
+    if (info->isVideo && (streams->videoPid == -1))
+    {
+        streams->videoPid = pid;
+        streams->videoCodec = info->codec;
+        streams->videoStreamType = streamType;
+    }
+    else if (!info->isVideo && (streams->audioPid == -1))
+    {
+        streams->audioPid = pid;
+        streams->audioCodec = info->codec;
     }
-    
-    channelInfo->programNumber = currentChannel.programNumber;
-    channelInfo->audioPid = currentChannel.audioPid;
-    channelInfo->videoPid = currentChannel.videoPid;
-    
-    return SC_NO_ERROR;
 }
 
-/* Sets filter to receive current channel PMT table
- * Parses current channel PMT table when it arrives
- * Creates streams with current channel audio and video pids
- */
-void startChannel(int32_t channelNumber)
+void selectServiceStreams(const PmtTable* pmtTable, ServiceStreams* streams)
 {
-    /* free PAT table filter */
-    Demux_Free_Filter(playerHandle, filterHandle);
-    
-    /* set demux filter for receive PMT table of program */
-    if(Demux_Set_Filter(playerHandle, patTable->patServiceInfoArray[channelNumber + 1].pid, 0x02, &filterHandle))
-	{
-		printf("\n%s : ERROR Demux_Set_Filter() fail\n", __FUNCTION__);
-        return;
-	}
-    
-    /* wait for a PMT table to be parsed*/
-    pthread_mutex_lock(&demuxMutex);
-	if (ETIMEDOUT == pthread_cond_wait(&demuxCond, &demuxMutex))
-	{
-		printf("\n%s : ERROR Lock timeout exceeded!\n", __FUNCTION__);
-        streamControllerDeinit();
-	}
-	pthread_mutex_unlock(&demuxMutex);
-    
-    /* get audio and video pids */
-    int16_t audioPid = -1;
-    int16_t videoPid = -1;
     uint8_t i = 0;
+
+    streams->videoPid = -1;
+    streams->videoCodec = 0;
+    streams->videoStreamType = 0;
+    streams->audioPid = -1;
+    streams->audioCodec = 0;
+
     for (i = 0; i < pmtTable->elementaryInfoCount; i++)
     {
-        if (((pmtTable->pmtElementaryInfoArray[i].streamType == 0x1) || (pmtTable->pmtElementaryInfoArray[i].streamType == 0x2) || (pmtTable->pmtElementaryInfoArray[i].streamType == 0x1b))
-            && (videoPid == -1))
-        {
-            videoPid = pmtTable->pmtElementaryInfoArray[i].elementaryPid;
-        } 
-        else if (((pmtTable->pmtElementaryInfoArray[i].streamType == 0x3) || (pmtTable->pmtElementaryInfoArray[i].streamType == 0x4))
-            && (audioPid == -1))
-        {
-            audioPid = pmtTable->pmtElementaryInfoArray[i].elementaryPid;
-        }
+        selectStream(streams, pmtTable->pmtElementaryInfoArray[i].elementaryPid, pmtTable->pmtElementaryInfoArray[i].streamType);
     }
+}
+
+/* Applies PAT and PMT versions found by SI monitor while the channel plays */
+void applySiChanges(StreamController* controller)
+{
+    SiMonitorChange change = SI_MONITOR_NO_CHANGE;
+    struct timespec detected;
+    uint64_t applyStart = 0;
 
-    if (videoPid != -1) 
+    while ((change = siMonitorTakeChange(&controller->siMonitor, controller->acquiredSection, &detected)) != SI_MONITOR_NO_CHANGE)
     {
-        /* remove previous video stream */
-        if (streamHandleV != 0)
+        applyStart = threadCpuNanoseconds();
+        if (change == SI_MONITOR_PAT_CHANGED)
         {
-		    Player_Stream_Remove(playerHandle, sourceHandle, streamHandleV);
-            streamHandleV = 0;
+            applyPatChange(controller);
         }
-
-        /* create video stream */
-        if(Player_Stream_Create(playerHandle, sourceHandle, videoPid, VIDEO_TYPE_MPEG2, &streamHandleV))
+        else
         {
-            printf("\n%s : ERROR Cannot create video stream\n", __FUNCTION__);
-            streamControllerDeinit();
+            applyPmtChange(controller);
         }
+        siMonitorChangeApplied(&controller->siMonitor, &detected, threadCpuNanoseconds() - applyStart);
+    }
 }
-	else
-	{
-	Player_Stream_Remove(playerHandle, sourceHandle, streamHandleV);
-            streamHandleV = 0;
-	   MV_PE_ClearScreen(playerHandle,1);
-	
-	}
-    
 
-    if (audioPid != -1)
-    {   
-        /* remove previos audio stream */
-        if (streamHandleA != 0)
-        {
-            Player_Stream_Remove(playerHandle, sourceHandle, streamHandleA);
-            streamHandleA = 0;
-        }
+/* Finds current service in new PAT, moves PMT filter when its pid changed */
+void applyPatChange(StreamController* controller)
+{
+    uint16_t serviceProgramNumber = controller->patTable->patServiceInfoArray[controller->programNumber + 1].programNumber;
+    uint16_t pmtPid = controller->patTable->patServiceInfoArray[controller->programNumber + 1].pid;
+    uint8_t i = 0;
+
+    if (parsePatTable(controller->acquiredSection, controller->patTable) != TABLES_PARSE_OK)
+    {
+        printf("\n%s : ERROR parsing PAT\n", __FUNCTION__);
+        return;
+    }
+    printf("\n%s : INFO PAT version %d\n", __FUNCTION__, controller->patTable->patHeader.versionNumber);
 
-	    /* create audio stream */
-        if(Player_Stream_Create(playerHandle, sourceHandle, audioPid, AUDIO_TYPE_MPEG_AUDIO, &streamHandleA))
+    /* cached PMTs may describe services that are gone */
+    if (controller->decoding)
+    {
+        pmtPrefetchReset();
+    }
+
+    /* index 0 is the network pid */
+    for (i = 1; i < controller->patTable->serviceInfoCount; i++)
+    {
+        if (controller->patTable->patServiceInfoArray[i].programNumber == serviceProgramNumber)
         {
-            printf("\n%s : ERROR Cannot create audio stream\n", __FUNCTION__);
-            streamControllerDeinit();
+            break;
         }
     }
-    
-    /* store current channel info */
-    currentChannel.programNumber = channelNumber + 1;
-    currentChannel.audioPid = audioPid;
-    currentChannel.videoPid = videoPid;
 
-	if (timeTablesRecieved == false)
-	{
-		parseTimeTables();
-	}
+    if (i == controller->patTable->serviceInfoCount)
+    {
+        /* streams keep playing until the user zaps away */
+        printf("\n%s : INFO service %d removed from PAT\n", __FUNCTION__, serviceProgramNumber);
+        siMonitorWatchPmt(&controller->siMonitor, SI_MONITOR_NO_PROGRAM, SI_MONITOR_UNKNOWN_VERSION);
+        return;
+    }
+
+    controller->programNumber = i - 1;
+    pthread_mutex_lock(&controller->publishMutex);
+    controller->currentChannel.programNumber = i;
+    publishChannel(controller);
+    pthread_mutex_unlock(&controller->publishMutex);
+
+    if (controller->patTable->patServiceInfoArray[i].pid != pmtPid)
+    {
+        printf("\n%s : INFO PMT of service %d moved to pid %d\n", __FUNCTION__, serviceProgramNumber, controller->patTable->patServiceInfoArray[i].pid);
+        setPmtFilter(controller, controller->patTable->patServiceInfoArray[i].pid, serviceProgramNumber);
+
+        /* version numbering restarts on new pid, first PMT from it is applied */
+        siMonitorWatchPmt(&controller->siMonitor, serviceProgramNumber, SI_MONITOR_UNKNOWN_VERSION);
+    }
+
+    if (controller->decoding)
+    {
+        updatePrefetch(controller, controller->programNumber);
+    }
 }
 
-StreamControllerError parseTimeTables()
+/* Parses new PMT of current service, player streams that did not change keep running */
+void applyPmtChange(StreamController* controller)
 {
-	struct timeval tempTime;
+    ServiceStreams streams;
 
-	/* free previous table filter */
-    Demux_Free_Filter(playerHandle, filterHandle);
+    if (parsePmtTable(controller->acquiredSection, controller->pmtTable) != TABLES_PARSE_OK)
+    {
+        printf("\n%s : ERROR parsing PMT\n", __FUNCTION__);
+        return;
+    }
+    printf("\n%s : INFO PMT of channel %d version %d\n", __FUNCTION__, controller->programNumber + 1, controller->pmtTable->pmtHeader.versionNumber);
 
-	/* set demux filter for receive TDT table of program */
-    if(Demux_Set_Filter(playerHandle, 0x0014, 0x70, &filterHandle))
-	{
-		printf("\n%s : ERROR Demux_Set_Filter() fail\n", __FUNCTION__);
-        return SC_ERROR;
-	}
+    /* playService removes, replaces or adds only streams whose pid or codec differ */
+    selectServiceStreams(controller->pmtTable, &streams);
+    playService(controller, controller->programNumber, controller->patTable->patServiceInfoArray[controller->programNumber + 1].pid,
+                controller->pmtTable->pmtHeader.pcrPid, &streams);
 
-	/* wait for a TDT table to be parsed*/
-    pthread_mutex_lock(&demuxMutex);
-	if (ETIMEDOUT == pthread_cond_wait(&demuxCond, &demuxMutex))
-	{
-		printf("\n%s : ERROR Lock timeout exceeded!\n", __FUNCTION__);
-        streamControllerDeinit();
-	}	
-	pthread_mutex_unlock(&demuxMutex);
+    if (controller->decoding)
+    {
+        storeLiveService(controller, controller->programNumber);
+    }
+}
 
-	gettimeofday(&tempTime, NULL);
+uint64_t threadCpuNanoseconds()
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+void printSiMonitorStats(StreamController* controller)
+{
+    SiMonitorStats stats;
+
+    siMonitorGetStats(&controller->siMonitor, &stats);
+    printf("\n%s : INFO sections checked %u (%.1f us CPU each), PAT changes %u, PMT changes %u\n", __FUNCTION__,
+           stats.sectionCount, (stats.sectionCount > 0) ? stats.checkNanoseconds / 1000.0 / stats.sectionCount : 0,
+           stats.patChangeCount, stats.pmtChangeCount);
+    printf("\n%s : INFO changes applied in %.3f ms CPU, last reaction %u ms, worst case %u ms\n", __FUNCTION__,
+           stats.applyNanoseconds / 1e6, stats.lastReactionMilliseconds, stats.maxReactionMilliseconds);
+}
+
+void reportBootTime(const char* source)
+{
+    if (bootReported)
+    {
+        return;
+    }
+    bootReported = true;
 
-	/* free TDT table filter */
-    Demux_Free_Filter(playerHandle, filterHandle);
+    printf("\n%s : INFO boot to picture %.3f s, pids from %s\n", __FUNCTION__, secondsSince(&bootTime), source);
+    startupTraceMark("first picture");
+}
 
-	/* set demux filter for receive TOT table of program */
-    if(Demux_Set_Filter(playerHandle, 0x0014, 0x73, &filterHandle))
+StreamControllerError parseTimeTables(StreamController* controller)
+{
+	struct timeval tempTime;
+	TableRequest timeRequest;
+
+	/* TDT and TOT are repeated at most every 30 s */
+	timeRequest.pid = 0x0014;
+	timeRequest.tableId = 0x70;
+	timeRequest.tableIdExtension = TABLE_ACQUISITION_ANY_EXTENSION;
+	timeRequest.timeout = TIME_TABLE_TIMEOUT;
+	timeRequest.retries = 0;
+	timeRequest.backoff = 0;
+
+	/* wait for a TDT table */
+	if (tableAcquire(&controller->acquisition, &timeRequest, controller->acquiredSection, NULL) != TA_NO_ERROR ||
+		parseTdtTable(controller->acquiredSection, controller->tdtTable) != TABLES_PARSE_OK)
 	{
-		printf("\n%s : ERROR Demux_Set_Filter() fail\n", __FUNCTION__);
-        return SC_ERROR;
+		printf("\n%s : ERROR TDT not received\n", __FUNCTION__);
+		return SC_ERROR;
 	}
+	printTdtTable(controller->tdtTable);
+
+	gettimeofday(&tempTime, NULL);
 
-	/* wait for a TDT table to be parsed*/
-    pthread_mutex_lock(&demuxMutex);
-	if (ETIMEDOUT == pthread_cond_wait(&demuxCond, &demuxMutex))
+	/* wait for a TOT table */
+	timeRequest.tableId = 0x73;
+	if (tableAcquire(&controller->acquisition, &timeRequest, controller->acquiredSection, NULL) != TA_NO_ERROR ||
+		parseTotTable(controller->acquiredSection, controller->totTable) != TABLES_PARSE_OK)
 	{
-		printf("\n%s : ERROR Lock timeout exceeded!\n", __FUNCTION__);
-        streamControllerDeinit();
+		printf("\n%s : ERROR TOT not received\n", __FUNCTION__);
+		return SC_ERROR;
 	}
-	pthread_mutex_unlock(&demuxMutex);
+	printTotTable(controller->totTable);
 
-	uint8_t offsetHours = totTable->descriptors[0].ltoInfo[0].localTimeOffsetHours;
-	uint8_t offsetMinutes = totTable->descriptors[0].ltoInfo[0].localTimeOffsetMinutes;
+	uint8_t offsetHours = controller->totTable->descriptors[0].ltoInfo[0].localTimeOffsetHours;
+	uint8_t offsetMinutes = controller->totTable->descriptors[0].ltoInfo[0].localTimeOffsetMinutes;
 	
-	/*startTime.hours = tdtTable->hours;
-	startTime.minutes = tdtTable->minutes;
-	startTime.seconds = tdtTable->seconds;
+	/*startTime.hours = controller->tdtTable->hours;
+	startTime.minutes = controller->tdtTable->minutes;
+	startTime.seconds = controller->tdtTable->seconds;
 	startTime.timeStampSeconds = tempTime.tv_sec;*/
 /*
-	if (totTable->descriptors[0].ltoInfo[0].localTimeOffsetPolarity == 0)
+	if (controller->totTable->descriptors[0].ltoInfo[0].localTimeOffsetPolarity == 0)
 	{
 		startTime.hours += offsetHours;
 		startTime.minutes += offsetMinutes;
@@ -311,7 +1683,7 @@ StreamControllerError parseTimeTables()
 			startTime.minutes -= 60;
 		}
 	}
-	else if (totTable->descriptors[0].ltoInfo[0].localTimeOffsetPolarity == 1)
+	else if (controller->totTable->descriptors[0].ltoInfo[0].localTimeOffsetPolarity == 1)
 	{
 		if (offsetHours > startTime.hours)
 		{
@@ -332,233 +1704,434 @@ StreamControllerError parseTimeTables()
 		}
 	}*/
 
-	currentDate.Year = tdtTable->Year;
-	currentDate.tmpMonth = tdtTable->tmpMonth;
-	currentDate.day = tdtTable->day;
-	dateRecievedCallback(&currentDate);
+	controller->currentDate.Year = controller->tdtTable->Year;
+	controller->currentDate.tmpMonth = controller->tdtTable->tmpMonth;
+	controller->currentDate.day = controller->tdtTable->day;
+	if (controller->dateRecievedCallback != NULL)
+	{
+		controller->dateRecievedCallback(&controller->currentDate);
+	}
 
-	timeTablesRecieved = true;
+	controller->timeTablesRecieved = true;
 }
 
 
-void* streamControllerTask()
+void* streamControllerTask(void* arg)
 {
-    gettimeofday(&now,NULL);
-    lockStatusWaitTime.tv_sec = now.tv_sec+10;
+    StreamController* controller = (StreamController*) arg;
+    TableRequest patRequest;
+    FilterRequest patFilter;
+    uint8_t patFilterRequest = 0;
+    uint8_t filterSlots = (controller->configFile.filterSlots > 0) ? controller->configFile.filterSlots : FILTER_SCHEDULER_DEFAULT_SLOTS;
+    int32_t lockTrace = -1;
+    int32_t playerTrace = -1;
+    bool storedChannels = false;
 
     /* allocate memory for PAT table section */
-    patTable=(PatTable*)malloc(sizeof(PatTable));
-    if(patTable==NULL)
+    controller->patTable=(PatTable*)malloc(sizeof(PatTable));
+    if(controller->patTable==NULL)
     {
 		printf("\n%s : ERROR Cannot allocate memory\n", __FUNCTION__);
         return (void*) SC_ERROR;
 	}  
-    memset(patTable, 0x0, sizeof(PatTable));
+    memset(controller->patTable, 0x0, sizeof(PatTable));
 
     /* allocate memory for PMT table section */
-    pmtTable=(PmtTable*)malloc(sizeof(PmtTable));
-    if(pmtTable==NULL)
+    controller->pmtTable=(PmtTable*)malloc(sizeof(PmtTable));
+    if(controller->pmtTable==NULL)
     {
 		printf("\n%s : ERROR Cannot allocate memory\n", __FUNCTION__);
+		freeTables(controller);
         return (void*) SC_ERROR;
 	}
-    memset(pmtTable, 0x0, sizeof(PmtTable));
+    memset(controller->pmtTable, 0x0, sizeof(PmtTable));
 
     /* allocate memory for TDT table section */
-    tdtTable=(TdtTable*)malloc(sizeof(TdtTable));
-    if(tdtTable==NULL)
+    controller->tdtTable=(TdtTable*)malloc(sizeof(TdtTable));
+    if(controller->tdtTable==NULL)
     {
 		printf("\n%s : ERROR Cannot allocate memory\n", __FUNCTION__);
+		freeTables(controller);
         return (void*) SC_ERROR;
 	}  
-    memset(tdtTable, 0x0, sizeof(TdtTable));
+    memset(controller->tdtTable, 0x0, sizeof(TdtTable));
 
     /* allocate memory for TOT table section */
-    totTable=(TotTable*)malloc(sizeof(TotTable));
-    if(totTable==NULL)
+    controller->totTable=(TotTable*)malloc(sizeof(TotTable));
+    if(controller->totTable==NULL)
     {
 		printf("\n%s : ERROR Cannot allocate memory\n", __FUNCTION__);
+		freeTables(controller);
         return (void*) SC_ERROR;
 	}  
-    memset(totTable, 0x0, sizeof(TotTable));
+    memset(controller->totTable, 0x0, sizeof(TotTable));
 
-       
-    /* initialize tuner device */
-    if(Tuner_Init())
-    {
-        printf("\n%s : ERROR Tuner_Init() fail\n", __FUNCTION__);
-        free(patTable);
-        free(pmtTable);
-		free(tdtTable);
-		free(totTable);
-        return (void*) SC_ERROR;
-    }
-    
-    /* register tuner status callback */
-    if(Tuner_Register_Status_Callback(tunerStatusCallback))
-    {
-		printf("\n%s : ERROR Tuner_Register_Status_Callback() fail\n", __FUNCTION__);
-	}
-    
-    /* lock to frequency */
-    if(!Tuner_Lock_To_Frequency(configFile.tuneFrequency, configFile.tuneBandwidth, configFile.tuneModule))
-    {
-        printf("\n%s: INFO Tuner_Lock_To_Frequency(): %d Hz - success!\n",__FUNCTION__, configFile.tuneFrequency);
-    }
-    else
+    /* initialize tuner device and request lock, or join instance already tuned to the same frequency */
+    lockTrace = controller->decoding ? startupTraceBegin("tuner lock") : -1;
+    if (acquireTuner(&controller->configFile))
     {
-        printf("\n%s: ERROR Tuner_Lock_To_Frequency(): %d Hz - fail!\n",__FUNCTION__, configFile.tuneFrequency);
-        free(patTable);
-        free(pmtTable);
-		free(tdtTable);
-		free(totTable);
-        Tuner_Deinit();
-        return (void*) SC_ERROR;
-    }
-    
-    /* wait for tuner to lock */
-    pthread_mutex_lock(&statusMutex);
-    if(ETIMEDOUT == pthread_cond_timedwait(&statusCondition, &statusMutex, &lockStatusWaitTime))
-    {
-        printf("\n%s : ERROR Lock timeout exceeded!\n",__FUNCTION__);
-        free(patTable);
-        free(pmtTable);
-		free(tdtTable);
-		free(totTable);
-        Tuner_Deinit();
+        startupTraceEnd(lockTrace, false);
+        freeTables(controller);
         return (void*) SC_ERROR;
     }
-    pthread_mutex_unlock(&statusMutex);
-   
+
+    /* player is set up while demodulator locks, the two do not depend on each other */
+    playerTrace = controller->decoding ? startupTraceBegin("player init") : -1;
+
     /* initialize player */
-    if(Player_Init(&playerHandle))
+    if(Player_Init(&controller->playerHandle))
     {
 		printf("\n%s : ERROR Player_Init() fail\n", __FUNCTION__);
-		free(patTable);
-        free(pmtTable);
-		free(tdtTable);
-		free(totTable);
-        Tuner_Deinit();
+		startupTraceEnd(playerTrace, false);
+		freeTables(controller);
+        releaseTuner();
         return (void*) SC_ERROR;
 	}
 	
 	/* open source */
-	if(Player_Source_Open(playerHandle, &sourceHandle))
+	if(Player_Source_Open(controller->playerHandle, &controller->sourceHandle))
     {
 		printf("\n%s : ERROR Player_Source_Open() fail\n", __FUNCTION__);
-		free(patTable);
-        free(pmtTable);
-		free(tdtTable);
-		free(totTable);
-		Player_Deinit(playerHandle);
-        Tuner_Deinit();
+		startupTraceEnd(playerTrace, false);
+		freeTables(controller);
+		Player_Deinit(controller->playerHandle);
+        releaseTuner();
         return (void*) SC_ERROR;	
 	}
 
-	/* set PAT pid and tableID to demultiplexer */
-	if(Demux_Set_Filter(playerHandle, 0x00, 0x00, &filterHandle))
+	if (controller->decoding)
 	{
-		printf("\n%s : ERROR Demux_Set_Filter() fail\n", __FUNCTION__);
+		/* map timeshift buffer, it is filled from TS capture, playback continues without it on failure */
+		if (controller->configFile.captureFile[0] != '\0' && controller->configFile.timeshiftSize > 0 &&
+			timeshiftInit(controller->configFile.timeshiftFile, controller->configFile.timeshiftSize))
+		{
+			printf("\n%s : ERROR timeshiftInit() fail, timeshift disabled\n", __FUNCTION__);
+		}
+
+		/* tdp_api has no TS capture, multiplex is read from a file or DVR device instead */
+		if (controller->configFile.captureFile[0] != '\0' && tsFileSourceStart(controller->configFile.captureFile, feedTransportPackets))
+		{
+			printf("\n%s : ERROR tsFileSourceStart() fail, timeshift disabled\n", __FUNCTION__);
+			timeshiftDeinit();
+		}
+
+		storedChannels = (controller->configFile.channelDatabaseFile[0] != '\0') &&
+						 (channelDatabaseMap(&controller->channelDatabase, controller->configFile.channelDatabaseFile) == CDB_NO_ERROR);
 	}
-	
+	startupTraceEnd(playerTrace, true);
+
+	if (waitForTunerLock())
+	{
+		startupTraceEnd(lockTrace, false);
+		if (controller->decoding)
+		{
+			tsFileSourceStop();
+			timeshiftDeinit();
+		}
+		channelDatabaseUnmap(&controller->channelDatabase);
+		freeTables(controller);
+		Player_Source_Close(controller->playerHandle, controller->sourceHandle);
+		Player_Deinit(controller->playerHandle);
+		return (void*) SC_ERROR;
+	}
+	startupTraceEnd(lockTrace, true);
+
+    /* instance that joined a tuned multiplex missed the lock callback */
+    pthread_mutex_lock(&controller->publishMutex);
+    controller->currentChannel.signalLocked = true;
+    controller->currentChannel.lockLossCount = tunerLockLossCount;
+    publishChannel(controller);
+    pthread_mutex_unlock(&controller->publishMutex);
+
+	/* start channel from channel database while PAT and PMT are acquired */
+	if (storedChannels && controller->configFile.fastStart)
+	{
+		startStoredChannel(controller, controller->programNumber);
+	}
+
 	/* register section filter callback */
     if(Demux_Register_Section_Filter_Callback(sectionReceivedCallback))
     {
 		printf("\n%s : ERROR Demux_Register_Section_Filter_Callback() fail\n", __FUNCTION__);
 	}
 
-    pthread_mutex_lock(&demuxMutex);
-	if (ETIMEDOUT == pthread_cond_wait(&demuxCond, &demuxMutex))
+	/* set PAT pid and tableID to demultiplexer and wait for PAT */
+	patRequest.pid = 0x0000;
+	patRequest.tableId = 0x00;
+	patRequest.tableIdExtension = TABLE_ACQUISITION_ANY_EXTENSION;
+	patRequest.timeout = PSI_TIMEOUT;
+	patRequest.retries = PSI_RETRIES;
+	patRequest.backoff = PSI_BACKOFF;
+
+	/* one section filter is left to table acquisition, the others are shared by monitored and prefetched tables */
+	if (tableAcquisitionInit(&controller->acquisition, controller->playerHandle) == TA_NO_ERROR &&
+		filterSchedulerInit(&controller->filterScheduler, controller->playerHandle, (filterSlots > 1) ? filterSlots - 1 : 1) == FS_NO_ERROR)
 	{
-		printf("\n%s:ERROR Lock timeout exceeded!\n", __FUNCTION__);
-        free(patTable);
-        free(pmtTable);
-		free(tdtTable);
-		free(totTable);
-		Player_Deinit(playerHandle);
-        Tuner_Deinit();
+		setAcquisitionReady(controller, true);
+	}
+
+	if (!controller->acquisitionReady ||
+		tableAcquire(&controller->acquisition, &patRequest, controller->acquiredSection, NULL) ||
+		parsePatTable(controller->acquiredSection, controller->patTable) != TABLES_PARSE_OK)
+	{
+		printf("\n%s : ERROR PAT not received\n", __FUNCTION__);
+		setAcquisitionReady(controller, false);
+		tableAcquisitionDeinit(&controller->acquisition);
+		filterSchedulerDeinit(&controller->filterScheduler);
+		if (controller->decoding)
+		{
+			tsFileSourceStop();
+			timeshiftDeinit();
+		}
+		channelDatabaseUnmap(&controller->channelDatabase);
+		freeTables(controller);
+		Player_Source_Close(controller->playerHandle, controller->sourceHandle);
+		Player_Deinit(controller->playerHandle);
+        releaseTuner();
         return (void*) SC_ERROR;
 	}
-	pthread_mutex_unlock(&demuxMutex);
+	if (controller->decoding)
+	{
+		pmtPrefetchReset();
+	}
+
+	/* PAT filter stays set, newer versions are applied while channels play */
+	patFilter.pid = 0x0000;
+	patFilter.tableId = 0x00;
+	patFilter.tableIdExtension = FILTER_SCHEDULER_ANY_EXTENSION;
+	patFilter.priority = FILTER_PRIORITY_PAT;
+	patFilter.repetitionInterval = PSI_TIMEOUT;
+	patFilter.refreshInterval = 0;
+	if (filterSchedulerAdd(&controller->filterScheduler, &patFilter, &patFilterRequest) == FS_NO_ERROR)
+	{
+		controller->patFilterRequest = patFilterRequest;
+	}
+	siMonitorWatchPat(&controller->siMonitor, controller->patTable->patHeader.versionNumber);
+	if (controller->decoding)
+	{
+		addEpgFilters(controller);
+	}
     
     /* start current channel */
-    startChannel(programNumber);
+    startChannel(controller, controller->programNumber);
     
     /* set isInitialized flag */
-    isInitialized = true;
+    controller->isInitialized = true;
+
+    while(!controller->threadExit)
+    {
+        processChannelChanges(controller);
+    }
+
+    return (void*) SC_NO_ERROR;
+}
+
+/* Runs on driver thread, section is only copied so delivery to other filters is not stalled */
+int32_t sectionReceivedCallback(uint8_t *buffer)
+{
+    uint64_t start = monotonicNanoseconds();
+
+    if (sectionQueuePush(&sectionQueue, buffer))
+    {
+        sem_post(&sectionSemaphore);
+    }
+    addSectionTiming(&callbackTiming, monotonicNanoseconds() - start);
+
+    return 0;
+}
+
+void* sectionWorkerTask(void* arg)
+{
+    uint8_t* section = NULL;
+    uint64_t start = 0;
 
-    while(!threadExit)
+    while (!__atomic_load_n(&sectionWorkerExit, __ATOMIC_ACQUIRE))
     {
-        if (changeChannel)
+        sem_wait(&sectionSemaphore);
+
+        while ((section = sectionQueueFront(&sectionQueue)) != NULL)
         {
-            changeChannel = false;
-            startChannel(programNumber);
+            start = monotonicNanoseconds();
+            dispatchSection(section);
+            addSectionTiming(&dispatchTiming, monotonicNanoseconds() - start);
+            sectionQueuePop(&sectionQueue);
         }
     }
+
+    return NULL;
 }
 
-int32_t sectionReceivedCallback(uint8_t *buffer)
+void dispatchSection(uint8_t* section)
 {
-    uint8_t tableId = *buffer;  
-    if(tableId==0x00)
+    EpgCallback epgCallbacks[STREAM_CONTROLLER_MAX_INSTANCES];
+    uint8_t epgCallbackCount = 0;
+    uint8_t tableId = *section;
+    uint8_t i = 0;
+
+    /* tdp_api has one section callback for all filters, every instance matches section against its own acquisition
+     * and takes its own copy, tables are parsed by the waiting threads
+     */
+    pthread_mutex_lock(&controllersMutex);
+    for (i = 0; i < STREAM_CONTROLLER_MAX_INSTANCES; i++)
     {
-        printf("\n%s -----PAT TABLE ARRIVED-----\n",__FUNCTION__);
-        
-        if(parsePatTable(buffer,patTable)==TABLES_PARSE_OK)
+        if (controllers[i] != NULL && controllers[i]->acquisitionReady)
         {
-            //printPatTable(patTable);
-            pthread_mutex_lock(&demuxMutex);
-		    pthread_cond_signal(&demuxCond);
-		    pthread_mutex_unlock(&demuxMutex);
+            tableAcquisitionSectionReceived(&controllers[i]->acquisition, section);
+            filterSchedulerSectionReceived(&controllers[i]->filterScheduler, section);
+
+            /* only version_number is checked here, changed tables are parsed and applied by the task */
+            if (siMonitorSectionReceived(&controllers[i]->siMonitor, section))
+            {
+                pthread_mutex_lock(&controllers[i]->channelChangeMutex);
+                pthread_cond_signal(&controllers[i]->channelChangeCond);
+                pthread_mutex_unlock(&controllers[i]->channelChangeMutex);
+            }
+
+            if (controllers[i]->epgCallback != NULL)
+            {
+                epgCallbacks[epgCallbackCount++] = controllers[i]->epgCallback;
+            }
         }
-    } 
-    else if (tableId==0x02)
+    }
+    pthread_mutex_unlock(&controllersMutex);
+
+    /* PMTs of prefetched channels arrive on the same callback, other tables are parsed by waiting threads */
+    if (tableId == 0x02)
     {
-        printf("\n%s -----PMT TABLE ARRIVED-----\n",__FUNCTION__);
-        
-        if(parsePmtTable(buffer,pmtTable)==TABLES_PARSE_OK)
+        PmtTable receivedPmt;
+
+        /* current PMT repeats several times a second, it is parsed only when it is not cached yet or its version changed */
+        if (!pmtPrefetchRefresh((uint16_t)((section[3] << 8) | section[4]), (section[5] >> 1) & 0x1F) &&
+            parsePmtTable(section, &receivedPmt) == TABLES_PARSE_OK)
         {
-            //printPmtTable(pmtTable);
-            pthread_mutex_lock(&demuxMutex);
-		    pthread_cond_signal(&demuxCond);
-		    pthread_mutex_unlock(&demuxMutex);
+            pmtPrefetchStore(&receivedPmt);
         }
     }
-	else if (tableId == 0x70)
+	else if (tableId == 0x4E || ((tableId >= 0x50 && tableId <= 0x5F) && epgCallbackCount > 0))
 	{
-		printf("\n%s -----TDT TABLE ARRIVED-----\n",__FUNCTION__);
+		EitTable receivedEit;
 
-		if (parseTdtTable(buffer, tdtTable) == TABLES_PARSE_OK)
+		if (parseEitTable(section, &receivedEit) == TABLES_PARSE_OK)
 		{
-			printTdtTable(tdtTable);
-			pthread_mutex_lock(&demuxMutex);
-		    pthread_cond_signal(&demuxCond);
-		    pthread_mutex_unlock(&demuxMutex);
-		}
-	}
-	else if (tableId == 0x73)
-	{
-		printf("\n%s -----TOT TABLE ARRIVED-----\n",__FUNCTION__);
+			if (tableId == 0x4E)
+			{
+				publishEvent(&receivedEit);
+			}
 
-		if (parseTotTable(buffer, totTable) == TABLES_PARSE_OK)
-		{
-			printTotTable(totTable);
-			pthread_mutex_lock(&demuxMutex);
-		    pthread_cond_signal(&demuxCond);
-		    pthread_mutex_unlock(&demuxMutex);
+			/* guide is updated outside controllersMutex, callbacks may draw */
+			for (i = 0; i < epgCallbackCount; i++)
+			{
+				epgCallbacks[i](&receivedEit);
+			}
 		}
 	}
+}
 
-    return 0;
+/* Section 0 of EIT present/following carries running event of a service and section 1 the next one,
+ * they become now/next of every instance playing that service
+ */
+void publishEvent(const EitTable* eitTable)
+{
+    EitEventInfo event;
+    uint8_t i = 0;
+
+    if (eitTable->sectionNumber > 1)
+    {
+        return;
+    }
+
+    /* section without event clears it, nothing is scheduled */
+    memset(&event, 0x0, sizeof(EitEventInfo));
+    if (eitTable->eventInfoCount > 0)
+    {
+        event = eitTable->eitEventInfoArray[0];
+    }
+
+    pthread_mutex_lock(&controllersMutex);
+    for (i = 0; i < STREAM_CONTROLLER_MAX_INSTANCES; i++)
+    {
+        if (controllers[i] != NULL)
+        {
+            EitEventInfo* published = NULL;
+
+            pthread_mutex_lock(&controllers[i]->publishMutex);
+            published = (eitTable->sectionNumber == 0) ? &controllers[i]->currentChannel.nowEvent : &controllers[i]->currentChannel.nextEvent;
+            /* p/f repeats every few seconds, readers retry only when event really changed */
+            if ((controllers[i]->currentChannel.serviceId == eitTable->serviceId) &&
+                ((published->eventId != event.eventId) || (published->startTime != event.startTime) ||
+                 (published->duration != event.duration) || strcmp(published->eventName, event.eventName)))
+            {
+                *published = event;
+                publishChannel(controllers[i]);
+            }
+            pthread_mutex_unlock(&controllers[i]->publishMutex);
+        }
+    }
+    pthread_mutex_unlock(&controllersMutex);
+}
+
+void addSectionTiming(SectionTiming* timing, uint64_t nanoseconds)
+{
+    __atomic_fetch_add(&timing->count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&timing->totalNanoseconds, nanoseconds, __ATOMIC_RELAXED);
+    if (nanoseconds > __atomic_load_n(&timing->maxNanoseconds, __ATOMIC_RELAXED))
+    {
+        __atomic_store_n(&timing->maxNanoseconds, nanoseconds, __ATOMIC_RELAXED);
+    }
+}
+
+uint64_t monotonicNanoseconds()
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+/* Dispatch time is what the callback cost when sections were parsed on driver thread */
+void printSectionQueueStats()
+{
+    SectionQueueStats stats;
+
+    sectionQueueGetStats(&sectionQueue, &stats);
+    printf("\n%s : INFO sections queued %u, pool overflows %u, oversized %u, most cells in use %u of %d\n", __FUNCTION__,
+           stats.pushedCount, stats.overflowCount, stats.oversizeCount, stats.highWater, SECTION_QUEUE_SIZE);
+    printf("\n%s : INFO callback avg %.1f us, worst case %.1f us, dispatch avg %.1f us, worst case %.1f us\n", __FUNCTION__,
+           (callbackTiming.count > 0) ? callbackTiming.totalNanoseconds / 1000.0 / callbackTiming.count : 0, callbackTiming.maxNanoseconds / 1000.0,
+           (dispatchTiming.count > 0) ? dispatchTiming.totalNanoseconds / 1000.0 / dispatchTiming.count : 0, dispatchTiming.maxNanoseconds / 1000.0);
 }
 
-int32_t tunerStatusCallback(t_LockStatus status)
-{
+int32_t tunerStatusCallback(t_LockStatus status)
+{
+    uint8_t i = 0;
+
+    pthread_mutex_lock(&statusMutex);
+    if (tunerLocked && (status != STATUS_LOCKED))
+    {
+        tunerLockLossCount++;
+    }
+    tunerLocked = (status == STATUS_LOCKED);
+    pthread_cond_broadcast(&statusCondition);
+    pthread_mutex_unlock(&statusMutex);
+
+    /* every instance shares the tuner */
+    pthread_mutex_lock(&controllersMutex);
+    for (i = 0; i < STREAM_CONTROLLER_MAX_INSTANCES; i++)
+    {
+        if (controllers[i] != NULL)
+        {
+            pthread_mutex_lock(&controllers[i]->publishMutex);
+            controllers[i]->currentChannel.signalLocked = (status == STATUS_LOCKED);
+            controllers[i]->currentChannel.lockLossCount = tunerLockLossCount;
+            publishChannel(controllers[i]);
+            pthread_mutex_unlock(&controllers[i]->publishMutex);
+        }
+    }
+    pthread_mutex_unlock(&controllersMutex);
+
     if(status == STATUS_LOCKED)
     {
-        pthread_mutex_lock(&statusMutex);
-        pthread_cond_signal(&statusCondition);
-        pthread_mutex_unlock(&statusMutex);
         printf("\n%s -----TUNER LOCKED-----\n",__FUNCTION__);
     }
     else
@@ -570,13 +2143,59 @@ int32_t tunerStatusCallback(t_LockStatus status)
 
 StreamControllerError loadInitialInfo()
 {
-	if (loadConfigFile("config.ini", &configFile))
+	if (loadConfigFile("config.ini", &initialInfo))
 	{
 		printf("ERROR loading configuration file!\n");
 		return SC_ERROR;
 	}
 
-	programNumber = configFile.programNumber;
+	return SC_NO_ERROR;
+}
+
+const char* getRecordingPath()
+{
+	return initialInfo.recordingFile;
+}
+
+const char* getChannelDatabasePath()
+{
+	return initialInfo.channelDatabaseFile;
+}
+
+uint32_t getTuneFrequency()
+{
+	return initialInfo.tuneFrequency;
+}
+
+StreamControllerError scanChannels(char* const* files, uint8_t fileCount)
+{
+	static ChannelDatabase database;
+	ChannelScanError scanResult = CS_NO_ERROR;
+
+	channelDatabaseClear(&database);
+
+	if (files != NULL)
+	{
+		scanResult = channelScanFiles(files, fileCount, &database);
+	}
+	else
+	{
+		scanResult = channelScanFrequencies(initialInfo.scanFrequencies, initialInfo.scanFrequencyCount,
+											initialInfo.tuneBandwidth, initialInfo.tuneModule, &database);
+	}
+
+	if (scanResult)
+	{
+		printf("\n%s : ERROR channel scan failed\n", __FUNCTION__);
+		return SC_ERROR;
+	}
+
+	channelDatabasePrint(&database);
+
+	if (channelDatabaseSave(&database, initialInfo.channelDatabaseFile))
+	{
+		return SC_ERROR;
+	}
 
 	return SC_NO_ERROR;
 }
@@ -616,7 +2235,7 @@ StreamControllerError loadConfigFile(char* filename, InitialInfo* configInfo)
 			singleWord = strtok(NULL, "-");
 			removeWhiteSpaces(singleWord);
 
-			if (strcmp(singleWord, "DVB_T"))
+			if (strcmp(singleWord, "DVB_T") == 0)
 			{
 				configInfo->tuneModule = DVB_T;
 			}
@@ -632,6 +2251,96 @@ StreamControllerError loadConfigFile(char* filename, InitialInfo* configInfo)
 			removeWhiteSpaces(singleWord);
 			configInfo->programNumber = atoi(singleWord);
 		}
+		else if (strcmp(singleWord, "timeshift_file") == 0)
+		{
+			singleWord = strtok(NULL, "-");
+			removeWhiteSpaces(singleWord);
+			strncpy(configInfo->timeshiftFile, singleWord, LINE_LENGTH - 1);
+			configInfo->timeshiftFile[LINE_LENGTH - 1] = '\0';
+		}
+		else if (strcmp(singleWord, "recording_file") == 0)
+		{
+			singleWord = strtok(NULL, "-");
+			removeWhiteSpaces(singleWord);
+			strncpy(configInfo->recordingFile, singleWord, LINE_LENGTH - 1);
+			configInfo->recordingFile[LINE_LENGTH - 1] = '\0';
+		}
+		else if (strcmp(singleWord, "scan_frequencies") == 0)
+		{
+			char* frequency = NULL;
+			char* end = NULL;
+
+			singleWord = strtok(NULL, "-");
+			removeWhiteSpaces(singleWord);
+			/* list may continue on next scan_frequencies line */
+			for (frequency = singleWord; *frequency != '\0' && configInfo->scanFrequencyCount < CHANNEL_SCAN_MAX_FREQUENCIES; frequency = end + 1)
+			{
+				configInfo->scanFrequencies[configInfo->scanFrequencyCount++] = strtoul(frequency, &end, 10);
+				if (*end != ',')
+				{
+					break;
+				}
+			}
+		}
+		else if (strcmp(singleWord, "zap_settle_time") == 0)
+		{
+			singleWord = strtok(NULL, "-");
+			removeWhiteSpaces(singleWord);
+			configInfo->zapSettleTime = atoi(singleWord);
+		}
+		else if (strcmp(singleWord, "filter_slots") == 0)
+		{
+			singleWord = strtok(NULL, "-");
+			removeWhiteSpaces(singleWord);
+			configInfo->filterSlots = atoi(singleWord);
+			if (configInfo->filterSlots > FILTER_SCHEDULER_MAX_SLOTS + 1)
+			{
+				configInfo->filterSlots = FILTER_SCHEDULER_MAX_SLOTS + 1;
+			}
+		}
+		else if (strcmp(singleWord, "prefetch_count") == 0)
+		{
+			singleWord = strtok(NULL, "-");
+			removeWhiteSpaces(singleWord);
+			configInfo->prefetchCount = atoi(singleWord);
+			if (configInfo->prefetchCount > PMT_PREFETCH_MAX_NEIGHBOURS)
+			{
+				configInfo->prefetchCount = PMT_PREFETCH_MAX_NEIGHBOURS;
+			}
+		}
+		else if (strcmp(singleWord, "fast_start") == 0)
+		{
+			singleWord = strtok(NULL, "-");
+			removeWhiteSpaces(singleWord);
+			configInfo->fastStart = (atoi(singleWord) != 0);
+		}
+		else if (strcmp(singleWord, "channel_database") == 0)
+		{
+			singleWord = strtok(NULL, "-");
+			removeWhiteSpaces(singleWord);
+			strncpy(configInfo->channelDatabaseFile, singleWord, LINE_LENGTH - 1);
+			configInfo->channelDatabaseFile[LINE_LENGTH - 1] = '\0';
+		}
+		else if (strcmp(singleWord, "timeshift_size") == 0)
+		{
+			singleWord = strtok(NULL, "-");
+			removeWhiteSpaces(singleWord);
+			configInfo->timeshiftSize = atoi(singleWord);
+		}
+		else if (strcmp(singleWord, "capture_file") == 0)
+		{
+			singleWord = strtok(NULL, "-");
+			removeWhiteSpaces(singleWord);
+			strncpy(configInfo->captureFile, singleWord, LINE_LENGTH - 1);
+			configInfo->captureFile[LINE_LENGTH - 1] = '\0';
+		}
+		else if (strcmp(singleWord, "playback_file") == 0)
+		{
+			singleWord = strtok(NULL, "-");
+			removeWhiteSpaces(singleWord);
+			strncpy(configInfo->playbackFile, singleWord, LINE_LENGTH - 1);
+			configInfo->playbackFile[LINE_LENGTH - 1] = '\0';
+		}
 	}
 
 	fclose(inputFile);
@@ -652,12 +2361,13 @@ static void removeWhiteSpaces(char* word)
 		i++;
 	}
 
-	while ((startString[k] == 32) & (startString[k] != '\0'))
+	/* trailing spaces and line ending */
+	while ((k >= i) && ((startString[k] == 32) || (startString[k] == '\n') || (startString[k] == '\r')))
 	{
 		k--;
 	}
 
-	for (j = 0; j < (k - i); j++)
+	for (j = 0; j <= (k - i); j++)
 	{
 		word[j] = startString[j+i];
 	}
@@ -667,15 +2377,18 @@ static void removeWhiteSpaces(char* word)
 
 void changeChannelKey(int32_t channelNumber)
 {
-	if ((channelNumber > -1) && (channelNumber < patTable->serviceInfoCount))
-	{
-		startChannel(channelNumber);
-	}
+	/* number is checked against PAT on stream controller task */
+	channelChangeRequest(channelNumber);
 }
 
 StreamControllerError registerDateCallback(DateCallback dateCallback)
 {
-	if (dateCallback == NULL)
+	return streamControllerRegisterDateCallback(&liveController, dateCallback);
+}
+
+StreamControllerError streamControllerRegisterDateCallback(StreamController* controller, DateCallback dateCallback)
+{
+	if (controller == NULL || dateCallback == NULL)
 	{
 		printf("Error registring time callback!\n");
 		return SC_ERROR;
@@ -683,7 +2396,7 @@ StreamControllerError registerDateCallback(DateCallback dateCallback)
 	else
 	{
 		printf("Time callback function registered!\n");
-		dateRecievedCallback = dateCallback;
+		controller->dateRecievedCallback = dateCallback;
 		return SC_NO_ERROR;
 	}
 }
@@ -698,47 +2411,352 @@ StreamControllerError registerVolumeCallback(VolumeCallback volumeCallback)
 	else
 	{
 		printf("Volume callback function registered!\n");
-		volumeReportCallback = volumeCallback;
+		liveController.volumeReportCallback = volumeCallback;
+		return SC_NO_ERROR;
+	}
+}
+
+StreamControllerError registerChannelChangeCallback(ChannelChangeCallback changeCallback)
+{
+	return streamControllerRegisterChannelChangeCallback(&liveController, changeCallback);
+}
+
+StreamControllerError streamControllerRegisterChannelChangeCallback(StreamController* controller, ChannelChangeCallback changeCallback)
+{
+	if (controller == NULL || changeCallback == NULL)
+	{
+		printf("Error registring channel change callback!\n");
+		return SC_ERROR;
+	}
+	else
+	{
+		printf("Channel change callback function registered!\n");
+		controller->channelChangeCallback = changeCallback;
+		return SC_NO_ERROR;
+	}
+}
+
+StreamControllerError registerEpgCallback(EpgCallback epgCallback)
+{
+	if (epgCallback == NULL)
+	{
+		printf("Error registring programme guide callback!\n");
+		return SC_ERROR;
+	}
+	else
+	{
+		printf("Programme guide callback function registered!\n");
+		liveController.epgCallback = epgCallback;
+		return SC_NO_ERROR;
+	}
+}
+
+/* Captured packets of the whole multiplex, timeshift keeps those of current service */
+static void feedTransportPackets(const uint8_t* packets, uint32_t packetCount)
+{
+	uint8_t i = 0;
+
+	timeshiftWritePackets(packets, packetCount);
+
+	/* every instance records from the same capture, tdp_api has a single tuner */
+	pthread_mutex_lock(&controllersMutex);
+	for (i = 0; i < STREAM_CONTROLLER_MAX_INSTANCES; i++)
+	{
+		if (controllers[i] != NULL)
+		{
+			recordPackets(controllers[i], packets, packetCount);
+		}
+	}
+	pthread_mutex_unlock(&controllersMutex);
+}
+
+/* Writes packets of current service to recording of an instance */
+void recordPackets(StreamController* controller, const uint8_t* packets, uint32_t packetCount)
+{
+	uint32_t i = 0;
+	uint8_t j = 0;
+
+	pthread_mutex_lock(&controller->recordingMutex);
+	if (controller->recordingFile != NULL)
+	{
+		for (i = 0; i < packetCount; i++)
+		{
+			const uint8_t* packet = packets + i * TS_PACKET_SIZE;
+			uint16_t pid = tsPacketGetPid(packet);
+
+			for (j = 0; j < controller->servicePidCount; j++)
+			{
+				if (controller->servicePids[j] == pid)
+				{
+					/* index is built inline, in recording order */
+					fwrite(packet, TS_PACKET_SIZE, 1, controller->recordingFile);
+					tsIndexerProcessPackets(&controller->recordingIndexer, packet, 1);
+					break;
+				}
+			}
+		}
+	}
+	pthread_mutex_unlock(&controller->recordingMutex);
+}
+
+StreamControllerError recordingStart(const char* recordingPath)
+{
+	return streamControllerRecordingStart(&liveController, recordingPath);
+}
+
+StreamControllerError streamControllerRecordingStart(StreamController* controller, const char* recordingPath)
+{
+	char indexPath[LINE_LENGTH + 4];
+
+	if (controller == NULL || recordingPath == NULL || recordingPath[0] == '\0')
+	{
+		printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+		return SC_ERROR;
+	}
+
+	/* packets reach recordings only from TS capture, without it the files would stay empty */
+	if (!tsFileSourceIsRunning())
+	{
+		printf("\n%s : ERROR no TS capture, nothing to record\n", __FUNCTION__);
+		return SC_ERROR;
+	}
+
+	pthread_mutex_lock(&controller->recordingMutex);
+	if (controller->recordingFile != NULL)
+	{
+		pthread_mutex_unlock(&controller->recordingMutex);
+		return SC_NO_ERROR;
+	}
+
+	controller->recordingFile = fopen(recordingPath, "wb");
+	if (controller->recordingFile == NULL)
+	{
+		pthread_mutex_unlock(&controller->recordingMutex);
+		printf("\n%s : ERROR opening %s\n", __FUNCTION__, recordingPath);
+		return SC_ERROR;
+	}
+
+	snprintf(indexPath, sizeof(indexPath), "%s.idx", recordingPath);
+	if (tsIndexerOpen(&controller->recordingIndexer, indexPath, controller->currentChannel.videoPid, controller->activeStreams.videoStreamType))
+	{
+		/* recording without index can still be indexed offline */
+		printf("\n%s : ERROR tsIndexerOpen() fail\n", __FUNCTION__);
+	}
+	pthread_mutex_unlock(&controller->recordingMutex);
+
+	printf("\n%s : INFO recording to %s\n", __FUNCTION__, recordingPath);
+
+	return SC_NO_ERROR;
+}
+
+StreamControllerError recordingStop()
+{
+	return streamControllerRecordingStop(&liveController);
+}
+
+StreamControllerError streamControllerRecordingStop(StreamController* controller)
+{
+	if (controller == NULL)
+	{
+		printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+		return SC_ERROR;
+	}
+
+	pthread_mutex_lock(&controller->recordingMutex);
+	if (controller->recordingFile == NULL)
+	{
+		pthread_mutex_unlock(&controller->recordingMutex);
+		return SC_NO_ERROR;
+	}
+
+	fclose(controller->recordingFile);
+	controller->recordingFile = NULL;
+	if (controller->recordingIndexer.indexFile != NULL)
+	{
+		printf("\n%s : INFO recording stopped, %u index entries\n", __FUNCTION__, controller->recordingIndexer.entryCount);
+		tsIndexerClose(&controller->recordingIndexer);
+	}
+	pthread_mutex_unlock(&controller->recordingMutex);
+
+	return SC_NO_ERROR;
+}
+
+bool isRecording()
+{
+	return liveController.recordingFile != NULL;
+}
+
+StreamControllerError playbackPause()
+{
+	if (timeshiftPause())
+	{
+		printf("\n%s : ERROR timeshift not available\n", __FUNCTION__);
+		return SC_ERROR;
+	}
+
+	if (liveController.playbackSource == PLAYBACK_SOURCE_TIMESHIFT)
+	{
+		return SC_NO_ERROR;
+	}
+
+	/* player has only the tuner as source, buffer is played to playback file (or FIFO of a player) instead */
+	liveController.playbackFileDesc = open(liveController.configFile.playbackFile, O_WRONLY | O_CREAT | O_TRUNC | O_NONBLOCK, S_IRUSR | S_IWUSR);
+	if (liveController.playbackFileDesc == -1)
+	{
+		printf("\n%s : ERROR opening playback file %s (%s)\n", __FUNCTION__, liveController.configFile.playbackFile, strerror(errno));
+		timeshiftStop();
+		return SC_ERROR;
+	}
+	/* FIFO is opened only when its reader is there, playback then waits for the reader */
+	fcntl(liveController.playbackFileDesc, F_SETFL, 0);
+	liveController.playbackWriteFailed = false;
+
+	/* decoder stops on the last live frame, tables of current service are kept */
+	if (liveController.streamHandleV != 0)
+	{
+		Player_Stream_Remove(liveController.playerHandle, liveController.sourceHandle, liveController.streamHandleV);
+		liveController.streamHandleV = 0;
+	}
+	if (liveController.streamHandleA != 0)
+	{
+		Player_Stream_Remove(liveController.playerHandle, liveController.sourceHandle, liveController.streamHandleA);
+		liveController.streamHandleA = 0;
+	}
+	liveController.playbackSource = PLAYBACK_SOURCE_TIMESHIFT;
+
+	return SC_NO_ERROR;
+}
+
+StreamControllerError playbackResume()
+{
+	if (liveController.playbackSource != PLAYBACK_SOURCE_TIMESHIFT)
+	{
+		return SC_NO_ERROR;
+	}
+
+	if (timeshiftResume(timeshiftOutput))
+	{
+		printf("\n%s : ERROR timeshiftResume() fail\n", __FUNCTION__);
+		return SC_ERROR;
+	}
+
+	return SC_NO_ERROR;
+}
+
+StreamControllerError playbackSeek(int32_t seconds)
+{
+	if (liveController.playbackSource == PLAYBACK_SOURCE_LIVE)
+	{
+		if (seconds >= 0)
+		{
+			/* already live */
+			return SC_NO_ERROR;
+		}
+
+		if (playbackPause())
+		{
+			return SC_ERROR;
+		}
+	}
+
+	if (timeshiftSeekRelative(seconds))
+	{
+		printf("\n%s : ERROR timeshiftSeekRelative() fail\n", __FUNCTION__);
+		return SC_ERROR;
+	}
+
+	return playbackResume();
+}
+
+StreamControllerError playbackReturnToLive()
+{
+	if (liveController.playbackSource == PLAYBACK_SOURCE_LIVE)
+	{
 		return SC_NO_ERROR;
 	}
+
+	leaveTimeshift();
+
+	/* live streams of current service are created again with the codecs they had */
+	if ((liveController.activeStreams.videoPid != -1) &&
+		Player_Stream_Create(liveController.playerHandle, liveController.sourceHandle, liveController.activeStreams.videoPid, liveController.activeStreams.videoCodec, &liveController.streamHandleV))
+	{
+		printf("\n%s : ERROR Cannot create video stream\n", __FUNCTION__);
+		liveController.streamHandleV = 0;
+		return SC_ERROR;
+	}
+	if ((liveController.activeStreams.audioPid != -1) &&
+		Player_Stream_Create(liveController.playerHandle, liveController.sourceHandle, liveController.activeStreams.audioPid, liveController.activeStreams.audioCodec, &liveController.streamHandleA))
+	{
+		printf("\n%s : ERROR Cannot create audio stream\n", __FUNCTION__);
+		liveController.streamHandleA = 0;
+		return SC_ERROR;
+	}
+
+	return SC_NO_ERROR;
+}
+
+/* Stops playback from buffer, live streams are left to the caller */
+static void leaveTimeshift()
+{
+	if (liveController.playbackSource == PLAYBACK_SOURCE_LIVE)
+	{
+		return;
+	}
+
+	timeshiftStop();
+	close(liveController.playbackFileDesc);
+	liveController.playbackFileDesc = -1;
+	liveController.playbackSource = PLAYBACK_SOURCE_LIVE;
+}
+
+static void timeshiftOutput(const uint8_t* packets, uint32_t packetCount)
+{
+	/* reported once, reader of FIFO may have gone away */
+	if ((write(liveController.playbackFileDesc, packets, packetCount * TS_PACKET_SIZE) != (ssize_t) (packetCount * TS_PACKET_SIZE)) &&
+		!liveController.playbackWriteFailed)
+	{
+		liveController.playbackWriteFailed = true;
+		printf("\n%s : ERROR writing playback file (%s)\n", __FUNCTION__, strerror(errno));
+	}
 }
 
 void volumeUp()
 {
-	if (++currentVolume > 10)
+	if (++liveController.currentVolume > 10)
 	{
-		currentVolume = 10;
+		liveController.currentVolume = 10;
 	}
 
-	if (Player_Volume_Set(playerHandle, currentVolume*volumeConstant))
+	if (Player_Volume_Set(liveController.playerHandle, liveController.currentVolume*volumeConstant))
 	{
 		printf("\n%sError changing volume", __FUNCTION__);
 	}
 
-	volumeReportCallback(currentVolume);
+	liveController.volumeReportCallback(liveController.currentVolume);
 }
 
 void volumeDown()
 {
-	if (currentVolume > 0)
+	if (liveController.currentVolume > 0)
 	{
-		currentVolume--;
+		liveController.currentVolume--;
 	}
 
-	if (Player_Volume_Set(playerHandle, currentVolume*volumeConstant))
+	if (Player_Volume_Set(liveController.playerHandle, liveController.currentVolume*volumeConstant))
 	{
 		printf("\n%sError changing volume", __FUNCTION__);
 	}
 
-	volumeReportCallback(currentVolume);
+	liveController.volumeReportCallback(liveController.currentVolume);
 }
 
 void volumeMute()
 {
-	if (Player_Volume_Set(playerHandle, 0))
+	if (Player_Volume_Set(liveController.playerHandle, 0))
 	{
 		printf("\n%sError changing volume", __FUNCTION__);
 	}
 
-	currentVolume = 0;
+	liveController.currentVolume = 0;
 }
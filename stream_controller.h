@@ -10,10 +10,33 @@
 #include <time.h>
 #include <errno.h>
 #include <stdbool.h>
+#include <semaphore.h>
+#include "timeshift.h"
+#include "ts_file_source.h"
+#include "ts_indexer.h"
+#include "channel_scan.h"
+#include "pmt_prefetch.h"
+#include "table_acquisition.h"
+#include "si_monitor.h"
+#include "filter_scheduler.h"
+#include "section_queue.h"
+#include "startup_graph.h"
 
 #define DESIRED_FREQUENCY 754000000	        /* Tune frequency in Hz */
 #define BANDWIDTH 8    				        /* Bandwidth in Mhz */
 #define LINE_LENGTH 100						/* Max line length in config file */
+#define PSI_TIMEOUT 500						/* PAT and PMT acquisition deadline in ms, tables repeat at least every 100 ms */
+#define PSI_RETRIES 3						/* PAT and PMT acquisition retries */
+#define PSI_BACKOFF 100						/* Pause before first PAT and PMT retry in ms */
+#define TIME_TABLE_TIMEOUT 31000			/* TDT and TOT acquisition deadline in ms, tables repeat at most every 30 s */
+#define CHANNEL_CHANGE_QUEUE_SIZE 16		/* Max number of channel change requests waiting for stream controller task */
+#define STREAM_CONTROLLER_MAX_INSTANCES 4	/* Max number of stream controllers running at once, live one included */
+#define CACHE_LINE_SIZE 64					/* Data written and read by different threads is aligned to it */
+#define PREFETCH_REFRESH_INTERVAL 10000		/* Prefetched PMT is received again after this many ms, within PMT_PREFETCH_MAX_AGE */
+#define EIT_PID 0x0012
+#define EIT_PRESENT_FOLLOWING_INTERVAL 2000	/* EIT p/f of actual TS repeats at least every 2 s */
+#define EIT_SCHEDULE_INTERVAL 10000			/* EIT schedule of first days repeats at least every 10 s */
+#define EIT_SCHEDULE_TABLES 2				/* Schedule table ids from 0x50 received, each covers four days */
 
 /**
  * @brief Structure that defines stream controller error
@@ -25,14 +48,29 @@ typedef enum _StreamControllerError
     SC_THREAD_ERROR
 }StreamControllerError;
 
+/**
+ * @brief Stream controller instance, state of one tuned multiplex with its own task, filters and callbacks
+ */
+typedef struct _StreamController StreamController;
+
 /**
  * @brief Structure that defines channel info
  */
 typedef struct _ChannelInfo
 {
-    int16_t programNumber;
+    int16_t programNumber;                          /* Channel number, position of service in PAT */
     int16_t audioPid;
     int16_t videoPid;
+    tStreamType audioCodec;
+    tStreamType videoCodec;
+    uint16_t serviceId;                             /* program_number */
+    uint16_t pmtPid;
+    uint16_t pcrPid;
+    char serviceName[TABLES_MAX_NAME_LENGTH];       /* From channel database, empty if service was not scanned */
+    bool signalLocked;
+    uint32_t lockLossCount;                         /* Times tuner lost lock since it was initialized */
+    EitEventInfo nowEvent;                          /* From EIT present/following, eventName is empty while unknown */
+    EitEventInfo nextEvent;
 }ChannelInfo;
 
 /**
@@ -44,8 +82,29 @@ typedef struct _InitialInfo
 	uint32_t tuneBandwidth;
 	uint32_t programNumber;
 	t_Module tuneModule;
+	char timeshiftFile[LINE_LENGTH];
+	uint32_t timeshiftSize;
+	char captureFile[LINE_LENGTH];			/* Transport stream file or DVR device standing in for TS capture */
+	char playbackFile[LINE_LENGTH];			/* File or FIFO receiving packets played back from timeshift buffer */
+	char recordingFile[LINE_LENGTH];
+	uint32_t scanFrequencies[CHANNEL_SCAN_MAX_FREQUENCIES];
+	uint8_t scanFrequencyCount;
+	char channelDatabaseFile[LINE_LENGTH];
+	bool fastStart;
+	uint8_t prefetchCount;
+	uint32_t zapSettleTime;				/* In ms, P+/P- tuning waits this long for the next key */
+	uint8_t filterSlots;				/* Hardware section filters, 0 for FILTER_SCHEDULER_DEFAULT_SLOTS */
 }InitialInfo;
 
+/**
+ * @brief Structure that defines source the player is fed from
+ */
+typedef enum _PlaybackSource
+{
+    PLAYBACK_SOURCE_LIVE = 0,
+    PLAYBACK_SOURCE_TIMESHIFT
+}PlaybackSource;
+
 /**
  * @brief Structure that holds time when TOT table was received
  */
@@ -93,6 +152,56 @@ typedef void(*VolumeCallback)(uint8_t currentVolume);
 StreamControllerError registerVolumeCallback(VolumeCallback volumeCallback);
 
 /**
+ * @brief Structure that holds channel change counters
+ */
+typedef struct _ZapStats
+{
+    uint32_t requestCount;                          /* Channel change requests received */
+    uint32_t tuneCount;                             /* Requests that started tuning */
+    uint32_t avoidedCount;                          /* Requests replaced before tuning started */
+    uint32_t abortedCount;                          /* Tunes aborted by newer request */
+    uint32_t speculativeFetchCount;                 /* PMT filters set while user was scrolling */
+    uint32_t reusedStreamCount;                     /* Player streams kept because pid and codec did not change */
+    uint32_t createdStreamCount;                    /* Player streams created */
+    double abortedSeconds;                          /* Time spent in aborted tunes */
+}ZapStats;
+
+/**
+ * @brief Structure that defines progress of channel change request
+ */
+typedef enum _ChannelChangeStatus
+{
+    CHANNEL_CHANGE_PMT_ACQUIRED = 0,                /* PMT of new channel is known */
+    CHANNEL_CHANGE_STREAMS_CREATED,                 /* New channel is playing, request is completed */
+    CHANNEL_CHANGE_FAILED,                          /* Request is completed without channel change */
+    CHANNEL_CHANGE_CANCELLED                        /* Request was replaced by a newer one */
+}ChannelChangeStatus;
+
+/**
+ * @brief Channel change callback, called from stream controller task
+ */
+typedef void(*ChannelChangeCallback)(uint32_t requestId, ChannelChangeStatus status, int32_t channelNumber);
+
+/*
+ * @brief Registers channel change callback
+ *
+ * @param  [in]  channelChangeCallback - pointer to channel change callback function
+ * @return Stream controller error code
+ */
+StreamControllerError registerChannelChangeCallback(ChannelChangeCallback channelChangeCallback);
+
+/**
+ * @brief Programme guide callback, called from section worker with every EIT section of tuned multiplex
+ */
+typedef void(*EpgCallback)(const EitTable* eitTable);
+
+/*
+ * @brief Registers programme guide callback
+ *
+ * @param  [in]  epgCallback - pointer to programme guide callback function
+ * @return Stream controller error code
+ */
+StreamControllerError registerEpgCallback(EpgCallback epgCallback);
 
 /**
  * @brief Initializes stream controller module
@@ -109,21 +218,124 @@ StreamControllerError streamControllerInit();
 StreamControllerError streamControllerDeinit();
 
 /**
- * @brief Channel up
+ * @brief Starts background stream controller instance
+ *
+ * Background instance tunes, acquires tables and records, but does not create player streams.
+ * Player streams, timeshift and volume belong to the live instance driven by the rest of this API.
+ * tdp_api has a single tuner, so every instance must use the frequency the tuner is locked to.
+ *
+ * @param [out] controller - created instance
+ * @param [in]  initialInfo - tuning parameters and program of the instance
+ * @return stream controller error code
+ */
+StreamControllerError streamControllerCreate(StreamController** controller, const InitialInfo* initialInfo);
+
+/**
+ * @brief Stops background stream controller instance and frees it
+ *
+ * @param [in] controller - instance created by streamControllerCreate
+ * @return stream controller error code
+ */
+StreamControllerError streamControllerDestroy(StreamController* controller);
+
+/**
+ * @brief Requests change to given channel on given instance and returns immediately
+ *
+ * @param [in] controller - stream controller instance
+ * @param [in] channelNumber - channel to change to
+ * @return request id, 0 if request was not accepted
+ */
+uint32_t streamControllerChannelChangeRequest(StreamController* controller, int32_t channelNumber);
+
+/**
+ * @brief Returns current channel info of given instance
+ *
+ * Lock free, may be called from any number of threads, the copy is never torn by a zap in progress.
+ *
+ * @param [in]  controller - stream controller instance
+ * @param [out] channelInfo - channel info structure with current channel info
+ * @return stream controller error code
+ */
+StreamControllerError streamControllerGetChannelInfo(StreamController* controller, ChannelInfo* channelInfo);
+
+/**
+ * @brief Registers time callback of given instance
+ *
+ * @param [in] controller - stream controller instance
+ * @param [in] dateCallback - pointer to time callback function
+ * @return stream controller error code
+ */
+StreamControllerError streamControllerRegisterDateCallback(StreamController* controller, DateCallback dateCallback);
+
+/**
+ * @brief Registers channel change callback of given instance
+ *
+ * @param [in] controller - stream controller instance
+ * @param [in] channelChangeCallback - pointer to channel change callback function
+ * @return stream controller error code
+ */
+StreamControllerError streamControllerRegisterChannelChangeCallback(StreamController* controller, ChannelChangeCallback channelChangeCallback);
+
+/**
+ * @brief Starts recording current service of given instance from TS capture
+ *
+ * @param [in] controller - stream controller instance
+ * @param [in] recordingPath - path of recorded transport stream, index gets .idx suffix
+ * @return stream controller error code
+ */
+StreamControllerError streamControllerRecordingStart(StreamController* controller, const char* recordingPath);
+
+/**
+ * @brief Stops recording of given instance
+ *
+ * @param [in] controller - stream controller instance
+ * @return stream controller error code
+ */
+StreamControllerError streamControllerRecordingStop(StreamController* controller);
+
+/**
+ * @brief Channel up, channel is changed asynchronously
  *
  * @return stream controller error
  */
 StreamControllerError channelUp();
 
 /**
- * @brief Channel down
+ * @brief Channel down, channel is changed asynchronously
  *
  * @return stream controller error
  */
 StreamControllerError channelDown();
 
 /**
- * @brief Returns current channel info
+ * @brief Requests change to given channel and returns immediately
+ *
+ * Channel is changed on stream controller task, progress is reported through channel change callback.
+ * A newer request cancels the one in progress.
+ *
+ * @param [in] channelNumber - channel to change to
+ * @return request id, 0 if request was not accepted
+ */
+uint32_t channelChangeRequest(int32_t channelNumber);
+
+/**
+ * @brief Requests change by given number of channels relative to the last requested channel
+ *
+ * @param [in] step - number of channels, negative for channels below
+ * @return request id, 0 if request was not accepted
+ */
+uint32_t channelChangeStep(int8_t step);
+
+/**
+ * @brief Returns channel change counters
+ *
+ * @param [out] stats - channel change counters
+ * @return stream controller error code
+ */
+StreamControllerError getZapStats(ZapStats* stats);
+
+/**
+ * @brief Returns current channel info, lock free snapshot
  *
  * @param [out] channelInfo - channel info structure with current channel info
  * @return stream controller error code
@@ -138,11 +350,88 @@ StreamControllerError getChannelInfo(ChannelInfo* channelInfo);
 StreamControllerError loadInitialInfo();
 
 /**
- * @brief 
+ * @brief Changes channel to number entered with remote controller digits
+ *
+ * @param [in] channelNumber - entered channel number
  */
 void changeChannelKey(int32_t channelNumber);
 
 
+/**
+ * @brief Starts recording current service from TS capture, an I-frame index is written next to it
+ *
+ * @param [in] recordingPath - path of recorded transport stream, index gets .idx suffix
+ * @return stream controller error code
+ */
+StreamControllerError recordingStart(const char* recordingPath);
+
+/**
+ * @brief Stops recording and closes its index
+ *
+ * @return stream controller error code
+ */
+StreamControllerError recordingStop();
+
+/**
+ * @brief Returns true while a recording is active
+ */
+bool isRecording();
+
+/**
+ * @brief Returns path of recording configured in config.ini
+ */
+const char* getRecordingPath();
+
+/**
+ * @brief Returns path of channel database configured in config.ini
+ */
+const char* getChannelDatabasePath();
+
+/**
+ * @brief Returns frequency in Hz the tuner is locked to, channels of other multiplexes cannot be changed to
+ */
+uint32_t getTuneFrequency();
+
+/**
+ * @brief Scans frequencies from config.ini, or multiplex files when given, and writes channel database
+ *
+ * Must be called instead of streamControllerInit, scan uses the tuner and the player on its own.
+ *
+ * @param [in] files - transport stream files with one multiplex each, NULL to scan with the tuner
+ * @param [in] fileCount - number of files
+ * @return stream controller error code
+ */
+StreamControllerError scanChannels(char* const* files, uint8_t fileCount);
+
+/**
+ * @brief Pauses playback, player stops on last live frame and live content keeps being stored in timeshift buffer
+ *
+ * @return stream controller error code
+ */
+StreamControllerError playbackPause();
+
+/**
+ * @brief Resumes playback from timeshift buffer into playback file
+ *
+ * @return stream controller error code
+ */
+StreamControllerError playbackResume();
+
+/**
+ * @brief Moves playback position inside timeshift buffer
+ *
+ * @param [in] seconds - negative value rewinds, positive value goes towards live
+ * @return stream controller error code
+ */
+StreamControllerError playbackSeek(int32_t seconds);
+
+/**
+ * @brief Stops playback from timeshift buffer and creates live streams again
+ *
+ * @return stream controller error code
+ */
+StreamControllerError playbackReturnToLive();
+
 /**
  * @brief Increases current volume value
  */
@@ -0,0 +1,279 @@
+#include "table_acquisition.h"
+
+static void deadlineAfter(struct timespec* deadline, uint32_t milliseconds);
+static uint32_t millisecondsSince(const struct timespec* start);
+static TableAcquisitionError waitForSection(TableAcquisition* acquisition, const struct timespec* deadline);
+static bool sectionMatches(const TableRequest* request, const uint8_t* section);
+
+TableAcquisitionError tableAcquisitionInit(TableAcquisition* acquisition, uint32_t playerHandle)
+{
+    pthread_condattr_t condAttr;
+
+    if (acquisition == NULL)
+    {
+        printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+        return TA_ERROR;
+    }
+
+    memset(acquisition, 0x0, sizeof(TableAcquisition));
+    pthread_mutex_init(&acquisition->mutex, NULL);
+
+    /* deadlines are taken from monotonic clock, so setting the date does not stretch them */
+    pthread_condattr_init(&condAttr);
+    pthread_condattr_setclock(&condAttr, CLOCK_MONOTONIC);
+    if (pthread_cond_init(&acquisition->cond, &condAttr))
+    {
+        printf("\n%s : ERROR pthread_cond_init() fail\n", __FUNCTION__);
+        pthread_condattr_destroy(&condAttr);
+        pthread_mutex_destroy(&acquisition->mutex);
+        return TA_ERROR;
+    }
+    pthread_condattr_destroy(&condAttr);
+
+    acquisition->playerHandle = playerHandle;
+    acquisition->initialized = true;
+
+    return TA_NO_ERROR;
+}
+
+void tableAcquisitionDeinit(TableAcquisition* acquisition)
+{
+    if (acquisition != NULL && acquisition->initialized)
+    {
+        tableAcquisitionCancel(acquisition);
+        pthread_cond_destroy(&acquisition->cond);
+        pthread_mutex_destroy(&acquisition->mutex);
+        acquisition->initialized = false;
+    }
+}
+
+TableAcquisitionError tableAcquire(TableAcquisition* acquisition, const TableRequest* request, uint8_t* section, uint32_t* filterHandle)
+{
+    struct timespec start;
+    struct timespec deadline;
+    TableAcquisitionError result = TA_TIMEOUT;
+    uint32_t handle = 0;
+    uint32_t backoff = 0;
+    uint8_t attempt = 0;
+
+    if (acquisition == NULL || !acquisition->initialized || request == NULL || section == NULL)
+    {
+        printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+        return TA_ERROR;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    backoff = request->backoff;
+
+    for (attempt = 0; attempt <= request->retries; attempt++)
+    {
+        if (attempt > 0)
+        {
+            /* pause before retry, cancellation ends it early */
+            deadlineAfter(&deadline, backoff);
+            pthread_mutex_lock(&acquisition->mutex);
+            while (!acquisition->cancelRequested && pthread_cond_timedwait(&acquisition->cond, &acquisition->mutex, &deadline) != ETIMEDOUT);
+            pthread_mutex_unlock(&acquisition->mutex);
+            backoff *= 2;
+            acquisition->stats.retryCount++;
+        }
+
+        pthread_mutex_lock(&acquisition->mutex);
+        if (acquisition->cancelRequested)
+        {
+            pthread_mutex_unlock(&acquisition->mutex);
+            result = TA_CANCELLED;
+            break;
+        }
+        acquisition->pendingRequest = request;
+        acquisition->pendingSection = section;
+        acquisition->sectionArrived = false;
+        pthread_mutex_unlock(&acquisition->mutex);
+
+        if (Demux_Set_Filter(acquisition->playerHandle, request->pid, request->tableId, &handle))
+        {
+            printf("\n%s : ERROR Demux_Set_Filter() fail\n", __FUNCTION__);
+            pthread_mutex_lock(&acquisition->mutex);
+            acquisition->pendingRequest = NULL;
+            pthread_mutex_unlock(&acquisition->mutex);
+            result = TA_ERROR;
+            continue;
+        }
+
+        deadlineAfter(&deadline, request->timeout);
+        result = waitForSection(acquisition, &deadline);
+
+        if (result == TA_NO_ERROR && filterHandle != NULL)
+        {
+            *filterHandle = handle;
+        }
+        else
+        {
+            Demux_Free_Filter(acquisition->playerHandle, handle);
+        }
+
+        if (result != TA_TIMEOUT && result != TA_ERROR)
+        {
+            break;
+        }
+
+        printf("\n%s : INFO table 0x%.2x on pid %d not received within %u ms (attempt %d)\n", __FUNCTION__,
+               request->tableId, request->pid, request->timeout, attempt + 1);
+    }
+
+    switch (result)
+    {
+        case TA_NO_ERROR:
+            acquisition->stats.acquiredCount++;
+            acquisition->stats.lastMilliseconds = millisecondsSince(&start);
+            if (acquisition->stats.lastMilliseconds > acquisition->stats.maxMilliseconds)
+            {
+                acquisition->stats.maxMilliseconds = acquisition->stats.lastMilliseconds;
+            }
+            break;
+        case TA_CANCELLED:
+            acquisition->stats.cancelledCount++;
+            break;
+        default:
+            acquisition->stats.timeoutCount++;
+            break;
+    }
+
+    return result;
+}
+
+void tableAcquisitionCancel(TableAcquisition* acquisition)
+{
+    if (acquisition == NULL || !acquisition->initialized)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&acquisition->mutex);
+    acquisition->cancelRequested = true;
+    pthread_cond_broadcast(&acquisition->cond);
+    pthread_mutex_unlock(&acquisition->mutex);
+}
+
+void tableAcquisitionResetCancel(TableAcquisition* acquisition)
+{
+    if (acquisition == NULL || !acquisition->initialized)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&acquisition->mutex);
+    acquisition->cancelRequested = false;
+    pthread_mutex_unlock(&acquisition->mutex);
+}
+
+bool tableAcquisitionSectionReceived(TableAcquisition* acquisition, const uint8_t* section)
+{
+    bool completed = false;
+    uint16_t sectionSize = 0;
+
+    if (acquisition == NULL || !acquisition->initialized || section == NULL)
+    {
+        return false;
+    }
+
+    sectionSize = 3 + ((((*(section + 1)) << 8) + (*(section + 2))) & 0x0FFF);
+
+    pthread_mutex_lock(&acquisition->mutex);
+    if (acquisition->pendingRequest != NULL && !acquisition->sectionArrived && sectionMatches(acquisition->pendingRequest, section) &&
+        sectionSize <= TABLE_ACQUISITION_MAX_SECTION_SIZE)
+    {
+        memcpy(acquisition->pendingSection, section, sectionSize);
+        acquisition->sectionArrived = true;
+        completed = true;
+        pthread_cond_broadcast(&acquisition->cond);
+    }
+    pthread_mutex_unlock(&acquisition->mutex);
+
+    return completed;
+}
+
+void tableAcquisitionGetStats(TableAcquisition* acquisition, TableAcquisitionStats* stats)
+{
+    if (acquisition != NULL && stats != NULL)
+    {
+        *stats = acquisition->stats;
+    }
+}
+
+static TableAcquisitionError waitForSection(TableAcquisition* acquisition, const struct timespec* deadline)
+{
+    TableAcquisitionError result = TA_NO_ERROR;
+
+    pthread_mutex_lock(&acquisition->mutex);
+    /* predicate protects against spurious wakeups and sections that arrived before the wait */
+    while (!acquisition->sectionArrived && !acquisition->cancelRequested)
+    {
+        if (pthread_cond_timedwait(&acquisition->cond, &acquisition->mutex, deadline) == ETIMEDOUT)
+        {
+            break;
+        }
+    }
+
+    if (acquisition->sectionArrived)
+    {
+        result = TA_NO_ERROR;
+    }
+    else if (acquisition->cancelRequested)
+    {
+        result = TA_CANCELLED;
+    }
+    else
+    {
+        result = TA_TIMEOUT;
+    }
+    acquisition->pendingRequest = NULL;
+    pthread_mutex_unlock(&acquisition->mutex);
+
+    return result;
+}
+
+static bool sectionMatches(const TableRequest* request, const uint8_t* section)
+{
+    uint16_t tableIdExtension = 0;
+
+    if (section[0] != request->tableId)
+    {
+        return false;
+    }
+
+    if (request->tableIdExtension == TABLE_ACQUISITION_ANY_EXTENSION)
+    {
+        return true;
+    }
+
+    /* only long sections (section_syntax_indicator set) carry table_id_extension */
+    if (!(section[1] & 0x80))
+    {
+        return false;
+    }
+    tableIdExtension = (uint16_t) ((section[3] << 8) + section[4]);
+
+    return tableIdExtension == request->tableIdExtension;
+}
+
+static void deadlineAfter(struct timespec* deadline, uint32_t milliseconds)
+{
+    clock_gettime(CLOCK_MONOTONIC, deadline);
+    deadline->tv_sec += milliseconds / 1000;
+    deadline->tv_nsec += (milliseconds % 1000) * 1000000L;
+    if (deadline->tv_nsec >= 1000000000L)
+    {
+        deadline->tv_sec++;
+        deadline->tv_nsec -= 1000000000L;
+    }
+}
+
+static uint32_t millisecondsSince(const struct timespec* start)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (now.tv_sec - start->tv_sec) * 1000 + (now.tv_nsec - start->tv_nsec) / 1000000;
+}
@@ -0,0 +1,130 @@
+#ifndef __TABLE_ACQUISITION_H__
+#define __TABLE_ACQUISITION_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include "pthread.h"
+#include "tdp_api.h"
+
+#define TABLE_ACQUISITION_MAX_SECTION_SIZE 1024     /* Max size of PSI section */
+#define TABLE_ACQUISITION_ANY_EXTENSION -1          /* Section is matched by pid filter and table id only */
+
+/**
+ * @brief Structure that defines table acquisition error
+ */
+typedef enum _TableAcquisitionError
+{
+    TA_NO_ERROR = 0,
+    TA_ERROR,
+    TA_TIMEOUT,                                     /* Table did not arrive within deadline in any attempt */
+    TA_CANCELLED                                    /* Acquisition was cancelled by a newer request */
+}TableAcquisitionError;
+
+/**
+ * @brief Structure that describes table to acquire
+ */
+typedef struct _TableRequest
+{
+    uint16_t pid;
+    uint8_t tableId;
+    int32_t tableIdExtension;                       /* e.g. program_number of PMT, or TABLE_ACQUISITION_ANY_EXTENSION */
+    uint32_t timeout;                               /* Deadline of one attempt in ms */
+    uint8_t retries;                                /* Number of attempts after the first one */
+    uint32_t backoff;                               /* Pause before first retry in ms, doubled for every next retry */
+}TableRequest;
+
+/**
+ * @brief Structure that holds table acquisition statistics
+ */
+typedef struct _TableAcquisitionStats
+{
+    uint32_t acquiredCount;
+    uint32_t timeoutCount;
+    uint32_t cancelledCount;
+    uint32_t retryCount;
+    uint32_t lastMilliseconds;                      /* Duration of last successful acquisition */
+    uint32_t maxMilliseconds;                       /* Longest successful acquisition */
+}TableAcquisitionStats;
+
+/**
+ * @brief Structure that holds state of one table acquisition context, one per demux user
+ */
+typedef struct _TableAcquisition
+{
+    uint32_t playerHandle;
+    bool initialized;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    const TableRequest* pendingRequest;             /* In-flight request, guarded by mutex */
+    uint8_t* pendingSection;
+    bool sectionArrived;
+    bool cancelRequested;
+    TableAcquisitionStats stats;
+}TableAcquisition;
+
+/**
+ * @brief Initializes table acquisition context
+ *
+ * @param [out] acquisition - acquisition context
+ * @param [in]  playerHandle - player handle used for demux filters
+ * @return table acquisition error code
+ */
+TableAcquisitionError tableAcquisitionInit(TableAcquisition* acquisition, uint32_t playerHandle);
+
+/**
+ * @brief Deinitializes table acquisition context
+ *
+ * @param [in] acquisition - acquisition context
+ */
+void tableAcquisitionDeinit(TableAcquisition* acquisition);
+
+/**
+ * @brief Sets demux filter and waits for a matching section
+ *
+ * Only one acquisition may be in flight per context. The section is copied when it arrives,
+ * so the caller parses its own copy after this function returns.
+ *
+ * @param [in]  acquisition - acquisition context
+ * @param [in]  request - table to acquire
+ * @param [out] section - received section, TABLE_ACQUISITION_MAX_SECTION_SIZE bytes
+ * @param [out] filterHandle - filter is left set and returned here, NULL to free it
+ * @return table acquisition error code
+ */
+TableAcquisitionError tableAcquire(TableAcquisition* acquisition, const TableRequest* request, uint8_t* section, uint32_t* filterHandle);
+
+/**
+ * @brief Cancels in-flight acquisition and every next one until tableAcquisitionResetCancel is called
+ *
+ * @param [in] acquisition - acquisition context
+ */
+void tableAcquisitionCancel(TableAcquisition* acquisition);
+
+/**
+ * @brief Allows acquisitions again after tableAcquisitionCancel
+ *
+ * @param [in] acquisition - acquisition context
+ */
+void tableAcquisitionResetCancel(TableAcquisition* acquisition);
+
+/**
+ * @brief Passes received section to acquisition, must be called from section filter callback
+ *
+ * @param [in] acquisition - acquisition context
+ * @param [in] section - received section
+ * @return true if section completed the in-flight acquisition
+ */
+bool tableAcquisitionSectionReceived(TableAcquisition* acquisition, const uint8_t* section);
+
+/**
+ * @brief Returns table acquisition statistics
+ *
+ * @param [in]  acquisition - acquisition context
+ * @param [out] stats - statistics
+ */
+void tableAcquisitionGetStats(TableAcquisition* acquisition, TableAcquisitionStats* stats);
+
+#endif /* __TABLE_ACQUISITION_H__ */
@@ -9,6 +9,16 @@
 #define TABLES_MAX_NUMBER_OF_ELEMENTARY_PID 20      /* Max number of elementary pids in one PMT table */
 #define TABLES_MAX_NUMBER_OF_LTO_DESCRIPTORS 20     /* Max number of elementary info in local time offset descriptor */
 #define TABLES_MAX_NUMBER_OF_TOT_DESCRIPTORS 20     /* Max number of descriptors in tot table */
+#define TABLES_MAX_NUMBER_OF_SERVICES_IN_SDT 20     /* Max number of services in one SDT table */
+#define TABLES_MAX_NUMBER_OF_TS_IN_NIT 20           /* Max number of transport streams in one NIT table */
+#define TABLES_MAX_NUMBER_OF_LCN_IN_NIT 60          /* Max number of logical channel numbers in one NIT table */
+#define TABLES_MAX_NUMBER_OF_EVENTS_IN_EIT 128     /* Max number of events in one EIT section */
+#define TABLES_MAX_NAME_LENGTH 32                   /* Max length of service, provider, network and event name */
+#define TABLES_MAX_SI_SECTION_LENGTH 1021           /* Max section_length of SDT and NIT, sections are up to 1024 bytes */
+#define TABLES_MIN_SDT_SECTION_LENGTH 12            /* Fixed SDT header after section_length and CRC */
+#define TABLES_MIN_NIT_SECTION_LENGTH 13            /* Fixed NIT header, both loop lengths and CRC */
+#define TABLES_MAX_EIT_SECTION_LENGTH 4093          /* Max section_length of EIT, sections are up to 4096 bytes */
+#define TABLES_MIN_EIT_SECTION_LENGTH 15            /* Fixed EIT header after section_length and CRC */
 
 /**
  * @brief Enumeration of possible tables parser error codes
@@ -145,6 +155,101 @@ typedef struct _LocalTimeOffsetDescriptor
 	uint8_t descriptorsCount;
  }TotTable;
 	
+/**
+ * @brief Structure that defines SDT service info
+ */
+typedef struct _SdtServiceInfo
+{
+    uint16_t serviceId;
+    uint8_t eitScheduleFlag;
+    uint8_t eitPresentFollowingFlag;
+    uint8_t runningStatus;
+    uint8_t freeCaMode;
+    uint8_t serviceType;                                /* From service descriptor */
+    char providerName[TABLES_MAX_NAME_LENGTH];
+    char serviceName[TABLES_MAX_NAME_LENGTH];
+}SdtServiceInfo;
+
+/**
+ * @brief Structure that defines SDT table
+ */
+typedef struct _SdtTable
+{
+    uint8_t tableId;
+    uint16_t sectionLength;
+    uint16_t transportStreamId;
+    uint8_t versionNumber;
+    uint16_t originalNetworkId;
+    SdtServiceInfo sdtServiceInfoArray[TABLES_MAX_NUMBER_OF_SERVICES_IN_SDT];
+    uint8_t serviceInfoCount;
+}SdtTable;
+
+/**
+ * @brief Structure that defines NIT transport stream info
+ */
+typedef struct _NitTransportStreamInfo
+{
+    uint16_t transportStreamId;
+    uint16_t originalNetworkId;
+    uint32_t frequency;                                 /* From terrestrial delivery system descriptor, in Hz */
+    uint8_t bandwidth;                                  /* In MHz */
+}NitTransportStreamInfo;
+
+/**
+ * @brief Structure that defines NIT logical channel number
+ */
+typedef struct _NitLogicalChannel
+{
+    uint16_t transportStreamId;
+    uint16_t serviceId;
+    uint16_t logicalChannelNumber;
+    uint8_t visible;
+}NitLogicalChannel;
+
+/**
+ * @brief Structure that defines NIT table
+ */
+typedef struct _NitTable
+{
+    uint8_t tableId;
+    uint16_t sectionLength;
+    uint16_t networkId;
+    uint8_t versionNumber;
+    char networkName[TABLES_MAX_NAME_LENGTH];
+    NitTransportStreamInfo nitTransportStreamInfoArray[TABLES_MAX_NUMBER_OF_TS_IN_NIT];
+    uint8_t transportStreamCount;
+    NitLogicalChannel nitLogicalChannelArray[TABLES_MAX_NUMBER_OF_LCN_IN_NIT];
+    uint8_t logicalChannelCount;
+}NitTable;
+
+/**
+ * @brief Structure that defines EIT event info
+ */
+typedef struct _EitEventInfo
+{
+    uint16_t eventId;
+    uint32_t startTime;                                 /* UTC, seconds since 1970 */
+    uint32_t duration;                                  /* In seconds */
+    uint8_t runningStatus;
+    char eventName[TABLES_MAX_NAME_LENGTH];             /* From short event descriptor */
+}EitEventInfo;
+
+/**
+ * @brief Structure that defines EIT table
+ */
+typedef struct _EitTable
+{
+    uint8_t tableId;                                    /* 0x4E present/following, 0x50 - 0x5F schedule of actual TS */
+    uint16_t sectionLength;
+    uint16_t serviceId;
+    uint8_t versionNumber;
+    uint8_t sectionNumber;
+    uint16_t transportStreamId;
+    uint16_t originalNetworkId;
+    EitEventInfo eitEventInfoArray[TABLES_MAX_NUMBER_OF_EVENTS_IN_EIT];
+    uint8_t eventInfoCount;
+}EitTable;
+
 /**
  * @brief  Parse PAT header.
  * 
@@ -249,4 +354,47 @@ ParseErrorCode parseTotTable(const uint8_t* totSectionBuffer, TotTable* totTable
  */
 ParseErrorCode printTotTable(TotTable* totTable);
 
+/**
+ * @brief Parse SDT table
+ *
+ * @param [in]  sdtSectionBuffer Buffer that contains sdt table section
+ * @param [out] sdtTable SDT table
+ * @return tables error code
+ */
+ParseErrorCode parseSdtTable(const uint8_t* sdtSectionBuffer, SdtTable* sdtTable);
+
+/**
+ * @brief Print SDT table
+ *
+ * @param [in] sdtTable SDT table
+ * @return tables error code
+ */
+ParseErrorCode printSdtTable(SdtTable* sdtTable);
+
+/**
+ * @brief Parse NIT table
+ *
+ * @param [in]  nitSectionBuffer Buffer that contains nit table section
+ * @param [out] nitTable NIT table
+ * @return tables error code
+ */
+ParseErrorCode parseNitTable(const uint8_t* nitSectionBuffer, NitTable* nitTable);
+
+/**
+ * @brief Print NIT table
+ *
+ * @param [in] nitTable NIT table
+ * @return tables error code
+ */
+ParseErrorCode printNitTable(NitTable* nitTable);
+
+/**
+ * @brief Parse EIT table, events without start time are skipped
+ *
+ * @param [in]  eitSectionBuffer Buffer that contains eit table section
+ * @param [out] eitTable EIT table
+ * @return tables error code
+ */
+ParseErrorCode parseEitTable(const uint8_t* eitSectionBuffer, EitTable* eitTable);
+
 #endif /* __TABLES_H__ */
@@ -193,7 +193,7 @@ ParseErrorCode parsePmtHeader(const uint8_t* pmtHeaderBuffer, PmtTableHeader* pm
     higher8Bits = (uint8_t) (*(pmtHeaderBuffer + 8));
     lower8Bits = (uint8_t) (*(pmtHeaderBuffer + 9));
     all16Bits = (uint16_t) ((higher8Bits << 8) + lower8Bits);
-    pmtHeader->pcrPid = all16Bits & 0xFFFF;
+    pmtHeader->pcrPid = all16Bits & 0x1FFF;
 
     higher8Bits = (uint8_t) (*(pmtHeaderBuffer + 10));
     lower8Bits = (uint8_t) (*(pmtHeaderBuffer + 11));
@@ -508,3 +508,538 @@ ParseErrorCode printTotTable(TotTable* totTable)
 
 	return TABLES_PARSE_OK;
 }
+
+/* copies DVB text field, leading character table selection bytes are skipped */
+static void copyDvbString(char* destination, const uint8_t* source, uint8_t length)
+{
+    uint8_t i = 0;
+    uint8_t j = 0;
+
+    if (length > 0 && source[0] == 0x10)
+    {
+        i = 3;
+    }
+    else if (length > 0 && source[0] < 0x20)
+    {
+        i = 1;
+    }
+
+    for (; i < length && j < TABLES_MAX_NAME_LENGTH - 1; i++)
+    {
+        /* drop control codes (emphasis on/off, CR/LF) */
+        if (source[i] >= 0x20 && (source[i] < 0x80 || source[i] > 0x9F))
+        {
+            destination[j++] = (char) source[i];
+        }
+    }
+
+    destination[j] = '\0';
+}
+
+ParseErrorCode parseSdtTable(const uint8_t* sdtSectionBuffer, SdtTable* sdtTable)
+{
+    uint8_t lower8Bits = 0;
+    uint8_t higher8Bits = 0;
+    uint16_t all16Bits = 0;
+    uint32_t position = 0;
+    uint32_t sectionEnd = 0;
+
+    if (sdtSectionBuffer == NULL || sdtTable == NULL)
+    {
+        printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+        return TABLES_PARSE_ERROR;
+    }
+
+    sdtTable->tableId = (uint8_t) *sdtSectionBuffer;
+    if (sdtTable->tableId != 0x42 && sdtTable->tableId != 0x46)
+    {
+        printf("\n%s : ERROR it is not a SDT Table\n", __FUNCTION__);
+        return TABLES_PARSE_ERROR;
+    }
+
+    higher8Bits = (uint8_t) *(sdtSectionBuffer + 1);
+    lower8Bits = (uint8_t) *(sdtSectionBuffer + 2);
+    all16Bits = (uint16_t) ((higher8Bits << 8) + lower8Bits);
+    sdtTable->sectionLength = all16Bits & 0x0FFF;
+
+    /* short section would make section end wrap around, long one does not fit the section buffer */
+    if (sdtTable->sectionLength < TABLES_MIN_SDT_SECTION_LENGTH || sdtTable->sectionLength > TABLES_MAX_SI_SECTION_LENGTH)
+    {
+        printf("\n%s : ERROR invalid section length %u\n", __FUNCTION__, sdtTable->sectionLength);
+        return TABLES_PARSE_ERROR;
+    }
+
+    higher8Bits = (uint8_t) *(sdtSectionBuffer + 3);
+    lower8Bits = (uint8_t) *(sdtSectionBuffer + 4);
+    all16Bits = (uint16_t) ((higher8Bits << 8) + lower8Bits);
+    sdtTable->transportStreamId = all16Bits;
+
+    lower8Bits = (uint8_t) *(sdtSectionBuffer + 5);
+    sdtTable->versionNumber = (lower8Bits >> 1) & 0x1F;
+
+    higher8Bits = (uint8_t) *(sdtSectionBuffer + 8);
+    lower8Bits = (uint8_t) *(sdtSectionBuffer + 9);
+    all16Bits = (uint16_t) ((higher8Bits << 8) + lower8Bits);
+    sdtTable->originalNetworkId = all16Bits;
+
+    position = 11; /* Position after reserved_future_use byte */
+    sectionEnd = 3 + sdtTable->sectionLength - 4; /* CRC is not parsed */
+    sdtTable->serviceInfoCount = 0;
+
+    while (position + 5 <= sectionEnd)
+    {
+        SdtServiceInfo* serviceInfo = NULL;
+        uint16_t descriptorsLoopLength = 0;
+        uint32_t descriptorPosition = 0;
+
+        if (sdtTable->serviceInfoCount > TABLES_MAX_NUMBER_OF_SERVICES_IN_SDT - 1)
+        {
+            printf("\n%s : ERROR there is not enough space in SDT structure for service info\n", __FUNCTION__);
+            return TABLES_PARSE_ERROR;
+        }
+
+        serviceInfo = &(sdtTable->sdtServiceInfoArray[sdtTable->serviceInfoCount]);
+        memset(serviceInfo, 0x0, sizeof(SdtServiceInfo));
+
+        higher8Bits = (uint8_t) *(sdtSectionBuffer + position);
+        lower8Bits = (uint8_t) *(sdtSectionBuffer + position + 1);
+        all16Bits = (uint16_t) ((higher8Bits << 8) + lower8Bits);
+        serviceInfo->serviceId = all16Bits;
+
+        lower8Bits = (uint8_t) *(sdtSectionBuffer + position + 2);
+        serviceInfo->eitScheduleFlag = (lower8Bits >> 1) & 0x01;
+        serviceInfo->eitPresentFollowingFlag = lower8Bits & 0x01;
+
+        higher8Bits = (uint8_t) *(sdtSectionBuffer + position + 3);
+        lower8Bits = (uint8_t) *(sdtSectionBuffer + position + 4);
+        all16Bits = (uint16_t) ((higher8Bits << 8) + lower8Bits);
+        serviceInfo->runningStatus = higher8Bits >> 5;
+        serviceInfo->freeCaMode = (higher8Bits >> 4) & 0x01;
+        descriptorsLoopLength = all16Bits & 0x0FFF;
+
+        descriptorPosition = position + 5;
+        position += 5 + descriptorsLoopLength;
+        if (position > sectionEnd)
+        {
+            printf("\n%s : ERROR descriptors loop exceeds section\n", __FUNCTION__);
+            return TABLES_PARSE_ERROR;
+        }
+
+        while (descriptorPosition + 2 <= position)
+        {
+            uint8_t descriptorTag = (uint8_t) *(sdtSectionBuffer + descriptorPosition);
+            uint8_t descriptorLength = (uint8_t) *(sdtSectionBuffer + descriptorPosition + 1);
+            const uint8_t* descriptor = sdtSectionBuffer + descriptorPosition + 2;
+
+            if (descriptorPosition + 2 + descriptorLength > position)
+            {
+                break;
+            }
+
+            /* service descriptor */
+            if (descriptorTag == 0x48 && descriptorLength >= 3)
+            {
+                uint8_t providerNameLength = descriptor[1];
+                uint8_t serviceNameLength = 0;
+
+                serviceInfo->serviceType = descriptor[0];
+                if (2 + providerNameLength < descriptorLength)
+                {
+                    copyDvbString(serviceInfo->providerName, descriptor + 2, providerNameLength);
+                    serviceNameLength = descriptor[2 + providerNameLength];
+                    if (3 + providerNameLength + serviceNameLength <= descriptorLength)
+                    {
+                        copyDvbString(serviceInfo->serviceName, descriptor + 3 + providerNameLength, serviceNameLength);
+                    }
+                }
+            }
+
+            descriptorPosition += 2 + descriptorLength;
+        }
+
+        sdtTable->serviceInfoCount++;
+    }
+
+    return TABLES_PARSE_OK;
+}
+
+ParseErrorCode printSdtTable(SdtTable* sdtTable)
+{
+    uint8_t i = 0;
+
+    if (sdtTable == NULL)
+    {
+        printf("\n%s : ERROR received parameter is not ok\n", __FUNCTION__);
+        return TABLES_PARSE_ERROR;
+    }
+
+    printf("\n********************SDT TABLE SECTION********************\n");
+    printf("table_id                 |      %d\n", sdtTable->tableId);
+    printf("section_length           |      %d\n", sdtTable->sectionLength);
+    printf("transport_stream_id      |      %d\n", sdtTable->transportStreamId);
+    printf("original_network_id      |      %d\n", sdtTable->originalNetworkId);
+
+    for (i = 0; i < sdtTable->serviceInfoCount; i++)
+    {
+        printf("-----------------------------------------\n");
+        printf("service_id               |      %d\n", sdtTable->sdtServiceInfoArray[i].serviceId);
+        printf("service_type             |      %d\n", sdtTable->sdtServiceInfoArray[i].serviceType);
+        printf("service_name             |      %s\n", sdtTable->sdtServiceInfoArray[i].serviceName);
+        printf("provider_name            |      %s\n", sdtTable->sdtServiceInfoArray[i].providerName);
+    }
+    printf("\n********************SDT TABLE SECTION********************\n");
+
+    return TABLES_PARSE_OK;
+}
+
+ParseErrorCode parseNitTable(const uint8_t* nitSectionBuffer, NitTable* nitTable)
+{
+    uint8_t lower8Bits = 0;
+    uint8_t higher8Bits = 0;
+    uint16_t all16Bits = 0;
+    uint16_t descriptorsLength = 0;
+    uint32_t position = 0;
+    uint32_t loopEnd = 0;
+    uint32_t sectionEnd = 0;
+
+    if (nitSectionBuffer == NULL || nitTable == NULL)
+    {
+        printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+        return TABLES_PARSE_ERROR;
+    }
+
+    nitTable->tableId = (uint8_t) *nitSectionBuffer;
+    if (nitTable->tableId != 0x40 && nitTable->tableId != 0x41)
+    {
+        printf("\n%s : ERROR it is not a NIT Table\n", __FUNCTION__);
+        return TABLES_PARSE_ERROR;
+    }
+
+    higher8Bits = (uint8_t) *(nitSectionBuffer + 1);
+    lower8Bits = (uint8_t) *(nitSectionBuffer + 2);
+    all16Bits = (uint16_t) ((higher8Bits << 8) + lower8Bits);
+    nitTable->sectionLength = all16Bits & 0x0FFF;
+
+    /* short section would make section end wrap around, long one does not fit the section buffer */
+    if (nitTable->sectionLength < TABLES_MIN_NIT_SECTION_LENGTH || nitTable->sectionLength > TABLES_MAX_SI_SECTION_LENGTH)
+    {
+        printf("\n%s : ERROR invalid section length %u\n", __FUNCTION__, nitTable->sectionLength);
+        return TABLES_PARSE_ERROR;
+    }
+
+    sectionEnd = 3 + nitTable->sectionLength - 4; /* CRC is not parsed */
+
+    higher8Bits = (uint8_t) *(nitSectionBuffer + 3);
+    lower8Bits = (uint8_t) *(nitSectionBuffer + 4);
+    all16Bits = (uint16_t) ((higher8Bits << 8) + lower8Bits);
+    nitTable->networkId = all16Bits;
+
+    lower8Bits = (uint8_t) *(nitSectionBuffer + 5);
+    nitTable->versionNumber = (lower8Bits >> 1) & 0x1F;
+
+    nitTable->networkName[0] = '\0';
+    nitTable->transportStreamCount = 0;
+    nitTable->logicalChannelCount = 0;
+
+    /* network descriptors */
+    higher8Bits = (uint8_t) *(nitSectionBuffer + 8);
+    lower8Bits = (uint8_t) *(nitSectionBuffer + 9);
+    all16Bits = (uint16_t) ((higher8Bits << 8) + lower8Bits);
+    descriptorsLength = all16Bits & 0x0FFF;
+
+    position = 10;
+    loopEnd = position + descriptorsLength;
+    if (loopEnd + 2 > sectionEnd)
+    {
+        printf("\n%s : ERROR network descriptors exceed section\n", __FUNCTION__);
+        return TABLES_PARSE_ERROR;
+    }
+
+    while (position + 2 <= loopEnd)
+    {
+        uint8_t descriptorTag = (uint8_t) *(nitSectionBuffer + position);
+        uint8_t descriptorLength = (uint8_t) *(nitSectionBuffer + position + 1);
+
+        /* network name descriptor */
+        if (descriptorTag == 0x40 && position + 2 + descriptorLength <= loopEnd)
+        {
+            copyDvbString(nitTable->networkName, nitSectionBuffer + position + 2, descriptorLength);
+        }
+
+        position += 2 + descriptorLength;
+    }
+    position = loopEnd;
+
+    /* transport stream loop */
+    higher8Bits = (uint8_t) *(nitSectionBuffer + position);
+    lower8Bits = (uint8_t) *(nitSectionBuffer + position + 1);
+    all16Bits = (uint16_t) ((higher8Bits << 8) + lower8Bits);
+    position += 2;
+    loopEnd = position + (all16Bits & 0x0FFF);
+    if (loopEnd > sectionEnd)
+    {
+        loopEnd = sectionEnd;
+    }
+
+    while (position + 6 <= loopEnd)
+    {
+        NitTransportStreamInfo* streamInfo = NULL;
+        uint32_t descriptorPosition = 0;
+        uint32_t descriptorsEnd = 0;
+
+        if (nitTable->transportStreamCount > TABLES_MAX_NUMBER_OF_TS_IN_NIT - 1)
+        {
+            printf("\n%s : ERROR there is not enough space in NIT structure for transport stream info\n", __FUNCTION__);
+            return TABLES_PARSE_ERROR;
+        }
+
+        streamInfo = &(nitTable->nitTransportStreamInfoArray[nitTable->transportStreamCount]);
+        memset(streamInfo, 0x0, sizeof(NitTransportStreamInfo));
+
+        higher8Bits = (uint8_t) *(nitSectionBuffer + position);
+        lower8Bits = (uint8_t) *(nitSectionBuffer + position + 1);
+        streamInfo->transportStreamId = (uint16_t) ((higher8Bits << 8) + lower8Bits);
+
+        higher8Bits = (uint8_t) *(nitSectionBuffer + position + 2);
+        lower8Bits = (uint8_t) *(nitSectionBuffer + position + 3);
+        streamInfo->originalNetworkId = (uint16_t) ((higher8Bits << 8) + lower8Bits);
+
+        higher8Bits = (uint8_t) *(nitSectionBuffer + position + 4);
+        lower8Bits = (uint8_t) *(nitSectionBuffer + position + 5);
+        all16Bits = (uint16_t) ((higher8Bits << 8) + lower8Bits);
+
+        descriptorPosition = position + 6;
+        descriptorsEnd = descriptorPosition + (all16Bits & 0x0FFF);
+        if (descriptorsEnd > loopEnd)
+        {
+            printf("\n%s : ERROR transport descriptors exceed section\n", __FUNCTION__);
+            return TABLES_PARSE_ERROR;
+        }
+
+        while (descriptorPosition + 2 <= descriptorsEnd)
+        {
+            uint8_t descriptorTag = (uint8_t) *(nitSectionBuffer + descriptorPosition);
+            uint8_t descriptorLength = (uint8_t) *(nitSectionBuffer + descriptorPosition + 1);
+            const uint8_t* descriptor = nitSectionBuffer + descriptorPosition + 2;
+            uint8_t i = 0;
+
+            if (descriptorPosition + 2 + descriptorLength > descriptorsEnd)
+            {
+                break;
+            }
+
+            if (descriptorTag == 0x5A && descriptorLength >= 5)
+            {
+                /* terrestrial delivery system descriptor, centre frequency in 10 Hz units */
+                streamInfo->frequency = (((uint32_t) descriptor[0] << 24) | ((uint32_t) descriptor[1] << 16) |
+                                         ((uint32_t) descriptor[2] << 8) | (uint32_t) descriptor[3]) * 10;
+                streamInfo->bandwidth = 8 - ((descriptor[4] >> 5) & 0x07);
+            }
+            else if (descriptorTag == 0x83)
+            {
+                /* logical channel descriptor */
+                for (i = 0; i + 4 <= descriptorLength; i += 4)
+                {
+                    NitLogicalChannel* logicalChannel = NULL;
+
+                    if (nitTable->logicalChannelCount > TABLES_MAX_NUMBER_OF_LCN_IN_NIT - 1)
+                    {
+                        break;
+                    }
+
+                    logicalChannel = &(nitTable->nitLogicalChannelArray[nitTable->logicalChannelCount]);
+                    logicalChannel->transportStreamId = streamInfo->transportStreamId;
+                    logicalChannel->serviceId = (uint16_t) ((descriptor[i] << 8) + descriptor[i + 1]);
+                    logicalChannel->visible = descriptor[i + 2] >> 7;
+                    logicalChannel->logicalChannelNumber = (uint16_t) (((descriptor[i + 2] << 8) + descriptor[i + 3]) & 0x03FF);
+                    nitTable->logicalChannelCount++;
+                }
+            }
+
+            descriptorPosition += 2 + descriptorLength;
+        }
+
+        position = descriptorsEnd;
+        nitTable->transportStreamCount++;
+    }
+
+    return TABLES_PARSE_OK;
+}
+
+ParseErrorCode printNitTable(NitTable* nitTable)
+{
+    uint8_t i = 0;
+
+    if (nitTable == NULL)
+    {
+        printf("\n%s : ERROR received parameter is not ok\n", __FUNCTION__);
+        return TABLES_PARSE_ERROR;
+    }
+
+    printf("\n********************NIT TABLE SECTION********************\n");
+    printf("table_id                 |      %d\n", nitTable->tableId);
+    printf("section_length           |      %d\n", nitTable->sectionLength);
+    printf("network_id               |      %d\n", nitTable->networkId);
+    printf("network_name             |      %s\n", nitTable->networkName);
+
+    for (i = 0; i < nitTable->transportStreamCount; i++)
+    {
+        printf("-----------------------------------------\n");
+        printf("transport_stream_id      |      %d\n", nitTable->nitTransportStreamInfoArray[i].transportStreamId);
+        printf("frequency                |      %u\n", nitTable->nitTransportStreamInfoArray[i].frequency);
+    }
+
+    for (i = 0; i < nitTable->logicalChannelCount; i++)
+    {
+        printf("-----------------------------------------\n");
+        printf("service_id               |      %d\n", nitTable->nitLogicalChannelArray[i].serviceId);
+        printf("logical_channel_number   |      %d\n", nitTable->nitLogicalChannelArray[i].logicalChannelNumber);
+    }
+    printf("\n********************NIT TABLE SECTION********************\n");
+
+    return TABLES_PARSE_OK;
+}
+
+/* five bytes of MJD and BCD hours, minutes and seconds, 0xFFFFFFFFFF when undefined */
+static ParseErrorCode parseDvbTime(const uint8_t* source, uint32_t* utcTime)
+{
+    uint16_t mjd = (uint16_t) ((source[0] << 8) + source[1]);
+
+    /* MJD 40587 is 1970-01-01 */
+    if (mjd == 0xFFFF || mjd < 40587)
+    {
+        return TABLES_PARSE_ERROR;
+    }
+
+    *utcTime = (uint32_t) (mjd - 40587) * 86400 + ((source[2] >> 4) * 10 + (source[2] & 0x0F)) * 3600 +
+               ((source[3] >> 4) * 10 + (source[3] & 0x0F)) * 60 + (source[4] >> 4) * 10 + (source[4] & 0x0F);
+
+    return TABLES_PARSE_OK;
+}
+
+ParseErrorCode parseEitTable(const uint8_t* eitSectionBuffer, EitTable* eitTable)
+{
+    uint8_t lower8Bits = 0;
+    uint8_t higher8Bits = 0;
+    uint16_t all16Bits = 0;
+    uint32_t position = 0;
+    uint32_t sectionEnd = 0;
+
+    if (eitSectionBuffer == NULL || eitTable == NULL)
+    {
+        printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+        return TABLES_PARSE_ERROR;
+    }
+
+    eitTable->tableId = (uint8_t) *eitSectionBuffer;
+    if (eitTable->tableId < 0x4E || eitTable->tableId > 0x6F)
+    {
+        printf("\n%s : ERROR it is not a EIT Table\n", __FUNCTION__);
+        return TABLES_PARSE_ERROR;
+    }
+
+    higher8Bits = (uint8_t) *(eitSectionBuffer + 1);
+    lower8Bits = (uint8_t) *(eitSectionBuffer + 2);
+    all16Bits = (uint16_t) ((higher8Bits << 8) + lower8Bits);
+    eitTable->sectionLength = all16Bits & 0x0FFF;
+
+    /* short section would make section end wrap around, long one does not fit the section buffer */
+    if (eitTable->sectionLength < TABLES_MIN_EIT_SECTION_LENGTH || eitTable->sectionLength > TABLES_MAX_EIT_SECTION_LENGTH)
+    {
+        printf("\n%s : ERROR invalid section length %u\n", __FUNCTION__, eitTable->sectionLength);
+        return TABLES_PARSE_ERROR;
+    }
+
+    higher8Bits = (uint8_t) *(eitSectionBuffer + 3);
+    lower8Bits = (uint8_t) *(eitSectionBuffer + 4);
+    all16Bits = (uint16_t) ((higher8Bits << 8) + lower8Bits);
+    eitTable->serviceId = all16Bits;
+
+    lower8Bits = (uint8_t) *(eitSectionBuffer + 5);
+    eitTable->versionNumber = (lower8Bits >> 1) & 0x1F;
+    eitTable->sectionNumber = (uint8_t) *(eitSectionBuffer + 6);
+
+    higher8Bits = (uint8_t) *(eitSectionBuffer + 8);
+    lower8Bits = (uint8_t) *(eitSectionBuffer + 9);
+    all16Bits = (uint16_t) ((higher8Bits << 8) + lower8Bits);
+    eitTable->transportStreamId = all16Bits;
+
+    higher8Bits = (uint8_t) *(eitSectionBuffer + 10);
+    lower8Bits = (uint8_t) *(eitSectionBuffer + 11);
+    all16Bits = (uint16_t) ((higher8Bits << 8) + lower8Bits);
+    eitTable->originalNetworkId = all16Bits;
+
+    position = 14; /* Position after last_table_id */
+    sectionEnd = 3 + eitTable->sectionLength - 4; /* CRC is not parsed */
+    eitTable->eventInfoCount = 0;
+
+    while (position + 12 <= sectionEnd)
+    {
+        EitEventInfo* eventInfo = NULL;
+        uint16_t descriptorsLoopLength = 0;
+        uint32_t descriptorPosition = 0;
+        const uint8_t* startTime = eitSectionBuffer + position + 2;
+        const uint8_t* duration = eitSectionBuffer + position + 7;
+
+        if (eitTable->eventInfoCount > TABLES_MAX_NUMBER_OF_EVENTS_IN_EIT - 1)
+        {
+            printf("\n%s : ERROR there is not enough space in EIT structure for event info\n", __FUNCTION__);
+            return TABLES_PARSE_ERROR;
+        }
+
+        eventInfo = &(eitTable->eitEventInfoArray[eitTable->eventInfoCount]);
+        memset(eventInfo, 0x0, sizeof(EitEventInfo));
+
+        higher8Bits = (uint8_t) *(eitSectionBuffer + position);
+        lower8Bits = (uint8_t) *(eitSectionBuffer + position + 1);
+        all16Bits = (uint16_t) ((higher8Bits << 8) + lower8Bits);
+        eventInfo->eventId = all16Bits;
+
+        eventInfo->duration = ((duration[0] >> 4) * 10 + (duration[0] & 0x0F)) * 3600 +
+                              ((duration[1] >> 4) * 10 + (duration[1] & 0x0F)) * 60 + (duration[2] >> 4) * 10 + (duration[2] & 0x0F);
+
+        higher8Bits = (uint8_t) *(eitSectionBuffer + position + 10);
+        lower8Bits = (uint8_t) *(eitSectionBuffer + position + 11);
+        all16Bits = (uint16_t) ((higher8Bits << 8) + lower8Bits);
+        eventInfo->runningStatus = higher8Bits >> 5;
+        descriptorsLoopLength = all16Bits & 0x0FFF;
+
+        descriptorPosition = position + 12;
+        position += 12 + descriptorsLoopLength;
+        if (position > sectionEnd)
+        {
+            printf("\n%s : ERROR descriptors loop exceeds section\n", __FUNCTION__);
+            return TABLES_PARSE_ERROR;
+        }
+
+        /* events announced without time cannot be placed in a schedule */
+        if (parseDvbTime(startTime, &eventInfo->startTime) != TABLES_PARSE_OK)
+        {
+            continue;
+        }
+
+        while (descriptorPosition + 2 <= position)
+        {
+            uint8_t descriptorTag = (uint8_t) *(eitSectionBuffer + descriptorPosition);
+            uint8_t descriptorLength = (uint8_t) *(eitSectionBuffer + descriptorPosition + 1);
+            const uint8_t* descriptor = eitSectionBuffer + descriptorPosition + 2;
+
+            if (descriptorPosition + 2 + descriptorLength > position)
+            {
+                break;
+            }
+
+            /* short event descriptor, language code is followed by event name */
+            if (descriptorTag == 0x4D && descriptorLength >= 4 && 4 + descriptor[3] <= descriptorLength)
+            {
+                copyDvbString(eventInfo->eventName, descriptor + 4, descriptor[3]);
+            }
+
+            descriptorPosition += 2 + descriptorLength;
+        }
+
+        eitTable->eventInfoCount++;
+    }
+
+    return TABLES_PARSE_OK;
+}
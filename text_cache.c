@@ -0,0 +1,147 @@
+#include "text_cache.h"
+
+static TextCacheEntry* findEntry(TextCache* cache, const char* text, OsdFont* font, uint32_t color);
+static TextCacheEntry* renderText(TextCache* cache, const char* text, OsdFont* font, uint32_t color);
+static TextCacheEntry* takeEntry(TextCache* cache);
+static void releaseEntry(TextCache* cache, TextCacheEntry* entry);
+
+void textCacheInit(TextCache* cache, const OsdBackend* backend)
+{
+    memset(cache, 0x0, sizeof(TextCache));
+    cache->backend = backend;
+}
+
+void textCacheDeinit(TextCache* cache)
+{
+    uint8_t i = 0;
+
+    for (i = 0; i < TEXT_CACHE_MAX_ENTRIES; i++)
+    {
+        if (cache->entries[i].surface != NULL)
+        {
+            releaseEntry(cache, &cache->entries[i]);
+        }
+    }
+}
+
+OsdSurface* textCacheGet(TextCache* cache, const char* text, OsdFont* font, uint32_t color, int32_t* width, int32_t* height)
+{
+    TextCacheEntry* entry = NULL;
+
+    if (strlen(text) >= TEXT_CACHE_MAX_TEXT_LENGTH)
+    {
+        printf("\n%s : ERROR text %s too long!\n", __FUNCTION__, text);
+        return NULL;
+    }
+
+    entry = findEntry(cache, text, font, color);
+    if (entry != NULL)
+    {
+        cache->stats.hitCount++;
+    }
+    else
+    {
+        cache->stats.missCount++;
+        entry = renderText(cache, text, font, color);
+        if (entry == NULL)
+        {
+            return NULL;
+        }
+    }
+
+    entry->lastUse = ++cache->useClock;
+    *width = entry->width;
+    *height = entry->height;
+
+    return entry->surface;
+}
+
+void textCacheGetStats(TextCache* cache, TextCacheStats* stats)
+{
+    *stats = cache->stats;
+}
+
+TextCacheEntry* findEntry(TextCache* cache, const char* text, OsdFont* font, uint32_t color)
+{
+    uint8_t i = 0;
+
+    for (i = 0; i < TEXT_CACHE_MAX_ENTRIES; i++)
+    {
+        if (cache->entries[i].surface != NULL && cache->entries[i].font == font && cache->entries[i].color == color
+            && strcmp(cache->entries[i].text, text) == 0)
+        {
+            return &cache->entries[i];
+        }
+    }
+
+    return NULL;
+}
+
+TextCacheEntry* renderText(TextCache* cache, const char* text, OsdFont* font, uint32_t color)
+{
+    OsdSurface* surface = NULL;
+    TextCacheEntry* entry = NULL;
+    OsdRectangle area;
+    int32_t ascender = 0;
+
+    area.x = 0;
+    area.y = 0;
+    area.w = cache->backend->getStringWidth(font, text);
+    cache->backend->getFontMetrics(font, &area.h, &ascender);
+    if (area.w <= 0)
+    {
+        area.w = 1;
+    }
+
+    surface = cache->backend->createSurface(area.w, area.h);
+    if (surface == NULL)
+    {
+        printf("\n%s : ERROR cannot create surface for text %s!\n", __FUNCTION__, text);
+        return NULL;
+    }
+
+    cache->backend->fill(surface, &area, 0x00000000);
+    cache->backend->drawString(surface, font, text, 0, 0, color);
+
+    entry = takeEntry(cache);
+    strcpy(entry->text, text);
+    entry->font = font;
+    entry->color = color;
+    entry->surface = surface;
+    entry->width = area.w;
+    entry->height = area.h;
+    cache->stats.bytesInUse += (uint32_t)area.w * area.h * 4;
+
+    return entry;
+}
+
+TextCacheEntry* takeEntry(TextCache* cache)
+{
+    TextCacheEntry* oldest = NULL;
+    uint8_t i = 0;
+
+    for (i = 0; i < TEXT_CACHE_MAX_ENTRIES; i++)
+    {
+        if (cache->entries[i].surface == NULL)
+        {
+            return &cache->entries[i];
+        }
+        if (oldest == NULL || cache->entries[i].lastUse < oldest->lastUse)
+        {
+            oldest = &cache->entries[i];
+        }
+    }
+
+    /* every entry is taken, least recently used string gives its place */
+    releaseEntry(cache, oldest);
+    cache->stats.evictionCount++;
+
+    return oldest;
+}
+
+void releaseEntry(TextCache* cache, TextCacheEntry* entry)
+{
+    cache->backend->releaseSurface(entry->surface);
+    cache->stats.bytesInUse -= (uint32_t)entry->width * entry->height * 4;
+    memset(entry, 0x0, sizeof(TextCacheEntry));
+}
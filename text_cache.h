@@ -0,0 +1,90 @@
+#ifndef __TEXT_CACHE_H__
+#define __TEXT_CACHE_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "osd_backend.h"
+
+#define TEXT_CACHE_MAX_ENTRIES 32                   /* Max number of rendered strings kept at once */
+#define TEXT_CACHE_MAX_TEXT_LENGTH 64               /* Max length of cached string with terminating zero */
+
+/**
+ * @brief Structure that holds one string rendered into an off-screen surface
+ */
+typedef struct _TextCacheEntry
+{
+    char text[TEXT_CACHE_MAX_TEXT_LENGTH];
+    OsdFont* font;
+    uint32_t color;                                 /* ARGB */
+    OsdSurface* surface;                            /* NULL while entry is free */
+    int32_t width;
+    int32_t height;
+    uint64_t lastUse;                               /* Value of use clock at last lookup */
+}TextCacheEntry;
+
+/**
+ * @brief Structure that holds text cache statistics
+ */
+typedef struct _TextCacheStats
+{
+    uint32_t hitCount;
+    uint32_t missCount;                             /* Lookups that rendered the string */
+    uint32_t evictionCount;
+    uint32_t bytesInUse;
+}TextCacheStats;
+
+/**
+ * @brief Structure that holds rendered strings keyed by string, font and colour
+ *
+ * Used by one thread only, the one that draws.
+ */
+typedef struct _TextCache
+{
+    const OsdBackend* backend;
+    uint64_t useClock;
+    TextCacheEntry entries[TEXT_CACHE_MAX_ENTRIES];
+    TextCacheStats stats;
+}TextCache;
+
+/**
+ * @brief Initializes text cache
+ *
+ * @param [out] cache - text cache
+ * @param [in]  backend - rendering backend that draws the strings
+ */
+void textCacheInit(TextCache* cache, const OsdBackend* backend);
+
+/**
+ * @brief Releases every rendered string
+ *
+ * @param [in] cache - text cache
+ */
+void textCacheDeinit(TextCache* cache);
+
+/**
+ * @brief Returns string rendered with given font and colour on transparent background, renders it on first use
+ *
+ * Top left corner of the surface is the top left corner of the text. Surface stays owned by the cache and
+ * is valid until next lookup, which may evict it.
+ *
+ * @param [in]  cache - text cache
+ * @param [in]  text - string, longer ones are not cached
+ * @param [in]  font - font
+ * @param [in]  color - ARGB colour
+ * @param [out] width - surface width
+ * @param [out] height - surface height
+ * @return surface, NULL if string could not be rendered
+ */
+OsdSurface* textCacheGet(TextCache* cache, const char* text, OsdFont* font, uint32_t color, int32_t* width, int32_t* height);
+
+/**
+ * @brief Returns text cache statistics
+ *
+ * @param [in]  cache - text cache
+ * @param [out] stats - statistics
+ */
+void textCacheGetStats(TextCache* cache, TextCacheStats* stats);
+
+#endif /* __TEXT_CACHE_H__ */
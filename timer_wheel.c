@@ -0,0 +1,374 @@
+#include "timer_wheel.h"
+
+#define TICK_NANOSECONDS ((uint64_t)TIMER_WHEEL_TICK * 1000000ULL)
+#define SLOT_MASK (TIMER_WHEEL_SLOTS - 1)
+
+static void* timerWheelTask(void* arg);
+static void insertTimer(TimerWheel* wheel, WheelTimer* timer);
+static void linkTimer(WheelTimer* head, WheelTimer* timer);
+static void unlinkTimer(WheelTimer* timer);
+static void advanceTick(TimerWheel* wheel);
+static void cascade(TimerWheel* wheel, uint8_t level);
+static void runExpired(TimerWheel* wheel);
+static void scheduleWake(TimerWheel* wheel);
+static void setWake(TimerWheel* wheel, uint64_t tick);
+static uint64_t currentTickOf(TimerWheel* wheel);
+static uint64_t monotonicNanoseconds();
+
+TimerWheelError timerWheelInit(TimerWheel* wheel)
+{
+    uint8_t level = 0;
+    uint8_t slot = 0;
+
+    memset(wheel, 0x0, sizeof(TimerWheel));
+
+    for (level = 0; level < TIMER_WHEEL_LEVELS; level++)
+    {
+        for (slot = 0; slot < TIMER_WHEEL_SLOTS; slot++)
+        {
+            wheel->slots[level][slot].next = &wheel->slots[level][slot];
+            wheel->slots[level][slot].prev = &wheel->slots[level][slot];
+        }
+    }
+    wheel->expired.next = &wheel->expired;
+    wheel->expired.prev = &wheel->expired;
+
+    wheel->timerFd = timerfd_create(CLOCK_MONOTONIC, 0);
+    if (wheel->timerFd < 0)
+    {
+        printf("\n%s : ERROR timerfd_create fail!\n", __FUNCTION__);
+        return TW_ERROR;
+    }
+
+    pthread_mutex_init(&wheel->mutex, NULL);
+    wheel->startNanoseconds = monotonicNanoseconds();
+
+    if (pthread_create(&wheel->thread, NULL, &timerWheelTask, wheel))
+    {
+        printf("\n%s : ERROR pthread_create fail!\n", __FUNCTION__);
+        close(wheel->timerFd);
+        pthread_mutex_destroy(&wheel->mutex);
+        return TW_THREAD_ERROR;
+    }
+
+    return TW_NO_ERROR;
+}
+
+TimerWheelError timerWheelDeinit(TimerWheel* wheel)
+{
+    struct itimerspec wake;
+
+    pthread_mutex_lock(&wheel->mutex);
+    wheel->threadExit = true;
+    /* fire timerfd right away so the task sees the exit flag */
+    memset(&wake, 0x0, sizeof(wake));
+    wake.it_value.tv_nsec = 1;
+    timerfd_settime(wheel->timerFd, 0, &wake, NULL);
+    pthread_mutex_unlock(&wheel->mutex);
+
+    if (pthread_join(wheel->thread, NULL))
+    {
+        printf("\n%s : ERROR pthread_join fail!\n", __FUNCTION__);
+        return TW_THREAD_ERROR;
+    }
+
+    close(wheel->timerFd);
+    pthread_mutex_destroy(&wheel->mutex);
+
+    return TW_NO_ERROR;
+}
+
+void timerWheelSetup(WheelTimer* timer, TimerWheelCallback callback, void* data)
+{
+    memset(timer, 0x0, sizeof(WheelTimer));
+    timer->callback = callback;
+    timer->data = data;
+}
+
+void timerWheelArm(TimerWheel* wheel, WheelTimer* timer, uint32_t timeout)
+{
+    uint64_t now = monotonicNanoseconds();
+    uint64_t dueTick = 0;
+
+    pthread_mutex_lock(&wheel->mutex);
+
+    if (timer->armed)
+    {
+        unlinkTimer(timer);
+        wheel->armedCount--;
+    }
+
+    if (wheel->armedCount == 0)
+    {
+        /* task did not tick while idle, wheel is empty so it can jump to now */
+        wheel->currentTick = currentTickOf(wheel);
+    }
+
+    /* first tick at or after due time */
+    timer->dueNanoseconds = now + (uint64_t)timeout * 1000000ULL;
+    dueTick = (timer->dueNanoseconds - wheel->startNanoseconds + TICK_NANOSECONDS - 1) / TICK_NANOSECONDS;
+    timer->expiryTick = (dueTick > wheel->currentTick) ? dueTick : wheel->currentTick + 1;
+    timer->armed = true;
+    insertTimer(wheel, timer);
+    wheel->armedCount++;
+    wheel->stats.armCount++;
+
+    if (wheel->wakeTick == 0 || timer->expiryTick < wheel->wakeTick)
+    {
+        setWake(wheel, timer->expiryTick);
+    }
+
+    pthread_mutex_unlock(&wheel->mutex);
+}
+
+void timerWheelCancel(TimerWheel* wheel, WheelTimer* timer)
+{
+    pthread_mutex_lock(&wheel->mutex);
+
+    if (timer->armed)
+    {
+        unlinkTimer(timer);
+        timer->armed = false;
+        wheel->armedCount--;
+        wheel->stats.cancelCount++;
+    }
+
+    pthread_mutex_unlock(&wheel->mutex);
+}
+
+void timerWheelGetStats(TimerWheel* wheel, TimerWheelStats* stats)
+{
+    pthread_mutex_lock(&wheel->mutex);
+    *stats = wheel->stats;
+    stats->runNanoseconds = monotonicNanoseconds() - wheel->startNanoseconds;
+    pthread_mutex_unlock(&wheel->mutex);
+}
+
+void timerWheelPrintStats(TimerWheel* wheel)
+{
+    TimerWheelStats stats;
+    uint64_t minutes = 0;
+
+    timerWheelGetStats(wheel, &stats);
+    minutes = stats.runNanoseconds / 60000000000ULL;
+
+    printf("\n%s : INFO %u armed, %u cancelled, %u expired (%llu per minute, no thread created for any), %u wakeups\n",
+            __FUNCTION__, stats.armCount, stats.cancelCount, stats.expiredCount,
+            (unsigned long long)(minutes ? stats.expiredCount / minutes : stats.expiredCount), stats.wakeupCount);
+    printf("%s : INFO latency average %llu us, worst %u us\n", __FUNCTION__,
+            (unsigned long long)(stats.expiredCount ? stats.totalLatency / stats.expiredCount : 0), stats.maxLatency);
+}
+
+void* timerWheelTask(void* arg)
+{
+    TimerWheel* wheel = (TimerWheel*)arg;
+    uint64_t expirations = 0;
+    uint64_t nowTick = 0;
+
+    while (true)
+    {
+        /* sleeps until the tick timerfd is set to, forever while no timer is armed */
+        if (read(wheel->timerFd, &expirations, sizeof(expirations)) < 0 && errno != EINTR)
+        {
+            printf("\n%s : ERROR timerfd read fail!\n", __FUNCTION__);
+            break;
+        }
+
+        pthread_mutex_lock(&wheel->mutex);
+        if (wheel->threadExit)
+        {
+            pthread_mutex_unlock(&wheel->mutex);
+            break;
+        }
+
+        wheel->stats.wakeupCount++;
+        wheel->wakeTick = 0;
+        nowTick = currentTickOf(wheel);
+        while (wheel->currentTick < nowTick)
+        {
+            advanceTick(wheel);
+        }
+        runExpired(wheel);
+        scheduleWake(wheel);
+        pthread_mutex_unlock(&wheel->mutex);
+    }
+
+    return NULL;
+}
+
+void insertTimer(TimerWheel* wheel, WheelTimer* timer)
+{
+    uint64_t delta = timer->expiryTick - wheel->currentTick;
+    uint8_t level = 0;
+
+    /* level whose range covers the delta, slot by the bits of expiry tick at that level */
+    while (level < TIMER_WHEEL_LEVELS - 1 && delta >= ((uint64_t)1 << ((level + 1) * TIMER_WHEEL_LEVEL_BITS)))
+    {
+        level++;
+    }
+    if (delta >= ((uint64_t)1 << (TIMER_WHEEL_LEVELS * TIMER_WHEEL_LEVEL_BITS)))
+    {
+        printf("\n%s : WARNING timeout out of range, timer expires early!\n", __FUNCTION__);
+        timer->expiryTick = wheel->currentTick + ((uint64_t)1 << (TIMER_WHEEL_LEVELS * TIMER_WHEEL_LEVEL_BITS)) - 1;
+    }
+
+    linkTimer(&wheel->slots[level][(timer->expiryTick >> (level * TIMER_WHEEL_LEVEL_BITS)) & SLOT_MASK], timer);
+}
+
+void linkTimer(WheelTimer* head, WheelTimer* timer)
+{
+    timer->prev = head->prev;
+    timer->next = head;
+    head->prev->next = timer;
+    head->prev = timer;
+}
+
+void unlinkTimer(WheelTimer* timer)
+{
+    timer->prev->next = timer->next;
+    timer->next->prev = timer->prev;
+    timer->next = NULL;
+    timer->prev = NULL;
+}
+
+void advanceTick(TimerWheel* wheel)
+{
+    WheelTimer* head = NULL;
+    WheelTimer* timer = NULL;
+    uint8_t level = 1;
+
+    wheel->currentTick++;
+
+    /* when a level wraps, the next slot of the level above is spread over the levels below */
+    while (level < TIMER_WHEEL_LEVELS && (wheel->currentTick & (((uint64_t)1 << (level * TIMER_WHEEL_LEVEL_BITS)) - 1)) == 0)
+    {
+        cascade(wheel, level);
+        level++;
+    }
+
+    head = &wheel->slots[0][wheel->currentTick & SLOT_MASK];
+    while (head->next != head)
+    {
+        timer = head->next;
+        unlinkTimer(timer);
+        linkTimer(&wheel->expired, timer);
+    }
+}
+
+void cascade(TimerWheel* wheel, uint8_t level)
+{
+    WheelTimer* head = &wheel->slots[level][(wheel->currentTick >> (level * TIMER_WHEEL_LEVEL_BITS)) & SLOT_MASK];
+    WheelTimer list;
+    WheelTimer* timer = NULL;
+
+    /* detach the slot first, timers may land in the same slot again */
+    if (head->next == head)
+    {
+        return;
+    }
+    list.next = head->next;
+    list.prev = head->prev;
+    list.next->prev = &list;
+    list.prev->next = &list;
+    head->next = head;
+    head->prev = head;
+
+    while (list.next != &list)
+    {
+        timer = list.next;
+        unlinkTimer(timer);
+        insertTimer(wheel, timer);
+    }
+}
+
+void runExpired(TimerWheel* wheel)
+{
+    WheelTimer* timer = NULL;
+    TimerWheelCallback callback = NULL;
+    void* data = NULL;
+    uint64_t latency = 0;
+
+    /* one at a time, a timer cancelled or re-armed by an earlier callback is not called */
+    while (wheel->expired.next != &wheel->expired)
+    {
+        timer = wheel->expired.next;
+        unlinkTimer(timer);
+        timer->armed = false;
+        wheel->armedCount--;
+        callback = timer->callback;
+        data = timer->data;
+
+        latency = (monotonicNanoseconds() - timer->dueNanoseconds) / 1000;
+        wheel->stats.expiredCount++;
+        wheel->stats.totalLatency += latency;
+        if (latency > wheel->stats.maxLatency)
+        {
+            wheel->stats.maxLatency = latency;
+        }
+
+        pthread_mutex_unlock(&wheel->mutex);
+        callback(data);
+        pthread_mutex_lock(&wheel->mutex);
+    }
+}
+
+void scheduleWake(TimerWheel* wheel)
+{
+    uint64_t tick = 0;
+
+    if (wheel->armedCount == 0)
+    {
+        setWake(wheel, 0);
+        return;
+    }
+
+    /* first occupied slot of this round of level 0, or the tick the level above cascades */
+    for (tick = wheel->currentTick + 1; (tick & SLOT_MASK) != 0; tick++)
+    {
+        if (wheel->slots[0][tick & SLOT_MASK].next != &wheel->slots[0][tick & SLOT_MASK])
+        {
+            break;
+        }
+    }
+    if ((tick & SLOT_MASK) == 0 && wheel->slots[0][0].next == &wheel->slots[0][0])
+    {
+        /* nothing left in level 0, skip to next occupied slot of level 1 */
+        while (wheel->slots[1][(tick >> TIMER_WHEEL_LEVEL_BITS) & SLOT_MASK].next == &wheel->slots[1][(tick >> TIMER_WHEEL_LEVEL_BITS) & SLOT_MASK]
+               && ((tick >> TIMER_WHEEL_LEVEL_BITS) & SLOT_MASK) != 0)
+        {
+            tick += TIMER_WHEEL_SLOTS;
+        }
+    }
+
+    setWake(wheel, tick);
+}
+
+void setWake(TimerWheel* wheel, uint64_t tick)
+{
+    struct itimerspec wake;
+    uint64_t wakeNanoseconds = wheel->startNanoseconds + tick * TICK_NANOSECONDS;
+
+    memset(&wake, 0x0, sizeof(wake));
+    if (tick != 0)
+    {
+        wake.it_value.tv_sec = wakeNanoseconds / 1000000000ULL;
+        wake.it_value.tv_nsec = wakeNanoseconds % 1000000000ULL;
+    }
+    /* zero it_value disarms timerfd */
+    timerfd_settime(wheel->timerFd, TFD_TIMER_ABSTIME, &wake, NULL);
+    wheel->wakeTick = tick;
+}
+
+uint64_t currentTickOf(TimerWheel* wheel)
+{
+    return (monotonicNanoseconds() - wheel->startNanoseconds) / TICK_NANOSECONDS;
+}
+
+uint64_t monotonicNanoseconds()
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
@@ -0,0 +1,139 @@
+#ifndef __TIMER_WHEEL_H__
+#define __TIMER_WHEEL_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
+#include "pthread.h"
+
+#define TIMER_WHEEL_TICK 1                          /* Resolution of timers in ms */
+#define TIMER_WHEEL_LEVEL_BITS 6
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_LEVEL_BITS) /* Slots per level, a level covers 64 times the range of the level below */
+#define TIMER_WHEEL_LEVELS 4                        /* 64^4 ticks, timers up to about 4.6 hours */
+
+/**
+ * @brief Structure that defines timer wheel error
+ */
+typedef enum _TimerWheelError
+{
+    TW_NO_ERROR = 0,
+    TW_ERROR,
+    TW_THREAD_ERROR
+}TimerWheelError;
+
+/**
+ * @brief Timer callback, called on timer wheel task
+ */
+typedef void(*TimerWheelCallback)(void* data);
+
+/**
+ * @brief Structure that holds one timer, owned by the caller
+ */
+typedef struct _WheelTimer
+{
+    struct _WheelTimer* next;                       /* Slot or expired list the timer is linked in */
+    struct _WheelTimer* prev;
+    uint64_t expiryTick;
+    uint64_t dueNanoseconds;                        /* Monotonic time the timer is due, for latency */
+    TimerWheelCallback callback;
+    void* data;
+    bool armed;
+}WheelTimer;
+
+/**
+ * @brief Structure that holds timer wheel statistics
+ */
+typedef struct _TimerWheelStats
+{
+    uint32_t armCount;
+    uint32_t cancelCount;
+    uint32_t expiredCount;
+    uint32_t wakeupCount;                           /* Times the task woke up */
+    uint64_t totalLatency;                          /* From due time to callback in us */
+    uint32_t maxLatency;
+    uint64_t runNanoseconds;                        /* Time since timer wheel was started */
+}TimerWheelStats;
+
+/**
+ * @brief Structure that holds hierarchical timer wheel driven by one timerfd and one task
+ *
+ * Arm, re-arm and cancel are O(1). Task sleeps while no timer is armed.
+ */
+typedef struct _TimerWheel
+{
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    int timerFd;
+    bool threadExit;
+    uint64_t startNanoseconds;                      /* Tick 0 */
+    uint64_t currentTick;                           /* Last tick whose timers were expired */
+    uint64_t wakeTick;                              /* Tick timerfd is set to, 0 when it is not set */
+    uint32_t armedCount;
+    WheelTimer slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS]; /* List heads */
+    WheelTimer expired;                             /* List head of timers whose callback is due */
+    TimerWheelStats stats;
+}TimerWheel;
+
+/**
+ * @brief Initializes timer wheel and starts its task
+ *
+ * @param [out] wheel - timer wheel
+ * @return timer wheel error code
+ */
+TimerWheelError timerWheelInit(TimerWheel* wheel);
+
+/**
+ * @brief Stops task of timer wheel, armed timers do not expire anymore
+ *
+ * @param [in] wheel - timer wheel
+ * @return timer wheel error code
+ */
+TimerWheelError timerWheelDeinit(TimerWheel* wheel);
+
+/**
+ * @brief Sets callback of a timer, must be called before the timer is armed first time
+ *
+ * @param [out] timer - timer
+ * @param [in]  callback - function called when timer expires
+ * @param [in]  data - passed to callback
+ */
+void timerWheelSetup(WheelTimer* timer, TimerWheelCallback callback, void* data);
+
+/**
+ * @brief Arms timer, an armed timer is moved to the new expiry
+ *
+ * @param [in] wheel - timer wheel
+ * @param [in] timer - timer
+ * @param [in] timeout - time to expiry in ms
+ */
+void timerWheelArm(TimerWheel* wheel, WheelTimer* timer, uint32_t timeout);
+
+/**
+ * @brief Cancels timer, its callback is not called once this returns unless it is already running
+ *
+ * @param [in] wheel - timer wheel
+ * @param [in] timer - timer
+ */
+void timerWheelCancel(TimerWheel* wheel, WheelTimer* timer);
+
+/**
+ * @brief Returns timer wheel statistics
+ *
+ * @param [in]  wheel - timer wheel
+ * @param [out] stats - statistics
+ */
+void timerWheelGetStats(TimerWheel* wheel, TimerWheelStats* stats);
+
+/**
+ * @brief Prints timer wheel statistics
+ *
+ * @param [in] wheel - timer wheel
+ */
+void timerWheelPrintStats(TimerWheel* wheel);
+
+#endif /* __TIMER_WHEEL_H__ */
@@ -0,0 +1,635 @@
+#include "timeshift.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static uint8_t* bufferData = NULL;
+static uint64_t bufferSize = 0;
+static int32_t bufferFileDesc = -1;
+
+static TimeshiftIndexHeader* indexHeader = NULL;
+static TimeshiftIndexEntry* indexEntries = NULL;
+static size_t indexMapSize = 0;
+static int32_t indexFileDesc = -1;
+
+/* logical offsets grow forever, buffer position is offset modulo buffer size */
+static uint64_t writeOffset = 0;
+static uint64_t readOffset = 0;
+
+static uint16_t servicePids[TIMESHIFT_MAX_PIDS];
+static uint8_t servicePidCount = 0;
+static uint16_t servicePcrPid = TS_NULL_PID;
+static uint64_t lastTimestamp = 0;
+static bool timestampValid = false;
+
+static bool isInitialized = false;
+static bool paused = false;
+static bool playing = false;
+static bool playbackExit = false;
+static bool clockReset = false;
+static TimeshiftOutputCallback outputCallback = NULL;
+
+static pthread_t playbackThread;
+static pthread_mutex_t timeshiftMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t timeshiftCond = PTHREAD_COND_INITIALIZER;
+
+static void* mapFile(const char* path, size_t size, int32_t* fileDesc);
+static void unmapFile(void* data, size_t size, int32_t* fileDesc);
+static bool isServicePid(uint16_t pid);
+static void indexAppend(uint64_t timestamp, uint64_t offset);
+static void indexEvict(uint64_t oldestOffset);
+static TimeshiftIndexEntry* indexEntryAt(uint32_t position);
+static uint32_t indexFindByTimestamp(uint64_t timestamp);
+static uint32_t indexFindByOffset(uint64_t offset);
+static uint64_t oldestReadableOffset();
+static void* playbackTask();
+
+TimeshiftError timeshiftInit(const char* bufferPath, uint32_t size)
+{
+    char indexPath[256];
+
+    if (bufferPath == NULL || size < TS_PACKET_SIZE)
+    {
+        printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+        return TIMESHIFT_ERROR;
+    }
+
+    pthread_mutex_lock(&timeshiftMutex);
+    if (isInitialized)
+    {
+        pthread_mutex_unlock(&timeshiftMutex);
+        return TIMESHIFT_NO_ERROR;
+    }
+
+    /* packets never straddle the end of the buffer */
+    bufferSize = size - (size % TS_PACKET_SIZE);
+
+    bufferData = (uint8_t*) mapFile(bufferPath, bufferSize, &bufferFileDesc);
+    if (bufferData == NULL)
+    {
+        pthread_mutex_unlock(&timeshiftMutex);
+        return TIMESHIFT_ERROR;
+    }
+
+    snprintf(indexPath, sizeof(indexPath), "%s.idx", bufferPath);
+    indexMapSize = sizeof(TimeshiftIndexHeader) + TIMESHIFT_INDEX_CAPACITY * sizeof(TimeshiftIndexEntry);
+    indexHeader = (TimeshiftIndexHeader*) mapFile(indexPath, indexMapSize, &indexFileDesc);
+    if (indexHeader == NULL)
+    {
+        unmapFile(bufferData, bufferSize, &bufferFileDesc);
+        bufferData = NULL;
+        pthread_mutex_unlock(&timeshiftMutex);
+        return TIMESHIFT_ERROR;
+    }
+    indexEntries = (TimeshiftIndexEntry*) (indexHeader + 1);
+
+    indexHeader->magic = TIMESHIFT_INDEX_MAGIC;
+    indexHeader->capacity = TIMESHIFT_INDEX_CAPACITY;
+    indexHeader->head = 0;
+    indexHeader->count = 0;
+    indexHeader->bufferSize = bufferSize;
+
+    writeOffset = 0;
+    readOffset = 0;
+    timestampValid = false;
+    isInitialized = true;
+    pthread_mutex_unlock(&timeshiftMutex);
+
+    printf("\n%s : INFO timeshift buffer %s (%llu bytes) ready\n", __FUNCTION__, bufferPath, (unsigned long long) bufferSize);
+
+    return TIMESHIFT_NO_ERROR;
+}
+
+TimeshiftError timeshiftDeinit()
+{
+    bool initialized = false;
+
+    pthread_mutex_lock(&timeshiftMutex);
+    initialized = isInitialized;
+    pthread_mutex_unlock(&timeshiftMutex);
+
+    if (!initialized)
+    {
+        return TIMESHIFT_NOT_AVAILABLE;
+    }
+
+    timeshiftStop();
+
+    pthread_mutex_lock(&timeshiftMutex);
+    isInitialized = false;
+    unmapFile(indexHeader, indexMapSize, &indexFileDesc);
+    unmapFile(bufferData, bufferSize, &bufferFileDesc);
+    indexHeader = NULL;
+    indexEntries = NULL;
+    bufferData = NULL;
+    pthread_mutex_unlock(&timeshiftMutex);
+
+    return TIMESHIFT_NO_ERROR;
+}
+
+TimeshiftError timeshiftSetService(uint16_t pcrPid, const uint16_t* pids, uint8_t pidCount)
+{
+    if (pids == NULL || pidCount > TIMESHIFT_MAX_PIDS)
+    {
+        printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+        return TIMESHIFT_ERROR;
+    }
+
+    pthread_mutex_lock(&timeshiftMutex);
+    if (!isInitialized)
+    {
+        pthread_mutex_unlock(&timeshiftMutex);
+        return TIMESHIFT_NOT_AVAILABLE;
+    }
+
+    memcpy(servicePids, pids, pidCount * sizeof(uint16_t));
+    servicePidCount = pidCount;
+    servicePcrPid = pcrPid;
+
+    /* content of previous service is not valid any more */
+    writeOffset = 0;
+    readOffset = 0;
+    indexHeader->head = 0;
+    indexHeader->count = 0;
+    timestampValid = false;
+    clockReset = true;
+    pthread_mutex_unlock(&timeshiftMutex);
+
+    return TIMESHIFT_NO_ERROR;
+}
+
+TimeshiftError timeshiftWritePackets(const uint8_t* packets, uint32_t packetCount)
+{
+    uint32_t i = 0;
+    uint64_t pcrBase = 0;
+
+    if (packets == NULL)
+    {
+        return TIMESHIFT_ERROR;
+    }
+
+    pthread_mutex_lock(&timeshiftMutex);
+    if (!isInitialized)
+    {
+        pthread_mutex_unlock(&timeshiftMutex);
+        return TIMESHIFT_NOT_AVAILABLE;
+    }
+
+    for (i = 0; i < packetCount; i++)
+    {
+        const uint8_t* packet = packets + i * TS_PACKET_SIZE;
+        uint16_t pid = 0;
+
+        if (*packet != TS_SYNC_BYTE)
+        {
+            continue;
+        }
+
+        pid = tsPacketGetPid(packet);
+        if (!isServicePid(pid))
+        {
+            continue;
+        }
+
+        /* drop index entries pointing to the data this packet overwrites */
+        if (writeOffset + TS_PACKET_SIZE > bufferSize)
+        {
+            indexEvict(writeOffset + TS_PACKET_SIZE - bufferSize);
+        }
+
+        if (pid == servicePcrPid && tsPacketGetPcr(packet, &pcrBase) == TS_PACKET_OK)
+        {
+            uint64_t timestamp = timestampValid ? tsTimestampUnwrap(pcrBase, lastTimestamp) : pcrBase;
+
+            if (indexHeader->count == 0 ||
+                timestamp >= indexEntryAt(indexHeader->count - 1)->timestamp + TIMESHIFT_INDEX_INTERVAL)
+            {
+                indexAppend(timestamp, writeOffset);
+            }
+
+            lastTimestamp = timestamp;
+            timestampValid = true;
+        }
+
+        memcpy(bufferData + (writeOffset % bufferSize), packet, TS_PACKET_SIZE);
+        writeOffset += TS_PACKET_SIZE;
+    }
+
+    pthread_cond_signal(&timeshiftCond);
+    pthread_mutex_unlock(&timeshiftMutex);
+
+    return TIMESHIFT_NO_ERROR;
+}
+
+TimeshiftError timeshiftPause()
+{
+    pthread_mutex_lock(&timeshiftMutex);
+    if (!isInitialized)
+    {
+        pthread_mutex_unlock(&timeshiftMutex);
+        return TIMESHIFT_NOT_AVAILABLE;
+    }
+
+    if (!playing)
+    {
+        /* pausing live, playback will continue from this point */
+        readOffset = writeOffset;
+    }
+    paused = true;
+    pthread_mutex_unlock(&timeshiftMutex);
+
+    return TIMESHIFT_NO_ERROR;
+}
+
+TimeshiftError timeshiftResume(TimeshiftOutputCallback callback)
+{
+    if (callback == NULL)
+    {
+        printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+        return TIMESHIFT_ERROR;
+    }
+
+    pthread_mutex_lock(&timeshiftMutex);
+    if (!isInitialized)
+    {
+        pthread_mutex_unlock(&timeshiftMutex);
+        return TIMESHIFT_NOT_AVAILABLE;
+    }
+
+    outputCallback = callback;
+    paused = false;
+    clockReset = true;
+
+    if (!playing)
+    {
+        playbackExit = false;
+        if (pthread_create(&playbackThread, NULL, &playbackTask, NULL))
+        {
+            pthread_mutex_unlock(&timeshiftMutex);
+            printf("\n%s : ERROR creating playback task!\n", __FUNCTION__);
+            return TIMESHIFT_THREAD_ERROR;
+        }
+        playing = true;
+    }
+
+    pthread_cond_signal(&timeshiftCond);
+    pthread_mutex_unlock(&timeshiftMutex);
+
+    return TIMESHIFT_NO_ERROR;
+}
+
+TimeshiftError timeshiftSeekRelative(int32_t seconds)
+{
+    uint32_t position = 0;
+    uint64_t currentTimestamp = 0;
+    uint64_t targetTimestamp = 0;
+    int64_t delta = (int64_t) seconds * TS_CLOCK_FREQUENCY;
+
+    pthread_mutex_lock(&timeshiftMutex);
+
+    if (!isInitialized || indexHeader->count == 0)
+    {
+        pthread_mutex_unlock(&timeshiftMutex);
+        return TIMESHIFT_NOT_AVAILABLE;
+    }
+
+    if (!playing && !paused)
+    {
+        /* seeking from live */
+        readOffset = writeOffset;
+    }
+
+    currentTimestamp = indexEntryAt(indexFindByOffset(readOffset))->timestamp;
+    if (delta < 0 && (uint64_t) (-delta) > currentTimestamp)
+    {
+        targetTimestamp = 0;
+    }
+    else
+    {
+        targetTimestamp = currentTimestamp + delta;
+    }
+
+    /* target past the last entry ends right behind live */
+    position = indexFindByTimestamp(targetTimestamp);
+    readOffset = indexEntryAt(position)->offset;
+
+    clockReset = true;
+    pthread_cond_signal(&timeshiftCond);
+    pthread_mutex_unlock(&timeshiftMutex);
+
+    return TIMESHIFT_NO_ERROR;
+}
+
+TimeshiftError timeshiftStop()
+{
+    bool wasPlaying = false;
+
+    pthread_mutex_lock(&timeshiftMutex);
+    if (!isInitialized)
+    {
+        pthread_mutex_unlock(&timeshiftMutex);
+        return TIMESHIFT_NOT_AVAILABLE;
+    }
+
+    wasPlaying = playing;
+    playbackExit = true;
+    paused = false;
+    pthread_cond_signal(&timeshiftCond);
+    pthread_mutex_unlock(&timeshiftMutex);
+
+    if (wasPlaying && pthread_join(playbackThread, NULL))
+    {
+        printf("\n%s : ERROR pthread_join fail!\n", __FUNCTION__);
+        return TIMESHIFT_THREAD_ERROR;
+    }
+
+    pthread_mutex_lock(&timeshiftMutex);
+    playing = false;
+    pthread_mutex_unlock(&timeshiftMutex);
+
+    return TIMESHIFT_NO_ERROR;
+}
+
+TimeshiftError timeshiftGetStatus(TimeshiftStatus* status)
+{
+    uint64_t readTimestamp = 0;
+
+    if (status == NULL)
+    {
+        printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+        return TIMESHIFT_ERROR;
+    }
+
+    memset(status, 0x0, sizeof(TimeshiftStatus));
+
+    pthread_mutex_lock(&timeshiftMutex);
+    if (!isInitialized)
+    {
+        pthread_mutex_unlock(&timeshiftMutex);
+        return TIMESHIFT_NOT_AVAILABLE;
+    }
+
+    status->paused = paused;
+    status->playing = playing;
+    if (indexHeader->count > 0)
+    {
+        status->bufferedSeconds = (uint32_t) ((lastTimestamp - indexEntryAt(0)->timestamp) / TS_CLOCK_FREQUENCY);
+
+        if (playing || paused)
+        {
+            readTimestamp = indexEntryAt(indexFindByOffset(readOffset))->timestamp;
+            status->delaySeconds = (uint32_t) ((lastTimestamp - readTimestamp) / TS_CLOCK_FREQUENCY);
+        }
+    }
+    pthread_mutex_unlock(&timeshiftMutex);
+
+    return TIMESHIFT_NO_ERROR;
+}
+
+static void* mapFile(const char* path, size_t size, int32_t* fileDesc)
+{
+    void* data = NULL;
+
+    *fileDesc = open(path, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+    if (*fileDesc == -1)
+    {
+        printf("\n%s : ERROR opening %s (%s)\n", __FUNCTION__, path, strerror(errno));
+        return NULL;
+    }
+
+    if (ftruncate(*fileDesc, size))
+    {
+        printf("\n%s : ERROR resizing %s (%s)\n", __FUNCTION__, path, strerror(errno));
+        close(*fileDesc);
+        *fileDesc = -1;
+        return NULL;
+    }
+
+    data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, *fileDesc, 0);
+    if (data == MAP_FAILED)
+    {
+        printf("\n%s : ERROR mapping %s (%s)\n", __FUNCTION__, path, strerror(errno));
+        close(*fileDesc);
+        *fileDesc = -1;
+        return NULL;
+    }
+
+    return data;
+}
+
+static void unmapFile(void* data, size_t size, int32_t* fileDesc)
+{
+    if (data != NULL)
+    {
+        munmap(data, size);
+    }
+
+    if (*fileDesc != -1)
+    {
+        close(*fileDesc);
+        *fileDesc = -1;
+    }
+}
+
+static bool isServicePid(uint16_t pid)
+{
+    uint8_t i = 0;
+
+    for (i = 0; i < servicePidCount; i++)
+    {
+        if (servicePids[i] == pid)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static TimeshiftIndexEntry* indexEntryAt(uint32_t position)
+{
+    return &indexEntries[(indexHeader->head + position) % indexHeader->capacity];
+}
+
+static void indexAppend(uint64_t timestamp, uint64_t offset)
+{
+    TimeshiftIndexEntry* entry = NULL;
+
+    if (indexHeader->count == indexHeader->capacity)
+    {
+        /* index is full, oldest entry is lost */
+        indexHeader->head = (indexHeader->head + 1) % indexHeader->capacity;
+        indexHeader->count--;
+    }
+
+    entry = indexEntryAt(indexHeader->count);
+    entry->timestamp = timestamp;
+    entry->offset = offset;
+    indexHeader->count++;
+}
+
+static void indexEvict(uint64_t oldestOffset)
+{
+    while (indexHeader->count > 0 && indexEntryAt(0)->offset < oldestOffset)
+    {
+        indexHeader->head = (indexHeader->head + 1) % indexHeader->capacity;
+        indexHeader->count--;
+    }
+}
+
+/* binary search for the last entry whose time stamp is not after the given one */
+static uint32_t indexFindByTimestamp(uint64_t timestamp)
+{
+    uint32_t low = 0;
+    uint32_t high = indexHeader->count;
+
+    while (high - low > 1)
+    {
+        uint32_t middle = low + (high - low) / 2;
+
+        if (indexEntryAt(middle)->timestamp <= timestamp)
+        {
+            low = middle;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+/* binary search for the last entry whose offset is not after the given one */
+static uint32_t indexFindByOffset(uint64_t offset)
+{
+    uint32_t low = 0;
+    uint32_t high = indexHeader->count;
+
+    while (high - low > 1)
+    {
+        uint32_t middle = low + (high - low) / 2;
+
+        if (indexEntryAt(middle)->offset <= offset)
+        {
+            low = middle;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+static uint64_t oldestReadableOffset()
+{
+    if (indexHeader->count > 0)
+    {
+        return indexEntryAt(0)->offset;
+    }
+
+    return (writeOffset > bufferSize) ? (writeOffset - bufferSize) : 0;
+}
+
+static void* playbackTask()
+{
+    static uint8_t chunk[TIMESHIFT_PLAYBACK_CHUNK * TS_PACKET_SIZE];
+    struct timespec clockStart;
+    struct timespec wakeTime;
+    uint64_t clockTimestamp = 0;
+    uint64_t lastPcr = 0;
+    bool clockValid = false;
+
+    while (1)
+    {
+        uint32_t packetCount = 0;
+        uint32_t i = 0;
+        uint16_t pcrPid = 0;
+        TimeshiftOutputCallback callback = NULL;
+
+        pthread_mutex_lock(&timeshiftMutex);
+        while (!playbackExit && (paused || readOffset >= writeOffset))
+        {
+            pthread_cond_wait(&timeshiftCond, &timeshiftMutex);
+        }
+
+        if (playbackExit)
+        {
+            pthread_mutex_unlock(&timeshiftMutex);
+            break;
+        }
+
+        /* playback fell behind the writer, continue from oldest content */
+        if (readOffset < oldestReadableOffset())
+        {
+            readOffset = oldestReadableOffset();
+        }
+
+        if (clockReset)
+        {
+            clockValid = false;
+            clockReset = false;
+        }
+
+        packetCount = (uint32_t) ((writeOffset - readOffset) / TS_PACKET_SIZE);
+        if (packetCount > TIMESHIFT_PLAYBACK_CHUNK)
+        {
+            packetCount = TIMESHIFT_PLAYBACK_CHUNK;
+        }
+        if (packetCount > (bufferSize - readOffset % bufferSize) / TS_PACKET_SIZE)
+        {
+            packetCount = (uint32_t) ((bufferSize - readOffset % bufferSize) / TS_PACKET_SIZE);
+        }
+
+        memcpy(chunk, bufferData + readOffset % bufferSize, packetCount * TS_PACKET_SIZE);
+        readOffset += packetCount * TS_PACKET_SIZE;
+        callback = outputCallback;
+        pcrPid = servicePcrPid;
+        pthread_mutex_unlock(&timeshiftMutex);
+
+        /* pace output by PCR so the buffer plays back in real time */
+        for (i = 0; i < packetCount; i++)
+        {
+            uint64_t pcrBase = 0;
+            const uint8_t* packet = chunk + i * TS_PACKET_SIZE;
+
+            if (tsPacketGetPid(packet) != pcrPid || tsPacketGetPcr(packet, &pcrBase) != TS_PACKET_OK)
+            {
+                continue;
+            }
+
+            lastPcr = clockValid ? tsTimestampUnwrap(pcrBase, lastPcr) : pcrBase;
+            if (!clockValid || lastPcr < clockTimestamp ||
+                lastPcr - clockTimestamp > (uint64_t) 3600 * TS_CLOCK_FREQUENCY)
+            {
+                clock_gettime(CLOCK_MONOTONIC, &clockStart);
+                clockTimestamp = lastPcr;
+                clockValid = true;
+            }
+            else
+            {
+                uint64_t elapsed = (lastPcr - clockTimestamp) * 1000000000ULL / TS_CLOCK_FREQUENCY;
+
+                wakeTime.tv_sec = clockStart.tv_sec + (time_t) (elapsed / 1000000000ULL);
+                wakeTime.tv_nsec = clockStart.tv_nsec + (long) (elapsed % 1000000000ULL);
+                if (wakeTime.tv_nsec >= 1000000000L)
+                {
+                    wakeTime.tv_sec++;
+                    wakeTime.tv_nsec -= 1000000000L;
+                }
+                clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wakeTime, NULL);
+            }
+            break;
+        }
+
+        if (callback != NULL)
+        {
+            callback(chunk, packetCount);
+        }
+    }
+
+    return NULL;
+}
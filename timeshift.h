@@ -0,0 +1,140 @@
+#ifndef __TIMESHIFT_H__
+#define __TIMESHIFT_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "pthread.h"
+#include "ts_packet.h"
+
+#define TIMESHIFT_MAX_PIDS 8                        /* Max number of pids of one service stored in buffer */
+#define TIMESHIFT_INDEX_CAPACITY 8192               /* Max number of entries in sidecar index */
+#define TIMESHIFT_INDEX_INTERVAL 45000              /* Min distance between two index entries (0.5 s in 90 kHz units) */
+#define TIMESHIFT_INDEX_MAGIC 0x54534958            /* "TSIX" */
+#define TIMESHIFT_PLAYBACK_CHUNK 64                 /* Number of packets handed to output callback at once */
+
+/**
+ * @brief Structure that defines timeshift error
+ */
+typedef enum _TimeshiftError
+{
+    TIMESHIFT_NO_ERROR = 0,
+    TIMESHIFT_ERROR,
+    TIMESHIFT_THREAD_ERROR,
+    TIMESHIFT_NOT_AVAILABLE
+}TimeshiftError;
+
+/**
+ * @brief Structure that defines one entry of sidecar index
+ */
+typedef struct _TimeshiftIndexEntry
+{
+    uint64_t timestamp;                             /* Unwrapped PCR (or PTS) in 90 kHz units */
+    uint64_t offset;                                /* Logical byte offset of packet carrying the time stamp */
+}TimeshiftIndexEntry;
+
+/**
+ * @brief Structure that defines header of sidecar index file
+ */
+typedef struct _TimeshiftIndexHeader
+{
+    uint32_t magic;
+    uint32_t capacity;
+    uint32_t head;                                  /* Position of oldest entry */
+    uint32_t count;                                 /* Number of valid entries */
+    uint64_t bufferSize;                            /* Size of circular buffer file in bytes */
+}TimeshiftIndexHeader;
+
+/**
+ * @brief Structure that holds timeshift status
+ */
+typedef struct _TimeshiftStatus
+{
+    bool paused;
+    bool playing;                                   /* Playback from buffer is active */
+    uint32_t bufferedSeconds;                       /* Amount of content held in buffer */
+    uint32_t delaySeconds;                          /* Distance between playback position and live */
+}TimeshiftStatus;
+
+/**
+ * @brief Timeshift output callback, receives packets played back from buffer
+ */
+typedef void(*TimeshiftOutputCallback)(const uint8_t* packets, uint32_t packetCount);
+
+/**
+ * @brief Creates and maps circular buffer file and its sidecar index
+ *
+ * @param [in] bufferPath - path of circular buffer file, index is stored next to it with .idx suffix
+ * @param [in] bufferSize - size of circular buffer in bytes, rounded down to whole packets
+ * @return timeshift error code
+ */
+TimeshiftError timeshiftInit(const char* bufferPath, uint32_t bufferSize);
+
+/**
+ * @brief Stops playback and unmaps buffer and index
+ *
+ * @return timeshift error code
+ */
+TimeshiftError timeshiftDeinit();
+
+/**
+ * @brief Selects packets that are stored in buffer and drops previous content
+ *
+ * @param [in] pcrPid - pid carrying PCR of the service
+ * @param [in] pids - pids of the service (PAT, PMT, elementary streams)
+ * @param [in] pidCount - number of pids
+ * @return timeshift error code
+ */
+TimeshiftError timeshiftSetService(uint16_t pcrPid, const uint16_t* pids, uint8_t pidCount);
+
+/**
+ * @brief Appends packets of current service to buffer, called from demux
+ *
+ * @param [in] packets - transport stream packets
+ * @param [in] packetCount - number of packets
+ * @return timeshift error code
+ */
+TimeshiftError timeshiftWritePackets(const uint8_t* packets, uint32_t packetCount);
+
+/**
+ * @brief Freezes playback position, recording into buffer continues
+ *
+ * @return timeshift error code
+ */
+TimeshiftError timeshiftPause();
+
+/**
+ * @brief Starts or continues playback from buffer
+ *
+ * @param [in] outputCallback - callback receiving played back packets
+ * @return timeshift error code
+ */
+TimeshiftError timeshiftResume(TimeshiftOutputCallback outputCallback);
+
+/**
+ * @brief Moves playback position relative to current one using the index
+ *
+ * @param [in] seconds - negative value rewinds, positive value goes towards live
+ * @return timeshift error code
+ */
+TimeshiftError timeshiftSeekRelative(int32_t seconds);
+
+/**
+ * @brief Stops playback from buffer, recording into buffer continues
+ *
+ * @return timeshift error code
+ */
+TimeshiftError timeshiftStop();
+
+/**
+ * @brief Returns current timeshift status
+ *
+ * @param [out] status - timeshift status
+ * @return timeshift error code
+ */
+TimeshiftError timeshiftGetStatus(TimeshiftStatus* status);
+
+#endif /* __TIMESHIFT_H__ */
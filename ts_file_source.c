@@ -0,0 +1,219 @@
+#include "ts_file_source.h"
+#include <time.h>
+
+static FILE* sourceFile = NULL;
+static TsFileSourceCallback packetCallback = NULL;
+static bool sourceExit = false;
+static bool threadStarted = false;
+static bool isRunning = false;
+
+static pthread_t sourceThread;
+static pthread_mutex_t sourceMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static uint32_t findPacketStart(const uint8_t* data, uint32_t length);
+static void* sourceTask();
+
+TsFileSourceError tsFileSourceStart(const char* path, TsFileSourceCallback callback)
+{
+    if (path == NULL || callback == NULL)
+    {
+        printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+        return TS_FILE_SOURCE_ERROR;
+    }
+
+    pthread_mutex_lock(&sourceMutex);
+    if (threadStarted)
+    {
+        pthread_mutex_unlock(&sourceMutex);
+        printf("\n%s : ERROR file source is already started\n", __FUNCTION__);
+        return TS_FILE_SOURCE_ERROR;
+    }
+
+    sourceFile = fopen(path, "rb");
+    if (sourceFile == NULL)
+    {
+        pthread_mutex_unlock(&sourceMutex);
+        printf("\n%s : ERROR opening %s (%s)\n", __FUNCTION__, path, strerror(errno));
+        return TS_FILE_SOURCE_ERROR;
+    }
+
+    packetCallback = callback;
+    sourceExit = false;
+    isRunning = true;
+    if (pthread_create(&sourceThread, NULL, &sourceTask, NULL))
+    {
+        fclose(sourceFile);
+        sourceFile = NULL;
+        isRunning = false;
+        pthread_mutex_unlock(&sourceMutex);
+        printf("\n%s : ERROR creating file source task!\n", __FUNCTION__);
+        return TS_FILE_SOURCE_THREAD_ERROR;
+    }
+    threadStarted = true;
+    pthread_mutex_unlock(&sourceMutex);
+
+    printf("\n%s : INFO reading transport stream from %s\n", __FUNCTION__, path);
+
+    return TS_FILE_SOURCE_NO_ERROR;
+}
+
+TsFileSourceError tsFileSourceStop()
+{
+    pthread_mutex_lock(&sourceMutex);
+    if (!threadStarted)
+    {
+        pthread_mutex_unlock(&sourceMutex);
+        return TS_FILE_SOURCE_ERROR;
+    }
+    sourceExit = true;
+    pthread_mutex_unlock(&sourceMutex);
+
+    if (pthread_join(sourceThread, NULL))
+    {
+        printf("\n%s : ERROR pthread_join fail!\n", __FUNCTION__);
+        return TS_FILE_SOURCE_THREAD_ERROR;
+    }
+
+    pthread_mutex_lock(&sourceMutex);
+    fclose(sourceFile);
+    sourceFile = NULL;
+    threadStarted = false;
+    isRunning = false;
+    pthread_mutex_unlock(&sourceMutex);
+
+    return TS_FILE_SOURCE_NO_ERROR;
+}
+
+bool tsFileSourceIsRunning()
+{
+    bool running = false;
+
+    pthread_mutex_lock(&sourceMutex);
+    running = isRunning;
+    pthread_mutex_unlock(&sourceMutex);
+
+    return running;
+}
+
+/* file may start in the middle of a packet, packets start where sync bytes repeat at packet distance */
+static uint32_t findPacketStart(const uint8_t* data, uint32_t length)
+{
+    uint32_t offset = 0;
+    uint8_t i = 0;
+
+    for (offset = 0; offset + TS_FILE_SOURCE_SYNC_CHECK * TS_PACKET_SIZE <= length; offset++)
+    {
+        for (i = 0; i < TS_FILE_SOURCE_SYNC_CHECK && data[offset + i * TS_PACKET_SIZE] == TS_SYNC_BYTE; i++);
+
+        if (i == TS_FILE_SOURCE_SYNC_CHECK)
+        {
+            return offset;
+        }
+    }
+
+    return length;
+}
+
+static void* sourceTask()
+{
+    static uint8_t chunk[TS_FILE_SOURCE_CHUNK * TS_PACKET_SIZE];
+    struct timespec clockStart;
+    struct timespec wakeTime;
+    uint64_t clockTimestamp = 0;
+    uint64_t lastPcr = 0;
+    uint16_t pcrPid = TS_NULL_PID;
+    bool clockValid = false;
+    uint32_t length = 0;
+    uint32_t offset = 0;
+    bool stop = false;
+
+    length = fread(chunk, 1, sizeof(chunk), sourceFile);
+    offset = findPacketStart(chunk, length);
+    if (offset == length)
+    {
+        printf("\n%s : ERROR no transport stream packets found\n", __FUNCTION__);
+        stop = true;
+    }
+    memmove(chunk, chunk + offset, length - offset);
+    length -= offset;
+
+    while (!stop)
+    {
+        uint32_t packetCount = 0;
+        uint32_t i = 0;
+
+        pthread_mutex_lock(&sourceMutex);
+        stop = sourceExit;
+        pthread_mutex_unlock(&sourceMutex);
+        if (stop)
+        {
+            break;
+        }
+
+        /* partial packet left by the previous read is completed first */
+        length += fread(chunk + length, 1, sizeof(chunk) - length, sourceFile);
+        packetCount = length / TS_PACKET_SIZE;
+        if (packetCount == 0)
+        {
+            printf("\n%s : INFO end of transport stream file\n", __FUNCTION__);
+            break;
+        }
+
+        /* pace by the first PCR pid found, the multiplex arrives in real time as from the tuner */
+        for (i = 0; i < packetCount; i++)
+        {
+            uint64_t pcrBase = 0;
+            uint64_t pcr = 0;
+            const uint8_t* packet = chunk + i * TS_PACKET_SIZE;
+
+            if (*packet != TS_SYNC_BYTE || tsPacketGetPcr(packet, &pcrBase) != TS_PACKET_OK)
+            {
+                continue;
+            }
+
+            if (pcrPid == TS_NULL_PID)
+            {
+                pcrPid = tsPacketGetPid(packet);
+            }
+
+            if (tsPacketGetPid(packet) != pcrPid)
+            {
+                continue;
+            }
+
+            pcr = clockValid ? tsTimestampUnwrap(pcrBase, lastPcr) : pcrBase;
+            if (!clockValid || pcr < lastPcr || pcr - lastPcr > TS_FILE_SOURCE_MAX_PCR_GAP)
+            {
+                clock_gettime(CLOCK_MONOTONIC, &clockStart);
+                clockTimestamp = pcr;
+                clockValid = true;
+            }
+            else
+            {
+                uint64_t elapsed = (pcr - clockTimestamp) * 1000000000ULL / TS_CLOCK_FREQUENCY;
+
+                wakeTime.tv_sec = clockStart.tv_sec + (time_t) (elapsed / 1000000000ULL);
+                wakeTime.tv_nsec = clockStart.tv_nsec + (long) (elapsed % 1000000000ULL);
+                if (wakeTime.tv_nsec >= 1000000000L)
+                {
+                    wakeTime.tv_sec++;
+                    wakeTime.tv_nsec -= 1000000000L;
+                }
+                clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wakeTime, NULL);
+            }
+            lastPcr = pcr;
+            break;
+        }
+
+        packetCallback(chunk, packetCount);
+
+        memmove(chunk, chunk + packetCount * TS_PACKET_SIZE, length - packetCount * TS_PACKET_SIZE);
+        length -= packetCount * TS_PACKET_SIZE;
+    }
+
+    pthread_mutex_lock(&sourceMutex);
+    isRunning = false;
+    pthread_mutex_unlock(&sourceMutex);
+
+    return NULL;
+}
@@ -0,0 +1,59 @@
+#ifndef __TS_FILE_SOURCE_H__
+#define __TS_FILE_SOURCE_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "pthread.h"
+#include "ts_packet.h"
+
+#define TS_FILE_SOURCE_CHUNK 64                     /* Number of packets read and handed to packet callback at once */
+#define TS_FILE_SOURCE_SYNC_CHECK 3                 /* Number of sync bytes in a row that mark packet start */
+#define TS_FILE_SOURCE_MAX_PCR_GAP TS_CLOCK_FREQUENCY /* Larger PCR step (1 s) is a discontinuity, pacing starts again */
+
+/**
+ * @brief Structure that defines TS file source error
+ */
+typedef enum _TsFileSourceError
+{
+    TS_FILE_SOURCE_NO_ERROR = 0,
+    TS_FILE_SOURCE_ERROR,
+    TS_FILE_SOURCE_THREAD_ERROR
+}TsFileSourceError;
+
+/**
+ * @brief Packet callback, receives packets read from file
+ */
+typedef void(*TsFileSourceCallback)(const uint8_t* packets, uint32_t packetCount);
+
+/**
+ * @brief Starts task that reads transport stream file and passes its packets to callback
+ *
+ * Stands in for TS capture of tuned multiplex, tdp_api has none. Packets are passed at the pace
+ * of the PCR found in the file, so a recorded multiplex arrives as it would from the tuner.
+ * Path may also be a FIFO or a DVR device delivering live stream.
+ *
+ * @param [in] path - path of transport stream file
+ * @param [in] callback - callback receiving packets
+ * @return TS file source error code
+ */
+TsFileSourceError tsFileSourceStart(const char* path, TsFileSourceCallback callback);
+
+/**
+ * @brief Stops reading and closes file
+ *
+ * @return TS file source error code
+ */
+TsFileSourceError tsFileSourceStop();
+
+/**
+ * @brief Checks whether packets are being read
+ *
+ * @return true from start until stop or end of file
+ */
+bool tsFileSourceIsRunning();
+
+#endif /* __TS_FILE_SOURCE_H__ */
@@ -0,0 +1,661 @@
+#include "ts_indexer.h"
+#include "tables.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+static void scanPayload(TsIndexer* indexer, const uint8_t* payload, uint8_t payloadLength);
+static TsFrameType classifyStartCode(TsIndexer* indexer, const uint8_t* code);
+static bool readExpGolomb(const uint8_t* data, uint32_t size, uint32_t* bitPosition, uint32_t* value);
+static void finishPes(TsIndexer* indexer);
+static void writeEntry(TsIndexer* indexer, TsFrameType frameType);
+static bool isRandomAccessEntry(const TsIndexEntry* entry);
+static TsIndexerError findVideoStream(int32_t fileDesc, uint16_t* videoPid, uint8_t* streamType);
+
+TsVideoCodec tsIndexerCodecFromStreamType(uint8_t streamType)
+{
+    switch (streamType)
+    {
+        case 0x01:
+        case 0x02:
+            return TS_VIDEO_CODEC_MPEG2;
+        case 0x1B:
+            return TS_VIDEO_CODEC_H264;
+        default:
+            return TS_VIDEO_CODEC_UNKNOWN;
+    }
+}
+
+int32_t tsIndexerFindStartCode(const uint8_t* data, uint32_t length)
+{
+    uint32_t i = 0;
+
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi8(1);
+
+    /* compare 16 candidate positions at once: data[i] == 0, data[i+1] == 0, data[i+2] == 1 */
+    for (; i + 18 <= length; i += 16)
+    {
+        __m128i first = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*) (data + i)), zero);
+        __m128i second = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*) (data + i + 1)), zero);
+        __m128i third = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*) (data + i + 2)), one);
+        int32_t mask = _mm_movemask_epi8(_mm_and_si128(_mm_and_si128(first, second), third));
+
+        if (mask != 0)
+        {
+            return i + __builtin_ctz(mask);
+        }
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    const uint8x16_t zero = vdupq_n_u8(0);
+    const uint8x16_t one = vdupq_n_u8(1);
+
+    /* skip 16 byte blocks without a start code, scalar loop below locates it */
+    for (; i + 18 <= length; i += 16)
+    {
+        uint8x16_t first = vceqq_u8(vld1q_u8(data + i), zero);
+        uint8x16_t second = vceqq_u8(vld1q_u8(data + i + 1), zero);
+        uint8x16_t third = vceqq_u8(vld1q_u8(data + i + 2), one);
+        uint64x2_t mask = vreinterpretq_u64_u8(vandq_u8(vandq_u8(first, second), third));
+
+        if ((vgetq_lane_u64(mask, 0) | vgetq_lane_u64(mask, 1)) != 0)
+        {
+            break;
+        }
+    }
+#endif
+
+    for (; i + 3 <= length; i++)
+    {
+        if (data[i] == 0x00 && data[i + 1] == 0x00 && data[i + 2] == 0x01)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+TsIndexerError tsIndexerOpen(TsIndexer* indexer, const char* indexPath, uint16_t videoPid, uint8_t streamType)
+{
+    TsIndexHeader header;
+
+    if (indexer == NULL || indexPath == NULL)
+    {
+        printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+        return TS_INDEXER_ERROR;
+    }
+
+    memset(indexer, 0x0, sizeof(TsIndexer));
+    indexer->videoPid = videoPid;
+    indexer->codec = tsIndexerCodecFromStreamType(streamType);
+
+    /* recording may start in the middle of a PES packet, wait for the next one */
+    indexer->pesClassified = true;
+
+    indexer->indexFile = fopen(indexPath, "wb");
+    if (indexer->indexFile == NULL)
+    {
+        printf("\n%s : ERROR opening %s (%s)\n", __FUNCTION__, indexPath, strerror(errno));
+        return TS_INDEXER_ERROR;
+    }
+
+    memset(&header, 0x0, sizeof(TsIndexHeader));
+    header.magic = TS_INDEX_MAGIC;
+    header.version = TS_INDEX_VERSION;
+    header.videoPid = videoPid;
+    header.streamType = streamType;
+    header.entrySize = sizeof(TsIndexEntry);
+
+    if (fwrite(&header, sizeof(TsIndexHeader), 1, indexer->indexFile) != 1)
+    {
+        printf("\n%s : ERROR writing index header\n", __FUNCTION__);
+        fclose(indexer->indexFile);
+        indexer->indexFile = NULL;
+        return TS_INDEXER_ERROR;
+    }
+
+    return TS_INDEXER_NO_ERROR;
+}
+
+TsIndexerError tsIndexerProcessPackets(TsIndexer* indexer, const uint8_t* packets, uint32_t packetCount)
+{
+    uint32_t i = 0;
+
+    if (indexer == NULL || packets == NULL)
+    {
+        return TS_INDEXER_ERROR;
+    }
+
+    for (i = 0; i < packetCount; i++, indexer->packetNumber++)
+    {
+        const uint8_t* packet = packets + i * TS_PACKET_SIZE;
+        const uint8_t* payload = NULL;
+        uint8_t payloadLength = 0;
+        uint64_t pts = 0;
+
+        if (*packet != TS_SYNC_BYTE || tsPacketGetPid(packet) != indexer->videoPid)
+        {
+            continue;
+        }
+
+        if (tsPacketIsPayloadStart(packet))
+        {
+            finishPes(indexer);
+
+            indexer->pesPacketNumber = indexer->packetNumber;
+            indexer->pesRandomAccess = tsPacketHasRandomAccess(packet);
+            indexer->pesClassified = false;
+            indexer->carryLength = 0;
+
+            if (tsPacketGetPts(packet, &pts) == TS_PACKET_OK)
+            {
+                indexer->lastPts = indexer->ptsValid ? tsTimestampUnwrap(pts, indexer->lastPts) : pts;
+                indexer->ptsValid = true;
+            }
+            indexer->pesPts = indexer->lastPts;
+        }
+        else if (tsPacketHasRandomAccess(packet))
+        {
+            indexer->pesRandomAccess = true;
+        }
+
+        /* only the first picture of a PES packet is classified */
+        if (!indexer->pesClassified && indexer->codec != TS_VIDEO_CODEC_UNKNOWN &&
+            tsPacketGetPayload(packet, &payload, &payloadLength) == TS_PACKET_OK)
+        {
+            scanPayload(indexer, payload, payloadLength);
+        }
+    }
+
+    return TS_INDEXER_NO_ERROR;
+}
+
+TsIndexerError tsIndexerClose(TsIndexer* indexer)
+{
+    if (indexer == NULL || indexer->indexFile == NULL)
+    {
+        return TS_INDEXER_ERROR;
+    }
+
+    finishPes(indexer);
+
+    if (fclose(indexer->indexFile))
+    {
+        indexer->indexFile = NULL;
+        printf("\n%s : ERROR closing index file\n", __FUNCTION__);
+        return TS_INDEXER_ERROR;
+    }
+    indexer->indexFile = NULL;
+
+    return TS_INDEXER_NO_ERROR;
+}
+
+TsIndexerError tsIndexerIndexFile(const char* recordingPath, const char* indexPath, uint16_t videoPid, uint8_t streamType)
+{
+    TsIndexer indexer;
+    uint8_t* readBuffer = NULL;
+    int32_t fileDesc = -1;
+    ssize_t bytesRead = 0;
+    size_t bufferFill = 0;
+    uint64_t totalBytes = 0;
+    struct timespec startTime;
+    struct timespec endTime;
+    double elapsed = 0;
+
+    if (recordingPath == NULL || indexPath == NULL)
+    {
+        printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+        return TS_INDEXER_ERROR;
+    }
+
+    fileDesc = open(recordingPath, O_RDONLY);
+    if (fileDesc == -1)
+    {
+        printf("\n%s : ERROR opening %s (%s)\n", __FUNCTION__, recordingPath, strerror(errno));
+        return TS_INDEXER_ERROR;
+    }
+
+    /* recording is read once front to back */
+    posix_fadvise(fileDesc, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    if (videoPid == 0 && findVideoStream(fileDesc, &videoPid, &streamType))
+    {
+        printf("\n%s : ERROR no video stream found in %s\n", __FUNCTION__, recordingPath);
+        close(fileDesc);
+        return TS_INDEXER_ERROR;
+    }
+
+    readBuffer = (uint8_t*) malloc(TS_INDEXER_READ_PACKETS * TS_PACKET_SIZE);
+    if (readBuffer == NULL)
+    {
+        printf("\n%s : ERROR Cannot allocate memory\n", __FUNCTION__);
+        close(fileDesc);
+        return TS_INDEXER_ERROR;
+    }
+
+    if (tsIndexerOpen(&indexer, indexPath, videoPid, streamType))
+    {
+        free(readBuffer);
+        close(fileDesc);
+        return TS_INDEXER_ERROR;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &startTime);
+
+    while ((bytesRead = read(fileDesc, readBuffer + bufferFill, TS_INDEXER_READ_PACKETS * TS_PACKET_SIZE - bufferFill)) > 0)
+    {
+        size_t packetBytes = 0;
+
+        bufferFill += bytesRead;
+        totalBytes += bytesRead;
+        packetBytes = bufferFill - (bufferFill % TS_PACKET_SIZE);
+
+        tsIndexerProcessPackets(&indexer, readBuffer, packetBytes / TS_PACKET_SIZE);
+
+        /* keep partial packet for next read */
+        memmove(readBuffer, readBuffer + packetBytes, bufferFill - packetBytes);
+        bufferFill -= packetBytes;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &endTime);
+    elapsed = (endTime.tv_sec - startTime.tv_sec) + (endTime.tv_nsec - startTime.tv_nsec) / 1e9;
+
+    if (bytesRead < 0)
+    {
+        printf("\n%s : ERROR reading %s (%s)\n", __FUNCTION__, recordingPath, strerror(errno));
+    }
+
+    printf("\n%s : INFO indexed %llu bytes, %u entries in %.3f s (%.1f MB/s)\n", __FUNCTION__,
+           (unsigned long long) totalBytes, indexer.entryCount, elapsed,
+           elapsed > 0 ? totalBytes / elapsed / (1024 * 1024) : 0.0);
+
+    free(readBuffer);
+    close(fileDesc);
+
+    if (tsIndexerClose(&indexer) || bytesRead < 0)
+    {
+        return TS_INDEXER_ERROR;
+    }
+
+    return TS_INDEXER_NO_ERROR;
+}
+
+TsIndexerError tsIndexMap(TsIndex* index, const char* indexPath)
+{
+    struct stat fileStat;
+    int32_t fileDesc = -1;
+    void* data = NULL;
+
+    if (index == NULL || indexPath == NULL)
+    {
+        printf("\n%s : ERROR received parameters are not ok\n", __FUNCTION__);
+        return TS_INDEXER_ERROR;
+    }
+
+    memset(index, 0x0, sizeof(TsIndex));
+
+    fileDesc = open(indexPath, O_RDONLY);
+    if (fileDesc == -1)
+    {
+        printf("\n%s : ERROR opening %s (%s)\n", __FUNCTION__, indexPath, strerror(errno));
+        return TS_INDEXER_ERROR;
+    }
+
+    if (fstat(fileDesc, &fileStat) || fileStat.st_size < (off_t) sizeof(TsIndexHeader))
+    {
+        printf("\n%s : ERROR %s is not an index file\n", __FUNCTION__, indexPath);
+        close(fileDesc);
+        return TS_INDEXER_ERROR;
+    }
+
+    data = mmap(NULL, fileStat.st_size, PROT_READ, MAP_PRIVATE, fileDesc, 0);
+    close(fileDesc);
+    if (data == MAP_FAILED)
+    {
+        printf("\n%s : ERROR mapping %s (%s)\n", __FUNCTION__, indexPath, strerror(errno));
+        return TS_INDEXER_ERROR;
+    }
+
+    index->header = (const TsIndexHeader*) data;
+    index->mapSize = fileStat.st_size;
+    if (index->header->magic != TS_INDEX_MAGIC || index->header->version != TS_INDEX_VERSION ||
+        index->header->entrySize != sizeof(TsIndexEntry))
+    {
+        printf("\n%s : ERROR %s has unsupported layout\n", __FUNCTION__, indexPath);
+        tsIndexUnmap(index);
+        return TS_INDEXER_ERROR;
+    }
+
+    /* entry count follows from file size, so an index cut short by power loss stays usable */
+    index->entries = (const TsIndexEntry*) (index->header + 1);
+    index->entryCount = (uint32_t) ((index->mapSize - sizeof(TsIndexHeader)) / sizeof(TsIndexEntry));
+
+    return TS_INDEXER_NO_ERROR;
+}
+
+void tsIndexUnmap(TsIndex* index)
+{
+    if (index != NULL && index->header != NULL)
+    {
+        munmap((void*) index->header, index->mapSize);
+        memset(index, 0x0, sizeof(TsIndex));
+    }
+}
+
+int32_t tsIndexFindByPts(const TsIndex* index, uint64_t pts)
+{
+    int32_t low = 0;
+    int32_t high = 0;
+
+    if (index == NULL || index->entryCount == 0)
+    {
+        return -1;
+    }
+
+    high = (int32_t) index->entryCount;
+    while (high - low > 1)
+    {
+        int32_t middle = low + (high - low) / 2;
+
+        if (index->entries[middle].pts <= pts)
+        {
+            low = middle;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    /* decoding has to start at a random access point */
+    while (low >= 0 && !isRandomAccessEntry(&index->entries[low]))
+    {
+        low--;
+    }
+
+    return low;
+}
+
+int32_t tsIndexStepRandomAccess(const TsIndex* index, int32_t position, int32_t step)
+{
+    int32_t direction = (step < 0) ? -1 : 1;
+    int32_t remaining = (step < 0) ? -step : step;
+
+    if (index == NULL || position < 0 || position >= (int32_t) index->entryCount)
+    {
+        return -1;
+    }
+
+    while (remaining > 0)
+    {
+        position += direction;
+        if (position < 0 || position >= (int32_t) index->entryCount)
+        {
+            return -1;
+        }
+
+        if (isRandomAccessEntry(&index->entries[position]))
+        {
+            remaining--;
+        }
+    }
+
+    return position;
+}
+
+/* appends payload to the bytes carried from previous packet and classifies complete start codes */
+static void scanPayload(TsIndexer* indexer, const uint8_t* payload, uint8_t payloadLength)
+{
+    uint32_t windowLength = 0;
+    uint32_t limit = 0;
+    uint32_t position = 0;
+
+    memcpy(indexer->carry + indexer->carryLength, payload, payloadLength);
+    windowLength = indexer->carryLength + payloadLength;
+
+    /* start codes closer to the end than TS_INDEXER_HEADER_BYTES wait for next packet */
+    limit = (windowLength > TS_INDEXER_HEADER_BYTES) ? (windowLength - TS_INDEXER_HEADER_BYTES) : 0;
+
+    while (position < limit && !indexer->pesClassified)
+    {
+        int32_t found = tsIndexerFindStartCode(indexer->carry + position, windowLength - position);
+        TsFrameType frameType = TS_FRAME_TYPE_UNKNOWN;
+
+        if (found < 0 || position + found >= limit)
+        {
+            break;
+        }
+        position += found;
+
+        frameType = classifyStartCode(indexer, indexer->carry + position + 3);
+        if (frameType != TS_FRAME_TYPE_UNKNOWN)
+        {
+            indexer->pesClassified = true;
+
+            if (frameType == TS_FRAME_TYPE_I || indexer->pesRandomAccess || indexer->indexAllFrames)
+            {
+                writeEntry(indexer, frameType);
+            }
+        }
+
+        position += 3;
+    }
+
+    if (windowLength > TS_INDEXER_HEADER_BYTES)
+    {
+        memmove(indexer->carry, indexer->carry + windowLength - TS_INDEXER_HEADER_BYTES, TS_INDEXER_HEADER_BYTES);
+        indexer->carryLength = TS_INDEXER_HEADER_BYTES;
+    }
+    else
+    {
+        indexer->carryLength = windowLength;
+    }
+}
+
+/* code points to the byte following 00 00 01, TS_INDEXER_HEADER_BYTES - 3 bytes are available */
+static TsFrameType classifyStartCode(TsIndexer* indexer, const uint8_t* code)
+{
+    uint32_t bitPosition = 0;
+    uint32_t firstMbInSlice = 0;
+    uint32_t sliceType = 0;
+
+    if (indexer->codec == TS_VIDEO_CODEC_MPEG2)
+    {
+        if (code[0] == 0xB3)
+        {
+            /* sequence header precedes an I picture */
+            indexer->pesRandomAccess = true;
+        }
+        else if (code[0] == 0x00)
+        {
+            /* picture header: temporal_reference(10) picture_coding_type(3) */
+            switch ((code[2] >> 3) & 0x07)
+            {
+                case 1:
+                    return TS_FRAME_TYPE_I;
+                case 2:
+                    return TS_FRAME_TYPE_P;
+                case 3:
+                    return TS_FRAME_TYPE_B;
+                default:
+                    break;
+            }
+        }
+    }
+    else if (indexer->codec == TS_VIDEO_CODEC_H264)
+    {
+        /* forbidden_zero_bit is set in PES start codes (0xE0..0xEF) */
+        if (code[0] & 0x80)
+        {
+            return TS_FRAME_TYPE_UNKNOWN;
+        }
+
+        switch (code[0] & 0x1F)
+        {
+            case 5:
+                /* IDR slice */
+                return TS_FRAME_TYPE_I;
+            case 7:
+                /* SPS precedes a random access point */
+                indexer->pesRandomAccess = true;
+                break;
+            case 1:
+                if (readExpGolomb(code + 1, TS_INDEXER_HEADER_BYTES - 4, &bitPosition, &firstMbInSlice) &&
+                    readExpGolomb(code + 1, TS_INDEXER_HEADER_BYTES - 4, &bitPosition, &sliceType) &&
+                    firstMbInSlice == 0)
+                {
+                    switch (sliceType % 5)
+                    {
+                        case 0:
+                        case 3:
+                            return TS_FRAME_TYPE_P;
+                        case 1:
+                            return TS_FRAME_TYPE_B;
+                        default:
+                            return TS_FRAME_TYPE_I;
+                    }
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    return TS_FRAME_TYPE_UNKNOWN;
+}
+
+static bool readExpGolomb(const uint8_t* data, uint32_t size, uint32_t* bitPosition, uint32_t* value)
+{
+    uint32_t leadingZeros = 0;
+    uint32_t suffix = 0;
+    uint32_t i = 0;
+
+    while (((data[*bitPosition / 8] >> (7 - *bitPosition % 8)) & 0x01) == 0)
+    {
+        leadingZeros++;
+        (*bitPosition)++;
+        if (*bitPosition >= size * 8 || leadingZeros > 31)
+        {
+            return false;
+        }
+    }
+    (*bitPosition)++;
+
+    for (i = 0; i < leadingZeros; i++)
+    {
+        if (*bitPosition >= size * 8)
+        {
+            return false;
+        }
+        suffix = (suffix << 1) | ((data[*bitPosition / 8] >> (7 - *bitPosition % 8)) & 0x01);
+        (*bitPosition)++;
+    }
+
+    *value = (1U << leadingZeros) - 1 + suffix;
+
+    return true;
+}
+
+static void finishPes(TsIndexer* indexer)
+{
+    /* random access signalled, but no picture start code recognized */
+    if (indexer->pesRandomAccess && !indexer->pesClassified)
+    {
+        writeEntry(indexer, TS_FRAME_TYPE_RANDOM_ACCESS);
+    }
+
+    indexer->pesRandomAccess = false;
+    indexer->pesClassified = true;
+}
+
+static void writeEntry(TsIndexer* indexer, TsFrameType frameType)
+{
+    TsIndexEntry entry;
+
+    memset(&entry, 0x0, sizeof(TsIndexEntry));
+    entry.pts = indexer->pesPts;
+    entry.packetNumber = indexer->pesPacketNumber;
+    entry.frameType = (uint8_t) frameType;
+
+    if (indexer->indexFile != NULL && fwrite(&entry, sizeof(TsIndexEntry), 1, indexer->indexFile) == 1)
+    {
+        indexer->entryCount++;
+    }
+}
+
+static bool isRandomAccessEntry(const TsIndexEntry* entry)
+{
+    return entry->frameType == TS_FRAME_TYPE_I || entry->frameType == TS_FRAME_TYPE_RANDOM_ACCESS;
+}
+
+/* takes video pid and stream type from the first PAT and PMT found at the start of recording */
+static TsIndexerError findVideoStream(int32_t fileDesc, uint16_t* videoPid, uint8_t* streamType)
+{
+    static uint8_t packet[TS_PACKET_SIZE];
+    PatTable patTable;
+    PmtTable pmtTable;
+    uint16_t pmtPid = TS_NULL_PID;
+    uint32_t packetsChecked = 0;
+    TsIndexerError result = TS_INDEXER_ERROR;
+
+    /* PAT and PMT repeat at least every 100 ms, a few megabytes are enough */
+    while (packetsChecked++ < 50000 && read(fileDesc, packet, TS_PACKET_SIZE) == TS_PACKET_SIZE)
+    {
+        const uint8_t* payload = NULL;
+        uint8_t payloadLength = 0;
+        uint16_t pid = tsPacketGetPid(packet);
+        uint8_t i = 0;
+
+        if (*packet != TS_SYNC_BYTE || !tsPacketIsPayloadStart(packet) ||
+            tsPacketGetPayload(packet, &payload, &payloadLength) != TS_PACKET_OK ||
+            payload[0] + 1 >= payloadLength)
+        {
+            continue;
+        }
+
+        /* skip pointer_field */
+        payload += payload[0] + 1;
+
+        if (pid == TS_PAT_PID && pmtPid == TS_NULL_PID && parsePatTable(payload, &patTable) == TABLES_PARSE_OK)
+        {
+            for (i = 0; i < patTable.serviceInfoCount; i++)
+            {
+                /* program number 0 carries NIT pid */
+                if (patTable.patServiceInfoArray[i].programNumber != 0)
+                {
+                    pmtPid = patTable.patServiceInfoArray[i].pid;
+                    break;
+                }
+            }
+        }
+        else if (pid == pmtPid && payload[0] == 0x02 && parsePmtTable(payload, &pmtTable) == TABLES_PARSE_OK)
+        {
+            for (i = 0; i < pmtTable.elementaryInfoCount; i++)
+            {
+                if (tsIndexerCodecFromStreamType(pmtTable.pmtElementaryInfoArray[i].streamType) != TS_VIDEO_CODEC_UNKNOWN)
+                {
+                    *videoPid = pmtTable.pmtElementaryInfoArray[i].elementaryPid;
+                    *streamType = pmtTable.pmtElementaryInfoArray[i].streamType;
+                    result = TS_INDEXER_NO_ERROR;
+                    break;
+                }
+            }
+            break;
+        }
+    }
+
+    lseek(fileDesc, 0, SEEK_SET);
+
+    return result;
+}
@@ -0,0 +1,196 @@
+#ifndef __TS_INDEXER_H__
+#define __TS_INDEXER_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ts_packet.h"
+
+#define TS_INDEX_MAGIC 0x54535249                   /* "TSRI" */
+#define TS_INDEX_VERSION 1                          /* Version of index file layout */
+#define TS_INDEXER_HEADER_BYTES 10                  /* Bytes after start code needed to classify a picture */
+#define TS_INDEXER_CARRY_SIZE (TS_INDEXER_HEADER_BYTES + TS_PACKET_SIZE)
+#define TS_INDEXER_READ_PACKETS 5577                /* Packets read at once by offline indexer (~1 MB) */
+
+/**
+ * @brief Structure that defines ts indexer error
+ */
+typedef enum _TsIndexerError
+{
+    TS_INDEXER_NO_ERROR = 0,
+    TS_INDEXER_ERROR
+}TsIndexerError;
+
+/**
+ * @brief Enumeration of frame types stored in index
+ */
+typedef enum _TsFrameType
+{
+    TS_FRAME_TYPE_UNKNOWN = 0,
+    TS_FRAME_TYPE_I,
+    TS_FRAME_TYPE_P,
+    TS_FRAME_TYPE_B,
+    TS_FRAME_TYPE_RANDOM_ACCESS                     /* random_access_indicator without recognized picture */
+}TsFrameType;
+
+/**
+ * @brief Enumeration of video codecs the indexer understands
+ */
+typedef enum _TsVideoCodec
+{
+    TS_VIDEO_CODEC_UNKNOWN = 0,
+    TS_VIDEO_CODEC_MPEG2,
+    TS_VIDEO_CODEC_H264
+}TsVideoCodec;
+
+/**
+ * @brief Structure that defines header of index file
+ */
+typedef struct _TsIndexHeader
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t videoPid;
+    uint8_t streamType;
+    uint8_t reserved[3];
+    uint32_t entrySize;
+}TsIndexHeader;
+
+/**
+ * @brief Structure that defines one index entry (16 bytes)
+ */
+typedef struct _TsIndexEntry
+{
+    uint64_t pts;                                   /* Unwrapped PTS of the picture in 90 kHz units */
+    uint32_t packetNumber;                          /* Byte offset in recording divided by TS_PACKET_SIZE */
+    uint8_t frameType;                              /* TsFrameType */
+    uint8_t reserved[3];
+}TsIndexEntry;
+
+/**
+ * @brief Structure that holds state of one indexer
+ */
+typedef struct _TsIndexer
+{
+    FILE* indexFile;
+    uint16_t videoPid;
+    TsVideoCodec codec;
+    bool indexAllFrames;                            /* Index P and B pictures too, not only random access points */
+    uint32_t packetNumber;                          /* Number of packets of recording seen so far */
+    uint32_t pesPacketNumber;                       /* Packet where current PES packet started */
+    uint64_t pesPts;
+    uint64_t lastPts;
+    bool ptsValid;
+    bool pesRandomAccess;
+    bool pesClassified;                             /* First picture of current PES packet was seen */
+    uint8_t carry[TS_INDEXER_CARRY_SIZE];
+    uint32_t carryLength;
+    uint32_t entryCount;
+}TsIndexer;
+
+/**
+ * @brief Structure that holds index file mapped for trick play
+ */
+typedef struct _TsIndex
+{
+    const TsIndexHeader* header;
+    const TsIndexEntry* entries;
+    uint32_t entryCount;
+    size_t mapSize;
+}TsIndex;
+
+/**
+ * @brief Returns video codec for PMT stream type
+ *
+ * @param [in] streamType - PMT stream_type
+ * @return video codec
+ */
+TsVideoCodec tsIndexerCodecFromStreamType(uint8_t streamType);
+
+/**
+ * @brief Finds next 00 00 01 start code prefix using SIMD where available
+ *
+ * @param [in] data - buffer to scan
+ * @param [in] length - number of bytes in buffer
+ * @return position of the first byte of start code, or -1 if there is none
+ */
+int32_t tsIndexerFindStartCode(const uint8_t* data, uint32_t length);
+
+/**
+ * @brief Opens index file and prepares indexer for a recording
+ *
+ * @param [out] indexer - indexer state
+ * @param [in]  indexPath - path of index file
+ * @param [in]  videoPid - pid of video elementary stream
+ * @param [in]  streamType - PMT stream_type of video elementary stream
+ * @return ts indexer error code
+ */
+TsIndexerError tsIndexerOpen(TsIndexer* indexer, const char* indexPath, uint16_t videoPid, uint8_t streamType);
+
+/**
+ * @brief Indexes packets in the order they are written to recording
+ *
+ * @param [in] indexer - indexer state
+ * @param [in] packets - transport stream packets
+ * @param [in] packetCount - number of packets
+ * @return ts indexer error code
+ */
+TsIndexerError tsIndexerProcessPackets(TsIndexer* indexer, const uint8_t* packets, uint32_t packetCount);
+
+/**
+ * @brief Flushes and closes index file
+ *
+ * @param [in] indexer - indexer state
+ * @return ts indexer error code
+ */
+TsIndexerError tsIndexerClose(TsIndexer* indexer);
+
+/**
+ * @brief Indexes existing recording, video pid is taken from PAT and PMT when videoPid is 0
+ *
+ * @param [in] recordingPath - path of recorded transport stream
+ * @param [in] indexPath - path of index file
+ * @param [in] videoPid - pid of video elementary stream, or 0
+ * @param [in] streamType - PMT stream_type of video elementary stream, ignored when videoPid is 0
+ * @return ts indexer error code
+ */
+TsIndexerError tsIndexerIndexFile(const char* recordingPath, const char* indexPath, uint16_t videoPid, uint8_t streamType);
+
+/**
+ * @brief Maps index file read-only
+ *
+ * @param [out] index - mapped index
+ * @param [in]  indexPath - path of index file
+ * @return ts indexer error code
+ */
+TsIndexerError tsIndexMap(TsIndex* index, const char* indexPath);
+
+/**
+ * @brief Unmaps index file
+ *
+ * @param [in] index - mapped index
+ */
+void tsIndexUnmap(TsIndex* index);
+
+/**
+ * @brief Finds last random access entry at or before given PTS (seek to time)
+ *
+ * @param [in] index - mapped index
+ * @param [in] pts - unwrapped PTS in 90 kHz units
+ * @return entry position, or -1 if there is none
+ */
+int32_t tsIndexFindByPts(const TsIndex* index, uint64_t pts);
+
+/**
+ * @brief Finds next random access entry in given direction (fast forward and rewind)
+ *
+ * @param [in] index - mapped index
+ * @param [in] position - current entry position
+ * @param [in] step - number of random access entries to skip, negative value goes backwards
+ * @return entry position, or -1 if there is none
+ */
+int32_t tsIndexStepRandomAccess(const TsIndex* index, int32_t position, int32_t step);
+
+#endif /* __TS_INDEXER_H__ */
@@ -0,0 +1,275 @@
+#include "ts_packet.h"
+
+uint16_t tsPacketGetPid(const uint8_t* packet)
+{
+    uint8_t higher8Bits = (uint8_t) (*(packet + 1));
+    uint8_t lower8Bits = (uint8_t) (*(packet + 2));
+    uint16_t all16Bits = (uint16_t) ((higher8Bits << 8) + lower8Bits);
+
+    return all16Bits & 0x1FFF;
+}
+
+bool tsPacketIsPayloadStart(const uint8_t* packet)
+{
+    return ((*(packet + 1)) & 0x40) != 0;
+}
+
+bool tsPacketHasRandomAccess(const uint8_t* packet)
+{
+    /* adaptation field with at least the flags byte */
+    if (((*(packet + 3)) & 0x20) == 0 || *(packet + 4) == 0)
+    {
+        return false;
+    }
+
+    return ((*(packet + 5)) & 0x40) != 0;
+}
+
+TsPacketError tsPacketGetPayload(const uint8_t* packet, const uint8_t** payload, uint8_t* payloadLength)
+{
+    uint8_t adaptationFieldControl = 0;
+    uint8_t headerLength = 4;
+
+    if (packet == NULL || payload == NULL || payloadLength == NULL || *packet != TS_SYNC_BYTE)
+    {
+        return TS_PACKET_ERROR;
+    }
+
+    adaptationFieldControl = ((*(packet + 3)) >> 4) & 0x03;
+    if ((adaptationFieldControl & 0x01) == 0)
+    {
+        return TS_PACKET_NOT_PRESENT;
+    }
+
+    if (adaptationFieldControl & 0x02)
+    {
+        /* skip adaptation_field_length byte and adaptation field */
+        headerLength += 1 + *(packet + 4);
+        if (headerLength >= TS_PACKET_SIZE)
+        {
+            return TS_PACKET_ERROR;
+        }
+    }
+
+    *payload = packet + headerLength;
+    *payloadLength = TS_PACKET_SIZE - headerLength;
+
+    return TS_PACKET_OK;
+}
+
+TsPacketError tsPacketGetPcr(const uint8_t* packet, uint64_t* pcrBase)
+{
+    uint8_t adaptationFieldLength = 0;
+
+    if (packet == NULL || pcrBase == NULL || *packet != TS_SYNC_BYTE)
+    {
+        return TS_PACKET_ERROR;
+    }
+
+    /* adaptation field must be present */
+    if (((*(packet + 3)) & 0x20) == 0)
+    {
+        return TS_PACKET_NOT_PRESENT;
+    }
+
+    /* PCR needs flags byte and 6 bytes of PCR */
+    adaptationFieldLength = *(packet + 4);
+    if (adaptationFieldLength < 7 || ((*(packet + 5)) & 0x10) == 0)
+    {
+        return TS_PACKET_NOT_PRESENT;
+    }
+
+    *pcrBase = ((uint64_t) (*(packet + 6)) << 25) |
+               ((uint64_t) (*(packet + 7)) << 17) |
+               ((uint64_t) (*(packet + 8)) << 9) |
+               ((uint64_t) (*(packet + 9)) << 1) |
+               ((uint64_t) (*(packet + 10)) >> 7);
+
+    return TS_PACKET_OK;
+}
+
+TsPacketError tsPacketGetPts(const uint8_t* packet, uint64_t* pts)
+{
+    const uint8_t* payload = NULL;
+    uint8_t payloadLength = 0;
+    TsPacketError error;
+
+    if (packet == NULL || pts == NULL)
+    {
+        return TS_PACKET_ERROR;
+    }
+
+    if (!tsPacketIsPayloadStart(packet))
+    {
+        return TS_PACKET_NOT_PRESENT;
+    }
+
+    error = tsPacketGetPayload(packet, &payload, &payloadLength);
+    if (error != TS_PACKET_OK)
+    {
+        return error;
+    }
+
+    /* packet_start_code_prefix + stream_id + length + flags + header length + PTS */
+    if (payloadLength < 14 || payload[0] != 0x00 || payload[1] != 0x00 || payload[2] != 0x01)
+    {
+        return TS_PACKET_NOT_PRESENT;
+    }
+
+    /* PTS_DTS_flags */
+    if ((payload[7] & 0x80) == 0)
+    {
+        return TS_PACKET_NOT_PRESENT;
+    }
+
+    *pts = ((uint64_t) (payload[9] & 0x0E) << 29) |
+           ((uint64_t) payload[10] << 22) |
+           ((uint64_t) (payload[11] & 0xFE) << 14) |
+           ((uint64_t) payload[12] << 7) |
+           ((uint64_t) payload[13] >> 1);
+
+    return TS_PACKET_OK;
+}
+
+uint64_t tsTimestampUnwrap(uint64_t timestamp, uint64_t previous)
+{
+    uint64_t extended = previous - (previous % TS_TIMESTAMP_WRAP) + (timestamp % TS_TIMESTAMP_WRAP);
+
+    if (extended + TS_TIMESTAMP_WRAP / 2 < previous)
+    {
+        /* time stamp wrapped around */
+        extended += TS_TIMESTAMP_WRAP;
+    }
+    else if (extended > previous + TS_TIMESTAMP_WRAP / 2 && extended >= TS_TIMESTAMP_WRAP)
+    {
+        /* slightly late time stamp from before the wrap */
+        extended -= TS_TIMESTAMP_WRAP;
+    }
+
+    return extended;
+}
+
+uint32_t tsCrc32(const uint8_t* data, uint32_t size)
+{
+    uint32_t crc = 0xFFFFFFFF;
+    uint32_t i = 0;
+    uint8_t bit = 0;
+
+    for (i = 0; i < size; i++)
+    {
+        crc ^= (uint32_t) data[i] << 24;
+        for (bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04C11DB7 : (crc << 1);
+        }
+    }
+
+    return crc;
+}
+
+void tsSectionAssemblerInit(TsSectionAssembler* assembler, uint16_t pid)
+{
+    memset(assembler, 0x0, sizeof(TsSectionAssembler));
+    assembler->pid = pid;
+}
+
+/* hands out complete sections, keeps the beginning of the next one */
+static void deliverSections(TsSectionAssembler* assembler, TsSectionCallback sectionCallback, void* userData)
+{
+    while (assembler->length >= 3)
+    {
+        uint16_t sectionSize = 0;
+
+        /* stuffing after last section of the packet */
+        if (assembler->section[0] == 0xFF)
+        {
+            assembler->length = 0;
+            assembler->started = false;
+            return;
+        }
+
+        sectionSize = 3 + ((((assembler->section[1] << 8) + assembler->section[2])) & 0x0FFF);
+        if (sectionSize > TS_SECTION_MAX_SIZE)
+        {
+            assembler->length = 0;
+            assembler->started = false;
+            return;
+        }
+
+        if (assembler->length < sectionSize)
+        {
+            return;
+        }
+
+        sectionCallback(assembler->section, sectionSize, userData);
+
+        memmove(assembler->section, assembler->section + sectionSize, assembler->length - sectionSize);
+        assembler->length -= sectionSize;
+    }
+}
+
+TsPacketError tsSectionAssemblerPush(TsSectionAssembler* assembler, const uint8_t* packet,
+                                     TsSectionCallback sectionCallback, void* userData)
+{
+    const uint8_t* payload = NULL;
+    uint8_t payloadLength = 0;
+    uint8_t continuityCounter = 0;
+    TsPacketError error;
+
+    if (assembler == NULL || sectionCallback == NULL)
+    {
+        return TS_PACKET_ERROR;
+    }
+
+    error = tsPacketGetPayload(packet, &payload, &payloadLength);
+    if (error != TS_PACKET_OK)
+    {
+        return error;
+    }
+
+    /* lost packet breaks the section being collected */
+    continuityCounter = (*(packet + 3)) & 0x0F;
+    if (assembler->started && continuityCounter != ((assembler->continuityCounter + 1) & 0x0F))
+    {
+        assembler->started = false;
+        assembler->length = 0;
+    }
+    assembler->continuityCounter = continuityCounter;
+
+    if (tsPacketIsPayloadStart(packet))
+    {
+        uint8_t pointerField = payload[0];
+
+        if (1 + pointerField > payloadLength)
+        {
+            assembler->started = false;
+            assembler->length = 0;
+            return TS_PACKET_ERROR;
+        }
+
+        /* bytes before pointer_field target end the previous section */
+        if (assembler->started && assembler->length > 0)
+        {
+            memcpy(assembler->section + assembler->length, payload + 1, pointerField);
+            assembler->length += pointerField;
+            deliverSections(assembler, sectionCallback, userData);
+        }
+
+        assembler->length = payloadLength - 1 - pointerField;
+        memcpy(assembler->section, payload + 1 + pointerField, assembler->length);
+        assembler->started = true;
+    }
+    else if (assembler->started)
+    {
+        memcpy(assembler->section + assembler->length, payload, payloadLength);
+        assembler->length += payloadLength;
+    }
+    else
+    {
+        return TS_PACKET_NOT_PRESENT;
+    }
+
+    deliverSections(assembler, sectionCallback, userData);
+
+    return TS_PACKET_OK;
+}
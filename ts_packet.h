@@ -0,0 +1,134 @@
+#ifndef __TS_PACKET_H__
+#define __TS_PACKET_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define TS_PACKET_SIZE 188                          /* Size of one transport stream packet */
+#define TS_SYNC_BYTE 0x47                           /* Sync byte at the start of every packet */
+#define TS_PAT_PID 0x0000                           /* Pid of PAT table */
+#define TS_NULL_PID 0x1FFF                          /* Pid of null (stuffing) packets */
+#define TS_CLOCK_FREQUENCY 90000                    /* PCR base and PTS clock frequency in Hz */
+#define TS_TIMESTAMP_WRAP 0x200000000ULL            /* PCR base and PTS are 33 bit values */
+#define TS_SECTION_MAX_SIZE 4096                    /* Max size of private section including header */
+
+/**
+ * @brief Enumeration of possible transport stream packet error codes
+ */
+typedef enum _TsPacketError
+{
+    TS_PACKET_OK = 0,                               /* Field found and parsed */
+    TS_PACKET_ERROR,                                /* Packet is not valid */
+    TS_PACKET_NOT_PRESENT                           /* Packet is valid, but does not carry the field */
+}TsPacketError;
+
+/**
+ * @brief Section callback, receives every complete section assembled from packets
+ */
+typedef void(*TsSectionCallback)(const uint8_t* section, uint16_t sectionSize, void* userData);
+
+/**
+ * @brief Structure that holds state of section reassembly on one pid
+ */
+typedef struct _TsSectionAssembler
+{
+    uint16_t pid;
+    bool started;                                   /* Section start was seen */
+    uint8_t continuityCounter;
+    uint16_t length;                                /* Number of bytes collected */
+    uint8_t section[TS_SECTION_MAX_SIZE + TS_PACKET_SIZE];
+}TsSectionAssembler;
+
+/**
+ * @brief Returns pid of transport stream packet
+ *
+ * @param [in] packet - transport stream packet
+ * @return packet pid
+ */
+uint16_t tsPacketGetPid(const uint8_t* packet);
+
+/**
+ * @brief Checks payload_unit_start_indicator of transport stream packet
+ *
+ * @param [in] packet - transport stream packet
+ * @return true if a PES packet or section starts in this packet
+ */
+bool tsPacketIsPayloadStart(const uint8_t* packet);
+
+/**
+ * @brief Checks random_access_indicator in adaptation field of transport stream packet
+ *
+ * @param [in] packet - transport stream packet
+ * @return true if the stream can be decoded from this packet on
+ */
+bool tsPacketHasRandomAccess(const uint8_t* packet);
+
+/**
+ * @brief Returns payload of transport stream packet
+ *
+ * @param [in]  packet - transport stream packet
+ * @param [out] payload - pointer to first payload byte
+ * @param [out] payloadLength - number of payload bytes
+ * @return transport stream packet error code
+ */
+TsPacketError tsPacketGetPayload(const uint8_t* packet, const uint8_t** payload, uint8_t* payloadLength);
+
+/**
+ * @brief Returns PCR base carried in adaptation field of transport stream packet
+ *
+ * @param [in]  packet - transport stream packet
+ * @param [out] pcrBase - 33 bit PCR base in 90 kHz units
+ * @return transport stream packet error code
+ */
+TsPacketError tsPacketGetPcr(const uint8_t* packet, uint64_t* pcrBase);
+
+/**
+ * @brief Returns PTS of PES packet that starts in transport stream packet
+ *
+ * @param [in]  packet - transport stream packet
+ * @param [out] pts - 33 bit presentation time stamp in 90 kHz units
+ * @return transport stream packet error code
+ */
+TsPacketError tsPacketGetPts(const uint8_t* packet, uint64_t* pts);
+
+/**
+ * @brief Extends 33 bit time stamp to monotonic 64 bit time line
+ *
+ * @param [in] timestamp - 33 bit time stamp
+ * @param [in] previous - last extended time stamp, or 0 if there is none
+ * @return extended time stamp
+ */
+uint64_t tsTimestampUnwrap(uint64_t timestamp, uint64_t previous);
+
+/**
+ * @brief Calculates MPEG-2 CRC-32 (polynomial 0x04C11DB7) as used in PSI/SI sections
+ *
+ * @param [in] data - data to check
+ * @param [in] size - number of bytes
+ * @return CRC-32, 0 over a whole section including its CRC field means section is valid
+ */
+uint32_t tsCrc32(const uint8_t* data, uint32_t size);
+
+/**
+ * @brief Prepares section assembler for a pid
+ *
+ * @param [out] assembler - section assembler
+ * @param [in]  pid - pid carrying the sections
+ */
+void tsSectionAssemblerInit(TsSectionAssembler* assembler, uint16_t pid);
+
+/**
+ * @brief Adds packet payload to section assembler, calls callback for each complete section
+ *
+ * @param [in] assembler - section assembler
+ * @param [in] packet - transport stream packet on assembler pid
+ * @param [in] sectionCallback - callback receiving complete sections
+ * @param [in] userData - passed to callback
+ * @return transport stream packet error code
+ */
+TsPacketError tsSectionAssemblerPush(TsSectionAssembler* assembler, const uint8_t* packet,
+                                     TsSectionCallback sectionCallback, void* userData);
+
+#endif /* __TS_PACKET_H__ */
@@ -23,13 +23,26 @@ if (x != 0)                                                                 \
     return -1;                                                              \
  }                                                                          \
 }
+#define TIMESHIFT_SEEK_STEP 10	/* Seconds skipped by one rewind or fast forward key press */
+#define KEY_ENTRY_TIMEOUT 2000	/* Time in ms after last digit the channel is changed */
+#define STARTUP_THREADS 3		/* Startup thread pool, tuner, DirectFB and then font and images in parallel */
+
 void inputChannelNumber(uint16_t key);
-void changeChannel();
+void changeChannel(void* data);
+void selectDialedChannel();
 void printCurrentTime();
 
 static void registerCurrentDate(CurrentDate* currentDate);
 static void remoteControllerCallback(uint16_t code, uint16_t type, uint32_t value);
 static void registerCurrentVolume(uint8_t volumeValue);
+static void channelChanged(uint32_t requestId, ChannelChangeStatus status, int32_t channelNumber);
+static int32_t startStreamController(void* data);
+static int32_t startRemoteController(void* data);
+static int32_t initOsdBackend(void* data);
+static int32_t loadOsdFont(void* data);
+static int32_t loadOsdAssets(void* data);
+static int32_t startOsd(void* data);
+static int32_t loadChannelList(void* data);
 static pthread_cond_t deinitCond = PTHREAD_COND_INITIALIZER;
 static pthread_mutex_t deinitMutex = PTHREAD_MUTEX_INITIALIZER;
 static ChannelInfo channelInfo;
@@ -37,11 +50,8 @@ static ChannelInfo channelInfo;
 static int32_t keysPressed = 0;
 static int32_t keys[3];
 
-static timer_t keyTimer;
-static struct itimerspec timerSpec;
-static struct itimerspec timerSpecOld;
-static struct sigevent signalEvent;
-static int32_t timerFlags = 0;
+static TimerWheel timerWheel;
+static WheelTimer keyTimer;
 
 static CurrentDate currentDateMain;
 static bool timeRecieved = false;
@@ -53,19 +63,48 @@ static uint8_t currentVolume = 5;
 
 int main(int argc, char *argv[])
 {
-	signalEvent.sigev_notify = SIGEV_THREAD;
-	signalEvent.sigev_notify_function = changeChannel;
-	signalEvent.sigev_value.sival_ptr = NULL;
-	signalEvent.sigev_notify_attributes = NULL;
-	timer_create(CLOCK_REALTIME, &signalEvent, &keyTimer);
+	char indexPath[LINE_LENGTH + 4];
+	StartupGraph startup;
+	int8_t osdBackendStep = 0;
+	int8_t fontStep = 0;
+	int8_t assetStep = 0;
 
-	memset(&timerSpec, 0, sizeof(timerSpec));
-	timerSpec.it_value.tv_sec = 2;
-	timerSpec.it_value.tv_nsec = 0;
+	/* boot trace times are measured from here */
+	startupTraceInit();
+
+	/* offline indexing of existing recording: tv_app --index <recording.ts> */
+	if ((argc == 3) && (strcmp(argv[1], "--index") == 0))
+	{
+		snprintf(indexPath, sizeof(indexPath), "%s.idx", argv[2]);
+		return tsIndexerIndexFile(argv[2], indexPath, 0, 0) ? -1 : 0;
+	}
+
+	/* channel scan: tv_app --scan or tv_app --scan-files <mux1.ts> <mux2.ts> ... */
+	if ((argc >= 2) && ((strcmp(argv[1], "--scan") == 0) || (strcmp(argv[1], "--scan-files") == 0)))
+	{
+		if (loadInitialInfo())
+		{
+			printf("Initial info required!\n");
+			return -1;
+		}
+
+		if (strcmp(argv[1], "--scan-files") == 0)
+		{
+			return scanChannels(&argv[2], argc - 2) ? -1 : 0;
+		}
+		return scanChannels(NULL, 0) ? -1 : 0;
+	}
+
+	/* one task serves key entry and OSD timeouts */
+	ERRORCHECK(timerWheelInit(&timerWheel));
+	timerWheelSetup(&keyTimer, changeChannel, NULL);
 
 	currentTime.hours = 30;
 	currentTime.Year = 1000;
 
+	/* timeshift playback file may be a FIFO, its reader going away must not end the application */
+	signal(SIGPIPE, SIG_IGN);
+
 	/* load initial info from config.ini file */
 	if (loadInitialInfo())
 	{
@@ -73,23 +112,31 @@ int main(int argc, char *argv[])
 		return -1;
 	}
 
-    /* initialize remote controller module */
-    ERRORCHECK(remoteControllerInit());
-    
-    /* register remote controller callback */
-    ERRORCHECK(registerRemoteControllerCallback(remoteControllerCallback));
-
 	/* register time callback */
 	ERRORCHECK(registerDateCallback(registerCurrentDate));
 
 	/* register volume callback */
 	ERRORCHECK(registerVolumeCallback(registerCurrentVolume));
 
-    /* initialize stream controller module */
-    ERRORCHECK(streamControllerInit());
+	/* register channel change callback */
+	ERRORCHECK(registerChannelChangeCallback(channelChanged));
+
+	/* register programme guide callback */
+	ERRORCHECK(registerEpgCallback(graphicsControllerStoreEvents));
 
-	/* initialize graphics controller module */
-	ERRORCHECK(graphicsControllerInit());
+	/* callbacks may draw as soon as stream controller starts, OSD state is set up before anything runs */
+	graphicsControllerPrepare(&timerWheel, &directfbBackend);
+
+	/* tuner locks while DirectFB starts, then font and images load in parallel, OSD starts when both are done */
+	startupGraphInit(&startup);
+	startupGraphAddStep(&startup, "stream controller", startStreamController, NULL, 0);
+	osdBackendStep = startupGraphAddStep(&startup, "osd backend", initOsdBackend, NULL, 0);
+	fontStep = startupGraphAddStep(&startup, "font", loadOsdFont, NULL, STARTUP_STEP(osdBackendStep));
+	assetStep = startupGraphAddStep(&startup, "osd assets", loadOsdAssets, NULL, STARTUP_STEP(osdBackendStep));
+	startupGraphAddStep(&startup, "osd start", startOsd, NULL, STARTUP_STEP(fontStep) | STARTUP_STEP(assetStep));
+	startupGraphAddStep(&startup, "remote controller", startRemoteController, NULL, 0);
+	startupGraphAddStep(&startup, "channel list", loadChannelList, NULL, 0);
+	ERRORCHECK(startupGraphRun(&startup, STARTUP_THREADS));
 
     /* wait for a EXIT remote controller key press event */
     pthread_mutex_lock(&deinitMutex);
@@ -110,11 +157,58 @@ int main(int argc, char *argv[])
 
     /* deinitialize stream controller module */
     ERRORCHECK(streamControllerDeinit());
-  
-timer_delete(keyTimer);
+
+	timerWheelCancel(&timerWheel, &keyTimer);
+	timerWheelPrintStats(&timerWheel);
+	ERRORCHECK(timerWheelDeinit(&timerWheel));
     return 0;
 }
 
+int32_t startStreamController(void* data)
+{
+	/* returns once the task is started, the task itself waits for tuner lock */
+	return streamControllerInit();
+}
+
+int32_t startRemoteController(void* data)
+{
+	/* initialize remote controller module and register its callback */
+	if (remoteControllerInit())
+	{
+		return -1;
+	}
+	return registerRemoteControllerCallback(remoteControllerCallback);
+}
+
+int32_t initOsdBackend(void* data)
+{
+	return graphicsControllerInitBackend();
+}
+
+int32_t loadOsdFont(void* data)
+{
+	return graphicsControllerLoadFont();
+}
+
+int32_t loadOsdAssets(void* data)
+{
+	return graphicsControllerLoadAssets();
+}
+
+int32_t startOsd(void* data)
+{
+	return graphicsControllerStart();
+}
+
+int32_t loadChannelList(void* data)
+{
+	if (getChannelDatabasePath()[0] != '\0')
+	{
+		graphicsControllerSetChannelDatabase(getChannelDatabasePath());
+	}
+	return 0;
+}
+
 void remoteControllerCallback(uint16_t code, uint16_t type, uint32_t value)
 {
     switch(code)
@@ -125,8 +219,10 @@ void remoteControllerCallback(uint16_t code, uint16_t type, uint32_t value)
             {
                 printf("\n********************* Channel info *********************\n");
                 printf("Program number: %d\n", channelInfo.programNumber);
+                printf("Service: %s (id %d)\n", channelInfo.serviceName, channelInfo.serviceId);
                 printf("Audio pid: %d\n", channelInfo.audioPid);
                 printf("Video pid: %d\n", channelInfo.videoPid);
+                printf("Signal: %s, lost %u times\n", channelInfo.signalLocked ? "locked" : "not locked", channelInfo.lockLossCount);
                 printf("**********************************************************\n");
             }
 			drawInfoRect(currentDateMain.tmpMonth, currentDateMain.day, currentDateMain.Year, channelInfo.audioPid, channelInfo.videoPid);
@@ -134,7 +230,6 @@ void remoteControllerCallback(uint16_t code, uint16_t type, uint32_t value)
 		case KEYCODE_P_PLUS:
 			printf("\nP+ pressed\n");
             channelUp();
-			drawProgramNumber();
 			break;
 		case KEYCODE_P_MINUS:
 		    printf("\nP- pressed\n");
@@ -159,6 +254,75 @@ void remoteControllerCallback(uint16_t code, uint16_t type, uint32_t value)
 			printf("\nCurrent volume : %d\n", currentVolume);
 			drawVolumeBar(currentVolume);
 			break;
+		case KEYCODE_PAUSE:
+			printf("\nPAUSE pressed\n");
+			playbackPause();
+			break;
+		case KEYCODE_PLAY:
+			printf("\nPLAY pressed\n");
+			playbackResume();
+			break;
+		case KEYCODE_REWIND:
+			printf("\nREWIND pressed\n");
+			playbackSeek(-TIMESHIFT_SEEK_STEP);
+			break;
+		case KEYCODE_FAST_FORWARD:
+			printf("\nFAST FORWARD pressed\n");
+			playbackSeek(TIMESHIFT_SEEK_STEP);
+			break;
+		case KEYCODE_STOP:
+			printf("\nSTOP pressed\n");
+			playbackReturnToLive();
+			break;
+		case KEYCODE_RECORD:
+			printf("\nRECORD pressed\n");
+			if (isRecording())
+			{
+				recordingStop();
+			}
+			else
+			{
+				recordingStart(getRecordingPath());
+			}
+			break;
+		case KEYCODE_UP:
+			printf("\nUP pressed\n");
+			if (isEpgGridShown())
+			{
+				moveEpgCursor(-1, 0);
+			}
+			else
+			{
+				channelDial(-1);
+			}
+			break;
+		case KEYCODE_DOWN:
+			printf("\nDOWN pressed\n");
+			if (isEpgGridShown())
+			{
+				moveEpgCursor(1, 0);
+			}
+			else
+			{
+				channelDial(1);
+			}
+			break;
+		case KEYCODE_LEFT:
+			printf("\nLEFT pressed\n");
+			moveEpgCursor(0, -1);
+			break;
+		case KEYCODE_RIGHT:
+			printf("\nRIGHT pressed\n");
+			moveEpgCursor(0, 1);
+			break;
+		case KEYCODE_EPG:
+			printf("\nEPG pressed\n");
+			drawEpgGrid(!isEpgGridShown());
+			break;
+		case KEYCODE_OK:
+			printf("\nOK pressed\n");
+			selectDialedChannel();
+			break;
 		case KEYCODE_EXIT:
 			printf("\nExit pressed\n");
             pthread_mutex_lock(&deinitMutex);
@@ -219,7 +383,7 @@ void registerCurrentDate(CurrentDate* currentDate)
 
 void inputChannelNumber(uint16_t key)
 {
-	timer_settime(keyTimer, timerFlags, &timerSpec, &timerSpecOld);
+	timerWheelArm(&timerWheel, &keyTimer, KEY_ENTRY_TIMEOUT);
 
 	if (keysPressed == 0)
 	{
@@ -250,7 +414,26 @@ void inputChannelNumber(uint16_t key)
 	printf("Keypressed: %d\n", keysPressed);
 }
 
-void changeChannel()
+void selectDialedChannel()
+{
+	uint32_t frequency = 0;
+	int32_t channelNumber = 0;
+
+	if (!channelDialSelection(&frequency, &channelNumber))
+	{
+		return;
+	}
+
+	/* tuner stays on the configured multiplex, services of other multiplexes are only listed */
+	if (frequency != getTuneFrequency())
+	{
+		printf("\n%s : INFO Channel is on %u Hz, tuner is locked to %u Hz\n", __FUNCTION__, frequency, getTuneFrequency());
+		return;
+	}
+	channelChangeRequest(channelNumber);
+}
+
+void changeChannel(void* data)
 {
 	int32_t channel;
 
@@ -279,3 +462,23 @@ void registerCurrentVolume(uint8_t volumeValue)
 {
 	currentVolume = volumeValue;
 }
+
+void channelChanged(uint32_t requestId, ChannelChangeStatus status, int32_t channelNumber)
+{
+	switch (status)
+	{
+		case CHANNEL_CHANGE_PMT_ACQUIRED:
+			printf("\nChannel change %u: PMT of channel %d acquired\n", requestId, channelNumber + 1);
+			break;
+		case CHANNEL_CHANGE_STREAMS_CREATED:
+			printf("\nChannel change %u: channel %d playing\n", requestId, channelNumber + 1);
+			drawProgramNumber(channelNumber + 1);
+			break;
+		case CHANNEL_CHANGE_FAILED:
+			printf("\nChannel change %u: channel %d failed\n", requestId, channelNumber + 1);
+			break;
+		case CHANNEL_CHANGE_CANCELLED:
+			printf("\nChannel change %u: cancelled\n", requestId);
+			break;
+	}
+}